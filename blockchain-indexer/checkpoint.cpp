@@ -0,0 +1,116 @@
+#include "checkpoint.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/path.h"
+
+Checkpoint::Checkpoint(std::string path) : path_(std::move(path)) {
+}
+
+td::Status Checkpoint::open(bool resume) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  if (resume) {
+    auto R = td::read_file_str(path_);
+    if (R.is_error()) {
+      return td::Status::Error(PSLICE() << "cannot read checkpoint " << path_ << ": " << R.move_as_error());
+    }
+    auto data = R.move_as_ok();
+
+    std::size_t records = 0;
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+      auto end = data.find('\n', pos);
+      if (end == std::string::npos) {
+        // a record is complete only with its newline: the tail was torn by a crash
+        LOG(WARNING) << "Drop incomplete checkpoint record at offset " << pos;
+        break;
+      }
+      try {
+        replay(json::parse(data.begin() + pos, data.begin() + end));
+      } catch (json::exception &e) {
+        // a record written partly before a crash and followed by a newline of a later append
+        LOG(WARNING) << "Drop checkpoint from corrupt record at offset " << pos << ": " << e.what();
+        break;
+      }
+      records++;
+      pos = end + 1;
+    }
+
+    LOG(WARNING) << "Resume from " << path_ << ": " << records << " records, " << progress_.size() << " ranges, "
+                 << committed_blocks_.size() << " blocks and " << committed_states_.size() << " states committed";
+
+    TRY_RESULT_ASSIGN(fd_, td::FileFd::open(path_, td::FileFd::Write | td::FileFd::Create));
+    // rewrite from the last complete record on
+    TRY_STATUS(fd_.truncate_to_current_position(pos));
+    TRY_STATUS(fd_.seek(pos));
+  } else {
+    TRY_RESULT_ASSIGN(fd_, td::FileFd::open(path_, td::FileFd::Write | td::FileFd::Create | td::FileFd::Truncate));
+  }
+  return td::Status::OK();
+}
+
+td::Status Checkpoint::commitFile(const std::string &tmp_path, const std::string &path,
+                                  const std::vector<std::string> &block_ids, const std::vector<std::string> &state_ids) {
+  TRY_STATUS(moveIntoPlace(tmp_path, path));
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  json record = {{"type", "file"}, {"path", path}, {"blocks", block_ids}, {"states", state_ids}};
+  TRY_STATUS(append(record));
+  replay(record);
+  return td::Status::OK();
+}
+
+td::Status Checkpoint::commitProgress(td::uint32 first, td::uint32 last, td::uint32 done) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  json record = {{"type", "progress"}, {"first", first}, {"last", last}, {"done", done}};
+  TRY_STATUS(append(record));
+  replay(record);
+  return td::Status::OK();
+}
+
+td::uint32 Checkpoint::progress(td::uint32 first, td::uint32 last) const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = progress_.find({first, last});
+  return it == progress_.end() ? 0 : it->second;
+}
+
+bool Checkpoint::isCommitted(const std::string &id, bool state) const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  const auto &committed = state ? committed_states_ : committed_blocks_;
+  return committed.count(id) != 0;
+}
+
+td::Status Checkpoint::moveIntoPlace(const std::string &tmp_path, const std::string &path) {
+  {
+    TRY_RESULT(fd, td::FileFd::open(tmp_path, td::FileFd::Read | td::FileFd::Write));
+    TRY_STATUS(fd.sync());
+  }
+  return td::rename(tmp_path, path);
+}
+
+void Checkpoint::replay(const json &record) {
+  const auto type = record.value("type", "");
+  if (type == "file") {
+    for (const auto &id : record["blocks"]) {
+      committed_blocks_.insert(id.get<std::string>());
+    }
+    for (const auto &id : record["states"]) {
+      committed_states_.insert(id.get<std::string>());
+    }
+  } else if (type == "progress") {
+    auto &done = progress_[{record["first"].get<td::uint32>(), record["last"].get<td::uint32>()}];
+    done = std::max(done, record["done"].get<td::uint32>());
+  }
+}
+
+td::Status Checkpoint::append(const json &record) {
+  auto line = record.dump(-1);
+  line += '\n';
+
+  td::Slice data = line;
+  while (!data.empty()) {
+    TRY_RESULT(written, fd_.write(data));
+    data.remove_prefix(written);
+  }
+  return fd_.sync();
+}
@@ -0,0 +1,53 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "json.hpp"
+#include "td/utils/int_types.h"
+#include "td/utils/Status.h"
+#include "td/utils/port/FileFd.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Durable progress log of the indexer: one JSON record per line, fsync'ed before the call returns.
+//   {"type": "file", "path": p, "blocks": [ids], "states": [ids]}  output file p is committed
+//   {"type": "progress", "first": f, "last": l, "done": d}         worker range [f, l] is committed up to MC seqno d
+//
+// Output files are written to "<path>.tmp", synced and renamed into place before their record is appended, so a file
+// named in the log is complete and a crash leaves at most a stale .tmp behind. On --resume workers restart from `done`
+// and blocks / states listed in committed files are not stored again, so file output is exactly-once across restarts.
+class Checkpoint {
+ public:
+  explicit Checkpoint(std::string path);
+
+  // Replays the existing log when resuming, starts an empty one otherwise
+  td::Status open(bool resume);
+
+  td::Status commitFile(const std::string &tmp_path, const std::string &path, const std::vector<std::string> &block_ids,
+                        const std::vector<std::string> &state_ids);
+  td::Status commitProgress(td::uint32 first, td::uint32 last, td::uint32 done);
+
+  // Last committed masterchain seqno of worker range [first, last], 0 if nothing is committed yet
+  td::uint32 progress(td::uint32 first, td::uint32 last) const;
+  bool isCommitted(const std::string &id, bool state) const;
+
+  // Sync and rename without a log record, for dumpers running without a checkpoint
+  static td::Status moveIntoPlace(const std::string &tmp_path, const std::string &path);
+
+ private:
+  void replay(const json &record);
+  td::Status append(const json &record);
+
+  std::string path_;
+  td::FileFd fd_;
+  mutable std::mutex mtx_;
+  std::map<std::pair<td::uint32, td::uint32>, td::uint32> progress_;
+  std::unordered_set<std::string> committed_blocks_;
+  std::unordered_set<std::string> committed_states_;
+};
+
+#endif  // CHECKPOINT_H
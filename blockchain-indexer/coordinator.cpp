@@ -0,0 +1,256 @@
+#include "coordinator.h"
+#include "checkpoint.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/Time.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+BackfillCoordinator::BackfillCoordinator(Options options) : options_(std::move(options)) {
+  options_.processes = std::max<td::uint32>(options_.processes, 1);
+  options_.lease_size = std::max<td::uint32>(options_.lease_size, 2);
+}
+
+td::Status BackfillCoordinator::run(const std::vector<std::tuple<td::uint32, td::uint32>> &seqno_s) {
+  for (auto &range : seqno_s) {
+    auto first = std::get<0>(range);
+    auto last = std::get<1>(range);
+    // ranges are inclusive, a one-seqno range is a lease of its own
+    while (first <= last) {
+      auto end = last - first >= options_.lease_size - 1 ? first + options_.lease_size - 1 : last;
+      if (end < last && end + 1 == last) {
+        // a one-seqno lease costs a whole indexer process for a single block, give it to the previous lease
+        end = last;
+      }
+      leases_.push_back(Lease{first, end});
+      leases_.back().resume = options_.resume;
+      if (end == last) {
+        break;
+      }
+      first = end + 1;
+    }
+  }
+  LOG(WARNING) << "Backfill of " << leases_.size() << " leases on " << options_.processes << " processes";
+
+  while (true) {
+    reap();
+
+    for (std::size_t i = 0; i < leases_.size() && running_.size() < options_.processes; i++) {
+      auto &lease = leases_[i];
+      if (lease.state != LeaseState::Pending) {
+        continue;
+      }
+      lease.state = LeaseState::Running;
+      lease.started_at = td::Time::now();
+      auto S = start(i, lease_prefix(lease), lease.resume);
+      if (S.is_error()) {
+        for (auto &attempt : running_) {
+          kill(attempt.pid, SIGTERM);
+        }
+        return S;
+      }
+    }
+    speculate();
+
+    if (running_.empty()) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  auto failed = std::count_if(leases_.begin(), leases_.end(),
+                              [](const Lease &lease) { return lease.state == LeaseState::Failed; });
+  if (failed > 0) {
+    return td::Status::Error(PSLICE() << failed << " leases failed, see " << options_.prefix << "lease_*log");
+  }
+  LOG(WARNING) << "Backfill finished, manifest: " << options_.prefix << "manifest.json";
+  return td::Status::OK();
+}
+
+std::string BackfillCoordinator::lease_prefix(const Lease &lease) const {
+  return PSTRING() << options_.prefix << "lease_" << lease.first << "_" << lease.last << "_";
+}
+
+td::Status BackfillCoordinator::start(std::size_t lease_id, std::string prefix, bool resume) {
+  const auto &lease = leases_[lease_id];
+
+  std::vector<std::string> args;
+  args.push_back(options_.self_path);
+  args.insert(args.end(), options_.child_args.begin(), options_.child_args.end());
+  args.push_back("-s");
+  args.push_back(PSTRING() << lease.first << ":" << lease.last);
+  args.push_back("-O");
+  args.push_back(prefix);
+  if (resume) {
+    args.push_back("-r");
+  }
+
+  // everything the child needs is prepared before fork()
+  std::vector<char *> argv;
+  for (auto &arg : args) {
+    argv.push_back(arg.data());
+  }
+  argv.push_back(nullptr);
+  auto log_path = prefix + "log";
+
+  auto pid = fork();
+  if (pid < 0) {
+    return OS_ERROR("can't fork indexer process");
+  }
+  if (pid == 0) {
+    auto fd = ::open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd >= 0) {
+      dup2(fd, 1);
+      dup2(fd, 2);
+      close(fd);
+    }
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+
+  LOG(WARNING) << "Lease " << lease.first << ":" << lease.last << " started in process " << pid << " ("
+               << prefix << (resume ? ", resume)" : ")");
+  running_.push_back(Attempt{pid, lease_id, std::move(prefix)});
+  return td::Status::OK();
+}
+
+void BackfillCoordinator::reap() {
+  while (true) {
+    int status = 0;
+    auto pid = waitpid(-1, &status, WNOHANG);
+    if (pid <= 0) {
+      return;
+    }
+    auto it = std::find_if(running_.begin(), running_.end(), [&](const Attempt &attempt) { return attempt.pid == pid; });
+    if (it == running_.end()) {
+      continue;
+    }
+    finished(it - running_.begin(), WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+}
+
+void BackfillCoordinator::finished(std::size_t attempt_id, bool ok) {
+  auto attempt = std::move(running_[attempt_id]);
+  running_.erase(running_.begin() + attempt_id);
+  auto &lease = leases_[attempt.lease];
+
+  if (lease.state == LeaseState::Done || attempt.cancelled) {
+    return;
+  }
+
+  if (ok) {
+    lease.state = LeaseState::Done;
+    lease.winner_prefix = attempt.prefix;
+    lease_times_.push_back(td::Time::now() - lease.started_at);
+
+    // the output files of the attempt are exactly the ones committed to its checkpoint log
+    std::ifstream log(attempt.prefix + "checkpoint.log");
+    std::string line;
+    while (std::getline(log, line)) {
+      auto record = json::parse(line, nullptr, false);
+      if (!record.is_discarded() && record.value("type", "") == "file") {
+        lease.files.push_back(record["path"].get<std::string>());
+      }
+    }
+
+    for (auto &other : running_) {
+      if (other.lease == attempt.lease) {
+        LOG(WARNING) << "Cancel duplicate of lease " << lease.first << ":" << lease.last << " in process "
+                     << other.pid;
+        other.cancelled = true;
+        kill(other.pid, SIGTERM);
+      }
+    }
+
+    auto S = write_manifest();
+    if (S.is_error()) {
+      LOG(ERROR) << "Can't write manifest: " << S;
+    }
+    LOG(WARNING) << "Lease " << lease.first << ":" << lease.last << " done by " << attempt.prefix << " with "
+                 << lease.files.size() << " files";
+    return;
+  }
+
+  auto still_running = std::any_of(running_.begin(), running_.end(),
+                                   [&](const Attempt &other) { return other.lease == attempt.lease; });
+  LOG(ERROR) << "Lease " << lease.first << ":" << lease.last << " failed in process " << attempt.pid
+             << ", see " << attempt.prefix << "log";
+  if (still_running) {
+    return;
+  }
+
+  lease.attempts++;
+  if (lease.attempts >= options_.max_attempts) {
+    LOG(ERROR) << "Lease " << lease.first << ":" << lease.last << " failed " << lease.attempts << " times, give up";
+    lease.state = LeaseState::Failed;
+    return;
+  }
+  // the lease prefix holds a checkpoint of whatever the attempts managed to commit
+  lease.state = LeaseState::Pending;
+  lease.resume = true;
+}
+
+void BackfillCoordinator::speculate() {
+  if (lease_times_.empty()) {
+    return;
+  }
+  for (auto &lease : leases_) {
+    if (lease.state == LeaseState::Pending) {
+      return;
+    }
+  }
+
+  auto times = lease_times_;
+  std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+  auto threshold = times[times.size() / 2] * options_.straggler_factor;
+  auto now = td::Time::now();
+
+  while (running_.size() < options_.processes) {
+    std::size_t slowest = leases_.size();
+    for (std::size_t i = 0; i < leases_.size(); i++) {
+      const auto &lease = leases_[i];
+      if (lease.state != LeaseState::Running || lease.speculated || now - lease.started_at <= threshold) {
+        continue;
+      }
+      if (slowest == leases_.size() || lease.started_at < leases_[slowest].started_at) {
+        slowest = i;
+      }
+    }
+    if (slowest == leases_.size()) {
+      return;
+    }
+
+    auto &lease = leases_[slowest];
+    lease.speculated = true;
+    LOG(WARNING) << "Lease " << lease.first << ":" << lease.last << " is running for " << now - lease.started_at
+                 << "s (median " << threshold / options_.straggler_factor << "s), start a duplicate";
+    auto S = start(slowest, lease_prefix(lease) + "s_", false);
+    if (S.is_error()) {
+      LOG(ERROR) << "Can't start duplicate: " << S;
+      return;
+    }
+  }
+}
+
+td::Status BackfillCoordinator::write_manifest() const {
+  auto leases = json::array();
+  for (auto &lease : leases_) {
+    if (lease.state != LeaseState::Done) {
+      continue;
+    }
+    leases.push_back(
+        {{"first", lease.first}, {"last", lease.last}, {"prefix", lease.winner_prefix}, {"files", lease.files}});
+  }
+  json manifest = {{"leases", std::move(leases)}};
+
+  auto path = options_.prefix + "manifest.json";
+  TRY_STATUS(td::write_file(path + ".tmp", manifest.dump(4)));
+  return Checkpoint::moveIntoPlace(path + ".tmp", path);
+}
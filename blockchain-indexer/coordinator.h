@@ -0,0 +1,76 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include "json.hpp"
+#include "td/utils/int_types.h"
+#include "td/utils/Status.h"
+#include <string>
+#include <sys/types.h>
+#include <tuple>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Multi-process backfill: the masterchain range is cut into leases of lease_size seqnos, every lease is indexed by
+// a separate indexer process (own read-only DB handle, own ValidatorManager) started as
+//   <self_path> <child_args> -s first:last -O <lease prefix> [-r]
+// so block / state loads are no longer serialized by a single manager actor.
+//
+// Every lease writes to its own prefix "<prefix>lease_<first>_<last>_" and its own checkpoint log. A crashed lease is
+// restarted with --resume on the same prefix. Once no lease is pending, a lease running longer than
+// straggler_factor x the median lease time is started once more on a spare process ("_s" prefix); the first attempt
+// to finish wins and the other one is killed. Files of the winning attempts are merged into "<prefix>manifest.json".
+class BackfillCoordinator {
+ public:
+  struct Options {
+    std::string self_path;
+    std::vector<std::string> child_args;
+    std::string prefix = "dump_";
+    td::uint32 processes = 1;
+    td::uint32 lease_size = 10000;
+    td::uint32 max_attempts = 3;
+    double straggler_factor = 2.0;
+    bool resume = false;
+  };
+
+  explicit BackfillCoordinator(Options options);
+
+  // Blocks until every lease is done, fails if a lease has failed max_attempts times
+  td::Status run(const std::vector<std::tuple<td::uint32, td::uint32>> &seqno_s);
+
+ private:
+  enum class LeaseState { Pending, Running, Done, Failed };
+
+  struct Lease {
+    td::uint32 first;
+    td::uint32 last;
+    LeaseState state = LeaseState::Pending;
+    td::uint32 attempts = 0;   // failed attempts
+    bool resume = false;       // restart on the lease prefix instead of starting it over
+    bool speculated = false;
+    double started_at = 0;
+    std::string winner_prefix;
+    std::vector<std::string> files;
+  };
+
+  struct Attempt {
+    pid_t pid;
+    std::size_t lease;
+    std::string prefix;
+    bool cancelled = false;
+  };
+
+  std::string lease_prefix(const Lease &lease) const;
+  td::Status start(std::size_t lease_id, std::string prefix, bool resume);
+  void reap();
+  void finished(std::size_t attempt_id, bool ok);
+  void speculate();
+  td::Status write_manifest() const;
+
+  Options options_;
+  std::vector<Lease> leases_;
+  std::vector<Attempt> running_;
+  std::vector<double> lease_times_;
+};
+
+#endif  // COORDINATOR_H
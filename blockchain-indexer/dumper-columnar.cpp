@@ -0,0 +1,266 @@
+#include "dumper-columnar.h"
+#include "td/utils/logging.h"
+#include "td/utils/lz4.h"
+#include <chrono>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+void append_u8(std::string &to, td::uint8 x) {
+  to.push_back(static_cast<char>(x));
+}
+
+void append_u32(std::string &to, td::uint32 x) {
+  for (int i = 0; i < 4; i++) {
+    to.push_back(static_cast<char>((x >> (8 * i)) & 0xff));
+  }
+}
+
+void append_u64(std::string &to, td::uint64 x) {
+  for (int i = 0; i < 8; i++) {
+    to.push_back(static_cast<char>((x >> (8 * i)) & 0xff));
+  }
+}
+
+std::string make_row(const std::string &id, const char *id_key, json data) {
+  if (!data.is_object()) {
+    data = {{"value", std::move(data)}};
+  }
+  data[id_key] = id;
+  return data.dump(-1);
+}
+
+}  // namespace
+
+DumperColumnar::DumperColumnar(std::string prefix, std::size_t buffer_size, std::size_t row_groups_per_file,
+                               std::size_t max_group_bytes)
+    : Dumper(std::move(prefix), buffer_size)
+    , row_groups_per_file_(row_groups_per_file)
+    , max_group_bytes_(max_group_bytes) {
+}
+
+DumperColumnar::~DumperColumnar() {
+  forceDump();
+}
+
+void DumperColumnar::storeBlock(std::string id, std::string block) {
+  storeBlockJson(std::move(id), json::parse(block));
+}
+
+void DumperColumnar::storeState(std::string id, std::string state) {
+  storeStateJson(std::move(id), json::parse(state));
+}
+
+void DumperColumnar::storeBlockJson(std::string id, json block) {
+  LOG(DEBUG) << "Storing block " << id;
+
+  // Split the block outside of the lock: transactions and messages go to their own columns,
+  // the block row keeps per-account transaction counts only
+  Rows rows;
+  auto extra = block.find("BlockExtra");
+  if (extra != block.end() && extra->contains("accounts")) {
+    for (auto &account : (*extra)["accounts"]) {
+      if (!account.contains("transactions")) {
+        continue;
+      }
+      for (auto &tx : account["transactions"]) {
+        auto tx_hash = tx.value("hash", "");
+        auto tx_lt = tx.value("lt", static_cast<td::uint64>(0));
+
+        if (tx.contains("in_msg")) {
+          json msg = {{"tx_hash", tx_hash}, {"tx_lt", tx_lt}, {"direction", "in"}, {"index", 0},
+                      {"message", std::move(tx["in_msg"])}};
+          if (tx.contains("in_msg_cell")) {
+            msg["cell"] = std::move(tx["in_msg_cell"]);
+            tx.erase("in_msg_cell");
+          }
+          tx.erase("in_msg");
+          rows.emplace_back("messages", make_row(id, "block_id", std::move(msg)));
+        }
+        if (tx.contains("out_msgs")) {
+          int index = 0;
+          for (auto &out_msg : tx["out_msgs"]) {
+            json msg = {{"tx_hash", tx_hash},
+                        {"tx_lt", tx_lt},
+                        {"direction", "out"},
+                        {"index", index++},
+                        {"message", std::move(out_msg)}};
+            rows.emplace_back("messages", make_row(id, "block_id", std::move(msg)));
+          }
+          tx.erase("out_msgs");
+        }
+
+        rows.emplace_back("transactions", make_row(id, "block_id", std::move(tx)));
+      }
+      account.erase("transactions");
+    }
+  }
+  rows.emplace_back("blocks", make_row(id, "id", std::move(block)));
+
+  appendRows(std::move(rows), 1, std::move(id));
+}
+
+void DumperColumnar::storeStateJson(std::string id, json state) {
+  LOG(DEBUG) << "Storing state " << id;
+
+  Rows rows;
+  if (state.contains("accounts")) {
+    for (auto &account : state["accounts"]) {
+      rows.emplace_back("account_states", make_row(id, "block_id", std::move(account)));
+    }
+    state.erase("accounts");
+  }
+  rows.emplace_back("shard_states", make_row(id, "id", std::move(state)));
+
+  appendRows(std::move(rows), 0, {}, std::move(id));
+}
+
+void DumperColumnar::addError(std::string id, std::string type) {
+  LOG(ERROR) << "We have error in " << id << " in " << type;
+
+  Rows rows;
+  rows.emplace_back("errors", make_row(id, "id", {{"type", std::move(type)}}));
+  appendRows(std::move(rows), 0);
+}
+
+td::Status DumperColumnar::forceDump() {
+  LOG(INFO) << "Force dump of what is left";
+  {
+    std::lock_guard<std::mutex> lock(store_mtx);
+    dump();
+  }
+  {
+    std::lock_guard<std::mutex> lock(dump_mtx);
+    closeFile();
+  }
+  LOG(INFO) << "Finished force dumping";
+  return td::Status::OK();
+}
+
+void DumperColumnar::appendRows(Rows rows, std::size_t blocks_count, std::string block_id, std::string state_id) {
+  std::lock_guard<std::mutex> lock(store_mtx);
+
+  if (!block_id.empty()) {
+    group_block_ids_.push_back(std::move(block_id));
+  }
+  if (!state_id.empty()) {
+    group_state_ids_.push_back(std::move(state_id));
+  }
+
+  for (auto &row : rows) {
+    auto &column = columns_[row.first];
+    group_bytes_ += row.second.size() + 1;
+    column.rows += row.second;
+    column.rows += '\n';
+    column.count++;
+  }
+  group_blocks_ += blocks_count;
+
+  if (group_blocks_ >= buffer_size || group_bytes_ >= max_group_bytes_) {
+    dump();
+  }
+}
+
+void DumperColumnar::dump() {
+  if (columns_.empty()) {
+    return;
+  }
+  flushRowGroup();
+}
+
+void DumperColumnar::dumpError() {
+  // errors are stored as a regular column of the current row group
+}
+
+void DumperColumnar::dumpLoners() {
+  // blocks and states are not joined, so there are no loners to dump
+}
+
+void DumperColumnar::flushRowGroup() {
+  std::lock_guard<std::mutex> lock(dump_mtx);
+
+  if (!file_.is_open()) {
+    openFile();
+  }
+
+  std::string data;
+  append_u32(data, 0x50475254);  // "TRGP"
+  append_u32(data, static_cast<td::uint32>(columns_.size()));
+  append_u32(data, static_cast<td::uint32>(group_blocks_));
+
+  for (auto &column : columns_) {
+    auto compressed = td::lz4_compress(column.second.rows);
+    append_u8(data, static_cast<td::uint8>(column.first.size()));
+    data += column.first;
+    append_u32(data, column.second.count);
+    append_u32(data, static_cast<td::uint32>(column.second.rows.size()));
+    append_u32(data, static_cast<td::uint32>(compressed.size()));
+    data.append(compressed.data(), compressed.size());
+  }
+
+  row_group_offsets_.push_back(file_offset_);
+  write(data);
+  std::move(group_block_ids_.begin(), group_block_ids_.end(), std::back_inserter(file_block_ids_));
+  std::move(group_state_ids_.begin(), group_state_ids_.end(), std::back_inserter(file_state_ids_));
+  group_block_ids_.clear();
+  group_state_ids_.clear();
+
+  LOG(WARNING) << "Dumped row group of " << group_blocks_ << " blocks (" << group_bytes_ << " bytes raw) to "
+               << file_path_;
+
+  columns_.clear();
+  group_blocks_ = 0;
+  group_bytes_ = 0;
+
+  if (row_group_offsets_.size() >= row_groups_per_file_) {
+    closeFile();
+  }
+}
+
+void DumperColumnar::openFile() {
+  auto tag =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count();
+
+  std::ostringstream oss;
+  oss << prefix << tag << ".tcol";
+  file_path_ = oss.str();
+  file_.open(file_path_ + ".tmp", std::ios::binary | std::ios::trunc);
+  file_offset_ = 0;
+  row_group_offsets_.clear();
+
+  std::string header = "TCOL";
+  append_u32(header, version);
+  write(header);
+}
+
+void DumperColumnar::closeFile() {
+  if (!file_.is_open()) {
+    return;
+  }
+
+  auto footer_offset = file_offset_;
+  std::string footer;
+  append_u32(footer, 0x52544654);  // "TFTR"
+  append_u32(footer, static_cast<td::uint32>(row_group_offsets_.size()));
+  for (auto offset : row_group_offsets_) {
+    append_u64(footer, offset);
+  }
+  append_u64(footer, footer_offset);
+  footer += "TCOL";
+  write(footer);
+
+  file_.close();
+  commitFile(file_path_ + ".tmp", file_path_, file_block_ids_, file_state_ids_);
+  LOG(WARNING) << "Finalized " << file_path_ << " with " << row_group_offsets_.size() << " row groups";
+  row_group_offsets_.clear();
+  file_block_ids_.clear();
+  file_state_ids_.clear();
+}
+
+void DumperColumnar::write(const std::string &data) {
+  file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+  file_.flush();
+  file_offset_ += data.size();
+}
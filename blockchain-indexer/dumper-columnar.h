@@ -0,0 +1,72 @@
+#ifndef DUMPER_COLUMNAR_H
+#define DUMPER_COLUMNAR_H
+
+#include "dumper-interface.h"
+#include "td/utils/int_types.h"
+#include <fstream>
+#include <map>
+
+// Streams blocks and states into chunked, lz4-compressed columnar files instead of one big JSON array.
+//
+// File layout (all integers are little-endian):
+//   file       := "TCOL" version:u32 row_group* footer
+//   row_group  := "TRGP" columns:u32 blocks:u32 column_chunk*
+//   column     := name_len:u8 name rows:u32 raw_size:u32 compressed_size:u32 lz4(rows as newline-delimited JSON)
+//   footer     := "TFTR" row_groups:u32 (offset:u64)* footer_offset:u64 "TCOL"
+//
+// Columns: blocks, transactions, messages, shard_states, account_states, errors. Every row carries the
+// "wc:shard:seqno" block id, so a reader can decode only the columns it needs by skipping over the others.
+// A row group is flushed after buffer_size blocks (or max_group_bytes of raw rows), a file is finalized after
+// row_groups_per_file row groups, so memory stays bounded regardless of the backfill length. A file is written as
+// "<name>.tcol.tmp" and only renamed (and checkpointed with the ids it holds) once its footer is written.
+class DumperColumnar : public Dumper {
+ public:
+  static constexpr td::uint32 version = 1;
+
+  explicit DumperColumnar(std::string prefix, std::size_t buffer_size, std::size_t row_groups_per_file = 64,
+                          std::size_t max_group_bytes = (256 << 20));
+  ~DumperColumnar() override;
+
+  void storeBlock(std::string id, std::string block) override;
+  void storeState(std::string id, std::string state) override;
+  void storeBlockJson(std::string id, json block) override;
+  void storeStateJson(std::string id, json state) override;
+  void addError(std::string id, std::string type) override;
+  td::Status forceDump() override;
+
+ protected:
+  void dump() override;
+  void dumpError() override;
+  void dumpLoners() override;
+
+ private:
+  struct Column {
+    std::string rows;
+    td::uint32 count = 0;
+  };
+  using Rows = std::vector<std::pair<const char *, std::string>>;
+
+  void appendRows(Rows rows, std::size_t blocks_count, std::string block_id = {}, std::string state_id = {});
+  void flushRowGroup();
+  void openFile();
+  void closeFile();
+  void write(const std::string &data);
+
+  const std::size_t row_groups_per_file_;
+  const std::size_t max_group_bytes_;
+
+  std::map<std::string, Column> columns_;
+  std::size_t group_blocks_ = 0;
+  std::size_t group_bytes_ = 0;
+  std::vector<std::string> group_block_ids_;
+  std::vector<std::string> group_state_ids_;
+
+  std::ofstream file_;
+  std::string file_path_;
+  td::uint64 file_offset_ = 0;
+  std::vector<td::uint64> row_group_offsets_;
+  std::vector<std::string> file_block_ids_;
+  std::vector<std::string> file_state_ids_;
+};
+
+#endif  // DUMPER_COLUMNAR_H
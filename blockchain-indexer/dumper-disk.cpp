@@ -1,6 +1,18 @@
 #include "dumper-disk.h"
 #include "td/utils/logging.h"
 
+namespace {
+
+std::string write_tmp(const std::string &path, const std::string &data) {
+  auto tmp_path = path + ".tmp";
+  std::ofstream file(tmp_path);
+  file << data;
+  file.close();
+  return tmp_path;
+}
+
+}  // namespace
+
 DumperDisk::DumperDisk(std::string prefix, std::size_t buffer_size)
     : Dumper(std::move(prefix), buffer_size) {}
 
@@ -81,15 +93,19 @@ void DumperDisk::addError(std::string id, std::string type) {
       {"type", type},
   };
 
+  std::lock_guard lock(dump_mtx);
   error.emplace_back(std::move(data));
 }
 
-void DumperDisk::forceDump() {
+td::Status DumperDisk::forceDump() {
   LOG(INFO) << "Force dump of what is left";
+  // workers may still be storing when a chunk is checkpointed
+  std::lock_guard lock(store_mtx);
   dump();
   dumpLoners();
   dumpError();
   LOG(INFO) << "Finished force dumping";
+  return td::Status::OK();
 }
 
 void DumperDisk::dump() {
@@ -103,6 +119,8 @@ void DumperDisk::dump() {
 
   std::string to_dump = "[";
   std::string to_dump_ids = "[";
+  std::vector<std::string> ids;
+  ids.reserve(joined_ids.size());
 
   if (!joined.empty()) {
     while (!joined.empty()) {
@@ -120,6 +138,7 @@ void DumperDisk::dump() {
       to_dump_ids += "\"";
       to_dump_ids += tmp;
       to_dump_ids += "\",";
+      ids.emplace_back(std::move(tmp));
     }
     to_dump_ids.pop_back();
   }
@@ -133,15 +152,11 @@ void DumperDisk::dump() {
 
   std::ostringstream oss;
   oss << prefix << tag << ".json";
-  std::ofstream file(oss.str());
-  file << to_dump;
-  file.close();
-
   std::ostringstream oss_ids;
   oss_ids << prefix << tag << "_ids.json";
-  std::ofstream file_ids(oss_ids.str());
-  file_ids << to_dump_ids;
-  file_ids.close();
+
+  commitFile(write_tmp(oss_ids.str(), to_dump_ids), oss_ids.str());
+  commitFile(write_tmp(oss.str(), to_dump), oss.str(), ids, ids);
 
   std::ostringstream done_ids;
   done_ids << prefix << tag << "_done.json";
@@ -168,8 +183,7 @@ void DumperDisk::dumpError() {
 
     std::ostringstream oss_ids;
     oss_ids << prefix << tag << "_error.json";
-    std::ofstream file_ids(oss_ids.str());
-    file_ids << error_to_dump.dump(4);
+    commitFile(write_tmp(oss_ids.str(), error_to_dump.dump(4)), oss_ids.str());
 
     LOG(INFO) << "Dumped error data";
   }
@@ -185,11 +199,14 @@ void DumperDisk::dumpLoners() {
   }
 
   auto to_dump_ids = json::array();
+  std::vector<std::string> block_ids;
+  std::vector<std::string> state_ids;
 
   auto blocks_to_dump = json::array();
   for (auto &e : blocks) {
     json block_json = {{"id", e.first}, {"block", std::move(e.second)}};
     to_dump_ids.emplace_back(e.first);
+    block_ids.emplace_back(e.first);
     blocks_to_dump.emplace_back(std::move(block_json));
   }
   blocks.clear();
@@ -198,6 +215,7 @@ void DumperDisk::dumpLoners() {
   for (auto &e : states) {
     json state_json = {{"id", e.first}, {"state", std::move(e.second)}};
     to_dump_ids.emplace_back(e.first);
+    state_ids.emplace_back(e.first);
     states_to_dump.emplace_back(std::move(state_json));
   }
   states.clear();
@@ -211,13 +229,11 @@ void DumperDisk::dumpLoners() {
 
     std::ostringstream oss;
     oss << prefix << "loners_" << tag << ".json";
-    std::ofstream file(oss.str());
-    file << to_dump.dump(-1);
-
     std::ostringstream oss_ids;
     oss_ids << prefix << "loners_" << tag << "_ids.json";
-    std::ofstream file_ids(oss_ids.str());
-    file_ids << to_dump_ids.dump(-1);
+
+    commitFile(write_tmp(oss_ids.str(), to_dump_ids.dump(-1)), oss_ids.str());
+    commitFile(write_tmp(oss.str(), to_dump.dump(-1)), oss.str(), block_ids, state_ids);
 
     LOG(WARNING) << "Dumped " << lone_blocks_amount << " blocks without pair";
     LOG(WARNING) << "Dumped " << lone_states_amount << " states without pair";
@@ -14,7 +14,7 @@ class DumperDisk : public Dumper {
   void storeBlock(std::string id, std::string block) override;
   void storeState(std::string id, std::string state) override;
   void addError(std::string id, std::string type) override;
-  void forceDump() override;
+  td::Status forceDump() override;
 
  protected:
   void dump() override;
@@ -6,27 +6,58 @@
 #include <vector>
 #include <mutex>
 #include "json.hpp"
+#include "checkpoint.h"
 #include "td/utils/check.h"
+#include "td/utils/logging.h"
+#include "td/utils/Status.h"
 
 using json = nlohmann::json;
 
 class Dumper {
  public:
   explicit Dumper(std::string prefix_, std::size_t buffer_size_) : prefix(prefix_), buffer_size(buffer_size_){};
-  virtual ~Dumper() {
-    UNREACHABLE();
-  };
+  virtual ~Dumper() = default;
 
   virtual void storeBlock(std::string id, std::string block) = 0;
   virtual void storeState(std::string id, std::string state) = 0;
   virtual void addError(std::string id, std::string type) = 0;
-  virtual void forceDump() = 0;
+  // Writes out everything stored so far, fails if anything stored was lost
+  virtual td::Status forceDump() = 0;
+
+  // Structured variants: backends that split records (e.g. columnar) override these to avoid a dump/parse round trip
+  virtual void storeBlockJson(std::string id, json block) {
+    storeBlock(std::move(id), block.dump(-1));
+  }
+  virtual void storeStateJson(std::string id, json state) {
+    storeState(std::move(id), state.dump(-1));
+  }
+
+  void setCheckpoint(Checkpoint *checkpoint_) {
+    checkpoint = checkpoint_;
+  }
+  Checkpoint *getCheckpoint() const {
+    return checkpoint;
+  }
+  // Blocks / states written by a previous run, resumed workers must not store them again
+  bool isCommitted(const std::string &id, bool state) const {
+    return checkpoint != nullptr && checkpoint->isCommitted(id, state);
+  }
 
  protected:
   virtual void dump() = 0;
   virtual void dumpError() = 0;
   virtual void dumpLoners() = 0;
 
+  // Moves a fully written temporary file into place and records it (with the ids it holds) in the checkpoint
+  void commitFile(const std::string &tmp_path, const std::string &path, const std::vector<std::string> &block_ids = {},
+                  const std::vector<std::string> &state_ids = {}) {
+    auto S = checkpoint != nullptr ? checkpoint->commitFile(tmp_path, path, block_ids, state_ids)
+                                   : Checkpoint::moveIntoPlace(tmp_path, path);
+    if (S.is_error()) {
+      LOG(FATAL) << "Can't commit " << path << ": " << S;
+    }
+  }
+
   std::string prefix;
   std::mutex store_mtx;
   std::mutex dump_mtx;
@@ -36,6 +67,7 @@ class Dumper {
   std::vector<std::string> joined_ids;
   std::vector<json> error;
   std::size_t buffer_size;
+  Checkpoint *checkpoint = nullptr;
 };
 
 #endif  // DUMPER_INTERFACE_H
@@ -1,40 +1,162 @@
 #include "dumper-kafka.h"
 #include "td/utils/logging.h"
 
-DumperKafka::DumperKafka(std::string prefix, std::size_t buffer_size)
-    : Dumper(std::move(prefix), buffer_size) {
+namespace {
 
+std::string topic_from_env(const char *name, const char *default_topic) {
+  const char *value = getenv(name);
+  return value ? value : default_topic;
+}
+
+}  // namespace
+
+DumperKafka::DumperKafka(std::string endpoint, std::size_t buffer_size, std::size_t max_in_flight_bytes)
+    : Dumper("", buffer_size)
+    , block_topic_(topic_from_env("KAFKA_BLOCK_TOPIC", "indexer-block-data"))
+    , state_topic_(topic_from_env("KAFKA_STATE_TOPIC", "indexer-block-state"))
+    , error_topic_(topic_from_env("KAFKA_ERROR_TOPIC", "indexer-block-error"))
+    , max_in_flight_bytes_(max_in_flight_bytes) {
+  cppkafka::Configuration config{{"metadata.broker.list", endpoint},
+                                 {"message.max.bytes", "1000000000"},  // max
+                                 {"compression.type", "lz4"},
+                                 {"enable.idempotence", true},
+                                 {"acks", "all"},
+                                 {"linger.ms", 50},
+                                 {"batch.size", 16 << 20},
+                                 {"queue.buffering.max.messages", std::to_string(buffer_size * 2 + 16)},
+                                 {"queue.buffering.max.kbytes", std::to_string((max_in_flight_bytes >> 10) * 2 + 1024)},
+                                 {"retry.backoff.ms", 5}};
+  config.set_delivery_report_callback(
+      [this](cppkafka::Producer &, const cppkafka::Message &msg) { on_delivery(msg); });
+  producer_ = std::make_unique<cppkafka::Producer>(std::move(config));
+
+  poll_thread_ = std::thread([this] {
+    while (!stop_.load(std::memory_order_relaxed)) {
+      producer_->poll(std::chrono::milliseconds(100));
+    }
+  });
 }
 
 DumperKafka::~DumperKafka() {
-  forceDump();
+  auto S = forceDump();
+  if (S.is_error()) {
+    LOG(ERROR) << S;
+  }
   // Close Kafka producer
+  stop_ = true;
+  poll_thread_.join();
 }
 
 void DumperKafka::storeBlock(std::string id, std::string block) {
-
+  LOG(DEBUG) << "Storing block " << id;
+  produce(block_topic_, id, std::move(block));
 }
 
 void DumperKafka::storeState(std::string id, std::string state) {
-
+  LOG(DEBUG) << "Storing state " << id;
+  produce(state_topic_, id, std::move(state));
 }
 
 void DumperKafka::addError(std::string id, std::string type) {
-
+  LOG(ERROR) << "We have error in " << id << " in " << type;
+  json data = {
+      {"id", id},
+      {"type", type},
+  };
+
+  std::lock_guard<std::mutex> lock(store_mtx);
+  error.emplace_back(std::move(data));
 }
 
-void DumperKafka::forceDump() {
-
+td::Status DumperKafka::forceDump() {
+  LOG(INFO) << "Force dump of what is left";
+  dumpError();
+  dump();
+  td::uint64 failed = failed_;
+  LOG(INFO) << "Finished force dumping, delivered: " << delivered_ << " failed: " << failed;
+  // a lost message is not retried, so once one is lost no later flush may pass either: progress of other workers
+  // committed meanwhile could cover it
+  if (failed != 0) {
+    return td::Status::Error(PSLICE() << failed << " messages were not delivered to kafka");
+  }
+  return td::Status::OK();
 }
 
 void DumperKafka::dump() {
-
+  std::lock_guard<std::mutex> lock(dump_mtx);
+
+  // delivery reports are served by the poll thread, here we only wait for the window to drain
+  std::unique_lock<std::mutex> in_flight_lock(in_flight_mtx_);
+  while (in_flight_ != 0) {
+    LOG(INFO) << "Waiting for " << in_flight_ << " messages to be delivered";
+    in_flight_cv_.wait_for(in_flight_lock, std::chrono::seconds(1));
+  }
 }
 
 void DumperKafka::dumpError() {
-
+  std::vector<json> to_dump;
+  {
+    std::lock_guard<std::mutex> lock(store_mtx);
+    to_dump = std::move(error);
+    error.clear();
+  }
+
+  for (auto &e : to_dump) {
+    auto id = e["id"].get<std::string>();
+    produce(error_topic_, id, e.dump());
+  }
 }
 
 void DumperKafka::dumpLoners() {
+  // blocks and states are published separately keyed by id, consumers join them
+}
+
+void DumperKafka::produce(const std::string &topic, const std::string &id, std::string payload) {
+  acquire(payload.size());
+
+  while (true) {
+    try {
+      producer_->produce(cppkafka::MessageBuilder(topic).key(id).payload(payload));
+      return;
+    } catch (cppkafka::HandleException &e) {
+      if (e.get_error().get_error() != RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+        LOG(ERROR) << "Error while sending " << id << " to kafka topic " << topic << ": " << e.what();
+        failed_++;
+        release(payload.size());
+        return;
+      }
+      // local librdkafka queue is full, let the poll thread drain it
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+void DumperKafka::on_delivery(const cppkafka::Message &msg) {
+  if (msg.get_error()) {
+    failed_++;
+    LOG(ERROR) << "Failed to deliver " << std::string(msg.get_key()) << " to kafka topic " << msg.get_topic()
+               << ": " << msg.get_error().to_string();
+  } else {
+    delivered_++;
+  }
+  release(msg.get_payload().get_size());
+}
+
+void DumperKafka::acquire(std::size_t bytes) {
+  std::unique_lock<std::mutex> lock(in_flight_mtx_);
+  in_flight_cv_.wait(lock, [&] {
+    // a single oversized message is still allowed through when nothing else is in flight
+    return in_flight_ == 0 || (in_flight_ < buffer_size && in_flight_bytes_ + bytes <= max_in_flight_bytes_);
+  });
+  in_flight_++;
+  in_flight_bytes_ += bytes;
+}
 
+void DumperKafka::release(std::size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(in_flight_mtx_);
+    in_flight_--;
+    in_flight_bytes_ -= std::min(bytes, in_flight_bytes_);
+  }
+  in_flight_cv_.notify_all();
 }
@@ -2,16 +2,28 @@
 #define DUMPER_KAFKA_H
 
 #include "dumper-interface.h"
+#include "td/utils/int_types.h"
+#include <cppkafka/cppkafka.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <thread>
 
+// Streams blocks/states to Kafka keyed by "wc:shard:seqno".
+// produce() never waits for the broker: librdkafka batches by linger.ms / batch.size, a background thread
+// polls delivery reports, and at most buffer_size messages (max_in_flight_bytes) may be undelivered at once.
+// When the window is full storeBlock/storeState block the calling worker, which stalls IndexerWorker padding
+// until the broker catches up. The producer is idempotent, so retries never duplicate a record in a partition.
 class DumperKafka : public Dumper {
  public:
-  explicit DumperKafka(std::string prefix, std::size_t buffer_size);
+  explicit DumperKafka(std::string endpoint, std::size_t buffer_size,
+                       std::size_t max_in_flight_bytes = (std::size_t(512) << 20));
   ~DumperKafka() override;
 
   void storeBlock(std::string id, std::string block) override;
   void storeState(std::string id, std::string state) override;
   void addError(std::string id, std::string type) override;
-  void forceDump() override;
+  td::Status forceDump() override;
 
  protected:
   void dump() override;
@@ -19,7 +31,27 @@ class DumperKafka : public Dumper {
   void dumpLoners() override;
 
  private:
+  void produce(const std::string &topic, const std::string &id, std::string payload);
+  void on_delivery(const cppkafka::Message &msg);
+  void acquire(std::size_t bytes);
+  void release(std::size_t bytes);
+
+  std::string block_topic_;
+  std::string state_topic_;
+  std::string error_topic_;
+  const std::size_t max_in_flight_bytes_;
+
   // Kafka producer instance
+  std::unique_ptr<cppkafka::Producer> producer_;
+  std::thread poll_thread_;
+  std::atomic<bool> stop_{false};
+
+  std::mutex in_flight_mtx_;
+  std::condition_variable in_flight_cv_;
+  std::size_t in_flight_ = 0;
+  std::size_t in_flight_bytes_ = 0;
+  std::atomic<td::uint64> delivered_{0};
+  std::atomic<td::uint64> failed_{0};
 };
 
 #endif  // DUMPER_KAFKA_H
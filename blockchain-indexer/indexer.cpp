@@ -23,7 +23,9 @@
 #include "vm/vm.h"
 #include "td/utils/Slice.h"
 #include "td/utils/common.h"
+#include "td/db/RocksDb.h"
 #include "td/utils/OptionParser.h"
+#include "td/utils/port/path.h"
 #include "td/utils/port/user.h"
 #include <utility>
 #include <fstream>
@@ -31,6 +33,12 @@
 #include "adnl/utils.hpp"
 #include "json.hpp"
 #include "json-utils.hpp"
+#include "dumper-disk.h"
+#include "dumper-columnar.h"
+#include "dumper-kafka.h"
+#include "checkpoint.h"
+#include "coordinator.h"
+#include "state-diff.hpp"
 #include "tuple"
 #include "crypto/block/mc-config.h"
 #include <algorithm>
@@ -44,414 +52,30 @@ namespace ton {
 
 namespace validator {
 
-class Dumper {
- public:
-  explicit Dumper(std::string prefix, const std::size_t buffer_size)
-      : prefix(std::move(prefix)), buffer_size(buffer_size) {
-    joined.reserve(buffer_size);
-  }
-
-  ~Dumper() {
-    forceDump();
-  }
-
-  void storeBlock(std::string id, std::string block) {
-    LOG(DEBUG) << "Storing block " << id;
-    {
-      std::lock_guard<std::mutex> lock(store_mtx);
-
-      auto state = states.find(id);
-      if (state == states.end()) {
-        blocks.insert({std::move(id), std::move(block)});
-      } else {
-        std::string tmp_id = id;
-        joined_ids.emplace_back(std::move(id));
-
-        std::string together = R"({"id": ")";
-        std::string state_str = state->second;
-
-        together += tmp_id;
-        together += R"(", "block": )";
-        together += block;
-        together += R"(, "state": )";
-        together += state_str;
-        together += "}";
-
-        joined.emplace_back(std::move(together));
-        states.erase(state);
-      }
-
-      if (joined.size() >= buffer_size) {
-        dump();
-        dumpLoners();
-      }
-    }
-  }
-
-  void storeState(std::string id, std::string state) {
-    LOG(DEBUG) << "Storing state " << id;
-    {
-      std::lock_guard lock(store_mtx);
-
-      auto block = blocks.find(id);
-      if (block == blocks.end()) {
-        states.insert({std::move(id), std::move(state)});
-      } else {
-        std::string tmp_id = id;
-        joined_ids.emplace_back(std::move(id));
-
-        std::string together = R"({"id": ")";
-        std::string block_str = block->second;
-
-        together += tmp_id;
-        together += R"(", "block": )";
-        together += block_str;
-        together += R"(, "state": )";
-        together += state;
-        together += "}";
-
-        //        json together = {{"id", std::move(id)}, {"block", std::move(block->second)}, {"state", std::move(state)}};
-        joined.emplace_back(std::move(together));
-        blocks.erase(block);
-      }
-
-      if (joined.size() >= buffer_size) {
-        dump();
-      }
-    }
-  }
-
-  void addError(std::string id, std::string type) {
-    LOG(ERROR) << "We have error in " << id << " in " << type;
-    json data;
-    data = {
-        {"id", id},
-        {"type", type},
-    };
-
-    error.emplace_back(std::move(data));
-  }
-
-  void forceDump() {
-    LOG(INFO) << "Force dump of what is left";
-    dump();
-    dumpLoners();
-    dumpError();
-    LOG(INFO) << "Finished force dumping";
-  }
-
- public:
-  void dump() {
-    if (joined.empty()) {
-      return;
-    }
-
-    std::lock_guard lock(dump_mtx);
-
-    const auto dumped_amount = joined.size();
-
-    std::string to_dump = "[";
-    std::string to_dump_ids = "[";
-
-    if (!joined.empty()) {
-      while (!joined.empty()) {
-        std::string tmp = joined.back();
-        joined.pop_back();
-        to_dump += tmp;
-        to_dump += ",";
-      }
-      to_dump.pop_back();
-
-      while (!joined_ids.empty()) {
-        std::string tmp = joined_ids.back();
-        joined_ids.pop_back();
-
-        to_dump_ids += "\"";
-        to_dump_ids += tmp;
-        to_dump_ids += "\",";
-      }
-      to_dump_ids.pop_back();
-    }
-
-    to_dump += "]";
-    to_dump_ids += "]";
-
-    auto tag =
-        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-            .count();
-
-    std::ostringstream oss;
-    oss << prefix << tag << ".json";
-    std::ofstream file(oss.str());
-    file << to_dump;
-    file.close();
-
-    std::ostringstream oss_ids;
-    oss_ids << prefix << tag << "_ids.json";
-    std::ofstream file_ids(oss_ids.str());
-    file_ids << to_dump_ids;
-    file_ids.close();
-
-    std::ostringstream done_ids;
-    done_ids << prefix << tag << "_done.json";
-    std::ofstream file_done(done_ids.str());
-    file_done << "done ids";
-    file_done.close();
-
-    LOG(WARNING) << "Dumped " << dumped_amount << " block/state pairs";
-  }
-
-  void dumpError() {
-    std::lock_guard lock(dump_mtx);
-
-    if (!error.empty()) {
-      auto tag =
-          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-              .count();
-
-      auto error_to_dump = json::array();
-      for (auto &e : error) {
-        error_to_dump.emplace_back(std::move(e));
-      }
-      error.clear();
-
-      std::ostringstream oss_ids;
-      oss_ids << prefix << tag << "_error.json";
-      std::ofstream file_ids(oss_ids.str());
-      file_ids << error_to_dump.dump(4);
-
-      LOG(INFO) << "Dumped error data";
-    }
+std::unique_ptr<Dumper> create_dumper(const std::string &type, std::string prefix, std::size_t size) {
+  if (type == "kafka") {
+    // prefix is the broker list for the kafka backend
+    return std::make_unique<DumperKafka>(std::move(prefix), size);
   }
-
-  void dumpLoners() {
-    std::lock_guard lock(dump_mtx);
-
-    const auto lone_blocks_amount = blocks.size();
-    const auto lone_states_amount = states.size();
-    if ((lone_blocks_amount == 0) & (lone_states_amount == 0)) {
-      return;
-    }
-
-    auto to_dump_ids = json::array();
-
-    auto blocks_to_dump = json::array();
-    for (auto &e : blocks) {
-      json block_json = {{"id", e.first}, {"block", std::move(e.second)}};
-      to_dump_ids.emplace_back(e.first);
-      blocks_to_dump.emplace_back(std::move(block_json));
-    }
-    blocks.clear();
-
-    auto states_to_dump = json::array();
-    for (auto &e : states) {
-      json state_json = {{"id", e.first}, {"state", std::move(e.second)}};
-      to_dump_ids.emplace_back(e.first);
-      states_to_dump.emplace_back(std::move(state_json));
-    }
-    states.clear();
-
-    json to_dump = {{"blocks", std::move(blocks_to_dump)}, {"states", std::move(states_to_dump)}};
-
-    if (lone_blocks_amount != 0 || lone_states_amount != 0) {
-      auto tag =
-          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-              .count();
-
-      std::ostringstream oss;
-      oss << prefix << "loners_" << tag << ".json";
-      std::ofstream file(oss.str());
-      file << to_dump.dump(-1);
-
-      std::ostringstream oss_ids;
-      oss_ids << prefix << "loners_" << tag << "_ids.json";
-      std::ofstream file_ids(oss_ids.str());
-      file_ids << to_dump_ids.dump(-1);
-
-      LOG(WARNING) << "Dumped " << lone_blocks_amount << " blocks without pair";
-      LOG(WARNING) << "Dumped " << lone_states_amount << " states without pair";
-    }
+  if (type == "columnar") {
+    return std::make_unique<DumperColumnar>(std::move(prefix), size);
   }
-
- private:
-  const std::string prefix;
-  std::mutex store_mtx;
-  std::mutex dump_mtx;
-  std::unordered_map<std::string, std::string> blocks;
-  std::unordered_map<std::string, std::string> states;
-  std::vector<std::string> joined;
-  std::vector<std::string> joined_ids;
-  std::vector<json> error;
-  const std::size_t buffer_size;
-};
-
-class AccountIndexer : public td::actor::Actor {
-  std::shared_ptr<vm::AugmentedDictionary> accounts;
-  std::shared_ptr<vm::AugmentedDictionary> prev_accounts;
-  td::Bits256 account;
-  std::string block_id_string;
-  WorkchainId wc;
-  td::Promise<json> promise;
-  int tx_count;
-
- public:
-  AccountIndexer(std::shared_ptr<vm::AugmentedDictionary> accounts_,
-                 std::shared_ptr<vm::AugmentedDictionary> prev_accounts_, td::Bits256 account_, int tx_count_,
-                 std::string block_id_string_, WorkchainId wc_, td::Promise<json> promise_) {
-    accounts = std::move(accounts_);
-    account = account_;
-    block_id_string = std::move(block_id_string_);
-    wc = wc_;
-    promise = std::move(promise_);
-    prev_accounts = std::move(prev_accounts_);
-    tx_count = tx_count_;
-  }
-
-  void start_up() override {
-    td::Timer timer;
-
-    try {
-      std::vector<std::tuple<int, std::string>> dummy;
-
-      auto value = accounts->lookup(account);
-      LOG(DEBUG) << "Parse accounts states got account data " << account.to_hex() << " " << block_id_string << " "
-                 << timer;
-
-      if (value.not_null()) {
-        block::gen::ShardAccount::Record sa;
-        block::gen::CurrencyCollection::Record dbi_cc;
-        CHECK(tlb::unpack(value.write(), sa));
-        LOG(DEBUG) << "Parse accounts states account data parsed " << account.to_hex() << " " << block_id_string << " "
-                   << timer;
-
-        json data;
-
-        data["account_address"] = {{"workchain", wc}, {"address", account.to_hex()}};
-
-        if (tx_count > 1) {
-          auto prev_acc = prev_accounts->lookup(account.cbits(), 256);
-
-          if (prev_acc.not_null() && (prev_acc->have_refs() || !prev_acc->empty())) {
-            vm::CellBuilder b;
-            b.append_cellslice(prev_acc);
-            const auto prev_state_acc = td::base64_encode(std_boc_serialize(b.finalize(), 31).move_as_ok());
-            data["prev_state"] = prev_state_acc;
-
-            LOG(DEBUG) << "In account " << account.to_hex()
-                       << " several transactions in one block save prev state for emulation";
-          }
-        }
-
-        data["account"] = {{"last_trans_hash", sa.last_trans_hash.to_hex()}, {"last_trans_lt", sa.last_trans_lt}};
-
-        auto account_cell = load_cell_slice(sa.account);
-        auto acc_tag = block::gen::t_Account.get_tag(account_cell);
-
-        if (acc_tag == block::gen::t_Account.account) {
-          block::gen::Account::Record_account acc;
-          block::gen::StorageInfo::Record si;
-          block::gen::AccountStorage::Record as;
-          block::gen::StorageUsed::Record su;
-          block::gen::CurrencyCollection::Record balance;
-
-          CHECK(tlb::unpack(account_cell, acc));
-
-          CHECK(tlb::unpack(acc.storage.write(), as));
-          CHECK(tlb::unpack(acc.storage_stat.write(), si));
-          CHECK(tlb::unpack(si.used.write(), su));
-          CHECK(tlb::unpack(as.balance.write(), balance));
-          LOG(DEBUG) << "Parse accounts states account main info parsed " << account.to_hex() << " " << block_id_string
-                     << " " << timer;
-
-          data["account"]["addr"] = parse_address(acc.addr.write());
-          std::string due_payment;
-
-          if (si.due_payment->prefetch_ulong(1) > 0) {
-            auto due = si.due_payment.write();
-            due.fetch_bits(1);  // maybe
-            due_payment = block::tlb::t_Grams.as_integer(due)->to_dec_string();
-          }
-
-          data["account"]["storage_stat"] = {{"last_paid", si.last_paid}, {"due_payment", due_payment}};
-
-          data["account"]["storage_stat"]["used"] = {
-              {"cells", block::tlb::t_VarUInteger_7.as_uint(su.cells.write())},
-              {"bits", block::tlb::t_VarUInteger_7.as_uint(su.bits.write())},
-          };
-
-          data["account"]["storage"] = {{"last_trans_lt", as.last_trans_lt}};
-
-          data["account"]["storage"]["balance"] = {
-              {"grams", block::tlb::t_Grams.as_integer(balance.grams)->to_dec_string()},
-              {"extra", balance.other->have_refs() ? parse_extra_currency(balance.other->prefetch_ref()) : dummy}};
-
-          LOG(DEBUG) << "Parse accounts states account storage parsed" << account.to_hex() << " " << block_id_string
-                     << " " << timer;
-
-          auto tag = block::gen::t_AccountState.get_tag(as.state.write());
-
-          if (tag == block::gen::t_AccountState.account_uninit) {
-            data["account"]["state"] = {{"type", "uninit"}};
-          }
-
-          else if (tag == block::gen::t_AccountState.account_active) {
-            block::gen::AccountState::Record_account_active active_account;
-            CHECK(tlb::unpack(as.state.write(), active_account));
-
-            data["account"]["state"] = {{"type", "active"}, {"state_init", parse_state_init(active_account.x.write())}};
-
-          }
-
-          else if (tag == block::gen::t_AccountState.account_frozen) {
-            block::gen::AccountState::Record_account_frozen f{};
-            CHECK(tlb::unpack(as.state.write(), f))
-            data["account"]["state"] = {{"type", "frozen"}, {"state_hash", f.state_hash.to_hex()}};
-          }
-
-          // SUCCESS SEND ACCOUNT
-          promise.set_value(std::move(data));
-          LOG(DEBUG) << "Parse accounts states account finally parsed " << account.to_hex() << " " << block_id_string
-                     << " " << timer;
-          stop();
-          return;
-        }
-      }
-
-      LOG(DEBUG) << "Parse accounts states account FAILED parsed " << account.to_hex() << " " << block_id_string << " "
-                 << timer;
-    } catch (std::exception &e) {
-      LOG(ERROR) << e.what() << "account error " << account.to_hex();
-    } catch (...) {
-      LOG(ERROR) << "account error " << account.to_hex();
-    }
-
-    promise.set_error(td::Status::Error(1));
-    stop();
-  }
-};
+  return std::make_unique<DumperDisk>(std::move(prefix), size);
+}
 
 class StateIndexer : public td::actor::Actor {
   Dumper *dumper_;
-  std::shared_ptr<vm::AugmentedDictionary> accounts;
-
-  bool after_merge;
-  std::shared_ptr<vm::AugmentedDictionary> prev_accounts_left;
-  ShardId prev_accounts_left_shard;
-  std::shared_ptr<vm::AugmentedDictionary> prev_accounts_right;
-  ShardId prev_accounts_right_shard;
+  std::vector<vm::Ref<vm::Cell>> prev_states;
 
   std::vector<json> json_accounts;
   std::string block_id_string;
   td::Timer timer;
   BlockIdExt block_id;
-  std::mutex accounts_mtx_;
-  std::mutex accounts_count_mtx_;
-  unsigned long total_accounts;
   json answer;
   td::Promise<td::int32> dec_promise;
   vm::Ref<vm::Cell> root_cell;
   std::vector<std::tuple<td::Bits256, int>> accounts_keys;
-  bool prev_state_received;
+  bool failed = false;
 
  public:
   StateIndexer(std::string block_id_string_, vm::Ref<vm::Cell> root_cell_,
@@ -460,11 +84,9 @@ class StateIndexer : public td::actor::Actor {
     dumper_ = dumper;
     block_id = block_id_;
     block_id_string = std::move(block_id_string_);
-    total_accounts = accounts_keys_.size();
     dec_promise = std::move(dec_promise_);
     root_cell = std::move(root_cell_);
     accounts_keys = std::move(accounts_keys_);
-    prev_state_received = false;
   }
 
   void start_up() override {
@@ -472,7 +94,7 @@ class StateIndexer : public td::actor::Actor {
       LOG(DEBUG) << "Parse accounts states " << block_id_string << " " << timer;
 
       block::gen::ShardStateUnsplit::Record shard_state;
-      CHECK(tlb::unpack_cell(std::move(root_cell), shard_state));
+      CHECK(tlb::unpack_cell(root_cell, shard_state));
 
       std::vector<std::tuple<int, std::string>> dummy;
 
@@ -592,90 +214,70 @@ class StateIndexer : public td::actor::Actor {
       }
 
       LOG(DEBUG) << "Parse accounts states libs " << block_id_string << " " << timer;
-
-      accounts = std::make_shared<vm::AugmentedDictionary>(vm::load_cell_slice_ref(shard_state.accounts), 256,
-                                                           block::tlb::aug_ShardAccounts);
     } catch (std::exception &e) {
       LOG(ERROR) << e.what() << " state error: " << block_id_string;
       dumper_->addError(block_id_string, "state");
-      td::actor::send_closure(actor_id(this), &StateIndexer::finalize);
+      failed = true;
     } catch (...) {
       dumper_->addError(block_id_string, "state");
-      td::actor::send_closure(actor_id(this), &StateIndexer::finalize);
+      failed = true;
     }
   }
 
-  void saveAccount(json data) {
-    json_accounts.emplace_back(std::move(data));
-    td::actor::send_closure(actor_id(this), &StateIndexer::skipAccount);
-  }
-
-  void skipAccount() {
-    total_accounts -= 1;
-    LOG(DEBUG) << "Parse accounts for " << block_id_string << " left " << total_accounts;
-    bool is_end = total_accounts == 0;
+  void got_prev_state(vm::Ref<vm::Cell> prev_root_cell, bool after_merge) {
+    prev_states.push_back(std::move(prev_root_cell));
 
-    if (is_end) {
-      td::actor::send_closure(actor_id(this), &StateIndexer::finalize);
+    // after a merge both previous states are needed
+    if (after_merge && prev_states.size() < 2) {
+      return;
+    }
+    if (!failed && !accounts_keys.empty()) {
+      process_accounts();
     }
+    finalize();
   }
 
-  void got_prev_state(vm::Ref<vm::Cell> prev_root_cell, bool left, bool after_merge_, ShardId shard_ident) {
-    block::gen::ShardStateUnsplit::Record prev_shard_state;
-    after_merge = after_merge_;
+  void process_accounts() {
+    LOG(DEBUG) << "Diff accounts states " << block_id_string << " " << timer;
 
-    CHECK(tlb::unpack_cell(std::move(prev_root_cell), prev_shard_state));
-
-    if (left) {
-      prev_accounts_left = std::make_shared<vm::AugmentedDictionary>(vm::load_cell_slice_ref(prev_shard_state.accounts),
-                                                                     256, block::tlb::aug_ShardAccounts);
-      prev_accounts_left_shard = shard_ident;
-    } else {
-      prev_accounts_right = std::make_shared<vm::AugmentedDictionary>(
-          vm::load_cell_slice_ref(prev_shard_state.accounts), 256, block::tlb::aug_ShardAccounts);
-      prev_accounts_right_shard = shard_ident;
+    std::map<td::Bits256, int> tx_counts;
+    for (const auto &account : accounts_keys) {
+      tx_counts.emplace(std::get<0>(account), std::get<1>(account));
     }
 
-    if (left & after_merge) {
+    auto &engine = StateDiffEngine::shared();
+    auto R = engine.diff(root_cell, std::move(prev_states));
+    if (R.is_error()) {
+      LOG(ERROR) << R.move_as_error() << " state error: " << block_id_string;
+      dumper_->addError(block_id_string, "state");
       return;
     }
+    auto changes = R.move_as_ok();
+    LOG(DEBUG) << "Parse " << changes.size() << " changed accounts " << block_id_string << " " << timer;
 
-    if (accounts_keys.empty()) {
-      td::actor::send_closure(actor_id(this), &StateIndexer::finalize);
-    } else {
-      LOG(DEBUG) << "Parse accounts states one by one " << block_id_string << " " << timer;
-
-      for (const auto &account : accounts_keys) {
-        td::actor::send_closure(actor_id(this), &StateIndexer::processAccount, std::get<0>(account),
-                                std::get<1>(account));
+    std::vector<json> parsed(changes.size());
+    engine.parallel_for(changes.size(), [&](std::size_t i) {
+      const auto &change = changes[i];
+      if (change.cur.is_null()) {
+        return;
       }
-    }
-  }
-
-  void processAccount(td::Bits256 account, int tx_count) {
-    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<json> R) {
-      if (R.is_ok()) {
-        auto data = R.move_as_ok();
-        td::actor::send_closure(SelfId, &StateIndexer::saveAccount, std::move(data));
-      } else {
-        td::actor::send_closure(SelfId, &StateIndexer::skipAccount);
+      // the state before the block is kept for emulation when the account has several transactions in it
+      auto tx_count = tx_counts.find(change.account);
+      bool with_prev = tx_count != tx_counts.end() && tx_count->second > 1;
+      try {
+        parsed[i] = parse_shard_account(change.cur, with_prev ? change.prev : Ref<vm::CellSlice>{}, change.account,
+                                        block_id.id.workchain);
+      } catch (std::exception &e) {
+        LOG(ERROR) << e.what() << "account error " << change.account.to_hex();
+      } catch (...) {
+        LOG(ERROR) << "account error " << change.account.to_hex();
       }
     });
 
-    if (!after_merge) {
-      td::actor::create_actor<AccountIndexer>("AccountIndexer", accounts, prev_accounts_left, account, tx_count,
-                                              block_id_string, block_id.id.workchain, std::move(P))
-          .release();
-    } else {
-      auto shard_id = ton::shard_prefix(account, 60);
-      if (ton::shard_is_ancestor(prev_accounts_left_shard, shard_id)) {
-        td::actor::create_actor<AccountIndexer>("AccountIndexer", accounts, prev_accounts_left, account, tx_count,
-                                                block_id_string, block_id.id.workchain, std::move(P))
-            .release();
-      } else {
-        td::actor::create_actor<AccountIndexer>("AccountIndexer", accounts, prev_accounts_right, account, tx_count,
-                                                block_id_string, block_id.id.workchain, std::move(P))
-            .release();
+    json_accounts.reserve(parsed.size());
+    for (auto &data : parsed) {
+      if (!data.is_null()) {
+        json_accounts.emplace_back(std::move(data));
       }
     }
   }
@@ -684,19 +286,21 @@ class StateIndexer : public td::actor::Actor {
     answer["accounts"] = json_accounts;
     LOG(DEBUG) << "Parse accounts states all accounts parsed " << block_id_string << " " << timer;
 
-    std::string final_json;
     std::string final_id = std::to_string(block_id.id.workchain) + ":" + std::to_string(block_id.id.shard) + ":" +
                            std::to_string(block_id.id.seqno);
 
     try {
-      final_json = answer.dump(-1);
+      if (dumper_->isCommitted(final_id, true)) {
+        LOG(DEBUG) << "State " << final_id << " already committed, skip";
+      } else {
+        dumper_->storeStateJson(std::move(final_id), std::move(answer));
+      }
     } catch (...) {
-      LOG(ERROR) << "Cant dump state: " << final_id;
+      LOG(ERROR) << "Cant dump state: " << block_id.to_str();
 
       LOG(WARNING) << "Calling std::exit(0)";
       std::exit(0);
     }
-    dumper_->storeState(std::move(final_id), std::move(final_json));
 
     LOG(DEBUG) << "received & parsed state from db " << block_id.to_str();
     dec_promise(1);
@@ -710,6 +314,9 @@ class IndexerWorker : public td::actor::Actor {
 
   BlockSeqno seqno_first_ = 0;
   BlockSeqno seqno_last_ = 0;
+  // range as assigned by Indexer, the checkpoint key of this worker
+  BlockSeqno range_first_ = 0;
+  BlockSeqno range_last_ = 0;
   int block_padding_ = 0;
   int state_padding_ = 0;
   td::uint32 chunk_size_ = 20000;
@@ -801,6 +408,18 @@ class IndexerWorker : public td::actor::Actor {
   void set_seqno_range(BlockSeqno seqno_first, BlockSeqno seqno_last) {
     seqno_first_ = seqno_first;
     seqno_last_ = seqno_last;
+    range_first_ = seqno_first;
+    range_last_ = seqno_last;
+
+    auto checkpoint = dumper_->getCheckpoint();
+    if (checkpoint != nullptr) {
+      auto done = checkpoint->progress(range_first_, range_last_);
+      if (done > seqno_first_) {
+        LOG(WARNING) << "IndexerWorker #" << my_id << " resumes range " << range_first_ << ":" << range_last_
+                     << " from MC " << done;
+        seqno_first_ = done;
+      }
+    }
   }
   void set_chunk_size(td::uint32 size) {
     chunk_size_ = size;
@@ -813,6 +432,13 @@ class IndexerWorker : public td::actor::Actor {
     validator_manager_ = std::move(v);
     shutdown_promise = std::move(promise);
 
+    if (seqno_first_ >= seqno_last_) {
+      LOG(WARNING) << "IndexerWorker #" << my_id << " range " << range_first_ << ":" << range_last_
+                   << " is already committed";
+      shutdown();
+      return;
+    }
+
     // separate first parse seqno to prevent WC shard seqno leak
     auto P = td::PromiseCreator::lambda([SelfId = actor_id(this),
                                          seqno_first = seqno_first_](td::Result<ConstBlockHandle> R) {
@@ -1523,16 +1149,6 @@ class IndexerWorker : public td::actor::Actor {
 
         std::string final_id =
             std::to_string(workchain) + ":" + std::to_string(blkid.id.shard) + ":" + std::to_string(blkid.seqno());
-        std::string final_json;
-
-        try {
-          final_json = answer.dump(-1);
-        } catch (...) {
-          LOG(ERROR) << "Can't dump block: " << final_id;
-
-          LOG(WARNING) << "Calling std::exit(0)";
-          std::exit(0);
-        }
 
         if ((is_first && !info.not_master)) {
           LOG(DEBUG) << "First block, start parse other: " << blkid.to_str() << " " << timer;
@@ -1541,7 +1157,18 @@ class IndexerWorker : public td::actor::Actor {
           return;
         }
 
-        dumper_->storeBlock(std::move(final_id), std::move(final_json));
+        try {
+          if (dumper_->isCommitted(final_id, false)) {
+            LOG(DEBUG) << "Block " << final_id << " already committed, skip";
+          } else {
+            dumper_->storeBlockJson(std::move(final_id), std::move(answer));
+          }
+        } catch (...) {
+          LOG(ERROR) << "Can't dump block: " << blkid.to_str();
+
+          LOG(WARNING) << "Calling std::exit(0)";
+          std::exit(0);
+        }
         td::actor::send_closure(SelfId, &IndexerWorker::decrease_block_padding);
 
         if (skip_state) {
@@ -1549,7 +1176,9 @@ class IndexerWorker : public td::actor::Actor {
                      std::to_string(blkid.id.seqno);
           LOG(DEBUG) << "Skip state: " << key;
 
-          dumper_->storeState(std::move(key), R"({"skip": true})");
+          if (!dumper_->isCommitted(key, true)) {
+            dumper_->storeState(std::move(key), R"({"skip": true})");
+          }
         }
       }
     });
@@ -1627,6 +1256,10 @@ class IndexerWorker : public td::actor::Actor {
 
       LOG(WARNING) << "Current chunk: " << chunk_current_ << " chunk count: " << chunk_count_;
 
+      if (chunk_current_ > 0) {
+        commit_progress(td::min(seqno_last_, seqno_first_ + (chunk_size_ * chunk_current_)));
+      }
+
       if (chunk_current_ <= chunk_count_ - 1) {
         LOG(WARNING) << "Call parse next chunk";
 
@@ -1697,19 +1330,38 @@ class IndexerWorker : public td::actor::Actor {
     shutdown_promise.set_value(0);
   }
 
+  // Everything up to MC `done` is stored: flush it to committed files, then record the range progress
+  void commit_progress(BlockSeqno done) {
+    auto checkpoint = dumper_->getCheckpoint();
+    if (checkpoint == nullptr) {
+      return;
+    }
+
+    auto S = dumper_->forceDump();
+    if (S.is_error()) {
+      // the checkpoint must not move past records which were lost, a resumed run stores them again
+      LOG(ERROR) << "Can't flush MC " << done << ", progress is not committed: " << S;
+      std::_Exit(2);
+    }
+    S = checkpoint->commitProgress(range_first_, range_last_, done);
+    if (S.is_error()) {
+      LOG(ERROR) << "Can't write checkpoint: " << S;
+      std::_Exit(2);
+    }
+    LOG(WARNING) << "IndexerWorker #" << my_id << " committed MC " << done;
+  }
+
   void got_prev_block_handle(std::shared_ptr<const BlockHandleInterface> handle,
-                             td::actor::ActorId<StateIndexer> state_indexer, bool left, bool after_merge) {
-    auto shard = handle->id().id.shard;
+                             td::actor::ActorId<StateIndexer> state_indexer, bool after_merge) {
     auto P = td::PromiseCreator::lambda(
-        [state_indexer = std::move(state_indexer), left, after_merge, shard](td::Result<td::Ref<vm::DataCell>> R) {
+        [state_indexer = std::move(state_indexer), after_merge](td::Result<td::Ref<vm::DataCell>> R) {
           if (R.is_error()) {
             // todo: process normally
             LOG(ERROR) << R.move_as_error().to_string() << " state error fatal";
             std::exit(2);
           } else {
             auto root_cell = R.move_as_ok();
-            td::actor::send_closure(state_indexer, &StateIndexer::got_prev_state, std::move(root_cell), left,
-                                    after_merge, shard);
+            td::actor::send_closure(state_indexer, &StateIndexer::got_prev_state, std::move(root_cell), after_merge);
           }
         });
 
@@ -1724,8 +1376,7 @@ class IndexerWorker : public td::actor::Actor {
     if (handle->id().id.seqno == 1) {
         auto P = td::PromiseCreator::lambda(
                 [state_indexer = std::move(state_indexer),
-                 after_merge,
-                 shard = handle->id().id.shard](td::Result<td::BufferSlice> R) {
+                 after_merge](td::Result<td::BufferSlice> R) {
                     if (R.is_error()) {
                         // todo: process normally
                         LOG(ERROR) << R.move_as_error().to_string() << " state error fatal";
@@ -1738,8 +1389,8 @@ class IndexerWorker : public td::actor::Actor {
                         }
                         auto root_cell = R2.move_as_ok();
 
-                        td::actor::send_closure(state_indexer, &StateIndexer::got_prev_state, std::move(root_cell), true,
-                                                after_merge, shard);
+                        td::actor::send_closure(state_indexer, &StateIndexer::got_prev_state, std::move(root_cell),
+                                                after_merge);
                     }
                 });
 
@@ -1752,7 +1403,7 @@ class IndexerWorker : public td::actor::Actor {
                         LOG(ERROR) << R.move_as_error().to_string() << " state handle error fatal";
                         std::exit(2);
                     } else {
-                        td::actor::send_closure(SelfId, &IndexerWorker::got_prev_block_handle, R.move_as_ok(), state_indexer, true,
+                        td::actor::send_closure(SelfId, &IndexerWorker::got_prev_block_handle, R.move_as_ok(), state_indexer,
                                                 after_merge);
                     }
                 });
@@ -1772,7 +1423,7 @@ class IndexerWorker : public td::actor::Actor {
                     LOG(ERROR) << R.move_as_error().to_string() << " state handle error fatal";
                     std::exit(2);
                 } else {
-                    td::actor::send_closure(SelfId, &IndexerWorker::got_prev_block_handle, R.move_as_ok(), state_indexer, false,
+                    td::actor::send_closure(SelfId, &IndexerWorker::got_prev_block_handle, R.move_as_ok(), state_indexer,
                                             after_merge);
                 }
             });
@@ -1826,8 +1477,17 @@ class Indexer : public td::actor::Actor {
  public:
   Indexer(td::uint32 threads_, std::string db_root, std::string config_path, td::uint32 chunk_size,
           std::vector<std::tuple<ton::BlockSeqno, ton::BlockSeqno>> seqno_s_,
-          std::vector<std::tuple<ton::WorkchainId, ton::BlockSeqno>> whitelist_, bool speed, int dumper_size = 5000) {
-    dumper_ = std::make_unique<Dumper>("dump_", dumper_size);
+          std::vector<std::tuple<ton::WorkchainId, ton::BlockSeqno>> whitelist_, bool speed, int dumper_size = 5000,
+          std::string dumper_type = "disk", std::string kafka_endpoint = "", bool resume = false,
+          std::string prefix = "dump_") {
+    dumper_ = create_dumper(dumper_type, dumper_type == "kafka" ? kafka_endpoint : prefix, dumper_size);
+    checkpoint_ = std::make_unique<Checkpoint>(prefix + "checkpoint.log");
+    auto S = checkpoint_->open(resume);
+    if (S.is_error()) {
+      LOG(ERROR) << "Can't open checkpoint: " << S;
+      std::_Exit(2);
+    }
+    dumper_->setCheckpoint(checkpoint_.get());
     seqno_s = std::move(seqno_s_);
     whitelist = std::move(whitelist_);
     threads = threads_;
@@ -1848,7 +1508,8 @@ class Indexer : public td::actor::Actor {
     }
 
     auto blocks_size = seqno_last - seqno_first;
-    auto workers_count = std::min(blocks_size, threads);
+    // the range is inclusive, a one-seqno range still needs its worker
+    auto workers_count = std::max(std::min(blocks_size, threads), 1u);
 
     LOG(WARNING) << "Current chunk size: " << chunk_size_ << " Workers: " << workers_count;
     LOG(WARNING) << "Total Masterchain seqno: " << seqno_last - seqno_first;
@@ -2010,6 +1671,8 @@ class Indexer : public td::actor::Actor {
   std::string global_config_;
   std::mutex display_mtx_;
   td::uint32 chunk_size_ = 20000;
+  // declared before dumper_: the dumper commits its last files on destruction
+  std::unique_ptr<Checkpoint> checkpoint_;
   std::unique_ptr<Dumper> dumper_;
   bool speed_;
   td::uint32 threads;
@@ -2079,8 +1742,12 @@ class Indexer : public td::actor::Actor {
       if (seqno_s.empty()) {
         LOG(INFO) << "Ready to die";
         ///TODO: danger danger
+        auto S = dumper_->forceDump();
+        if (S.is_error()) {
+          LOG(ERROR) << "Final flush failed: " << S;
+          std::exit(2);
+        }
         LOG(WARNING) << "Calling std::exit(0)";
-        dumper_->forceDump();
         std::exit(0);
       } else {
         w_stopped = 0;
@@ -2100,7 +1767,8 @@ class Indexer : public td::actor::Actor {
         seqno_last = std::get<1>(t);
 
         auto blocks_size = seqno_last - seqno_first;
-        auto workers_count = std::min(blocks_size, threads);
+        // the range is inclusive, a one-seqno range still needs its worker
+        auto workers_count = std::max(std::min(blocks_size, threads), 1u);
 
         LOG(WARNING) << "Current chunk size: " << chunk_size_ << " Workers: " << workers_count;
         LOG(WARNING) << "Total Masterchain seqno: " << seqno_last - seqno_first;
@@ -2155,8 +1823,17 @@ class IndexerSimple : public td::actor::Actor {
  public:
   IndexerSimple(td::uint32 threads_, std::string db_root, std::string config_path,
                 std::vector<std::tuple<ton::WorkchainId, ton::ShardId, ton::BlockSeqno>> whitelist_, bool speed,
-                int dumper_size = 5000) {
-    dumper_ = std::make_unique<Dumper>("dump_", dumper_size);
+                int dumper_size = 5000, std::string dumper_type = "disk", std::string kafka_endpoint = "",
+                bool resume = false, std::string prefix = "dump_") {
+    dumper_ = create_dumper(dumper_type, dumper_type == "kafka" ? kafka_endpoint : prefix, dumper_size);
+    // the whitelist has no ranges to resume, committed blocks and states are skipped by the dumper
+    checkpoint_ = std::make_unique<Checkpoint>(prefix + "checkpoint.log");
+    auto S = checkpoint_->open(resume);
+    if (S.is_error()) {
+      LOG(ERROR) << "Can't open checkpoint: " << S;
+      std::_Exit(2);
+    }
+    dumper_->setCheckpoint(checkpoint_.get());
     whitelist = std::move(whitelist_);
     threads = threads_;
     speed_ = speed;
@@ -2293,6 +1970,7 @@ class IndexerSimple : public td::actor::Actor {
   std::string global_config_;
   std::mutex display_mtx_;
   td::uint32 chunk_size_ = 20000;
+  std::unique_ptr<Checkpoint> checkpoint_;
   std::unique_ptr<Dumper> dumper_;
   bool speed_;
   td::uint32 threads;
@@ -2359,8 +2037,12 @@ class IndexerSimple : public td::actor::Actor {
 
     if (w_stopped >= workers.size()) {
       LOG(INFO) << "Ready to die";
+      auto S = dumper_->forceDump();
+      if (S.is_error()) {
+        LOG(ERROR) << "Final flush failed: " << S;
+        std::exit(2);
+      }
       LOG(WARNING) << "Calling std::exit(0)";
-      dumper_->forceDump();
       std::exit(0);
     } else {
       LOG(WARNING) << "Ready to die, but some active workers: " << workers.size() - w_stopped;
@@ -2423,6 +2105,15 @@ int main(int argc, char **argv) {
   std::vector<std::tuple<ton::WorkchainId, ton::BlockSeqno>> whitelist;
   std::vector<std::tuple<ton::WorkchainId, ton::ShardId, ton::BlockSeqno>> whitelist_simple;
   int dump_size = 5000;
+  std::string dumper_type = "disk";
+  std::string kafka_endpoint;
+  bool resume = false;
+  std::string prefix = "dump_";
+  bool verbosity_set = false;
+  std::string whitelist_path;
+  td::uint32 processes = 0;
+  td::uint32 lease_size = 10000;
+  td::uint32 parse_cache_mb = 64;
 
   p.set_description("blockchain indexer");
   p.add_option('h', "help", "prints_help", [&]() {
@@ -2440,6 +2131,7 @@ int main(int argc, char **argv) {
                        });
   p.add_checked_option('v', "verbosity", "set verbosity level", [&](td::Slice arg) {
     verbosity = td::to_integer<int>(arg);
+    verbosity_set = true;
     SET_VERBOSITY_LEVEL(VERBOSITY_NAME(FATAL) + verbosity);
     return (verbosity >= 0 && verbosity <= 9) ? td::Status::OK() : td::Status::Error("verbosity must be 0..9");
   });
@@ -2448,9 +2140,60 @@ int main(int argc, char **argv) {
     dump_size = td::to_integer<int>(arg);
     return td::Status::OK();
   });
+  p.add_checked_option('o', "output-format", "dump format: disk (json files, default) or columnar (lz4 row groups)",
+                       [&](td::Slice arg) {
+                         dumper_type = arg.str();
+                         if (dumper_type != "disk" && dumper_type != "columnar") {
+                           return td::Status::Error(ton::ErrorCode::error, "bad value for --output-format");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_option('K', "kafka", "stream blocks/states to kafka <endpoint> instead of files (-g is max in-flight messages)",
+               [&](td::Slice arg) {
+                 dumper_type = "kafka";
+                 kafka_endpoint = arg.str();
+               });
+  p.add_option('r', "resume", "continue from <prefix>checkpoint.log: skip committed ranges, blocks and states",
+               [&]() { resume = true; });
+  p.add_option('O', "output-prefix", "prefix of output files and of the checkpoint log (default=dump_)",
+               [&](td::Slice arg) { prefix = arg.str(); });
+  p.add_checked_option('P', "processes",
+                       "backfill the --seqno ranges with <N> indexer processes, each with its own read-only db "
+                       "(--threads is per process)",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(processes, td::to_integer_safe<td::uint32>(arg));
+                         if (processes < 1 || processes > 256) {
+                           return td::Status::Error(ton::ErrorCode::error, "bad value for --processes");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('L', "lease-size", PSTRING() << "masterchain seqnos per process lease (default=" << lease_size
+                                                    << ")",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(lease_size, td::to_integer_safe<td::uint32>(arg));
+                         if (lease_size < 2) {
+                           return td::Status::Error(ton::ErrorCode::error, "bad value for --lease-size");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('M', "parse-cache", PSTRING() << "parsed message / state init cache per thread in MB, 0 to disable "
+                                                     << "(default=" << parse_cache_mb << ")",
+                       [&](td::Slice arg) {
+                         TRY_RESULT_ASSIGN(parse_cache_mb, td::to_integer_safe<td::uint32>(arg));
+                         JsonCache::set_shard_limit(static_cast<std::size_t>(parse_cache_mb) << 20);
+                         return td::Status::OK();
+                       });
   p.add_checked_option('u', "user", "change user", [&](td::Slice user) { return td::change_user(user.str()); });
   p.add_option('D', "db", "root for dbs", [&](td::Slice fname) { db_root = fname.str(); });
   p.add_option('C', "config", "global config path", [&](td::Slice fname) { config_path = fname.str(); });
+  std::string secondary_root;
+  p.add_option('R', "secondary-db",
+               "open dbs as secondary instances of a running node, with private files under <dir>, and follow its "
+               "writes",
+               [&](td::Slice dir) {
+                 secondary_root = dir.str();
+                 td::RocksDb::set_secondary_root(secondary_root);
+               });
   td::uint32 threads = 7;
   p.add_checked_option(
       't', "threads", PSTRING() << "number of threads (default=" << threads << ")", [&](td::Slice arg) {
@@ -2536,6 +2279,7 @@ int main(int argc, char **argv) {
   });
 
   p.add_option('w', "whitelistFile", "seqno_first[:seqno_last]\tseqno file", [&](td::Slice arg) {
+    whitelist_path = arg.str();
     std::ifstream file(arg.str());
     if (!file.is_open()) {
       std::cerr << "Failed to open the file." << std::endl;
@@ -2688,17 +2432,60 @@ int main(int argc, char **argv) {
     std::_Exit(2);
   }
 
+  if (processes > 0) {
+    if (simple || seqno_s.empty()) {
+      std::cerr << "--processes needs --seqno or --seqnoFile ranges" << std::endl;
+      std::_Exit(2);
+    }
+
+    BackfillCoordinator::Options options;
+    auto self_path = td::realpath("/proc/self/exe");
+    options.self_path = self_path.is_ok() ? self_path.move_as_ok() : std::string(argv[0]);
+    options.child_args = {"-D", db_root, "-C", config_path, "-t", std::to_string(threads), "-g",
+                          std::to_string(dump_size), "-M", std::to_string(parse_cache_mb), "-S", "false"};
+    if (dumper_type == "kafka") {
+      options.child_args.insert(options.child_args.end(), {"-K", kafka_endpoint});
+    } else {
+      options.child_args.insert(options.child_args.end(), {"-o", dumper_type});
+    }
+    if (!chunk_size.empty()) {
+      options.child_args.insert(options.child_args.end(), {"-c", chunk_size});
+    }
+    if (verbosity_set) {
+      options.child_args.insert(options.child_args.end(), {"-v", std::to_string(verbosity)});
+    }
+    if (!whitelist_path.empty()) {
+      options.child_args.insert(options.child_args.end(), {"-w", whitelist_path});
+    }
+    if (!secondary_root.empty()) {
+      options.child_args.insert(options.child_args.end(), {"-R", secondary_root});
+    }
+    options.prefix = prefix;
+    options.processes = processes;
+    options.lease_size = lease_size;
+    options.resume = resume;
+
+    auto S = BackfillCoordinator(std::move(options)).run(seqno_s);
+    if (S.is_error()) {
+      LOG(ERROR) << "Backfill failed: " << S;
+      return 1;
+    }
+    return 0;
+  }
+
   td::actor::set_debug(true);
   td::actor::Scheduler scheduler({threads});
   scheduler.run_in_context([&] {
     TRY_RESULT(size, td::to_integer_safe<ton::BlockSeqno>(chunk_size));
     if (!simple) {
       td::actor::create_actor<ton::validator::Indexer>("CoolBlockIndexer", threads, db_root, config_path, size,
-                                                       std::move(seqno_s), std::move(whitelist), speed, dump_size)
+                                                       std::move(seqno_s), std::move(whitelist), speed, dump_size,
+                                                       dumper_type, kafka_endpoint, resume, prefix)
           .release();
     } else {
       td::actor::create_actor<ton::validator::IndexerSimple>("CoolBlockSimpleIndexer", threads, db_root, config_path,
-                                                             std::move(whitelist_simple), speed, dump_size)
+                                                             std::move(whitelist_simple), speed, dump_size,
+                                                             dumper_type, kafka_endpoint, resume, prefix)
           .release();
     }
 
@@ -1,9 +1,11 @@
 #include "json-utils.hpp"
 #include "td/utils/Timer.h"
 #include <string>
+#include <atomic>
 #include <cassert>
 #include <codecvt>
 #include <iostream>
+#include <list>
 #include <locale>
 #include <sstream>
 #include <string>
@@ -66,9 +68,143 @@ bool clear_cache() {
   std::lock_guard<std::mutex> lock(cache_mtx);
 
   cache.clear();
+
+  auto stats = JsonCache::stats();
+  LOG(INFO) << "JSON cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+            << " evictions, " << stats.bytes << " bytes";
   return true;
 }
 
+namespace {
+
+std::atomic<std::size_t> json_cache_shard_limit{64 << 20};
+std::atomic<td::uint64> json_cache_hits{0};
+std::atomic<td::uint64> json_cache_misses{0};
+std::atomic<td::uint64> json_cache_evictions{0};
+std::atomic<td::int64> json_cache_bytes{0};
+
+// Rough heap footprint of a parsed fragment, dominated by the base64 BOC strings
+std::size_t json_bytes(const json &value) {
+  std::size_t size = sizeof(json);
+  if (value.is_string()) {
+    size += value.get_ref<const std::string &>().size();
+  } else if (value.is_object()) {
+    for (auto &item : value.items()) {
+      size += item.key().size() + json_bytes(item.value());
+    }
+  } else if (value.is_array()) {
+    for (auto &item : value) {
+      size += json_bytes(item);
+    }
+  }
+  return size;
+}
+
+class JsonCacheShard {
+ public:
+  ~JsonCacheShard() {
+    json_cache_bytes -= static_cast<td::int64>(bytes_);
+  }
+
+  bool lookup(JsonCache::Kind kind, const vm::CellHash &hash, json &value) {
+    auto it = index_.find(Key{hash, kind});
+    if (it == index_.end()) {
+      return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    value = it->second->value;
+    return true;
+  }
+
+  void store(JsonCache::Kind kind, const vm::CellHash &hash, const json &value, std::size_t limit) {
+    Key key{hash, kind};
+    if (index_.count(key) != 0) {
+      return;
+    }
+    auto size = json_bytes(value);
+    if (size > limit) {
+      return;
+    }
+
+    lru_.push_front(Entry{key, value, size});
+    index_.emplace(key, lru_.begin());
+    bytes_ += size;
+    json_cache_bytes += static_cast<td::int64>(size);
+
+    while (bytes_ > limit) {
+      auto &last = lru_.back();
+      bytes_ -= last.size;
+      json_cache_bytes -= static_cast<td::int64>(last.size);
+      index_.erase(last.key);
+      lru_.pop_back();
+      json_cache_evictions++;
+    }
+  }
+
+ private:
+  struct Key {
+    vm::CellHash hash;
+    JsonCache::Kind kind;
+
+    bool operator==(const Key &other) const {
+      return kind == other.kind && hash == other.hash;
+    }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      return std::hash<vm::CellHash>()(key.hash) + key.kind;
+    }
+  };
+  struct Entry {
+    Key key;
+    json value;
+    std::size_t size;
+  };
+
+  std::list<Entry> lru_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  std::size_t bytes_ = 0;
+};
+
+JsonCacheShard &json_cache_shard() {
+  static thread_local JsonCacheShard shard;
+  return shard;
+}
+
+}  // namespace
+
+void JsonCache::set_shard_limit(std::size_t bytes) {
+  json_cache_shard_limit = bytes;
+}
+
+JsonCache::Stats JsonCache::stats() {
+  Stats stats;
+  stats.hits = json_cache_hits;
+  stats.misses = json_cache_misses;
+  stats.evictions = json_cache_evictions;
+  stats.bytes = json_cache_bytes;
+  return stats;
+}
+
+bool JsonCache::lookup(Kind kind, const vm::CellHash &hash, json &value) {
+  if (json_cache_shard_limit == 0) {
+    return false;
+  }
+  if (json_cache_shard().lookup(kind, hash, value)) {
+    json_cache_hits++;
+    return true;
+  }
+  json_cache_misses++;
+  return false;
+}
+
+void JsonCache::store(Kind kind, const vm::CellHash &hash, const json &value) {
+  auto limit = json_cache_shard_limit.load();
+  if (limit != 0) {
+    json_cache_shard().store(kind, hash, value, limit);
+  }
+}
+
 json parse_address(vm::CellSlice address) {
   json answer;
 
@@ -151,6 +287,12 @@ json parse_address(vm::CellSlice address) {
 }
 
 json parse_libraries(Ref<vm::Cell> lib_cell) {
+  auto hash = lib_cell->get_hash();
+  return JsonCache::get_or_parse(JsonCache::Libraries, hash,
+                                 [&] { return parse_libraries_uncached(std::move(lib_cell)); });
+}
+
+json parse_libraries_uncached(Ref<vm::Cell> lib_cell) {
   std::vector<json> libs;
 
   try {
@@ -182,6 +324,12 @@ json parse_libraries(Ref<vm::Cell> lib_cell) {
 }
 
 json parse_state_init(vm::CellSlice state_init) {
+  auto hash = vm::CellBuilder().append_cellslice(state_init).finalize_novm()->get_hash();
+  return JsonCache::get_or_parse(JsonCache::StateInit, hash,
+                                 [&] { return parse_state_init_uncached(std::move(state_init)); });
+}
+
+json parse_state_init_uncached(vm::CellSlice state_init) {
   td::Timer t;
   LOG(DEBUG) << "Start parse state init " << t;
 
@@ -303,6 +451,12 @@ std::string parse_snake_data_string(vm::CellSlice &cs, bool convert_to_utf8 = tr
 }
 
 json parse_message(Ref<vm::Cell> message_any) {
+  auto hash = message_any->get_hash();
+  return JsonCache::get_or_parse(JsonCache::Message, hash,
+                                 [&] { return parse_message_uncached(std::move(message_any)); });
+}
+
+json parse_message_uncached(Ref<vm::Cell> message_any) {
   // int_msg_info$0
   // ext_in_msg_info$10
   // ext_out_msg_info$11
@@ -1252,3 +1406,78 @@ json parse_out_msg(vm::CellSlice out_msg, int workchain) {
 
   return answer;
 }
+
+json parse_shard_account(const Ref<vm::CellSlice> &value, const Ref<vm::CellSlice> &prev_value,
+                         const td::Bits256 &account, int workchain) {
+  std::vector<std::tuple<int, std::string>> dummy;
+
+  block::gen::ShardAccount::Record sa;
+  CHECK(tlb::csr_unpack(value, sa));
+
+  json data;
+  data["account_address"] = {{"workchain", workchain}, {"address", account.to_hex()}};
+
+  if (prev_value.not_null() && (prev_value->have_refs() || !prev_value->empty())) {
+    vm::CellBuilder b;
+    b.append_cellslice(prev_value);
+    data["prev_state"] = td::base64_encode(vm::std_boc_serialize(b.finalize(), 31).move_as_ok());
+  }
+
+  data["account"] = {{"last_trans_hash", sa.last_trans_hash.to_hex()}, {"last_trans_lt", sa.last_trans_lt}};
+
+  auto account_cell = vm::load_cell_slice(sa.account);
+  if (block::gen::t_Account.get_tag(account_cell) != block::gen::t_Account.account) {
+    return {};
+  }
+
+  block::gen::Account::Record_account acc;
+  block::gen::StorageInfo::Record si;
+  block::gen::AccountStorage::Record as;
+  block::gen::StorageUsed::Record su;
+  block::gen::CurrencyCollection::Record balance;
+
+  CHECK(tlb::unpack(account_cell, acc));
+  CHECK(tlb::unpack(acc.storage.write(), as));
+  CHECK(tlb::unpack(acc.storage_stat.write(), si));
+  CHECK(tlb::unpack(si.used.write(), su));
+  CHECK(tlb::unpack(as.balance.write(), balance));
+
+  data["account"]["addr"] = parse_address(acc.addr.write());
+  std::string due_payment;
+
+  if (si.due_payment->prefetch_ulong(1) > 0) {
+    auto due = si.due_payment.write();
+    due.fetch_bits(1);  // maybe
+    due_payment = block::tlb::t_Grams.as_integer(due)->to_dec_string();
+  }
+
+  data["account"]["storage_stat"] = {{"last_paid", si.last_paid}, {"due_payment", due_payment}};
+
+  data["account"]["storage_stat"]["used"] = {
+      {"cells", block::tlb::t_VarUInteger_7.as_uint(su.cells.write())},
+      {"bits", block::tlb::t_VarUInteger_7.as_uint(su.bits.write())},
+  };
+
+  data["account"]["storage"] = {{"last_trans_lt", as.last_trans_lt}};
+
+  data["account"]["storage"]["balance"] = {
+      {"grams", block::tlb::t_Grams.as_integer(balance.grams)->to_dec_string()},
+      {"extra", balance.other->have_refs() ? parse_extra_currency(balance.other->prefetch_ref()) : dummy}};
+
+  auto tag = block::gen::t_AccountState.get_tag(as.state.write());
+
+  if (tag == block::gen::t_AccountState.account_uninit) {
+    data["account"]["state"] = {{"type", "uninit"}};
+  } else if (tag == block::gen::t_AccountState.account_active) {
+    block::gen::AccountState::Record_account_active active_account;
+    CHECK(tlb::unpack(as.state.write(), active_account));
+
+    data["account"]["state"] = {{"type", "active"}, {"state_init", parse_state_init(active_account.x.write())}};
+  } else if (tag == block::gen::t_AccountState.account_frozen) {
+    block::gen::AccountState::Record_account_frozen f{};
+    CHECK(tlb::unpack(as.state.write(), f))
+    data["account"]["state"] = {{"type", "frozen"}, {"state_hash", f.state_hash.to_hex()}};
+  }
+
+  return data;
+}
@@ -35,11 +35,15 @@ std::string parseblock_snake_data_string(vm::CellSlice &cs, bool convert_to_utf8
 
 json parse_address(vm::CellSlice address);
 
+// parse_libraries, parse_state_init and parse_message go through JsonCache, the _uncached variants always parse
 json parse_libraries(Ref<vm::Cell> lib_cell);
+json parse_libraries_uncached(Ref<vm::Cell> lib_cell);
 
 json parse_state_init(vm::CellSlice state_init);
+json parse_state_init_uncached(vm::CellSlice state_init);
 
 json parse_message(Ref<vm::Cell> message_any);
+json parse_message_uncached(Ref<vm::Cell> message_any);
 
 json parse_intermediate_address(vm::CellSlice intermediate_address);
 
@@ -71,6 +75,46 @@ json parse_in_msg(vm::CellSlice in_msg, int workchain);
 
 json parse_out_msg(vm::CellSlice out_msg, int workchain);
 
+// ShardAccount `value` as published by the indexers, null for accounts that are not account$1.
+// prev_value (the account before the block) is attached as a BOC when non-null, for emulation.
+json parse_shard_account(const Ref<vm::CellSlice> &value, const Ref<vm::CellSlice> &prev_value,
+                         const td::Bits256 &account, int workchain);
+
 bool clear_cache();
 
+// Bounded memo of parsed JSON fragments keyed by cell hash, for cells that show up again and again: the in_msg of a
+// transaction is the out_msg of another one, popular contracts share code, data and libraries. Every thread has its
+// own LRU shard (no locking on the parse path) limited to shard_limit bytes of estimated JSON size, hits / misses /
+// evictions are counted over all shards.
+class JsonCache {
+ public:
+  enum Kind : td::uint8 { Message = 0, StateInit = 1, Libraries = 2 };
+
+  struct Stats {
+    td::uint64 hits = 0;
+    td::uint64 misses = 0;
+    td::uint64 evictions = 0;
+    td::int64 bytes = 0;
+  };
+
+  // Byte limit of every per-thread shard, 0 disables caching
+  static void set_shard_limit(std::size_t bytes);
+  static Stats stats();
+
+  template <class F>
+  static json get_or_parse(Kind kind, const vm::CellHash &hash, F &&parse) {
+    json value;
+    if (lookup(kind, hash, value)) {
+      return value;
+    }
+    value = parse();
+    store(kind, hash, value);
+    return value;
+  }
+
+ private:
+  static bool lookup(Kind kind, const vm::CellHash &hash, json &value);
+  static void store(Kind kind, const vm::CellHash &hash, const json &value);
+};
+
 #endif  //TON_JSON_UTILS_HPP
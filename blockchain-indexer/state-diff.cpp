@@ -0,0 +1,243 @@
+#include "state-diff.hpp"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "ton/ton-shard.h"
+#include "vm/dict.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace ton {
+
+namespace validator {
+
+namespace {
+
+struct ShardAccounts {
+  ShardId shard;
+  std::unique_ptr<vm::AugmentedDictionary> dict;
+};
+
+td::Result<ShardAccounts> unpack_shard_accounts(td::Ref<vm::Cell> state) {
+  block::gen::ShardStateUnsplit::Record shard_state;
+  if (!tlb::unpack_cell(std::move(state), shard_state)) {
+    return td::Status::Error("cannot unpack ShardStateUnsplit");
+  }
+  ShardIdFull shard;
+  if (!block::tlb::t_ShardIdent.unpack(shard_state.shard_id.write(), shard)) {
+    return td::Status::Error("cannot unpack ShardIdent of shard state");
+  }
+  return ShardAccounts{shard.shard,
+                       std::make_unique<vm::AugmentedDictionary>(vm::load_cell_slice_ref(shard_state.accounts), 256,
+                                                                 block::tlb::aug_ShardAccounts)};
+}
+
+// HashmapAug root holding only the keys of `partition`; identical subtrees give identical roots in both states
+td::Ref<vm::Cell> partition_root(vm::AugmentedDictionary &dict, ShardId partition) {
+  td::BitArray<64> prefix;
+  prefix.store_ulong(partition);
+  return dict.extract_prefix_subdict_root(prefix.bits(), static_cast<int>(shard_prefix_length(partition)));
+}
+
+}  // namespace
+
+// threads - 1 workers that stay alive as long as the engine. A caller queues its job for up to count - 1 workers
+// and works on it too; workers and the caller take indices from the job until none are left.
+class StateDiffEngine::Pool {
+ public:
+  explicit Pool(td::uint32 threads) {
+    for (td::uint32 i = 1; i < threads; i++) {
+      workers_.emplace_back([this] { loop(); });
+    }
+  }
+
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void run(std::size_t count, const std::function<void(std::size_t)> &f) {
+    Job job{count, &f};
+    auto helpers = std::min<std::size_t>(workers_.size(), count > 0 ? count - 1 : 0);
+    if (helpers > 0) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job.helpers = helpers;
+        jobs_.push_back(&job);
+      }
+      job_cv_.notify_all();
+    }
+
+    job.work();
+
+    if (helpers > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // every index is taken, workers that have not joined yet must not see the job anymore
+      auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+      if (it != jobs_.end()) {
+        jobs_.erase(it);
+      }
+      done_cv_.wait(lock, [&] { return job.active == 0; });
+    }
+  }
+
+ private:
+  struct Job {
+    std::size_t count;
+    const std::function<void(std::size_t)> *f;
+    std::atomic<std::size_t> next{0};
+    std::size_t helpers = 0;  // workers that may still join, guarded by mutex_
+    std::size_t active = 0;   // workers running the job, guarded by mutex_
+
+    void work() {
+      for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+        (*f)(i);
+      }
+    }
+  };
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      job_cv_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        return;
+      }
+      auto job = jobs_.front();
+      job->active++;
+      if (--job->helpers == 0) {
+        jobs_.pop_front();
+      }
+      lock.unlock();
+      job->work();
+      lock.lock();
+      if (--job->active == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Job *> jobs_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+
+StateDiffEngine::StateDiffEngine(td::uint32 threads, td::uint32 split_bits)
+    : pool_(std::make_unique<Pool>(std::max<td::uint32>(threads, 1))), split_bits_(split_bits) {
+}
+
+StateDiffEngine::~StateDiffEngine() = default;
+
+StateDiffEngine &StateDiffEngine::shared() {
+  static StateDiffEngine engine;
+  return engine;
+}
+
+void StateDiffEngine::parallel_for(std::size_t count, const std::function<void(std::size_t)> &f) const {
+  pool_->run(count, f);
+}
+
+td::Result<std::vector<AccountStateChange>> StateDiffEngine::diff(td::Ref<vm::Cell> state,
+                                                                  std::vector<td::Ref<vm::Cell>> prev_states) const {
+  if (prev_states.empty()) {
+    return td::Status::Error("no previous state to diff against");
+  }
+
+  std::vector<ShardId> partitions;
+  std::vector<std::pair<td::Ref<vm::Cell>, td::Ref<vm::Cell>>> roots;
+
+  // Partition roots are extracted up front: dictionaries are not thread-safe, cells are
+  try {
+    TRY_RESULT(accounts, unpack_shard_accounts(std::move(state)));
+    std::vector<ShardAccounts> prev_accounts;
+    for (auto &prev_state : prev_states) {
+      TRY_RESULT(prev, unpack_shard_accounts(std::move(prev_state)));
+      prev_accounts.push_back(std::move(prev));
+    }
+
+    partitions.push_back(accounts.shard);
+    auto depth = std::min<td::uint32>(split_bits_, 60 - shard_prefix_length(accounts.shard));
+    if (prev_accounts.size() > 1) {
+      // after a merge every partition has to lie inside one of the previous shards
+      depth = std::max<td::uint32>(depth, 1);
+    }
+    for (td::uint32 i = 0; i < depth; i++) {
+      std::vector<ShardId> next;
+      next.reserve(partitions.size() * 2);
+      for (auto partition : partitions) {
+        next.push_back(shard_child(partition, true));
+        next.push_back(shard_child(partition, false));
+      }
+      partitions = std::move(next);
+    }
+
+    roots.reserve(partitions.size());
+    for (auto partition : partitions) {
+      auto prev = std::find_if(prev_accounts.begin(), prev_accounts.end(),
+                               [&](const ShardAccounts &p) { return shard_is_ancestor(p.shard, partition); });
+      if (prev == prev_accounts.end()) {
+        return td::Status::Error(PSTRING() << "no previous state covers shard " << shard_to_str(partition));
+      }
+      roots.emplace_back(partition_root(*prev->dict, partition), partition_root(*accounts.dict, partition));
+    }
+  } catch (vm::VmError &err) {
+    return err.as_status("cannot split shard accounts: ");
+  } catch (vm::VmVirtError &err) {
+    return err.as_status("cannot split shard accounts: ");
+  }
+
+  std::vector<std::vector<AccountStateChange>> changes(partitions.size());
+  std::vector<td::Status> errors(partitions.size());
+
+  parallel_for(partitions.size(), [&](std::size_t i) {
+    try {
+      vm::AugmentedDictionary prev{roots[i].first, 256, block::tlb::aug_ShardAccounts};
+      vm::AugmentedDictionary cur{roots[i].second, 256, block::tlb::aug_ShardAccounts};
+      bool ok = prev.scan_diff(cur, [&](td::ConstBitPtr key, int key_len, td::Ref<vm::CellSlice> prev_value,
+                                        td::Ref<vm::CellSlice> cur_value) {
+        CHECK(key_len == 256);
+        changes[i].push_back(AccountStateChange{td::Bits256{key},
+                                                prev_value.not_null() ? prev.extract_value(std::move(prev_value))
+                                                                      : td::Ref<vm::CellSlice>{},
+                                                cur_value.not_null() ? cur.extract_value(std::move(cur_value))
+                                                                     : td::Ref<vm::CellSlice>{}});
+        return true;
+      });
+      if (!ok) {
+        errors[i] = td::Status::Error(PSTRING() << "cannot diff accounts of shard " << shard_to_str(partitions[i]));
+      }
+    } catch (vm::VmError &err) {
+      errors[i] = err.as_status(PSTRING() << "cannot diff accounts of shard " << shard_to_str(partitions[i]) << ": ");
+    } catch (vm::VmVirtError &err) {
+      errors[i] = err.as_status(PSTRING() << "cannot diff accounts of shard " << shard_to_str(partitions[i]) << ": ");
+    }
+  });
+
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < partitions.size(); i++) {
+    TRY_STATUS(std::move(errors[i]));
+    total += changes[i].size();
+  }
+
+  std::vector<AccountStateChange> result;
+  result.reserve(total);
+  for (auto &partition_changes : changes) {
+    std::move(partition_changes.begin(), partition_changes.end(), std::back_inserter(result));
+  }
+  return result;
+}
+
+}  // namespace validator
+
+}  // namespace ton
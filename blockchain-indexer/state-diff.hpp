@@ -0,0 +1,54 @@
+#ifndef TON_STATE_DIFF_HPP
+#define TON_STATE_DIFF_HPP
+
+#include "ton/ton-types.h"
+#include "vm/cells/CellSlice.h"
+#include "td/utils/Status.h"
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ton {
+
+namespace validator {
+
+struct AccountStateChange {
+  td::Bits256 account;
+  td::Ref<vm::CellSlice> prev;  // ShardAccount before the block, null if the account did not exist
+  td::Ref<vm::CellSlice> cur;   // ShardAccount after the block, null if the account was removed
+};
+
+// Finds the accounts changed between shard states by walking the old and new ShardAccounts dictionaries together
+// and descending only into subtrees whose hashes differ, so the cost depends on the number of touched accounts and
+// not on the size of the shard. The shard is cut into 2^split_bits key-prefix partitions diffed on a thread pool;
+// changes come out ordered by account address.
+class StateDiffEngine {
+ public:
+  explicit StateDiffEngine(td::uint32 threads = std::thread::hardware_concurrency(), td::uint32 split_bits = 4);
+  ~StateDiffEngine();
+
+  // Engine of the process; its pool is started once and shared by all the indexers
+  static StateDiffEngine &shared();
+
+  // state and prev_states are ShardStateUnsplit roots. There are two previous states after a merge and one
+  // otherwise; every previous state must cover its part of the new shard (same shard, parent or child).
+  td::Result<std::vector<AccountStateChange>> diff(td::Ref<vm::Cell> state,
+                                                   std::vector<td::Ref<vm::Cell>> prev_states) const;
+
+  // Calls f(i) for every i in [0, count) on the pool, the calling thread takes part. f must not throw.
+  // Safe to call from several threads at once.
+  void parallel_for(std::size_t count, const std::function<void(std::size_t)> &f) const;
+
+ private:
+  class Pool;
+
+  std::unique_ptr<Pool> pool_;
+  td::uint32 split_bits_;
+};
+
+}  // namespace validator
+
+}  // namespace ton
+
+#endif  //TON_STATE_DIFF_HPP
@@ -0,0 +1,194 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "openssl/sha256-batch.h"
+#include "openssl/digest.hpp"
+#include "td/utils/check.h"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__) && !defined(__SHA__)
+#include <immintrin.h>
+#define TON_SHA256_MULTI_BUFFER 1
+#endif
+
+namespace digest {
+
+namespace {
+
+void sha256_one(td::Slice data, td::MutableSlice output) {
+  SHA256 hasher;
+  hasher.feed(data);
+  hasher.extract(output);
+}
+
+#ifdef TON_SHA256_MULTI_BUFFER
+
+constexpr std::size_t lanes = 8;
+// longer messages are rare (cell hashing needs at most 5 blocks) and are hashed one by one
+constexpr std::size_t max_blocks = 8;
+
+alignas(32) const td::uint32 round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+const td::uint32 initial_state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+std::size_t padded_blocks(std::size_t size) {
+  return (size + 9 + 63) / 64;
+}
+
+inline __m256i rotr(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+inline __m256i add(__m256i a, __m256i b) {
+  return _mm256_add_epi32(a, b);
+}
+
+// Hashes eight messages of `blocks` padded blocks each
+void sha256_x8(const td::Slice* data, const td::MutableSlice* output, std::size_t blocks) {
+  alignas(32) unsigned char padded[lanes][max_blocks * 64];
+  for (std::size_t lane = 0; lane < lanes; lane++) {
+    auto size = data[lane].size();
+    auto total = blocks * 64;
+    std::memcpy(padded[lane], data[lane].data(), size);
+    std::memset(padded[lane] + size, 0, total - size);
+    padded[lane][size] = 0x80;
+    td::uint64 bits = static_cast<td::uint64>(size) * 8;
+    for (int i = 0; i < 8; i++) {
+      padded[lane][total - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+  }
+
+  // byte order inside every 32-bit word of a lane is reversed to make the words big-endian
+  const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4,
+                                         11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i gather = _mm256_setr_epi32(0, max_blocks * 64 / 4, 2 * max_blocks * 64 / 4, 3 * max_blocks * 64 / 4,
+                                           4 * max_blocks * 64 / 4, 5 * max_blocks * 64 / 4, 6 * max_blocks * 64 / 4,
+                                           7 * max_blocks * 64 / 4);
+
+  __m256i state[8];
+  for (int i = 0; i < 8; i++) {
+    state[i] = _mm256_set1_epi32(static_cast<int>(initial_state[i]));
+  }
+
+  for (std::size_t block = 0; block < blocks; block++) {
+    __m256i w[64];
+    auto base = reinterpret_cast<const int*>(&padded[0][block * 64]);
+    for (int i = 0; i < 16; i++) {
+      w[i] = _mm256_shuffle_epi8(_mm256_i32gather_epi32(base + i, gather, 4), bswap);
+    }
+    for (int i = 16; i < 64; i++) {
+      auto s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(w[i - 15], 7), rotr(w[i - 15], 18)),
+                                 _mm256_srli_epi32(w[i - 15], 3));
+      auto s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(w[i - 2], 17), rotr(w[i - 2], 19)),
+                                 _mm256_srli_epi32(w[i - 2], 10));
+      w[i] = add(add(w[i - 16], s0), add(w[i - 7], s1));
+    }
+
+    auto a = state[0], b = state[1], c = state[2], d = state[3];
+    auto e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+      auto s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(e, 6), rotr(e, 11)), rotr(e, 25));
+      auto ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+      auto t1 = add(add(add(h, s1), add(ch, w[i])), _mm256_set1_epi32(static_cast<int>(round_constants[i])));
+      auto s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(a, 2), rotr(a, 13)), rotr(a, 22));
+      auto maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+      auto t2 = add(s0, maj);
+      h = g;
+      g = f;
+      f = e;
+      e = add(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = add(t1, t2);
+    }
+    state[0] = add(state[0], a);
+    state[1] = add(state[1], b);
+    state[2] = add(state[2], c);
+    state[3] = add(state[3], d);
+    state[4] = add(state[4], e);
+    state[5] = add(state[5], f);
+    state[6] = add(state[6], g);
+    state[7] = add(state[7], h);
+  }
+
+  alignas(32) td::uint32 words[8][lanes];
+  for (int i = 0; i < 8; i++) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), _mm256_shuffle_epi8(state[i], bswap));
+  }
+  for (std::size_t lane = 0; lane < lanes; lane++) {
+    auto out = output[lane].ubegin();
+    for (int i = 0; i < 8; i++) {
+      std::memcpy(out + 4 * i, &words[i][lane], 4);
+    }
+  }
+}
+
+#endif
+
+}  // namespace
+
+void sha256_batch(td::Span<td::Slice> data, td::Span<td::MutableSlice> output) {
+  CHECK(data.size() == output.size());
+#ifdef TON_SHA256_MULTI_BUFFER
+  if (data.size() >= lanes) {
+    // messages are grouped by their number of blocks, every lane of a group runs the same rounds
+    std::array<std::vector<std::size_t>, max_blocks + 1> groups;
+    for (std::size_t i = 0; i < data.size(); i++) {
+      auto blocks = padded_blocks(data[i].size());
+      if (blocks > max_blocks) {
+        sha256_one(data[i], output[i]);
+        continue;
+      }
+      auto& group = groups[blocks];
+      group.push_back(i);
+      if (group.size() == lanes) {
+        td::Slice lane_data[lanes];
+        td::MutableSlice lane_output[lanes];
+        for (std::size_t lane = 0; lane < lanes; lane++) {
+          lane_data[lane] = data[group[lane]];
+          lane_output[lane] = output[group[lane]];
+        }
+        sha256_x8(lane_data, lane_output, blocks);
+        group.clear();
+      }
+    }
+    for (auto& group : groups) {
+      for (auto i : group) {
+        sha256_one(data[i], output[i]);
+      }
+    }
+    return;
+  }
+#endif
+  for (std::size_t i = 0; i < data.size(); i++) {
+    sha256_one(data[i], output[i]);
+  }
+}
+
+}  // namespace digest
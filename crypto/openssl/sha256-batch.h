@@ -0,0 +1,28 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "td/utils/Slice.h"
+#include "td/utils/Span.h"
+
+namespace digest {
+
+// SHA-256 of many independent messages, output[i] receives the 32-byte digest of data[i].
+// With AVX2 (and without SHA-NI, which OpenSSL already uses for a single message) messages of the same number of
+// blocks are hashed eight at a time, one per 32-bit lane; the rest is hashed one by one.
+void sha256_batch(td::Span<td::Slice> data, td::Span<td::MutableSlice> output);
+
+}  // namespace digest
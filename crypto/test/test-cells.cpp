@@ -33,10 +33,12 @@
 #include "common/util.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
+#include "openssl/sha256-batch.h"
 
 #include "td/utils/tests.h"
 #include "td/utils/crypto.h"
 #include "td/utils/misc.h"
+#include "td/utils/Random.h"
 
 static std::stringstream create_ss() {
   std::stringstream ss;
@@ -481,6 +483,25 @@ TEST(RefInt, main) {
   REGRESSION_VERIFY(os.str());
 }
 
+TEST(sha256_batch, main) {
+  td::Random::Xorshift128plus rnd(123);
+  for (int n : {0, 1, 7, 8, 9, 64, 100}) {
+    std::vector<std::string> data(n), hashes(n, std::string(32, '\0'));
+    std::vector<td::Slice> data_slices;
+    std::vector<td::MutableSlice> hash_slices;
+    for (int i = 0; i < n; i++) {
+      data[i].resize(rnd.fast(0, i % 5 == 0 ? 1000 : 300));
+      rnd.bytes(data[i]);
+      data_slices.emplace_back(data[i]);
+      hash_slices.emplace_back(hashes[i]);
+    }
+    digest::sha256_batch(data_slices, hash_slices);
+    for (int i = 0; i < n; i++) {
+      ASSERT_EQ(td::sha256(data[i]), hashes[i]);
+    }
+  }
+}
+
 TEST(crc16, main) {
   os = create_ss();
   std::string s = "EMSI_FCK";
@@ -36,6 +36,7 @@
 #include "td/utils/Timer.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/format.h"
 #include "td/utils/misc.h"
 #include "td/utils/tests.h"
@@ -954,6 +955,73 @@ TEST(TonDb, BocMultipleRoots) {
   }
 };
 
+TEST(TonDb, BocParallel) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 200; t++) {
+    auto cells = gen_random_cells(rnd.fast(1, 10), rnd.fast(1, 1000), rnd);
+    auto mode = get_random_serialization_mode(rnd);
+    auto serialized = serialize_boc(cells, mode);
+
+    vm::BagOfCells boc;
+    boc.set_extra_threads(rnd.fast(1, 3));
+    boc.deserialize(td::Slice(serialized)).ensure();
+    ASSERT_EQ((int)cells.size(), boc.get_root_count());
+    for (size_t i = 0; i < cells.size(); i++) {
+      ASSERT_EQ(cells[i]->get_hash(), boc.get_root_cell((int)i)->get_hash());
+    }
+  }
+}
+
+class BenchBocDeserialize : public td::Benchmark {
+ public:
+  explicit BenchBocDeserialize(size_t extra_threads) : extra_threads_(extra_threads) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchBocDeserialize extra_threads=" << extra_threads_;
+  }
+
+  void start_up() override {
+    if (!serialized_.empty()) {
+      return;
+    }
+    // a binary tree with 2^20 distinct leaves, about 2M cells in total
+    td::Random::Xorshift128plus rnd{123};
+    std::vector<Ref<Cell>> level;
+    for (int i = 0; i < (1 << 20); i++) {
+      CellBuilder cb;
+      cb.store_long(rnd(), 64).store_long(i, 32);
+      level.push_back(cb.finalize());
+    }
+    while (level.size() > 1) {
+      std::vector<Ref<Cell>> next;
+      for (size_t i = 0; i < level.size(); i += 2) {
+        CellBuilder cb;
+        cb.store_long(i, 32).store_ref(level[i]).store_ref(level[i + 1]);
+        next.push_back(cb.finalize());
+      }
+      level = std::move(next);
+    }
+    root_hash_ = level[0]->get_hash();
+    serialized_ = vm::std_boc_serialize(level[0], 31).move_as_ok();
+  }
+
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      auto root = vm::std_boc_deserialize(serialized_, false, false, extra_threads_).move_as_ok();
+      CHECK(root->get_hash() == root_hash_);
+    }
+  }
+
+ private:
+  size_t extra_threads_;
+  Cell::Hash root_hash_;
+  td::BufferSlice serialized_;
+};
+TEST(Bench, BocDeserialize) {
+  td::bench(BenchBocDeserialize(0));
+  td::bench(BenchBocDeserialize(std::max(td::thread::hardware_concurrency(), 1u) - 1));
+}
+
 TEST(TonDb, InMemoryDynamicBocSimple) {
   auto counter = [] { return td::NamedThreadSafeCounter::get_default().get_counter("DataCell").sum(); };
   auto before = counter();
@@ -1691,6 +1759,30 @@ TEST(TonDb, BocDeserializerSimpleThreads) {
   test_boc_deserializer_threads<StaticBagOfCellsDbLazy>();
 }
 
+TEST(TonDb, BocDeserializerMemoryMapped) {
+  td::Random::Xorshift128plus rnd{123};
+  std::string path = "boc_deserializer_mmap";
+  SCOPE_EXIT {
+    td::unlink(path).ignore();
+  };
+  for (int t = 0; t < 50; t++) {
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd);
+    for (auto mode : get_serialization_modes()) {
+      auto serialized = serialize_boc(cell, mode);
+      td::unlink(path).ignore();
+      td::write_file(path, serialized).ensure();
+
+      StaticBagOfCellsDbLazy::Options options;
+      options.max_cached_cells = rnd.fast(1, 64);
+      options.prefetch_bytes = 1 << 12;
+      auto boc = StaticBagOfCellsDbLazy::create_from_file(path, options).move_as_ok();
+      auto loaded_cell = boc->get_root_cell(0).move_as_ok();
+      ASSERT_EQ(cell->get_hash(), loaded_cell->get_hash());
+      ASSERT_EQ(serialized, serialize_boc(std::move(loaded_cell), mode));
+    }
+  }
+}
+
 class RandomTree {
   public:
     RandomTree(size_t size, td::Random::Xorshift128plus rnd) : rnd_(rnd) {
@@ -3047,6 +3139,106 @@ TEST(TonDb, LargeBocSerializer) {
   }
 }
 
+TEST(TonDb, DynamicBocPrefetch) {
+  td::Random::Xorshift128plus rnd{123};
+  vm::Dictionary dict{64};
+  std::vector<td::BitArray<64>> keys(1000);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i].store_ulong(rnd());
+    vm::CellBuilder cb;
+    cb.store_long(i, 32);
+    ASSERT_TRUE(dict.set_builder(keys[i].bits(), 64, cb));
+  }
+  auto root = dict.get_root_cell();
+
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto dboc = vm::DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<vm::CellLoader>(kv));
+  dboc->inc(root);
+  dboc->prepare_commit();
+  vm::CellStorer cell_storer(*kv);
+  dboc->commit(cell_storer);
+
+  dboc = vm::DynamicBagOfCellsDb::create(
+      vm::DynamicBagOfCellsDb::CreateV1Options{.prefetch_depth = 2, .prefetch_fanout = 16});
+  dboc->set_loader(std::make_unique<vm::CellLoader>(kv));
+  auto loaded_root = dboc->load_cell(root->get_hash().as_slice()).move_as_ok();
+  for (unsigned i = 0; i < loaded_root->size_refs(); i++) {
+    auto child = loaded_root->get_ref(i);
+    ASSERT_TRUE(child->is_loaded());
+    auto loaded_child = child->load_cell().move_as_ok().data_cell;
+    for (unsigned j = 0; j < loaded_child->size_refs(); j++) {
+      ASSERT_TRUE(loaded_child->get_ref(j)->is_loaded());
+    }
+  }
+
+  auto reader = dboc->get_cell_db_reader();
+  vm::Dictionary cold_dict{td::Ref<vm::Cell>(loaded_root), 64};
+  size_t prefetched = 0;
+  cold_dict.prefetch_levels(
+      [&](td::Span<td::Ref<vm::Cell>> cells) {
+        reader->prefetch(cells);
+        for (auto &cell : cells) {
+          ASSERT_TRUE(cell->is_loaded());
+        }
+        prefetched += cells.size();
+      },
+      6);
+  ASSERT_EQ(63u, prefetched);
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto value = cold_dict.lookup(keys[i].bits(), 64);
+    ASSERT_TRUE(value.not_null());
+    ASSERT_EQ(static_cast<long long>(i), value->prefetch_long(32));
+  }
+}
+
+TEST(TonDb, DynamicBocSecondaryFollowsPrimary) {
+  std::string primary_path = "secondary_celldb";
+  std::string secondary_path = "secondary_celldb_private";
+  td::RocksDb::destroy(primary_path).ignore();
+  td::rmrf(secondary_path).ignore();
+
+  auto primary = std::make_shared<td::RocksDb>(td::RocksDb::open(primary_path).move_as_ok());
+  auto store = [&](td::Ref<vm::Cell> root) {
+    auto dboc = vm::DynamicBagOfCellsDb::create();
+    dboc->set_loader(std::make_unique<vm::CellLoader>(primary));
+    dboc->inc(root);
+    dboc->prepare_commit();
+    vm::CellStorer cell_storer(*primary);
+    primary->begin_write_batch().ensure();
+    dboc->commit(cell_storer);
+    primary->commit_write_batch().ensure();
+    // the primary buffers its WAL, flushing the memtable makes the write visible through the MANIFEST
+    primary->flush().ensure();
+  };
+  auto first = vm::CellBuilder().store_long(1, 32).finalize();
+  store(first);
+
+  td::RocksDbOptions options;
+  options.secondary_path = secondary_path;
+  options.secondary_catch_up_period = 0;
+  auto secondary = std::make_shared<td::RocksDb>(td::RocksDb::open(primary_path, options, true).move_as_ok());
+  // like in CellDbIn, the loader keeps its snapshot for as long as it lives
+  auto dboc = vm::DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<vm::CellLoader>(secondary->snapshot()));
+  ASSERT_TRUE(dboc->load_cell(first->get_hash().as_slice()).is_ok());
+
+  auto second = vm::CellBuilder().store_long(2, 32).store_ref(first).finalize();
+  ASSERT_TRUE(dboc->load_cell(second->get_hash().as_slice()).is_error());
+  store(second);
+  auto loaded = dboc->load_cell(second->get_hash().as_slice());
+  ASSERT_TRUE(loaded.is_ok());
+  ASSERT_EQ(second->get_hash(), loaded.ok()->get_hash());
+  ASSERT_EQ(primary->freshness().sequence_number, secondary->freshness().sequence_number);
+
+  dboc.reset();
+  secondary.reset();
+  primary.reset();
+  td::RocksDb::destroy(primary_path).ignore();
+  td::rmrf(secondary_path).ignore();
+}
+
 TEST(TonDb, DoNotMakeListsPrunned) {
   auto cell = vm::CellBuilder().store_bytes("abc").finalize();
   auto is_prunned = [&](const td::Ref<vm::Cell> &cell) { return true; };
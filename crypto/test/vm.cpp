@@ -19,10 +19,14 @@
 #include "vm/vm.h"
 #include "vm/cp0.h"
 #include "vm/dict.h"
+#include "vm/dispatch.h"
+#include "vm/opctable.h"
 #include "fift/utils.h"
 #include "common/bigint.hpp"
 
 #include "td/utils/base64.h"
+#include "td/utils/benchmark.h"
+#include "td/utils/Random.h"
 #include "td/utils/tests.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/StringBuilder.h"
@@ -448,3 +452,102 @@ RETALT
 )A";
   test_run_vm(fift::compile_asm(test1).move_as_ok());
 }
+
+class BenchOpcodeLookup : public td::Benchmark {
+ public:
+  explicit BenchOpcodeLookup(bool by_search) : by_search(by_search) {
+  }
+
+  std::string get_description() const override {
+    return by_search ? "BenchOpcodeLookup (binary search)" : "BenchOpcodeLookup";
+  }
+
+  void start_up() override {
+    vm::init_vm().ensure();
+    td::Random::Xorshift128plus rnd(123);
+    for (int i = 0; i < 1024; i++) {
+      vm::CellBuilder cb;
+      for (int j = 0; j < 4; j++) {
+        cb.store_long(rnd() & 0xffffffff, 32);
+      }
+      code.push_back(vm::load_cell_slice(cb.finalize()));
+    }
+  }
+
+  void run(int n) override {
+    auto table = vm::DispatchTable::get_table(0);
+    int sum = 0;
+    if (by_search) {
+      auto opcode_table = dynamic_cast<const vm::OpcodeTable*>(table);
+      CHECK(opcode_table);
+      for (int i = 0; i < n; i++) {
+        sum += opcode_table->instr_len_by_search(code[i & 1023]);
+      }
+    } else {
+      for (int i = 0; i < n; i++) {
+        sum += table->instr_len(code[i & 1023]);
+      }
+    }
+    td::do_not_optimize_away(sum);
+  }
+
+ private:
+  bool by_search;
+  std::vector<vm::CellSlice> code;
+};
+
+// Every op is one VM step: a loop body of 9 instructions with one- to three-byte opcodes plus the implicit RET
+class BenchVmSteps : public td::Benchmark {
+ public:
+  explicit BenchVmSteps(bool decoded_code_cache) : decoded_code_cache(decoded_code_cache) {
+  }
+
+  std::string get_description() const override {
+    return decoded_code_cache ? "BenchVmSteps (decoded code cache)" : "BenchVmSteps";
+  }
+
+  void start_up() override {
+    vm::init_vm().ensure();
+    code = fift::compile_asm(R"A(
+REPEAT:<{
+  DUP
+  INC
+  NIP
+  1000 INT
+  OVER
+  AND
+  5 RSHIFT#
+  DROP
+  NOP
+}>
+)A")
+               .move_as_ok();
+    vm::DecodedCodeCache::set_capacity(decoded_code_cache ? 1024 : 0);
+  }
+
+  void tear_down() override {
+    vm::DecodedCodeCache::set_capacity(0);
+  }
+
+  void run(int n) override {
+    vm::Stack stack;
+    stack.push_smallint(0);
+    stack.push_smallint(n / 10 + 1);
+    vm::GasLimits gas_limit;
+    long long steps = 0;
+    auto res = vm::run_vm_code(vm::load_cell_slice_ref(code), stack, 0, nullptr, vm::VmLog::Null(), &steps, &gas_limit);
+    CHECK(res == 0);
+    td::do_not_optimize_away(steps);
+  }
+
+ private:
+  bool decoded_code_cache;
+  td::Ref<vm::Cell> code;
+};
+
+TEST(Bench, VmDispatch) {
+  td::bench(BenchOpcodeLookup(true));
+  td::bench(BenchOpcodeLookup(false));
+  td::bench(BenchVmSteps(false));
+  td::bench(BenchVmSteps(true));
+}
@@ -28,10 +28,120 @@
 #include "td/utils/format.h"
 #include "td/utils/misc.h"
 #include "td/utils/Slice-decl.h"
+#include "td/utils/port/thread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
 
 namespace vm {
 using td::Ref;
 
+namespace {
+// Helper threads shared by all deserializations in the process: they are started once, and concurrent
+// deserializations split them instead of each starting its own threads
+class ParallelRunPool {
+ public:
+  static ParallelRunPool& get() {
+    static ParallelRunPool pool(std::max(td::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+  }
+
+  explicit ParallelRunPool(size_t workers_n) {
+    for (size_t i = 0; i < workers_n; i++) {
+      workers_.emplace_back([this] { loop(); });
+    }
+  }
+
+  ~ParallelRunPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // runs tasks 0..n-1 on the calling thread and on at most extra_threads_n pool threads
+  void run(size_t n, const std::function<void(size_t)>& run_task, size_t extra_threads_n) {
+    Job job{n, &run_task};
+    auto helpers = std::min({extra_threads_n, workers_.size(), n > 0 ? n - 1 : 0});
+    if (helpers > 0) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job.helpers = helpers;
+        jobs_.push_back(&job);
+      }
+      job_cv_.notify_all();
+    }
+
+    job.work();
+
+    if (helpers > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // every task is taken, threads that have not joined yet must not see the job anymore
+      auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+      if (it != jobs_.end()) {
+        jobs_.erase(it);
+      }
+      done_cv_.wait(lock, [&] { return job.active == 0; });
+    }
+  }
+
+ private:
+  struct Job {
+    size_t n;
+    const std::function<void(size_t)>* run_task;
+    std::atomic<size_t> next_task_id{0};
+    size_t helpers = 0;  // threads that may still join, guarded by mutex_
+    size_t active = 0;   // threads running the job, guarded by mutex_
+
+    void work() {
+      for (auto task_id = next_task_id++; task_id < n; task_id = next_task_id++) {
+        (*run_task)(task_id);
+      }
+    }
+  };
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      job_cv_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        return;
+      }
+      auto job = jobs_.front();
+      job->active++;
+      if (--job->helpers == 0) {
+        jobs_.pop_front();
+      }
+      lock.unlock();
+      job->work();
+      lock.lock();
+      if (--job->active == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Job*> jobs_;
+  bool stop_ = false;
+  std::vector<td::thread> workers_;
+};
+
+template <class F>
+void parallel_run(size_t n, F&& run_task, size_t extra_threads_n) {
+  ParallelRunPool::get().run(n, std::function<void(size_t)>(std::forward<F>(run_task)), extra_threads_n);
+}
+}  // namespace
+
 td::Status CellSerializationInfo::init(td::Slice data, int ref_byte_size) {
   if (data.size() < 2) {
     return td::Status::Error(PSLICE() << "Not enough bytes " << td::tag("got", data.size())
@@ -92,6 +202,10 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
   DCHECK(refs_cnt == (td::int64)refs.size());
   TRY_RESULT(bits, get_bits(cell_slice));
   TRY_RESULT(res, DataCell::create(cell_slice.substr(data_offset), bits, refs, special));
+  return check_data_cell(std::move(res), cell_slice);
+}
+
+td::Result<Ref<DataCell>> CellSerializationInfo::check_data_cell(Ref<DataCell> res, td::Slice cell_slice) const {
   CHECK(!res.is_null());
   if (res->is_special() != special) {
     return td::Status::Error("is_special mismatch");
@@ -759,21 +873,19 @@ td::Result<td::Slice> BagOfCells::get_cell_slice(int idx, td::Slice data) {
   return data.substr(offs, td::narrow_cast<size_t>(offs_end - offs));
 }
 
-td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slice cells_slice,
-                                                               td::Span<td::Ref<DataCell>> cells_span,
-                                                               std::vector<td::uint8>* cell_should_cache) {
-  TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
-  std::array<td::Ref<Cell>, 4> refs_buf;
+td::Status BagOfCells::read_cell(int idx, td::Slice cells_slice, std::vector<td::uint8>* cell_should_cache,
+                                 PendingCell& cell) {
+  TRY_RESULT_ASSIGN(cell.data, get_cell_slice(idx, cells_slice));
+  cell.idx = idx;
 
-  CellSerializationInfo cell_info;
-  TRY_STATUS(cell_info.init(cell_slice, info.ref_byte_size));
-  if (cell_info.end_offset != cell_slice.size()) {
+  auto& cell_info = cell.info;
+  TRY_STATUS(cell_info.init(cell.data, info.ref_byte_size));
+  if (cell_info.end_offset != cell.data.size()) {
     return td::Status::Error("unused space in cell serialization");
   }
 
-  auto refs = td::MutableSpan<td::Ref<Cell>>(refs_buf).substr(0, cell_info.refs_cnt);
   for (int k = 0; k < cell_info.refs_cnt; k++) {
-    int ref_idx = (int)info.read_ref(cell_slice.ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
+    int ref_idx = (int)info.read_ref(cell.data.ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
     if (ref_idx <= idx) {
       return td::Status::Error(PSLICE() << "bag-of-cells error: reference #" << k << " of cell #" << idx
                                         << " is to cell #" << ref_idx << " with smaller index");
@@ -783,7 +895,7 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
                                         << " is to non-existent cell #" << ref_idx << ", only " << cell_count
                                         << " cells are defined");
     }
-    refs[k] = cells_span[cell_count - ref_idx - 1];
+    cell.ref_idx[k] = ref_idx;
     if (cell_should_cache) {
       auto& cnt = (*cell_should_cache)[ref_idx];
       if (cnt < 2) {
@@ -791,8 +903,146 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
       }
     }
   }
+  return td::Status::OK();
+}
+
+td::Status BagOfCells::create_cells(std::vector<PendingCell>& pending, std::vector<td::Ref<DataCell>>& cells) {
+  std::vector<DataCell::CreateArgs> args;
+  args.reserve(pending.size());
+  for (auto& cell : pending) {
+    auto r_bits = cell.info.get_bits(cell.data);
+    if (r_bits.is_error()) {
+      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << cell.idx << " "
+                                        << r_bits.error());
+    }
+    args.push_back(DataCell::CreateArgs{cell.data.substr(cell.info.data_offset), r_bits.ok(),
+                                        td::Span<td::Ref<Cell>>(cell.refs.data(), cell.info.refs_cnt),
+                                        cell.info.special});
+  }
 
-  return cell_info.create_data_cell(cell_slice, refs);
+  auto created = DataCell::create_batch(args);
+  for (size_t i = 0; i < pending.size(); i++) {
+    auto r_cell = std::move(created[i]);
+    if (r_cell.is_ok()) {
+      r_cell = pending[i].info.check_data_cell(r_cell.move_as_ok(), pending[i].data);
+    }
+    if (r_cell.is_error()) {
+      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << pending[i].idx << " "
+                                        << r_cell.error());
+    }
+    cells.push_back(r_cell.move_as_ok());
+    DCHECK(cells.back().not_null());
+  }
+  pending.clear();
+  return td::Status::OK();
+}
+
+td::Status BagOfCells::create_cells_in_order(td::Slice cells_slice, std::vector<td::uint8>* cell_should_cache,
+                                             std::vector<td::Ref<DataCell>>& cell_list) {
+  cell_list.reserve(cell_count);
+  // consecutive cells not referencing each other are created together, so that their hashes are computed in one batch
+  constexpr size_t max_batch = 256;
+  std::vector<PendingCell> pending;
+  pending.reserve(max_batch);
+  for (int i = 0; i < cell_count; i++) {
+    // reconstruct cell with index cell_count - 1 - i
+    int idx = cell_count - 1 - i;
+    PendingCell cell;
+    auto status = read_cell(idx, cells_slice, cell_should_cache, cell);
+    if (status.is_error()) {
+      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                        << status.error());
+    }
+    for (int k = 0; k < cell.info.refs_cnt; k++) {
+      if (cell_count - cell.ref_idx[k] - 1 >= (int)cell_list.size()) {
+        TRY_STATUS(create_cells(pending, cell_list));
+        break;
+      }
+    }
+    for (int k = 0; k < cell.info.refs_cnt; k++) {
+      cell.refs[k] = cell_list[cell_count - cell.ref_idx[k] - 1];
+    }
+    pending.push_back(std::move(cell));
+    if (pending.size() == max_batch) {
+      TRY_STATUS(create_cells(pending, cell_list));
+    }
+  }
+  return create_cells(pending, cell_list);
+}
+
+td::Status BagOfCells::create_cells_by_levels(td::Slice cells_slice, std::vector<td::uint8>* cell_should_cache,
+                                              std::vector<td::Ref<DataCell>>& cell_list) {
+  // the level of a cell is the length of the longest reference chain below it,
+  // so cells of one level never reference each other and are created in parallel once the previous levels exist
+  std::vector<td::uint32> level(cell_count, 0);
+  td::uint32 max_level = 0;
+  for (int idx = cell_count - 1; idx >= 0; idx--) {
+    PendingCell cell;
+    auto status = read_cell(idx, cells_slice, cell_should_cache, cell);
+    if (status.is_error()) {
+      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                        << status.error());
+    }
+    td::uint32 cell_level = 0;
+    for (int k = 0; k < cell.info.refs_cnt; k++) {
+      cell_level = std::max(cell_level, level[cell.ref_idx[k]] + 1);
+    }
+    level[idx] = cell_level;
+    max_level = std::max(max_level, cell_level);
+  }
+
+  std::vector<int> level_begin(max_level + 2, 0);
+  for (int idx = 0; idx < cell_count; idx++) {
+    level_begin[level[idx] + 1]++;
+  }
+  for (td::uint32 l = 0; l <= max_level; l++) {
+    level_begin[l + 1] += level_begin[l];
+  }
+  std::vector<int> order(cell_count);
+  {
+    auto pos = level_begin;
+    for (int idx = cell_count - 1; idx >= 0; idx--) {
+      order[pos[level[idx]]++] = idx;
+    }
+  }
+  level = {};
+
+  cell_list.resize(cell_count);
+  constexpr int chunk_size = 256;
+  bool use_arena = DataCell::use_arena;
+  for (td::uint32 l = 0; l <= max_level; l++) {
+    int begin = level_begin[l];
+    int end = level_begin[l + 1];
+    size_t chunks = (end - begin + chunk_size - 1) / chunk_size;
+    std::vector<td::Status> errors(chunks);
+    parallel_run(
+        chunks,
+        [&](size_t chunk) {
+          DataCell::use_arena = use_arena;
+          int chunk_begin = begin + static_cast<int>(chunk) * chunk_size;
+          int chunk_end = std::min(end, chunk_begin + chunk_size);
+          std::vector<PendingCell> pending(chunk_end - chunk_begin);
+          for (int i = chunk_begin; i < chunk_end; i++) {
+            auto& cell = pending[i - chunk_begin];
+            // the cell was validated by the first pass
+            read_cell(order[i], cells_slice, nullptr, cell).ensure();
+            for (int k = 0; k < cell.info.refs_cnt; k++) {
+              cell.refs[k] = cell_list[cell_count - cell.ref_idx[k] - 1];
+            }
+          }
+          std::vector<Ref<DataCell>> created;
+          created.reserve(pending.size());
+          errors[chunk] = create_cells(pending, created);
+          for (size_t i = 0; i < created.size(); i++) {
+            cell_list[cell_count - order[chunk_begin + i] - 1] = std::move(created[i]);
+          }
+        },
+        std::min(extra_threads_, chunks > 0 ? chunks - 1 : 0));
+    for (auto& error : errors) {
+      TRY_STATUS(std::move(error));
+    }
+  }
+  return td::Status::OK();
 }
 
 td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roots) {
@@ -878,18 +1128,10 @@ td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roo
   }
   auto cells_slice = data.substr(info.data_offset, info.data_size);
   std::vector<Ref<DataCell>> cell_list;
-  cell_list.reserve(cell_count);
-  std::array<td::Ref<Cell>, 4> refs_buf;
-  for (int i = 0; i < cell_count; i++) {
-    // reconstruct cell with index cell_count - 1 - i
-    int idx = cell_count - 1 - i;
-    auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr);
-    if (r_cell.is_error()) {
-      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
-                                        << r_cell.error());
-    }
-    cell_list.push_back(r_cell.move_as_ok());
-    DCHECK(cell_list.back().not_null());
+  if (extra_threads_ > 0) {
+    TRY_STATUS(create_cells_by_levels(cells_slice, info.has_cache_bits ? &cell_should_cache : nullptr, cell_list));
+  } else {
+    TRY_STATUS(create_cells_in_order(cells_slice, info.has_cache_bits ? &cell_should_cache : nullptr, cell_list));
   }
   if (info.has_cache_bits) {
     for (int idx = 0; idx < cell_count; idx++) {
@@ -951,11 +1193,13 @@ unsigned long long BagOfCells::get_idx_entry_raw(int index) {
  * 
  */
 
-td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty, bool allow_nonzero_level) {
+td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty, bool allow_nonzero_level,
+                                          size_t extra_threads) {
   if (data.empty() && can_be_empty) {
     return Ref<Cell>();
   }
   BagOfCells boc;
+  boc.set_extra_threads(extra_threads);
   auto res = boc.deserialize(data, 1);
   if (res.is_error()) {
     return res.move_as_error();
@@ -19,6 +19,7 @@
 #pragma once
 #include "td/utils/CancellationToken.h"
 
+#include <array>
 #include <set>
 #include <map>
 #include "vm/db/DynamicBagOfCellsDb.h"
@@ -205,6 +206,8 @@ struct CellSerializationInfo {
   td::Result<int> get_bits(td::Slice cell) const;
 
   td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  // Checks a cell created from `data` against the serialized flags, hashes and depths
+  td::Result<Ref<DataCell>> check_data_cell(Ref<DataCell> cell, td::Slice data) const;
 };
 
 class BagOfCellsLogger {
@@ -336,6 +339,7 @@ class BagOfCells {
   const unsigned char* data_ptr{nullptr};
   std::vector<unsigned long long> custom_index;
   BagOfCellsLogger* logger_ptr_{nullptr};
+  size_t extra_threads_{0};
 
  public:
   void clear();
@@ -348,6 +352,11 @@ class BagOfCells {
   void set_logger(BagOfCellsLogger* logger_ptr) {
     logger_ptr_ = logger_ptr;
   }
+  // deserialize() creates cells level by level (leaves first) on the calling thread and up to extra_threads
+  // helper threads, which are shared by all deserializations in the process
+  void set_extra_threads(size_t extra_threads) {
+    extra_threads_ = extra_threads;
+  }
   std::size_t estimate_serialized_size(int mode = 0);
   td::Status serialize(int mode = 0);
   td::string serialize_to_string(int mode = 0);
@@ -390,11 +399,24 @@ class BagOfCells {
   unsigned long long get_idx_entry(int index);
   bool get_cache_entry(int index);
   td::Result<td::Slice> get_cell_slice(int index, td::Slice data);
-  td::Result<td::Ref<vm::DataCell>> deserialize_cell(int index, td::Slice data, td::Span<td::Ref<DataCell>> cells,
-                                                     std::vector<td::uint8>* cell_should_cache);
+  // a cell read from the serialization, created together with the other cells of its batch
+  struct PendingCell {
+    int idx;
+    td::Slice data;
+    CellSerializationInfo info;
+    std::array<int, 4> ref_idx;
+    std::array<td::Ref<Cell>, 4> refs;
+  };
+  td::Status read_cell(int index, td::Slice data, std::vector<td::uint8>* cell_should_cache, PendingCell& cell);
+  td::Status create_cells(std::vector<PendingCell>& pending, std::vector<td::Ref<DataCell>>& cells);
+  td::Status create_cells_in_order(td::Slice cells_slice, std::vector<td::uint8>* cell_should_cache,
+                                   std::vector<td::Ref<DataCell>>& cell_list);
+  td::Status create_cells_by_levels(td::Slice cells_slice, std::vector<td::uint8>* cell_should_cache,
+                                    std::vector<td::Ref<DataCell>>& cell_list);
 };
 
-td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false, bool allow_nonzero_level = false);
+td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false, bool allow_nonzero_level = false,
+                                          size_t extra_threads = 0);
 td::Result<td::BufferSlice> std_boc_serialize(Ref<Cell> root, int mode = 0);
 
 td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data,
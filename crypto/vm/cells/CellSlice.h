@@ -140,6 +140,10 @@ class CellSlice : public td::CntObject {
   unsigned get_cell_level() const;
   unsigned get_level() const;
   Ref<Cell> get_base_cell() const;  // be careful with this one!
+  // loaded cell without virtualization and usage tracking, identifies the underlying data
+  const Ref<DataCell>& get_data_cell() const {
+    return cell;
+  }
   int fetch_octet();
   int prefetch_octet() const;
   unsigned long long prefetch_ulong_top(unsigned& bits) const;
@@ -18,14 +18,17 @@
 */
 
 #include "openssl/digest.hpp"
+#include "openssl/sha256-batch.h"
 #include "vm/cells/DataCell.h"
 
 namespace vm {
 
-namespace {
+namespace detail {
 
 class CellChecker {
  public:
+  static constexpr size_t max_hash_input = 512;
+
   CellChecker(bool is_special, td::Slice data, int bit_length, td::Span<Ref<Cell>> refs)
       : is_special_(is_special)
       , refs_(refs)
@@ -35,6 +38,12 @@ class CellChecker {
   }
 
   td::Status check_and_compute_level_info() {
+    TRY_STATUS(check_level_info());
+    compute_hashes();
+    return {};
+  }
+
+  td::Status check_level_info() {
     // First, we figure out what is the type of the cell.
     type_ = Cell::SpecialType::Ordinary;
 
@@ -83,7 +92,10 @@ class CellChecker {
       return td::Status::Error("Virtualization is too big to be stored in vm::DataCell");
     }
 
-    // And finally, we compute cell hashes.
+    return {};
+  }
+
+  void compute_hashes() {
     // NOTE: Hash computation algorithm is not described correctly (or at all) in the documentation.
     int last_computed_hash = -1;
 
@@ -98,8 +110,19 @@ class CellChecker {
       }
       last_computed_hash = i;
     }
+  }
 
-    return {};
+  // A cell without levels has one hash, of the representation written by single_hash_input()
+  bool has_single_hash() const {
+    return level_mask_.get_level() == 0;
+  }
+
+  size_t single_hash_input(char* data_to_hash) const {
+    return hash_input(max_level, -1, data_to_hash);
+  }
+
+  void set_single_hash(const CellHash& hash) {
+    hash_.fill(hash);
   }
 
   // Getters for computed values
@@ -258,8 +281,16 @@ class CellChecker {
       return;
     }
 
-    static_assert(2 + CellTraits::max_bytes + CellTraits::max_refs * (hash_bytes + depth_bytes) <= 512);
-    char data_to_hash[512];
+    static_assert(2 + CellTraits::max_bytes + CellTraits::max_refs * (hash_bytes + depth_bytes) <= max_hash_input);
+    char data_to_hash[max_hash_input];
+    auto size = hash_input(level, last_computed_hash, data_to_hash);
+
+    digest::SHA256 hasher;
+    hasher.feed(data_to_hash, size);
+    hasher.extract(hash_[level].as_slice());
+  }
+
+  size_t hash_input(int level, int last_computed_hash, char* data_to_hash) const {
     int pointer = 0;
 
     auto add_byte_to_hash = [&](char byte) { data_to_hash[pointer++] = byte; };
@@ -301,9 +332,7 @@ class CellChecker {
       add_slice_to_hash(refs_[i]->get_hash(child_level).as_slice());
     }
 
-    digest::SHA256 hasher;
-    hasher.feed(data_to_hash, pointer);
-    hasher.extract(hash_[level].as_slice());
+    return pointer;
   }
 
   bool is_special_;
@@ -319,6 +348,10 @@ class CellChecker {
   std::array<CellHash, max_level + 1> hash_{};
 };
 
+}  // namespace detail
+
+namespace {
+
 char* allocate_in_arena(size_t size) {
   constexpr size_t batch_size = 1 << 20;
   thread_local td::MutableSlice batch;
@@ -336,7 +369,7 @@ char* allocate_in_arena(size_t size) {
 
 thread_local bool DataCell::use_arena = false;
 
-td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs, bool is_special) {
+td::Status DataCell::check_args(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs) {
   CHECK(bit_length >= 0 && data.size() * 8 >= static_cast<size_t>(bit_length));
   if (refs.size() > CellTraits::max_refs) {
     return td::Status::Error("Too many references");
@@ -344,10 +377,69 @@ td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::S
   if (bit_length > CellTraits::max_bits) {
     return td::Status::Error("Too many data bits");
   }
+  return td::Status::OK();
+}
 
-  CellChecker checker{is_special, data, bit_length, refs};
+td::Result<Ref<DataCell>> DataCell::create(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs, bool is_special) {
+  TRY_STATUS(check_args(data, bit_length, refs));
+
+  detail::CellChecker checker{is_special, data, bit_length, refs};
   TRY_STATUS(checker.check_and_compute_level_info());
+  return create_checked(checker, data, bit_length, refs);
+}
+
+std::vector<td::Result<Ref<DataCell>>> DataCell::create_batch(td::Span<CreateArgs> cells) {
+  std::vector<td::Result<Ref<DataCell>>> result(cells.size());
+  std::vector<bool> failed(cells.size());
+  std::vector<detail::CellChecker> checkers;
+  checkers.reserve(cells.size());
+
+  std::vector<size_t> batched;
+  std::vector<char> inputs(cells.size() * detail::CellChecker::max_hash_input);
+  std::vector<td::Slice> input_slices;
+  for (size_t i = 0; i < cells.size(); i++) {
+    const auto& args = cells[i];
+    checkers.emplace_back(args.is_special, args.data, args.bit_length, args.refs);
+    auto status = check_args(args.data, args.bit_length, args.refs);
+    if (status.is_ok()) {
+      status = checkers[i].check_level_info();
+    }
+    if (status.is_error()) {
+      result[i] = std::move(status);
+      failed[i] = true;
+      continue;
+    }
+    if (!checkers[i].has_single_hash()) {
+      // higher level hashes are computed from the lower ones, one after another
+      checkers[i].compute_hashes();
+      continue;
+    }
+    auto input = inputs.data() + batched.size() * detail::CellChecker::max_hash_input;
+    input_slices.emplace_back(input, checkers[i].single_hash_input(input));
+    batched.push_back(i);
+  }
+
+  std::vector<CellHash> hashes(batched.size());
+  std::vector<td::MutableSlice> hash_slices;
+  hash_slices.reserve(hashes.size());
+  for (auto& hash : hashes) {
+    hash_slices.push_back(hash.as_slice());
+  }
+  digest::sha256_batch(input_slices, hash_slices);
+  for (size_t j = 0; j < batched.size(); j++) {
+    checkers[batched[j]].set_single_hash(hashes[j]);
+  }
+
+  for (size_t i = 0; i < cells.size(); i++) {
+    if (!failed[i]) {
+      result[i] = create_checked(checkers[i], cells[i].data, cells[i].bit_length, cells[i].refs);
+    }
+  }
+  return result;
+}
 
+Ref<DataCell> DataCell::create_checked(const detail::CellChecker& checker, td::Slice data, int bit_length,
+                                       td::Span<Ref<Cell>> refs) {
   auto level_info_size = sizeof(detail::LevelInfo) * (checker.level_mask().get_level() + 1);
   auto cell_size = sizeof(DataCell) + level_info_size + (bit_length + 7) / 8;
 
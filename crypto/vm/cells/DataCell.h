@@ -31,6 +31,8 @@ struct LevelInfo {
   td::uint16 depth;
 };
 
+class CellChecker;
+
 }  // namespace detail
 
 class DataCell final : public Cell {
@@ -40,6 +42,16 @@ class DataCell final : public Cell {
 
   static td::Result<Ref<DataCell>> create(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs, bool is_special);
 
+  struct CreateArgs {
+    td::Slice data;
+    int bit_length;
+    td::Span<Ref<Cell>> refs;
+    bool is_special;
+  };
+  // Same as create() for many cells, none of which may reference another one of the batch.
+  // Cells without levels have a single hash, these hashes are computed together by digest::sha256_batch.
+  static std::vector<td::Result<Ref<DataCell>>> create_batch(td::Span<CreateArgs> cells);
+
   static void store_depth(td::uint8* dest, td::uint16 depth) {
     td::bitstring::bits_store_long(dest, depth, depth_bits);
   }
@@ -171,6 +183,10 @@ class DataCell final : public Cell {
   DataCell(int bit_length, size_t refs_cnt, Cell::SpecialType type, LevelMask level_mask, bool allocated_in_arena,
            td::uint8 virtualization);
 
+  static td::Status check_args(td::Slice data, int bit_length, td::Span<Ref<Cell>> refs);
+  static Ref<DataCell> create_checked(const detail::CellChecker& checker, td::Slice data, int bit_length,
+                                      td::Span<Ref<Cell>> refs);
+
   detail::LevelInfo const* level_info() const {
     return reinterpret_cast<detail::LevelInfo const*>(trailer_);
   }
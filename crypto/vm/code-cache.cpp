@@ -0,0 +1,101 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/code-cache.h"
+#include "td/utils/LRUCache.h"
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+
+namespace vm {
+
+namespace {
+
+struct CodeKey {
+  CellHash hash;
+  const DispatchTable* table;
+
+  bool operator<(const CodeKey& other) const {
+    return std::tie(hash, table) < std::tie(other.hash, other.table);
+  }
+};
+
+// steps of different VMs switch code cells independently, one lock would serialize them
+constexpr std::size_t shards_count = 16;
+
+struct CacheShard {
+  std::mutex mutex;
+  std::unique_ptr<td::LRUCache<CodeKey, std::shared_ptr<DecodedCodeCache::Entry>>> cells;
+};
+
+CacheShard shards[shards_count];
+std::atomic<td::uint64> hits{0}, misses{0}, decoded{0};
+
+}  // namespace
+
+std::atomic<std::size_t> DecodedCodeCache::capacity_{0};
+
+DecodedCodeCache::Entry::Entry(unsigned bits) : slots_(new std::atomic<td::uint64>[bits]) {
+  for (unsigned i = 0; i < bits; i++) {
+    slots_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void DecodedCodeCache::Entry::set(unsigned pos, td::uint64 value) {
+  // concurrent VMs decoding the same offset store the same value
+  slots_[pos].store(value, std::memory_order_relaxed);
+  decoded.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DecodedCodeCache::set_capacity(std::size_t cells) {
+  for (auto& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cells.reset();
+    if (cells) {
+      shard.cells = std::make_unique<td::LRUCache<CodeKey, std::shared_ptr<Entry>>>(
+          std::max<std::size_t>(cells / shards_count, 1));
+    }
+  }
+  capacity_.store(cells, std::memory_order_relaxed);
+}
+
+std::shared_ptr<DecodedCodeCache::Entry> DecodedCodeCache::get(const DataCell& cell, const DispatchTable* table) {
+  CodeKey key{cell.get_hash(), table};
+  auto& shard = shards[key.hash.as_array()[0] % shards_count];
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (!shard.cells) {
+    return nullptr;
+  }
+  if (auto entry = shard.cells->get_if_exists(key)) {
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return *entry;
+  }
+  misses.fetch_add(1, std::memory_order_relaxed);
+  auto entry = std::make_shared<Entry>(cell.get_bits());
+  shard.cells->put(key, entry);
+  return entry;
+}
+
+DecodedCodeCache::Stats DecodedCodeCache::get_stats() {
+  Stats stats;
+  stats.hits = hits.load(std::memory_order_relaxed);
+  stats.misses = misses.load(std::memory_order_relaxed);
+  stats.decoded = decoded.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace vm
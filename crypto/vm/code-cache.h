@@ -0,0 +1,68 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "vm/cells/DataCell.h"
+#include "td/utils/int_types.h"
+#include <atomic>
+#include <memory>
+
+namespace vm {
+
+class DispatchTable;
+
+// Decoded instruction streams of TVM code cells, shared by all VmStates of the process. Disabled by default.
+//
+// For every code cell (by hash) and dispatch table (i.e. codepage) an entry remembers, per bit offset in the cell, the
+// instruction starting there as packed by DispatchTable::decode_instr(): handler index, opcode bits and their length.
+// VmState::step() executes these records directly instead of prefetching the opcode and searching the opcode table
+// on every step. Handlers still take their operands from the code slice and charge gas themselves, so gas accounting
+// and cell load charging are exactly those of the uncached path.
+class DecodedCodeCache {
+ public:
+  class Entry {
+   public:
+    explicit Entry(unsigned bits);
+    // Packed instruction at bit offset `pos` of the cell, 0 if it was not decoded yet
+    td::uint64 get(unsigned pos) const {
+      return slots_[pos].load(std::memory_order_relaxed);
+    }
+    void set(unsigned pos, td::uint64 decoded);
+
+   private:
+    std::unique_ptr<std::atomic<td::uint64>[]> slots_;
+  };
+
+  struct Stats {
+    td::uint64 hits{0};     // code cells found decoded
+    td::uint64 misses{0};   // code cells seen for the first time or evicted
+    td::uint64 decoded{0};  // instructions decoded
+  };
+
+  // Keeps up to `cells` decoded code cells in LRU order; 0 disables the cache and drops all entries
+  static void set_capacity(std::size_t cells);
+  static bool enabled() {
+    return capacity_.load(std::memory_order_relaxed) != 0;
+  }
+  // Entry of `cell` under `table`, created empty on the first use; nullptr if the cache is disabled
+  static std::shared_ptr<Entry> get(const DataCell& cell, const DispatchTable* table);
+  static Stats get_stats();
+
+ private:
+  static std::atomic<std::size_t> capacity_;
+};
+
+}  // namespace vm
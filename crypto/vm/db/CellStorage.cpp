@@ -100,12 +100,18 @@ class RefcntCellStorer {
 
 class RefcntCellParser {
  public:
-  RefcntCellParser(bool need_data) : need_data_(need_data) {
+  RefcntCellParser(bool need_data, bool defer_create = false) : need_data_(need_data), defer_create_(defer_create) {
   }
   td::int32 refcnt;
   Ref<DataCell> cell;
   bool stored_boc_;
 
+  // with defer_create a cell stored without BOC is not created by parse(), it is left pending in these fields
+  bool pending_{false};
+  CellSerializationInfo info_;
+  td::Slice cell_data_;
+  std::array<Ref<Cell>, Cell::max_refs> refs_;
+
   template <class ParserT>
   void parse(ParserT &parser, ExtCellCreator &ext_cell_creator) {
     using ::td::parse;
@@ -134,7 +140,7 @@ class RefcntCellParser {
       TRY_STATUS(info.init(cell_data, 0 /*ref_byte_size*/));
       data = data.substr(info.end_offset);
 
-      Ref<Cell> refs[Cell::max_refs];
+      auto &refs = refs_;
       for (int i = 0; i < info.refs_cnt; i++) {
         if (data.size() < 1) {
           return td::Status::Error("Not enough data");
@@ -155,7 +161,13 @@ class RefcntCellParser {
       if (!data.empty()) {
         return td::Status::Error("Too much data");
       }
-      TRY_RESULT(data_cell, info.create_data_cell(cell_data, td::Span<Ref<Cell>>(refs, info.refs_cnt)));
+      if (defer_create_) {
+        pending_ = true;
+        info_ = info;
+        cell_data_ = cell_data;
+        return td::Status::OK();
+      }
+      TRY_RESULT(data_cell, info.create_data_cell(cell_data, td::Span<Ref<Cell>>(refs.data(), info.refs_cnt)));
       cell = std::move(data_cell);
       return td::Status::OK();
     }();
@@ -167,6 +179,7 @@ class RefcntCellParser {
 
  private:
   bool need_data_;
+  bool defer_create_;
 };
 }  // namespace
 
@@ -199,20 +212,52 @@ td::Result<std::vector<CellLoader::LoadResult>> CellLoader::load_bulk(td::Span<t
                                                                 ExtCellCreator &ext_cell_creator) {
   std::vector<std::string> values;
   TRY_RESULT(get_statuses, reader_->get_multi(hashes, &values));
-  std::vector<LoadResult> res;
-  res.reserve(hashes.size());
+  std::vector<LoadResult> res(hashes.size());
+
+  // refs of loaded cells are ext cells, so the loaded cells are independent and are created in one batch
+  std::vector<RefcntCellParser> parsers;
+  parsers.reserve(hashes.size());
+  std::vector<size_t> pending;
+  std::vector<DataCell::CreateArgs> args;
   for (size_t i = 0; i < hashes.size(); i++) {
+    parsers.emplace_back(need_data, true);
     auto get_status = get_statuses[i];
     if (get_status != KeyValue::GetStatus::Ok) {
       DCHECK(get_status == KeyValue::GetStatus::NotFound);
-      res.push_back(LoadResult{});
       continue;
     }
-    TRY_RESULT(load_res, load(hashes[i], values[i], need_data, ext_cell_creator));
+    auto &refcnt_cell = parsers.back();
+    td::TlParser parser(values[i]);
+    refcnt_cell.parse(parser, ext_cell_creator);
+    TRY_STATUS(parser.get_status());
+    if (refcnt_cell.pending_) {
+      TRY_RESULT(bits, refcnt_cell.info_.get_bits(refcnt_cell.cell_data_));
+      args.push_back(DataCell::CreateArgs{refcnt_cell.cell_data_.substr(refcnt_cell.info_.data_offset), bits,
+                                          td::Span<Ref<Cell>>(refcnt_cell.refs_.data(), refcnt_cell.info_.refs_cnt),
+                                          refcnt_cell.info_.special});
+      pending.push_back(i);
+    }
+  }
+
+  auto created = DataCell::create_batch(args);
+  for (size_t j = 0; j < pending.size(); j++) {
+    auto &refcnt_cell = parsers[pending[j]];
+    TRY_RESULT(data_cell, std::move(created[j]));
+    TRY_RESULT_ASSIGN(refcnt_cell.cell, refcnt_cell.info_.check_data_cell(std::move(data_cell), refcnt_cell.cell_data_));
+  }
+
+  for (size_t i = 0; i < hashes.size(); i++) {
+    if (get_statuses[i] != KeyValue::GetStatus::Ok) {
+      continue;
+    }
+    auto &load_res = res[i];
+    load_res.status = LoadResult::Ok;
+    load_res.refcnt_ = parsers[i].refcnt;
+    load_res.cell_ = std::move(parsers[i].cell);
+    load_res.stored_boc_ = parsers[i].stored_boc_;
     if (on_load_callback_) {
       on_load_callback_(load_res);
     }
-    res.push_back(std::move(load_res));
   }
   return res;
 }
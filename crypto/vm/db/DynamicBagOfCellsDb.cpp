@@ -97,7 +97,7 @@ bool operator<(td::Slice a, const CellInfo &b) {
 
 class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreator {
  public:
-  DynamicBagOfCellsDbImpl() {
+  explicit DynamicBagOfCellsDbImpl(CreateV1Options options) : options_(options) {
     get_thread_safe_counter().add(1);
   }
   ~DynamicBagOfCellsDbImpl() {
@@ -149,6 +149,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     }
     Ref<DataCell> cell = res.cell();
     hash_table_.apply(hash, [&](CellInfo &info) { update_cell_info_loaded(info, hash, std::move(res)); });
+    cell_db_reader_->prefetch_children(cell);
     return cell;
   }
   td::Result<Ref<DataCell>> load_root(td::Slice hash) override {
@@ -303,7 +304,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     //cell_db_reader_ = std::make_shared<CellDbReaderImpl>(this);
     // Temporary(?) fix to make ExtCell thread safe.
     // Downside(?) - loaded cells won't be cached
-    cell_db_reader_ = std::make_shared<CellDbReaderImpl>(std::make_unique<CellLoader>(*loader_));
+    cell_db_reader_ = std::make_shared<CellDbReaderImpl>(std::make_unique<CellLoader>(*loader_), options_);
     stats_diff_ = {};
     return td::Status::OK();
   }
@@ -317,6 +318,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
   }
 
  private:
+  CreateV1Options options_;
   std::unique_ptr<CellLoader> loader_;
   std::vector<Ref<Cell>> to_inc_;
   std::vector<Ref<Cell>> to_dec_;
@@ -357,7 +359,11 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
                            private ExtCellCreator,
                            public std::enable_shared_from_this<CellDbReaderImpl> {
    public:
-    CellDbReaderImpl(std::unique_ptr<CellLoader> cell_loader) : db_(nullptr), cell_loader_(std::move(cell_loader)) {
+    CellDbReaderImpl(std::unique_ptr<CellLoader> cell_loader, const CreateV1Options &options)
+        : db_(nullptr)
+        , cell_loader_(std::move(cell_loader))
+        , prefetch_depth_(options.prefetch_depth)
+        , prefetch_fanout_(options.prefetch_fanout) {
       if (cell_loader_) {
         get_thread_safe_counter().add(1);
       }
@@ -396,6 +402,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       if (load_result.status != CellLoader::LoadResult::Ok) {
         return td::Status::Error(57, "cell not found");
       }
+      prefetch_children(load_result.cell());
       return std::move(load_result.cell());
     }
 
@@ -416,13 +423,85 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       return res;
     }
 
+    void prefetch(td::Span<Ref<Cell>> cells) override {
+      if (db_) {
+        return;
+      }
+      std::vector<Ref<Cell>> unloaded;
+      for (auto &cell : cells) {
+        if (!cell->is_loaded()) {
+          unloaded.push_back(cell);
+        }
+      }
+      load_into(unloaded);
+    }
+
+    void prefetch_children(const Ref<DataCell> &cell) {
+      if (db_ || prefetch_depth_ == 0) {
+        return;
+      }
+      std::vector<Ref<DataCell>> level{cell};
+      for (td::uint32 depth = 0; depth < prefetch_depth_ && !level.empty(); depth++) {
+        std::vector<Ref<Cell>> children;
+        for (auto &parent : level) {
+          for (unsigned i = 0; i < parent->size_refs() && children.size() < prefetch_fanout_; i++) {
+            auto child = parent->get_ref(i);
+            if (!child->is_loaded()) {
+              children.push_back(std::move(child));
+            }
+          }
+        }
+        level = load_into(children);
+      }
+    }
+
    private:
     static td::NamedThreadSafeCounter::CounterRef get_thread_safe_counter() {
       static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DynamicBagOfCellsDbLoader");
       return res;
     }
+    static td::NamedThreadSafeCounter::CounterRef get_prefetch_counter() {
+      static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DynamicBagOfCellsDbPrefetched");
+      return res;
+    }
     DynamicBagOfCellsDb *db_;
     std::unique_ptr<CellLoader> cell_loader_;
+    td::uint32 prefetch_depth_{0};
+    td::uint32 prefetch_fanout_{0};
+
+    // Loads the data of ext cells with one get_multi. Loading is speculative, so errors are ignored and the cells
+    // stay unloaded. Returns the data cells which were loaded.
+    std::vector<Ref<DataCell>> load_into(const std::vector<Ref<Cell>> &cells) {
+      std::vector<Ref<DataCell>> res;
+      if (cells.empty()) {
+        return res;
+      }
+      std::vector<CellHash> hashes;
+      hashes.reserve(cells.size());
+      for (auto &cell : cells) {
+        hashes.push_back(cell->get_hash());
+      }
+      std::vector<td::Slice> keys;
+      keys.reserve(hashes.size());
+      for (auto &hash : hashes) {
+        keys.push_back(hash.as_slice());
+      }
+      auto r_load_result = cell_loader_->load_bulk(keys, true, *this);
+      if (r_load_result.is_error()) {
+        return res;
+      }
+      auto load_result = r_load_result.move_as_ok();
+      for (size_t i = 0; i < cells.size(); i++) {
+        if (load_result[i].status != CellLoader::LoadResult::Ok ||
+            cells[i]->set_data_cell(std::move(load_result[i].cell())).is_error()) {
+          continue;
+        }
+        // the cell may have been loaded concurrently, continue with the data it actually holds
+        res.push_back(cells[i]->load_cell().move_as_ok().data_cell);
+      }
+      get_prefetch_counter().add(static_cast<td::int64>(res.size()));
+      return res;
+    }
   };
 
   std::shared_ptr<CellDbReaderImpl> cell_db_reader_;
@@ -904,7 +983,11 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
 };
 }  // namespace
 
-std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create(CreateV1Options) {
-  return std::make_unique<DynamicBagOfCellsDbImpl>();
+std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create() {
+  return create(CreateV1Options{});
+}
+
+std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create(CreateV1Options options) {
+  return std::make_unique<DynamicBagOfCellsDbImpl>(options);
 }
 }  // namespace vm
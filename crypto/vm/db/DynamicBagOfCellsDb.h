@@ -46,6 +46,9 @@ class CellDbReader {
   virtual ~CellDbReader() = default;
   virtual td::Result<Ref<DataCell>> load_cell(td::Slice hash) = 0;
   virtual td::Result<std::vector<Ref<DataCell>>> load_bulk(td::Span<td::Slice> hashes) = 0;
+  // Speculatively loads the not yet loaded cells among `cells` in one bulk request, see DictionaryFixed::prefetch_levels
+  virtual void prefetch(td::Span<Ref<Cell>> cells) {
+  }
 };
 
 class DynamicBagOfCellsDb {
@@ -124,11 +127,17 @@ class DynamicBagOfCellsDb {
   };
 
   struct CreateV1Options {
+    // A cell loaded from the db also loads up to `prefetch_depth` levels of its children with one MultiGet per level,
+    // at most `prefetch_fanout` cells per level
+    td::uint32 prefetch_depth{0};
+    td::uint32 prefetch_fanout{16};
     friend td::StringBuilder &operator<<(td::StringBuilder &sb, const CreateV1Options &options) {
-      return sb << "V1{}";
+      return sb << "V1{prefetch_depth=" << options.prefetch_depth << ", prefetch_fanout=" << options.prefetch_fanout
+                << "}";
     }
   };
-  static std::unique_ptr<DynamicBagOfCellsDb> create(CreateV1Options = {});
+  static std::unique_ptr<DynamicBagOfCellsDb> create();
+  static std::unique_ptr<DynamicBagOfCellsDb> create(CreateV1Options options);
 
   struct CreateV2Options {
     size_t extra_threads{std::thread::hardware_concurrency()};
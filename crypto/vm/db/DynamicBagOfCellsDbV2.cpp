@@ -5,6 +5,7 @@
 #include "vm/cells/ExtCell.h"
 
 #include "td/utils/base64.h"
+#include "td/utils/EpochBasedMemoryReclamation.h"
 #include "td/utils/format.h"
 #include "td/utils/ThreadSafeCounter.h"
 #include "td/utils/misc.h"
@@ -128,6 +129,11 @@ struct CacheStats {
   S(sync_with_db);
   S(sync_with_db_only_ref);
   S(load_cell_no_cache);
+
+  S(cache_lookup_hits);
+  S(cache_lookup_misses);
+  S(cache_lookup_locked);
+  S(cache_evicted_cells);
 };
 
 struct CommitStats {
@@ -639,6 +645,161 @@ struct Executor {
   ExecutorOptions options_;
 };
 
+// Slot of the current thread in EpochBasedMemoryReclamation. td::get_thread_id() can't be used, because it is 0 for
+// every thread not started by td::thread. A slot is owned by the thread until it exits, there are at most max_slots
+// of them, threads beyond that just don't use lock-free paths.
+class ThreadSlots {
+ public:
+  static constexpr size_t max_slots = 256;
+  static constexpr size_t no_slot = max_slots;
+
+  static size_t get() {
+    static thread_local Slot slot;
+    return slot.slot;
+  }
+
+ private:
+  struct Slot {
+    size_t slot{acquire()};
+    ~Slot() {
+      release(slot);
+    }
+  };
+  static std::mutex &mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+  static std::vector<size_t> &free_slots() {
+    static std::vector<size_t> slots;
+    return slots;
+  }
+  static size_t acquire() {
+    static size_t next_slot = 0;
+    std::lock_guard guard(mutex());
+    auto &slots = free_slots();
+    if (!slots.empty()) {
+      auto slot = slots.back();
+      slots.pop_back();
+      return slot;
+    }
+    if (next_slot < max_slots) {
+      return next_slot++;
+    }
+    return no_slot;
+  }
+  static void release(size_t slot) {
+    if (slot == no_slot) {
+      return;
+    }
+    std::lock_guard guard(mutex());
+    free_slots().push_back(slot);
+  }
+};
+
+// Lock-free index of CellInfo by hash: open-addressed tables, one per shard, readers never wait.
+// Entries are never removed (CellInfo lives as long as the storage), a full table is replaced with a twice larger one
+// and the old table is freed by epoch based reclamation once no reader may still look into it.
+// The index is only a fast path: an entry may be missing for a moment after its CellInfo was created.
+class CellInfoIndex {
+ public:
+  CellInfoIndex() {
+    lockers_.reserve(ThreadSlots::max_slots);
+    for (size_t i = 0; i < ThreadSlots::max_slots; i++) {
+      lockers_.push_back(ebmr_.get_locker(i));
+    }
+  }
+  ~CellInfoIndex() {
+    lockers_.clear();
+    for (auto &shard : shards_) {
+      delete shard.table.load(std::memory_order_relaxed);
+    }
+  }
+
+  // returns nullptr if the entry is not in the index (yet)
+  CellInfo *find(size_t slot, td::Slice hash) {
+    auto &locker = lockers_[slot];
+    locker.lock();
+    CellInfo *res = nullptr;
+    auto *table = get_shard(hash).table.load(std::memory_order_acquire);
+    if (table) {
+      for (size_t i = get_pos(hash), left = table->mask + 1; left > 0; i++, left--) {
+        auto *info = table->slots[i & table->mask].load(std::memory_order_acquire);
+        if (info == nullptr) {
+          break;
+        }
+        if (info->key().as_slice() == hash) {
+          res = info;
+          break;
+        }
+      }
+    }
+    locker.unlock();
+    return res;
+  }
+
+  void insert(size_t slot, CellInfo *info) {
+    auto hash = info->key();
+    auto &shard = get_shard(hash.as_slice());
+    std::lock_guard guard(shard.mutex);
+    auto *table = shard.table.load(std::memory_order_relaxed);
+    if (table == nullptr || (shard.size + 1) * 2 > table->mask + 1) {
+      auto *new_table = new Table(table ? (table->mask + 1) * 2 : 64);
+      if (table) {
+        for (size_t i = 0; i <= table->mask; i++) {
+          auto *old_info = table->slots[i].load(std::memory_order_relaxed);
+          if (old_info) {
+            new_table->insert(get_pos(old_info->key().as_slice()), old_info);
+          }
+        }
+      }
+      shard.table.store(new_table, std::memory_order_release);
+      if (table) {
+        auto &locker = lockers_[slot];
+        locker.lock();
+        locker.retire(table);
+        locker.unlock();
+      }
+      table = new_table;
+    }
+    table->insert(get_pos(hash.as_slice()), info);
+    shard.size++;
+  }
+
+ private:
+  struct Table {
+    explicit Table(size_t capacity) : mask(capacity - 1), slots(new std::atomic<CellInfo *>[capacity]) {
+      for (size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    void insert(size_t pos, CellInfo *info) {
+      while (slots[pos & mask].load(std::memory_order_relaxed) != nullptr) {
+        pos++;
+      }
+      slots[pos & mask].store(info, std::memory_order_release);
+    }
+    size_t mask;
+    std::unique_ptr<std::atomic<CellInfo *>[]> slots;
+  };
+  struct Shard {
+    std::atomic<Table *> table{nullptr};
+    std::mutex mutex;
+    size_t size{0};
+    char pad[TD_CONCURRENCY_PAD];
+  };
+  constexpr static size_t shards_n = 64;
+  std::array<Shard, shards_n> shards_;
+  td::EpochBasedMemoryReclamation<Table> ebmr_{ThreadSlots::max_slots};
+  std::vector<td::EpochBasedMemoryReclamation<Table>::Locker> lockers_;
+
+  Shard &get_shard(td::Slice hash) {
+    return shards_[td::as<td::uint64>(hash.substr(8, 8).ubegin()) % shards_n];
+  }
+  static size_t get_pos(td::Slice hash) {
+    return static_cast<size_t>(td::as<td::uint64>(hash.ubegin()));
+  }
+};
+
 // Thread safe storage for CellInfo
 // Will be used by everybody as shared cache. Yes there is some overhead, but it don't want to create other hash table
 struct CellInfoStorage {
@@ -647,8 +808,22 @@ struct CellInfoStorage {
   // All CellInfo pointers lives as long as CellInfoStorage
 
   // returns CellInfo, only if it is already exists
-  CellInfo *get_cell_info(td::Slice hash) {
-    return lock(hash)->hash_table.get_if_exists(hash);
+  CellInfo *get_cell_info(td::Slice hash, CacheStats &stats) {
+    auto slot = ThreadSlots::get();
+    if (slot != ThreadSlots::no_slot) {
+      auto *info = index_.find(slot, hash);
+      if (info != nullptr) {
+        stats.cache_lookup_hits.inc();
+        return info;
+      }
+    }
+    // the index may lag behind the hash table, which is the source of truth
+    stats.cache_lookup_locked.inc();
+    auto *info = lock(hash)->hash_table.get_if_exists(hash);
+    if (info == nullptr) {
+      stats.cache_lookup_misses.inc();
+    }
+    return info;
   }
 
   CellInfo &create_cell_info_from_db(Ref<DataCell> data_cell, td::int32 ref_cnt) {
@@ -665,7 +840,9 @@ struct CellInfoStorage {
     auto hash = cell->get_hash();
     auto [info, created] = lock(hash.as_slice())->hash_table.emplace(hash.as_slice(), std::move(cell));
 
-    if (!created) {
+    if (created) {
+      add_to_index(info);
+    } else {
       info.cell->set_data_cell(std::move(cell));
     }
     return info;
@@ -692,6 +869,9 @@ struct CellInfoStorage {
 
     auto hash = cell->get_hash();
     auto [info, created] = lock(hash.as_slice())->hash_table.emplace(hash.as_slice(), std::move(cell));
+    if (created) {
+      add_to_index(info);
+    }
     if (our_ext_cell) {
       stats.ext_cells_load.inc();
       if (info.cell->is_loaded()) {
@@ -738,6 +918,14 @@ struct CellInfoStorage {
   };
   std::array<Bucket, buckets_n> buckets_{};
   std::atomic<bool> force_drop_cache_{false};
+  CellInfoIndex index_;
+
+  void add_to_index(CellInfo &info) {
+    auto slot = ThreadSlots::get();
+    if (slot != ThreadSlots::no_slot) {
+      index_.insert(slot, &info);
+    }
+  }
 
   std::unique_ptr<Bucket, Unlock> lock(Bucket &bucket) {
     bucket.mutex.lock();
@@ -1062,6 +1250,9 @@ class DynamicBagOfCellsDbImplV2 : public DynamicBagOfCellsDb {
     }
     void drop_cache() {
       // NOT thread safe
+      if (internal_storage_) {
+        stats_.cache_evicted_cells.add(internal_storage_->cache_size());
+      }
       internal_storage_.reset();
     }
 
@@ -1212,7 +1403,7 @@ class DynamicBagOfCellsDbImplV2 : public DynamicBagOfCellsDb {
       if (!storage) {
         return {};
       }
-      auto cell_info = storage->get_cell_info(hash);
+      auto cell_info = storage->get_cell_info(hash, stats_);
       if (cell_info != nullptr) {
         if (!cell_info->cell->is_loaded()) {
           if (may_block) {
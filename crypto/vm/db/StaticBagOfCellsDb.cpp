@@ -27,6 +27,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/port/RwMutex.h"
 #include "td/utils/ConcurrentHashTable.h"
+#include "td/utils/LRUCache.h"
 
 #include <limits>
 
@@ -118,6 +119,46 @@ class DataCellCacheMutex {
   td::HashMap<int, Ref<DataCell>> cells_;
 };
 
+class DataCellCacheLru {
+ public:
+  explicit DataCellCacheLru(size_t max_cells) {
+    for (auto& bucket : buckets_) {
+      bucket.cells = std::make_unique<td::LRUCache<int, Ref<DataCell>>>(td::max<size_t>(max_cells / buckets_count, 1));
+    }
+  }
+  Ref<DataCell> store(int idx, Ref<DataCell> cell) {
+    auto& bucket = get_bucket(idx);
+    std::lock_guard lock(bucket.mutex);
+    auto* cached = bucket.cells->get_if_exists(idx);
+    if (cached) {
+      return *cached;
+    }
+    bucket.cells->put(idx, cell);
+    return cell;
+  }
+  Ref<DataCell> load(int idx) {
+    auto& bucket = get_bucket(idx);
+    std::lock_guard lock(bucket.mutex);
+    auto* cached = bucket.cells->get_if_exists(idx);
+    if (cached) {
+      return *cached;
+    }
+    return {};
+  }
+
+ private:
+  static constexpr size_t buckets_count = 16;
+  struct Bucket {
+    std::mutex mutex;
+    std::unique_ptr<td::LRUCache<int, Ref<DataCell>>> cells;
+  };
+  std::array<Bucket, buckets_count> buckets_;
+
+  Bucket& get_bucket(int idx) {
+    return buckets_[static_cast<td::uint32>(idx) % buckets_count];
+  }
+};
+
 class DataCellCacheTdlib {
  public:
   Ref<DataCell> store(int idx, Ref<DataCell> cell) {
@@ -215,7 +256,10 @@ td::Result<std::shared_ptr<StaticBagOfCellsDb>> StaticBagOfCellsDbBaseline::crea
 class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
  public:
   explicit StaticBagOfCellsDbLazyImpl(td::BlobView data, StaticBagOfCellsDbLazy::Options options)
-      : data_(std::move(data)), options_(std::move(options)) {
+      : data_(std::move(data)), options_(std::move(options)), memory_(data_.as_slice()) {
+    if (options_.max_cached_cells != 0) {
+      lru_cells_ = std::make_unique<DataCellCacheLru>(options_.max_cached_cells);
+    }
     get_thread_safe_counter().add(1);
   }
   td::Result<size_t> get_root_count() override {
@@ -245,6 +289,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
   std::atomic<bool> should_cache_cells_{true};
   td::BlobView data_;
   StaticBagOfCellsDbLazy::Options options_;
+  // the blob itself when it is held in memory, cells are then parsed in place
+  td::Slice memory_;
   bool has_info_{false};
   BagOfCells::Info info_;
 
@@ -256,6 +302,9 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
   DataCellCacheMutex cells_;
   //DataCellCacheNoop cells_;
   //DataCellCacheTdlib cells_;
+  std::unique_ptr<DataCellCacheLru> lru_cells_;
+  std::atomic<size_t> prefetched_begin_{0};
+  std::atomic<size_t> prefetched_end_{0};
   int next_idx_{0};
   Ref<Cell> empty_cell_;
 
@@ -446,6 +495,9 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
   }
 
   Ref<DataCell> get_data_cell(int idx) {
+    if (lru_cells_) {
+      return lru_cells_->load(idx);
+    }
     return cells_.load(idx);
   }
 
@@ -454,6 +506,9 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
       return cell;
     }
     CHECK(cell.not_null());
+    if (lru_cells_) {
+      return lru_cells_->store(idx, std::move(cell));
+    }
     return cells_.store(idx, std::move(cell));
   }
 
@@ -465,6 +520,28 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
     return set_data_cell(idx, std::move(data_cell));
   }
 
+  td::Result<td::Slice> view_cell(const CellLocation& location, Ptr& buf) {
+    if (!memory_.empty()) {
+      if (location.end > memory_.size()) {
+        return td::Status::Error(PSLICE() << "bag-of-cell error: cell location " << location.begin << ":"
+                                          << location.end << " is out of data (size=" << memory_.size() << ")");
+      }
+      return memory_.substr(location.begin, location.end - location.begin);
+    }
+    buf = alloc(location.end - location.begin);
+    return data_.view(buf.as_slice(), location.begin);
+  }
+
+  void prefetch(size_t offset) {
+    if (offset >= prefetched_begin_.load(std::memory_order_relaxed) &&
+        offset + options_.prefetch_bytes / 2 < prefetched_end_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    prefetched_begin_.store(offset, std::memory_order_relaxed);
+    prefetched_end_.store(offset + options_.prefetch_bytes, std::memory_order_relaxed);
+    data_.advise(offset, options_.prefetch_bytes, td::BlobView::Advice::WillNeed).ignore();
+  }
+
   td::Result<Ref<Cell>> load_any_cell(int idx) {
     {
       auto cell = get_any_cell(idx);
@@ -474,8 +551,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
     }
 
     TRY_RESULT(cell_location, get_cell_location(idx));
-    auto buf = alloc(cell_location.end - cell_location.begin);
-    TRY_RESULT(cell_slice, data_.view(buf.as_slice(), cell_location.begin));
+    Ptr buf;
+    TRY_RESULT(cell_slice, view_cell(cell_location, buf));
     TRY_RESULT(res, deserialize_any_cell(idx, cell_slice, cell_location.should_cache));
     return std::move(res);
   }
@@ -489,8 +566,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
     }
 
     TRY_RESULT(cell_location, get_cell_location(idx));
-    auto buf = alloc(cell_location.end - cell_location.begin);
-    TRY_RESULT(cell_slice, data_.view(buf.as_slice(), cell_location.begin));
+    Ptr buf;
+    TRY_RESULT(cell_slice, view_cell(cell_location, buf));
     TRY_RESULT(res, deserialize_data_cell(idx, cell_slice, cell_location.should_cache));
     return std::move(res);
   }
@@ -513,6 +590,13 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
                                         << " refs");
     }
     auto* ref_ptr = cell_slice.ubegin() + cell_info.refs_offset;
+    if (options_.prefetch_bytes != 0 && cell_info.refs_cnt > 0 && !memory_.empty()) {
+      // references always point forward and a subtree is mostly serialized right after its root
+      auto r_location = get_cell_location(td::narrow_cast<int>(info_.read_ref(ref_ptr)));
+      if (r_location.is_ok()) {
+        prefetch(r_location.ok().begin);
+      }
+    }
     for (int k = 0; k < cell_info.refs_cnt; k++, ref_ptr += info_.ref_byte_size) {
       int ref_idx = td::narrow_cast<int>(info_.read_ref(ref_ptr));
       if (ref_idx >= info_.cell_count) {
@@ -564,4 +648,12 @@ td::Result<std::shared_ptr<StaticBagOfCellsDb>> StaticBagOfCellsDbLazy::create(s
   return create(td::BufferSliceBlobView::create(td::BufferSlice(data)), std::move(options));
 }
 
+td::Result<std::shared_ptr<StaticBagOfCellsDb>> StaticBagOfCellsDbLazy::create_from_file(td::CSlice file_path,
+                                                                                         Options options) {
+  TRY_RESULT(data, td::FileMemoryMappingBlobView::create(file_path));
+  // point lookups touch a few pages each, kernel readahead is replaced with explicit prefetching
+  TRY_STATUS(data.advise(0, data.size(), td::BlobView::Advice::Random));
+  return create(std::move(data), std::move(options));
+}
+
 }  // namespace vm
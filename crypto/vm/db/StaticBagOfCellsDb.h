@@ -51,10 +51,17 @@ class StaticBagOfCellsDbLazy {
     Options() {
     }
     bool check_crc32c{false};
+    // LRU bound on the number of materialized cells kept in memory, 0 means that all loaded cells are kept
+    size_t max_cached_cells{0};
+    // when the blob is in memory, this many bytes after the first reference of a loaded cell are prefetched,
+    // so that a scan of its subtree does not fault on every page
+    size_t prefetch_bytes{0};
   };
   static td::Result<std::shared_ptr<StaticBagOfCellsDb>> create(td::BlobView data, Options options = {});
   static td::Result<std::shared_ptr<StaticBagOfCellsDb>> create(td::BufferSlice data, Options options = {});
   static td::Result<std::shared_ptr<StaticBagOfCellsDb>> create(std::string data, Options options = {});
+  // Memory maps a serialized bag of cells (e.g. a persistent state file) for random access
+  static td::Result<std::shared_ptr<StaticBagOfCellsDb>> create_from_file(td::CSlice file_path, Options options = {});
 };
 
 }  // namespace vm
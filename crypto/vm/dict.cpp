@@ -2319,6 +2319,30 @@ bool DictionaryFixed::check_for_each(const foreach_func_t& foreach_func, bool in
                              shuffle);
 }
 
+void DictionaryFixed::prefetch_levels(const prefetch_func_t& prefetch, int levels, std::size_t max_cells) {
+  force_validate();
+  if (is_empty()) {
+    return;
+  }
+  std::vector<Ref<Cell>> level{get_root_cell()};
+  for (int i = 0; i < levels && !level.empty(); i++) {
+    prefetch(level);
+    std::vector<Ref<Cell>> next;
+    for (auto& cell : level) {
+      auto r_loaded_cell = cell->load_cell();
+      if (r_loaded_cell.is_error()) {
+        // the scan itself will report the missing cell
+        return;
+      }
+      auto& data_cell = r_loaded_cell.ok().data_cell;
+      for (unsigned j = 0; j < data_cell->size_refs() && next.size() < max_cells; j++) {
+        next.push_back(data_cell->get_ref(j));
+      }
+    }
+    level = std::move(next);
+  }
+}
+
 static inline bool set_bit(td::BitPtr ptr, bool value = true) {
   *ptr = value;
   return true;
@@ -185,6 +185,7 @@ class DictionaryFixed : public DictionaryBase {
   typedef std::function<bool(CellBuilder&, Ref<CellSlice>, Ref<CellSlice>, td::ConstBitPtr, int)> combine_func_t;
   typedef std::function<bool(Ref<CellSlice>, td::ConstBitPtr, int)> foreach_func_t;
   typedef std::function<bool(td::ConstBitPtr, int, Ref<CellSlice>, Ref<CellSlice>)> scan_diff_func_t;
+  typedef std::function<void(td::Span<Ref<Cell>>)> prefetch_func_t;
 
   DictionaryFixed(int _n, bool validate = true) : DictionaryBase(_n, validate) {
   }
@@ -224,6 +225,9 @@ class DictionaryFixed : public DictionaryBase {
   bool cut_prefix_subdict(td::ConstBitPtr prefix, int prefix_len, bool remove_prefix = false);
   Ref<vm::Cell> extract_prefix_subdict_root(td::ConstBitPtr prefix, int prefix_len, bool remove_prefix = false);
   bool check_for_each(const foreach_func_t& foreach_func, bool invert_first = false, bool shuffle = false);
+  // walks the upper `levels` levels of the tree breadth-first and hands every level (at most `max_cells` cells) to
+  // `prefetch` before descending, so that a scan over a cold CellDb pays one bulk request per level
+  void prefetch_levels(const prefetch_func_t& prefetch, int levels, std::size_t max_cells = 4096);
   int filter(filter_func_t check);
   bool combine_with(DictionaryFixed& dict2, const combine_func_t& combine_func, int mode = 0);
   bool combine_with(DictionaryFixed& dict2, const simple_combine_func_t& simple_combine_func, int mode = 0);
@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #pragma once
+#include "td/utils/int_types.h"
 #include <string>
 
 namespace vm {
@@ -33,6 +34,14 @@ class DispatchTable {
   virtual int dispatch(VmState* st, CellSlice& cs) const = 0;
   virtual std::string dump_instr(CellSlice& cs) const = 0;
   virtual int instr_len(const CellSlice& cs) const = 0;
+  // Instruction at the start of cs packed for DecodedCodeCache, 0 if the table can't decode ahead
+  virtual td::uint64 decode_instr(const CellSlice& cs) const {
+    return 0;
+  }
+  // Executes an instruction packed by decode_instr(), cs is at the offset it was decoded at
+  virtual int dispatch_decoded(VmState* st, CellSlice& cs, td::uint64 decoded) const {
+    return dispatch(st, cs);
+  }
   virtual DispatchTable* finalize() = 0;
   virtual bool is_final() const = 0;
   static const DispatchTable* get_table(Codepage cp);
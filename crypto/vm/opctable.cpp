@@ -16,6 +16,7 @@
 
     Copyright 2017-2020 Telegram Systems LLP
 */
+#include <algorithm>
 #include <cassert>
 #include <iterator>
 #include "vm/opctable.h"
@@ -57,6 +58,22 @@ DispatchTable* OpcodeTable::finalize() {
   }
 
   instruction_list.shrink_to_fit();
+
+  // most opcodes are resolved by the top byte alone, the rest mostly by the next one
+  top_level.clear();
+  second_level.clear();
+  for (unsigned b = 0; b < 256; b++) {
+    auto range = make_range(b << 16, (b + 1) << 16);
+    if (range.first != range.last) {
+      range.next = static_cast<td::uint32>(second_level.size());
+      for (unsigned c = 0; c < 256; c++) {
+        second_level.push_back(make_range((b << 16) | (c << 8), ((b << 16) | (c << 8)) + 256));
+      }
+    }
+    top_level.push_back(range);
+  }
+  second_level.shrink_to_fit();
+
   final = true;
   return this;
 }
@@ -100,9 +117,8 @@ bool OpcodeTable::insert_bool(const OpcodeInstr* instr) {
   return true;
 }
 
-const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) const {
-  std::size_t i = 0, j = instruction_list.size();
-  assert(j);
+std::size_t OpcodeTable::search_index(unsigned opcode, std::size_t i, std::size_t j) const {
+  assert(j > i);
   while (j - i > 1) {
     auto k = ((j + i) >> 1);
     if (instruction_list[k].first <= opcode) {
@@ -111,14 +127,39 @@ const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) con
       j = k;
     }
   }
-  return instruction_list[i].second;
+  return i;
 }
 
-const OpcodeInstr* OpcodeTable::lookup_instr(const CellSlice& cs, unsigned& opcode, unsigned& bits) const {
+OpcodeTable::DispatchRange OpcodeTable::make_range(unsigned opcode_min, unsigned opcode_max) const {
+  return {static_cast<td::uint32>(search_index(opcode_min, 0, instruction_list.size())),
+          static_cast<td::uint32>(search_index(opcode_max - 1, 0, instruction_list.size())), 0};
+}
+
+std::size_t OpcodeTable::lookup_index(unsigned opcode) const {
+  static_assert(max_opcode_bits == 24, "dispatch ranges are built for 24-bit opcodes");
+  const auto* range = &top_level[opcode >> 16];
+  if (range->first != range->last) {
+    range = &second_level[range->next + ((opcode >> 8) & 0xff)];
+    if (range->first != range->last) {
+      return search_index(opcode, range->first, range->last + 1);
+    }
+  }
+  return range->first;
+}
+
+const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) const {
+  return instruction_list[lookup_index(opcode)].second;
+}
+
+void OpcodeTable::prefetch_opcode(const CellSlice& cs, unsigned& opcode, unsigned& bits) {
   bits = max_opcode_bits;
   unsigned long long prefetch = cs.prefetch_ulong_top(bits);
   opcode = (unsigned)(prefetch >> (64 - max_opcode_bits));
   opcode &= (static_cast<int32_t>(static_cast<td::uint32>(-1) << max_opcode_bits) >> bits);
+}
+
+const OpcodeInstr* OpcodeTable::lookup_instr(const CellSlice& cs, unsigned& opcode, unsigned& bits) const {
+  prefetch_opcode(cs, opcode, bits);
   return lookup_instr(opcode, bits);
 }
 
@@ -144,6 +185,35 @@ int OpcodeTable::instr_len(const CellSlice& cs) const {
   return instr->instr_len(cs, opcode, bits);
 }
 
+int OpcodeTable::instr_len_by_search(const CellSlice& cs) const {
+  assert(final);
+  unsigned bits, opcode;
+  prefetch_opcode(cs, opcode, bits);
+  auto instr = instruction_list[search_index(opcode, 0, instruction_list.size())].second;
+  return instr->instr_len(cs, opcode, bits);
+}
+
+// packed as | 1 | index in instruction_list : 31 | 0 : 3 | available opcode bits : 5 | opcode : 24 |
+td::uint64 OpcodeTable::decode_instr(const CellSlice& cs) const {
+  assert(final);
+  unsigned bits, opcode;
+  lookup_instr(cs, opcode, bits);
+  auto index = lookup_index(opcode);
+  return (1ULL << 63) | (static_cast<td::uint64>(index) << 32) | (static_cast<td::uint64>(bits) << max_opcode_bits) |
+         opcode;
+}
+
+int OpcodeTable::dispatch_decoded(VmState* st, CellSlice& cs, td::uint64 decoded) const {
+  auto bits = static_cast<unsigned>(decoded >> max_opcode_bits) & 31;
+  if (bits != std::min<unsigned>(cs.size(), max_opcode_bits)) {
+    // the same offset of the cell seen through a slice ending elsewhere
+    return dispatch(st, cs);
+  }
+  auto index = static_cast<std::size_t>(decoded >> 32) & 0x7fffffff;
+  auto opcode = static_cast<unsigned>(decoded) & (top_opcode - 1);
+  return instruction_list[index].second->dispatch(st, cs, opcode, bits);
+}
+
 OpcodeInstr::OpcodeInstr(unsigned _opcode, unsigned _bits, bool)
     : min_opcode(_opcode << (max_opcode_bits - _bits)), max_opcode((_opcode + 1) << (max_opcode_bits - _bits)) {
   assert(_opcode < (1U << _bits) && _bits <= max_opcode_bits);
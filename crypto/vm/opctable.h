@@ -89,8 +89,14 @@ dump_arg_instr_func_t dump_2c_add(unsigned add, std::string prefix, std::string
 }  // namespace instr
 
 class OpcodeTable : public DispatchTable {
+  // instruction_list entries covering a range of opcodes, `next` is the second-level block of a range with several
+  struct DispatchRange {
+    td::uint32 first, last, next;
+  };
   std::map<unsigned, const OpcodeInstr*> instructions;
   std::vector<std::pair<unsigned, const OpcodeInstr*>> instruction_list;
+  // built by finalize(): indexed by the top opcode byte, then by the next one
+  std::vector<DispatchRange> top_level, second_level;
   std::string name;
   Codepage codepage;
   bool final;
@@ -110,10 +116,19 @@ class OpcodeTable : public DispatchTable {
   int dispatch(VmState* st, CellSlice& cs) const override;
   std::string dump_instr(CellSlice& cs) const override;
   int instr_len(const CellSlice& cs) const override;
+  // instr_len() resolving the opcode by a binary search over the whole instruction list, as before the dispatch
+  // ranges were built; the baseline for the opcode lookup benchmark
+  int instr_len_by_search(const CellSlice& cs) const;
+  td::uint64 decode_instr(const CellSlice& cs) const override;
+  int dispatch_decoded(VmState* st, CellSlice& cs, td::uint64 decoded) const override;
   bool insert_bool(const OpcodeInstr*);
   OpcodeTable& insert(const OpcodeInstr*);
 
  private:
+  static void prefetch_opcode(const CellSlice& cs, unsigned& opcode, unsigned& bits);
+  std::size_t search_index(unsigned opcode, std::size_t i, std::size_t j) const;
+  DispatchRange make_range(unsigned opcode_min, unsigned opcode_max) const;
+  std::size_t lookup_index(unsigned opcode) const;
   const OpcodeInstr* lookup_instr(unsigned opcode, unsigned bits) const;
   const OpcodeInstr* lookup_instr(const CellSlice& cs, unsigned& opcode, unsigned& bits) const;
 };
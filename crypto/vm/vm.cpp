@@ -430,6 +430,28 @@ VM_LOG(this) << "changing gas limit to " << std::min(new_limit, gas.gas_max);
 gas.change_limit(new_limit);
 }
 
+int VmState::dispatch_code(CellSlice& cs) {
+  const auto& cell = cs.get_data_cell();
+  if (cell.get() != decoded_cell.get() || dispatch != decoded_dispatch) {
+    decoded_code = DecodedCodeCache::get(*cell, dispatch);
+    decoded_cell = cell;
+    decoded_dispatch = dispatch;
+  }
+  if (!decoded_code) {
+    return dispatch->dispatch(this, cs);
+  }
+  auto pos = cs.cur_pos();
+  auto decoded = decoded_code->get(pos);
+  if (!decoded) {
+    decoded = dispatch->decode_instr(cs);
+    if (!decoded) {
+      return dispatch->dispatch(this, cs);
+    }
+    decoded_code->set(pos, decoded);
+  }
+  return dispatch->dispatch_decoded(this, cs, decoded);
+}
+
 int VmState::step() {
   CHECK(code.not_null() && stack.not_null());
   if (log.log_mask & vm::VmLog::DumpStack) {
@@ -465,7 +487,7 @@ int VmState::step() {
   if (code->size()) {
     VM_LOG_MASK(this, vm::VmLog::ExecLocation)
         << "code cell hash: " << code->get_base_cell()->get_hash().to_hex() << " offset: " << code->cur_pos();
-    return dispatch->dispatch(this, code.write());
+    return DecodedCodeCache::enabled() ? dispatch_code(code.write()) : dispatch->dispatch(this, code.write());
   } else if (code->size_refs()) {
     VM_LOG(this) << "execute implicit JMPREF";
     auto ref_cell = code->prefetch_ref();
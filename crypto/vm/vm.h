@@ -28,6 +28,7 @@ Copyright 2017-2020 Telegram Systems LLP
 #include "td/utils/HashSet.h"
 #include "vm/dumper.hpp"
 #include "td/utils/optional.h"
+#include "vm/code-cache.h"
 #include "vm/dumper.hpp"
 
 namespace vm {
@@ -112,6 +113,10 @@ class VmState final : public VmStateInterface {
   long long free_gas_consumed = 0;
   std::unique_ptr<ParentVmState> parent = nullptr;
   VmDumper vm_dumper;
+  // DecodedCodeCache entry of the current code cell, looked up again only when the code cell or codepage changes
+  Ref<DataCell> decoded_cell;
+  const DispatchTable* decoded_dispatch{nullptr};
+  std::shared_ptr<DecodedCodeCache::Entry> decoded_code;
 
  public:
   enum {
@@ -476,6 +481,7 @@ class VmState final : public VmStateInterface {
  private:
   void init_cregs(bool same_c3 = false, bool push_0 = true);
   int run_inner();
+  int dispatch_code(CellSlice& cs);
 };
 
 struct ParentVmState {
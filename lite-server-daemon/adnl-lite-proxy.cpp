@@ -23,6 +23,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/common.h"
 #include "td/utils/Random.h"
+#include "td/utils/List.h"
 #include "td/utils/OptionParser.h"
 #include "td/utils/port/user.h"
 #include "auto/tl/lite_api.h"
@@ -38,6 +39,7 @@
 #include "crypto/block/mc-config.h"
 #include "lite-server-config.hpp"
 #include <algorithm>
+#include <deque>
 #include <queue>
 #include <chrono>
 #include <thread>
@@ -381,16 +383,253 @@ namespace ton::liteserver {
         td::actor::ActorOwn<ton::adnl::AdnlExtClient> client_;
     };
 
+    // Light queries are answered from the latest state and must not wait behind heavy ones, which are capped per
+    // server and shed first under load.
+    enum class QueryPriority { light = 0, normal = 1, heavy = 2 };
+
+    class LiteProxy;
+
+    // Sends a query to the primary server and, if it has not answered in hedge_after seconds or has failed, to the
+    // secondary one. The first answer that is not a network error wins, and is reported with the server that gave it.
+    // Both go through the proxy, which accounts them to their servers.
+    class HedgedQuery : public td::actor::Actor {
+    public:
+        struct Answer {
+          adnl::AdnlNodeIdShort server;
+          td::Result<td::BufferSlice> result;
+        };
+
+        HedgedQuery(td::BufferSlice data, td::actor::ActorId<LiteProxy> proxy, adnl::AdnlNodeIdShort primary,
+                    adnl::AdnlNodeIdShort secondary, QueryPriority priority, double hedge_after,
+                    td::Promise<Answer> promise, td::Promise<td::Unit> hedged)
+                : data_(std::move(data)), proxy_(std::move(proxy)), primary_(primary), secondary_(secondary),
+                  priority_(priority), hedge_after_(hedge_after), promise_(std::move(promise)),
+                  hedged_promise_(std::move(hedged)) {
+        }
+
+        void start_up() override {
+          send(primary_);
+          alarm_timestamp() = td::Timestamp::in(hedge_after_);
+        }
+
+        void alarm() override {
+          alarm_timestamp() = td::Timestamp::never();
+          if (hedged_) {
+            return;
+          }
+          hedged_ = true;
+          hedged_promise_.set_value(td::Unit());
+          send(secondary_);
+        }
+
+        void got_answer(adnl::AdnlNodeIdShort server, td::Result<td::BufferSlice> R) {
+          pending_--;
+          if (R.is_error() && !hedged_) {
+            alarm();
+            return;
+          }
+          if (R.is_ok() || pending_ == 0) {
+            promise_.set_value(Answer{server, std::move(R)});
+            stop();
+          }
+        }
+
+    private:
+        void send(adnl::AdnlNodeIdShort server);
+
+        td::BufferSlice data_;
+        td::actor::ActorId<LiteProxy> proxy_;
+        adnl::AdnlNodeIdShort primary_;
+        adnl::AdnlNodeIdShort secondary_;
+        QueryPriority priority_;
+        double hedge_after_;
+        td::Promise<Answer> promise_;
+        td::Promise<td::Unit> hedged_promise_;
+        bool hedged_{false};
+        int pending_{0};
+    };
+
+    // Completed responses to block-pinned queries. An entry lives for ttl seconds, the least recently used entries are
+    // dropped once the responses take more than max_size bytes.
+    class ResponseCache {
+    public:
+        ResponseCache(td::uint64 max_size, double ttl) : max_size_(max_size), ttl_(ttl) {
+        }
+
+        td::Result<td::BufferSlice> get(const td::Bits256 &key) {
+          auto it = entries_.find(key);
+          if (it == entries_.end()) {
+            return td::Status::Error("not found");
+          }
+          auto entry = it->second.get();
+          if (entry->expires_at.is_in_past()) {
+            erase(it);
+            return td::Status::Error("not found");
+          }
+          entry->remove();
+          lru_.put(entry);
+          return entry->value.clone();
+        }
+
+        void put(const td::Bits256 &key, td::BufferSlice value) {
+          if (value.size() + 64 > max_size_ / 16) {
+            return;
+          }
+          auto it = entries_.find(key);
+          if (it != entries_.end()) {
+            erase(it);
+          }
+          auto &entry = entries_[key];
+          entry = std::make_unique<Entry>(key, std::move(value), td::Timestamp::in(ttl_));
+          lru_.put(entry.get());
+          size_ += entry->size();
+          while (size_ > max_size_) {
+            auto to_remove = static_cast<Entry *>(lru_.get());
+            CHECK(to_remove);
+            erase(entries_.find(to_remove->key));
+          }
+        }
+
+        size_t entries() const {
+          return entries_.size();
+        }
+
+        td::uint64 size() const {
+          return size_;
+        }
+
+    private:
+        struct Entry : public td::ListNode {
+            Entry(td::Bits256 key, td::BufferSlice value, td::Timestamp expires_at)
+                    : key(key), value(std::move(value)), expires_at(expires_at) {
+            }
+
+            td::Bits256 key;
+            td::BufferSlice value;
+            td::Timestamp expires_at;
+
+            size_t size() const {
+              return value.size() + 64;
+            }
+        };
+
+        void erase(std::map<td::Bits256, std::unique_ptr<Entry>>::iterator it) {
+          size_ -= it->second->size();
+          entries_.erase(it);
+        }
+
+        td::uint64 max_size_;
+        double ttl_;
+        std::map<td::Bits256, std::unique_ptr<Entry>> entries_;
+        td::ListNode lru_;
+        td::uint64 size_{0};
+    };
+
+    // A response to a query pinned to a block never changes and can be cached. Queries about the same account or
+    // block are routed by key to the same server, so that its cell cache stays warm.
+    struct QueryRoute {
+        bool pinned{false};
+        bool idempotent{true};
+        QueryPriority priority{QueryPriority::normal};
+        td::int32 function_id{0};
+        td::optional<td::Bits256> key;
+    };
+
+    QueryRoute route_query(const td::BufferSlice &data) {
+      QueryRoute route;
+      auto Q = fetch_tl_object<lite_api::liteServer_query>(data.clone(), true);
+      if (Q.is_error()) {
+        return route;
+      }
+      auto query = std::move(Q.move_as_ok()->data_);
+      fetch_tl_prefix<lite_api::liteServer_waitMasterchainSeqno>(query, true).ignore();
+      auto F = fetch_tl_object<lite_api::Function>(query, true);
+      if (F.is_error()) {
+        return route;
+      }
+      auto f = F.move_as_ok();
+      route.function_id = f->get_id();
+      auto pinned = [](const tl_object_ptr<lite_api::tonNode_blockIdExt> &id) {
+          return id->workchain_ != masterchainId || id->seqno_ != -1;
+      };
+      auto by_block = [&](const tl_object_ptr<lite_api::tonNode_blockIdExt> &id) {
+          route.pinned = pinned(id);
+          if (route.pinned) {
+            route.key = id->root_hash_;
+          }
+      };
+      auto by_account = [&](const tl_object_ptr<lite_api::tonNode_blockIdExt> &id,
+                            const tl_object_ptr<lite_api::liteServer_accountId> &account) {
+          route.pinned = pinned(id);
+          route.key = account->id_;
+      };
+      lite_api::downcast_call(
+              *f,
+              td::overloaded(
+                      [&](lite_api::liteServer_getMasterchainInfo &q) { route.priority = QueryPriority::light; },
+                      [&](lite_api::liteServer_getMasterchainInfoExt &q) { route.priority = QueryPriority::light; },
+                      [&](lite_api::liteServer_getTime &q) { route.priority = QueryPriority::light; },
+                      [&](lite_api::liteServer_getVersion &q) { route.priority = QueryPriority::light; },
+                      [&](lite_api::liteServer_getBlock &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getBlockHeader &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getState &q) {
+                          route.key = q.id_->root_hash_;
+                          route.priority = QueryPriority::heavy;
+                      },
+                      [&](lite_api::liteServer_getAccountState &q) { by_account(q.id_, q.account_); },
+                      [&](lite_api::liteServer_getAccountStatePrunned &q) { by_account(q.id_, q.account_); },
+                      [&](lite_api::liteServer_runSmcMethod &q) {
+                          by_account(q.id_, q.account_);
+                          route.priority = QueryPriority::heavy;
+                      },
+                      [&](lite_api::liteServer_getOneTransaction &q) { by_account(q.id_, q.account_); },
+                      [&](lite_api::liteServer_getTransactions &q) { route.key = q.account_->id_; },
+                      [&](lite_api::liteServer_getShardInfo &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getAllShardsInfo &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_listBlockTransactions &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_listBlockTransactionsExt &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getConfigAll &q) {
+                          by_block(q.id_);
+                          route.priority = QueryPriority::heavy;
+                      },
+                      [&](lite_api::liteServer_getConfigParams &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getValidatorStats &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getLibrariesWithProof &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getShardBlockProof &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getBlockOutMsgQueueSize &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getDispatchQueueInfo &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getDispatchQueueMessages &q) { by_block(q.id_); },
+                      [&](lite_api::liteServer_getBlockProof &q) {
+                          // without a target block the proof goes to the last known masterchain block
+                          route.pinned = (q.mode_ & 1) && pinned(q.known_block_);
+                      },
+                      // lookup by lt or utime may resolve differently until the next block is known
+                      [&](lite_api::liteServer_lookupBlock &q) { route.pinned = (q.mode_ & 7) == 1; },
+                      [&](lite_api::liteServer_lookupBlockWithProof &q) {
+                          route.pinned = (q.mode_ & 7) == 1 && pinned(q.mc_block_id_);
+                      },
+                      [&](lite_api::liteServer_sendMessage &q) {
+                          route.idempotent = false;
+                          route.priority = QueryPriority::light;
+                      },
+                      [&](auto &obj) {}));
+      return route;
+    }
+
     class LiteProxy : public td::actor::Actor {
     public:
         LiteProxy(std::string config_path, std::string db_path, const std::string &address, td::uint32 lite_port,
-                  td::uint32 adnl_port, std::string global_config, int mode, std::string publisher_endpoint) : producer(
+                  td::uint32 adnl_port, std::string global_config, int mode, std::string publisher_endpoint,
+                  td::uint64 cache_size, double cache_ttl, bool hedge, int max_in_flight, int max_heavy_in_flight)
+                : producer(
                 cppkafka::Configuration{{"metadata.broker.list", publisher_endpoint},
                                         {"message.max.bytes",    "1000000000"},  // max
                                         {"retry.backoff.ms",     5},
                                         {"retries",              2147483647},
                                         {"acks",                 "1"},
-                                        {"debug",                "broker,topic,msg"}}) {
+                                        {"debug",                "broker,topic,msg"}}),
+                  response_cache_(cache_size, cache_ttl), hedge_(hedge), max_in_flight_(max_in_flight),
+                  max_heavy_in_flight_(max_heavy_in_flight) {
           config_path_ = std::move(config_path);
           db_root_ = std::move(db_path);
           address_.init_host_port(address, lite_port).ensure();
@@ -483,7 +722,10 @@ namespace ton::liteserver {
               }
             }
 
-            uptodate_private_ls = std::move(uptodate);
+            if (uptodate != uptodate_private_ls) {
+              uptodate_private_ls = std::move(uptodate);
+              update_ring();
+            }
 
             while (!shard_client_waiters_.empty()) {
               auto it = shard_client_waiters_.begin();
@@ -555,6 +797,196 @@ namespace ton::liteserver {
           auto pos = std::find(uptodate_private_ls.begin(), uptodate_private_ls.end(), server);
           if (pos != uptodate_private_ls.end()) {
             uptodate_private_ls.erase(pos);
+            update_ring();
+          }
+        }
+
+        // Every up-to-date server owns ring_replicas points of the ring, a key goes to the owner of the first point
+        // after it. A server that joins or leaves moves only the keys of its own points.
+        void update_ring() {
+          ring_.clear();
+          for (auto &server: uptodate_private_ls) {
+            for (td::uint32 i = 0; i < ring_replicas; i++) {
+              auto point = compute_file_hash(PSLICE() << server.bits256_value().as_slice() << i);
+              ring_[td::as<td::uint64>(point.data())] = server;
+            }
+          }
+        }
+
+        // Servers for a query in the order to try them: the owner of the key and the next different servers on the
+        // ring, skipping the ones with an open circuit. A query without a key starts from a random point.
+        std::vector<adnl::AdnlNodeIdShort> pick_servers(const td::optional<td::Bits256> &key, size_t count) {
+          std::vector<adnl::AdnlNodeIdShort> res;
+          td::uint64 point = key ? td::as<td::uint64>(key.value().data()) : td::Random::fast_uint64();
+          auto it = ring_.lower_bound(point);
+          for (size_t i = 0; i < ring_.size() && res.size() < count; i++, ++it) {
+            if (it == ring_.end()) {
+              it = ring_.begin();
+            }
+            if (backend_available(it->second) && std::find(res.begin(), res.end(), it->second) == res.end()) {
+              res.push_back(it->second);
+            }
+          }
+          return res;
+        }
+
+        // A server with an open circuit gets no queries until the cooldown is over, then a single probe: the circuit
+        // closes if it succeeds and opens again otherwise
+        bool backend_available(adnl::AdnlNodeIdShort server) {
+          auto it = backends_.find(server);
+          if (it == backends_.end() || it->second.open_until == 0) {
+            return true;
+          }
+          return td::Time::now() >= it->second.open_until && !it->second.probing;
+        }
+
+        // Expected time to answer one more query: the latency EWMA times the queries already waiting there
+        double backend_cost(adnl::AdnlNodeIdShort server) {
+          auto &b = backends_[server];
+          return std::max(b.latency, min_backend_latency) * (b.in_flight + 1);
+        }
+
+        bool backend_admits(adnl::AdnlNodeIdShort server, QueryPriority priority) {
+          auto &b = backends_[server];
+          switch (priority) {
+            case QueryPriority::light:
+              return true;
+            case QueryPriority::normal:
+              return b.in_flight < max_in_flight_;
+            case QueryPriority::heavy:
+              return b.in_flight < max_in_flight_ && b.heavy_in_flight < max_heavy_in_flight_;
+          }
+          return true;
+        }
+
+        // Power of two choices among the first two candidates. The owner of a key keeps it unless it is clearly
+        // more loaded than the other one; light queries always go to the less loaded server. Returns the servers
+        // in the order to use them, or nothing if both have no room for the query.
+        td::optional<std::pair<adnl::AdnlNodeIdShort, adnl::AdnlNodeIdShort>> choose_backend(
+                const QueryRoute &route, adnl::AdnlNodeIdShort first, adnl::AdnlNodeIdShort second) {
+          auto slack = route.key && route.priority != QueryPriority::light ? affinity_slack : 1.0;
+          if (backend_cost(first) > slack * backend_cost(second)) {
+            std::swap(first, second);
+          }
+          if (!backend_admits(first, route.priority)) {
+            std::swap(first, second);
+          }
+          if (!backend_admits(first, route.priority)) {
+            return {};
+          }
+          return std::make_pair(first, second);
+        }
+
+        // Every query of mode 0 goes to the servers through here, so that the counters of the server see it
+        void send_to_backend(adnl::AdnlNodeIdShort server, QueryPriority priority, td::BufferSlice data,
+                             td::Promise<td::BufferSlice> promise) {
+          auto it = private_servers_.find(server);
+          if (it == private_servers_.end()) {
+            promise.set_error(td::Status::Error(ErrorCode::notready, "server is not connected"));
+            return;
+          }
+          auto &b = backends_[server];
+          b.in_flight++;
+          if (priority == QueryPriority::heavy) {
+            b.heavy_in_flight++;
+          }
+          // only the first query after the cooldown probes a half-open circuit
+          bool probe = b.open_until > 0 && td::Time::now() >= b.open_until && !b.probing;
+          if (probe) {
+            b.probing = true;
+          }
+          auto P = td::PromiseCreator::lambda(
+                  [SelfId = actor_id(this), server, priority, generation = b.generation, probe,
+                          elapsed = td::Timer(), promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+                      td::actor::send_closure(SelfId, &LiteProxy::backend_answered, server, priority, generation,
+                                              probe, R.is_ok(), elapsed.elapsed());
+                      promise.set_result(std::move(R));
+                  });
+          td::actor::send_closure(it->second.get(), &LiteServerClient::send_raw, std::move(data), std::move(P),
+                                  live_timeout);
+        }
+
+        void backend_answered(adnl::AdnlNodeIdShort server, QueryPriority priority, td::uint64 generation, bool probe,
+                              bool ok, double elapsed) {
+          auto &b = backends_[server];
+          b.in_flight--;
+          if (priority == QueryPriority::heavy) {
+            b.heavy_in_flight--;
+          }
+
+          // answers to the queries sent before the circuit last opened or closed say nothing about its state now
+          if (generation != b.generation) {
+            return;
+          }
+          if (b.open_until > 0) {
+            if (!probe) {
+              return;
+            }
+            b.probing = false;
+            if (!ok) {
+              open_circuit(server, "probe failed");
+              return;
+            }
+            LOG(WARNING) << "Server: " << server.bits256_value().to_hex() << " circuit closed";
+            b.open_until = 0;
+            b.generation++;
+            b.errors = 0;
+            b.latency = elapsed;
+            return;
+          }
+
+          if (!ok) {
+            if (++b.errors >= circuit_errors) {
+              open_circuit(server, "too many errors");
+            }
+            return;
+          }
+          b.errors = 0;
+          b.latency = b.latency == 0 ? elapsed : b.latency + latency_ewma_alpha * (elapsed - b.latency);
+
+          std::vector<double> latencies;
+          for (auto &s: uptodate_private_ls) {
+            auto it = backends_.find(s);
+            if (it != backends_.end() && it->second.latency > 0) {
+              latencies.push_back(it->second.latency);
+            }
+          }
+          if (latencies.size() >= 3 && b.latency > min_slow_latency &&
+              b.latency > slow_factor * percentile(latencies, 50.0)) {
+            open_circuit(server, "too slow");
+          }
+        }
+
+        void open_circuit(adnl::AdnlNodeIdShort server, td::Slice reason) {
+          auto &b = backends_[server];
+          LOG(WARNING) << "Server: " << server.bits256_value().to_hex() << " circuit opened: " << reason
+                       << ", latency: " << b.latency << " errors: " << b.errors;
+          b.open_until = td::Time::now() + circuit_cooldown;
+          b.probing = false;
+          b.generation++;
+          circuits_opened_++;
+        }
+
+        // Queries answered by the proxy itself go to the stat data as failed items that never reached a server
+        // (start_at == end_at), the split into rejected and shed is in the prometheus stats
+        void query_dropped(adnl::AdnlNodeIdShort dst, const QueryRoute &route, bool shed) {
+          if (shed) {
+            shed_[static_cast<int>(route.priority)]++;
+          } else {
+            rejected_++;
+          }
+          auto now = static_cast<long>(std::time(nullptr));
+          stats_data_.emplace_back(dst, route.function_id, now, now, false);
+        }
+
+        void add_latency(double latency) {
+          latencies_.push_back(latency);
+          if (latencies_.size() > latency_window) {
+            latencies_.pop_front();
+          }
+          if (++latencies_added_ % 100 == 0 && latencies_.size() >= 100) {
+            std::vector<double> v(latencies_.begin(), latencies_.end());
+            hedge_after_ = std::max(percentile(v, 99.0), min_hedge_after);
           }
         }
 
@@ -598,6 +1030,26 @@ namespace ton::liteserver {
           std::string final_status = stats_;
           final_status += "ton_balancer_best_time " + std::to_string(std::get<0>(best_time)) + "\n";
           final_status += "ton_balancer_available_servers " + std::to_string(uptodate_private_ls.size()) + "\n";
+          final_status += "ton_balancer_cache_hits " + std::to_string(cache_hits_) + "\n";
+          final_status += "ton_balancer_cache_entries " + std::to_string(response_cache_.entries()) + "\n";
+          final_status += "ton_balancer_cache_size " + std::to_string(response_cache_.size()) + "\n";
+          final_status += "ton_balancer_coalesced " + std::to_string(coalesced_) + "\n";
+          final_status += "ton_balancer_hedged " + std::to_string(hedged_) + "\n";
+          final_status += "ton_balancer_hedge_after " + std::to_string(hedge_after_) + "\n";
+          final_status += "ton_balancer_rejected " + std::to_string(rejected_) + "\n";
+          final_status += "ton_balancer_shed{class=\"light\"} " + std::to_string(shed_[0]) + "\n";
+          final_status += "ton_balancer_shed{class=\"normal\"} " + std::to_string(shed_[1]) + "\n";
+          final_status += "ton_balancer_shed{class=\"heavy\"} " + std::to_string(shed_[2]) + "\n";
+          final_status += "ton_balancer_circuits_opened " + std::to_string(circuits_opened_) + "\n";
+          for (auto &b: backends_) {
+            auto server = b.first.bits256_value().to_hex();
+            final_status += "ton_balancer_backend_latency{adnl_short=\"" + server + "\"} " +
+                            std::to_string(b.second.latency) + "\n";
+            final_status += "ton_balancer_backend_in_flight{adnl_short=\"" + server + "\"} " +
+                            std::to_string(b.second.in_flight) + "\n";
+            final_status += "ton_balancer_backend_circuit_open{adnl_short=\"" + server + "\"} " +
+                            (b.second.open_until > 0 ? "1" : "0") + "\n";
+          }
           int success_count = 0, fail_count = 0;
           std::vector<double> elapsed_times;
 
@@ -975,29 +1427,31 @@ namespace ton::liteserver {
           }
         }
 
-        void process_cache(td::BufferSlice data, td::BufferSlice result, const std::string &compiled_query = "",
-                           td::Timer elapsed = {}) {
-          std::string data_hash = compute_file_hash(data).to_hex();
-
-          auto it = cache_similar.find(data_hash);
+        void process_cache(td::Bits256 key, td::BufferSlice data, td::BufferSlice result, bool pinned,
+                           td::Timer elapsed) {
+          auto it = cache_similar.find(key);
 
           if (it != cache_similar.end()) {
             for (auto &promise: it->second) {
-              LOG(INFO) << "Found cache for request: " << data_hash << " query: " << compiled_query;
+              LOG(INFO) << "Found cache for request: " << key.to_hex();
               td::actor::send_closure(actor_id(this), &LiteProxy::publish_call, std::get<1>(promise), data.clone(),
                                       std::get<0>(promise),
                                       elapsed, true);
               std::get<2>(promise).set_value(result.clone());
             }
 
-            cache_similar.erase(data_hash);
+            cache_similar.erase(it);
+          }
+
+          if (pinned && fetch_tl_object<lite_api::liteServer_error>(result.clone(), true).is_error()) {
+            response_cache_.put(key, std::move(result));
           }
         }
 
         void check_ext_answer(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data,
                               td::Promise<td::BufferSlice> promise, int refire, td::Result<td::BufferSlice> result,
                               std::time_t started_at, td::Timer elapsed, adnl::AdnlNodeIdShort server_adnl,
-                              const std::string &compiled_query = "") {
+                              const std::string &compiled_query = "", bool hedge_answered = false) {
           if (result.is_ok()) {
             auto res = result.move_as_ok();
             auto lite_error = ton::fetch_tl_object<ton::lite_api::liteServer_error>(res.clone(), true);
@@ -1017,7 +1471,6 @@ namespace ton::liteserver {
 
                     td::actor::send_closure(actor_id(this), &LiteProxy::publish_call, dst, data.clone(), started_at,
                                             elapsed, false);
-                    process_cache(std::move(data), res.clone(), compiled_query, elapsed);
                     promise.set_value(std::move(res));
                     return;
                   } else {
@@ -1043,7 +1496,6 @@ namespace ton::liteserver {
 
                 td::actor::send_closure(actor_id(this), &LiteProxy::publish_call, dst, data.clone(), started_at,
                                         elapsed, false);
-                process_cache(std::move(data), res.clone(), compiled_query, elapsed);
                 promise.set_value(std::move(res));
                 return;
               } else {
@@ -1060,9 +1512,12 @@ namespace ton::liteserver {
               LOG(INFO)
               << "Query to: " << server_adnl << " success, Query: " << compiled_query << " Elapsed: " << elapsed;
               query_statuses_.push_back({true, elapsed.elapsed(), compiled_query});
+              if (!hedge_answered) {
+                // hedge_after is derived from how fast the first choice answers
+                add_latency(elapsed.elapsed());
+              }
               td::actor::send_closure(actor_id(this), &LiteProxy::publish_call, dst, data.clone(), started_at,
                                       elapsed, false);
-              process_cache(std::move(data), res.clone(), compiled_query, elapsed);
               promise.set_value(std::move(res));
               return;
             }
@@ -1079,7 +1534,6 @@ namespace ton::liteserver {
               auto res = create_serialize_tl_object<lite_api::liteServer_error>(228, error.message().str());
               td::actor::send_closure(actor_id(this), &LiteProxy::publish_call, dst, data.clone(), started_at,
                                       elapsed, false);
-              process_cache(std::move(data), res.clone(), compiled_query, elapsed);
               promise.set_value(std::move(res));
               return;
             } else {
@@ -1095,16 +1549,44 @@ namespace ton::liteserver {
 
         void process_ext_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data,
                                td::Promise<td::BufferSlice> promise, int refire = 0, std::string query_compiled = "") {
-          std::string data_hash = compute_file_hash(data).to_hex();
+          auto route = route_query(data);
 
-          auto it = cache_similar.find(data_hash);
+          // refires carry the promise of the query that is already in flight
+          if (refire == 0) {
+            auto key = compute_file_hash(data);
 
-          if (it != cache_similar.end() && !cache_similar[data_hash].empty()) {
-            LOG(INFO) << "Found similar request, store: " << data_hash;
-            it->second.push_back(std::make_tuple(std::time(nullptr), dst, std::move(promise)));
-            return;
-          } else {
-            cache_similar[data_hash] = std::vector<std::tuple<std::time_t, adnl::AdnlNodeIdShort, td::Promise<td::BufferSlice>>>();
+            if (route.pinned) {
+              auto R = response_cache_.get(key);
+              if (R.is_ok()) {
+                LOG(INFO) << "Found cached response: " << key.to_hex();
+                cache_hits_++;
+                td::actor::send_closure(actor_id(this), &LiteProxy::publish_call, dst, data.clone(),
+                                        std::time(nullptr), td::Timer(), true);
+                promise.set_value(R.move_as_ok());
+                return;
+              }
+            }
+
+            auto it = cache_similar.find(key);
+            if (it != cache_similar.end()) {
+              LOG(INFO) << "Found similar request, store: " << key.to_hex();
+              coalesced_++;
+              it->second.push_back(std::make_tuple(std::time(nullptr), dst, std::move(promise)));
+              return;
+            }
+
+            // identical queries arriving until this one is answered wait for its answer
+            cache_similar[key];
+            promise = td::PromiseCreator::lambda(
+                    [SelfId = actor_id(this), key, data = data.clone(), pinned = route.pinned, elapsed = td::Timer(),
+                            P = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+                        auto result = R.is_ok() ? R.ok().clone()
+                                                : create_serialize_tl_object<lite_api::liteServer_error>(
+                                        228, R.error().message().str());
+                        td::actor::send_closure(SelfId, &LiteProxy::process_cache, key, std::move(data),
+                                                std::move(result), pinned && R.is_ok(), elapsed);
+                        P.set_result(std::move(R));
+                    });
           }
 
 
@@ -1118,11 +1600,30 @@ namespace ton::liteserver {
 
             td::actor::ActorId<LiteServerClient> server;
             adnl::AdnlNodeIdShort adnl;
+            td::optional<adnl::AdnlNodeIdShort> hedge_adnl;
             if (!uptodate_private_ls.empty()) {
-              adnl =
-                      uptodate_private_ls[td::Random::fast(0, td::narrow_cast<td::uint32>(
-                              uptodate_private_ls.size() - 1))];
+              // a refire goes to the next server on the ring
+              auto servers = pick_servers(route.key, refire + 2);
+              if (servers.empty()) {
+                LOG(WARNING) << "Reject query to: " << dst.bits256_value().to_hex() << ", all circuits are open";
+                query_dropped(dst, route, false);
+                promise.set_value(create_serialize_tl_object<lite_api::liteServer_error>(228, "No available servers"));
+                return;
+              }
+              auto chosen = choose_backend(route, servers[refire % servers.size()],
+                                           servers[(refire + 1) % servers.size()]);
+              if (!chosen) {
+                LOG(WARNING) << "Shed query to: " << dst.bits256_value().to_hex() << ", servers are overloaded";
+                query_dropped(dst, route, true);
+                promise.set_value(create_serialize_tl_object<lite_api::liteServer_error>(228, "Overloaded"));
+                return;
+              }
+              adnl = chosen.value().first;
               server = private_servers_[adnl].get();
+              auto other = chosen.value().second;
+              if (other != adnl && backend_admits(other, route.priority)) {
+                hedge_adnl = other;
+              }
             } else {
               auto s = td::Random::fast(0, td::narrow_cast<td::uint32>(private_servers_.size() - 1));
               int a{0};
@@ -1137,24 +1638,47 @@ namespace ton::liteserver {
             }
 
             if (!server.empty()) {
-              auto mP = td::PromiseCreator::lambda(
-                      [P = std::move(promise),
-                              SelfId = actor_id(this),
-                              src, dst, data = data.clone(), refire,
-                              started_at = std::time(nullptr), server_adbl = adnl,
-                              elapsed = td::Timer(),
-                              query_compiled = std::move(query_compiled)](
-                              td::Result<td::BufferSlice> R) mutable {
-                          td::actor::send_closure(SelfId, &LiteProxy::check_ext_answer, src, dst,
-                                                  std::move(data), std::move(P), refire, std::move(R),
-                                                  started_at, elapsed, server_adbl, std::move(query_compiled));
-                      });
-
-              td::actor::send_closure(server, &LiteServerClient::send_raw, std::move(data),
-                                      std::move(mP), live_timeout);
+              auto answer = [P = std::move(promise),
+                             SelfId = actor_id(this),
+                             src, dst, data = data.clone(), refire,
+                             started_at = std::time(nullptr), primary = adnl,
+                             elapsed = td::Timer(),
+                             query_compiled = std::move(query_compiled)](
+                              adnl::AdnlNodeIdShort server, td::Result<td::BufferSlice> R) mutable {
+                  td::actor::send_closure(SelfId, &LiteProxy::check_ext_answer, src, dst,
+                                          std::move(data), std::move(P), refire, std::move(R),
+                                          started_at, elapsed, server, std::move(query_compiled), server != primary);
+              };
+
+              if (hedge_ && route.idempotent && hedge_after_ > 0 && hedge_adnl) {
+                auto hP = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Unit> R) {
+                    if (R.is_ok()) {
+                      td::actor::send_closure(SelfId, &LiteProxy::query_hedged);
+                    }
+                });
+                auto mP = td::PromiseCreator::lambda(
+                        [answer = std::move(answer), primary = adnl](td::Result<HedgedQuery::Answer> R) mutable {
+                            if (R.is_error()) {
+                              answer(primary, R.move_as_error());
+                              return;
+                            }
+                            auto A = R.move_as_ok();
+                            answer(A.server, std::move(A.result));
+                        });
+                td::actor::create_actor<HedgedQuery>("LSC::Hedged", std::move(data), actor_id(this), adnl,
+                                                     hedge_adnl.value(), route.priority, hedge_after_,
+                                                     std::move(mP), std::move(hP))
+                        .release();
+              } else {
+                auto mP = td::PromiseCreator::lambda(
+                        [answer = std::move(answer), server = adnl](td::Result<td::BufferSlice> R) mutable {
+                            answer(server, std::move(R));
+                        });
+                send_to_backend(adnl, route.priority, std::move(data), std::move(mP));
+              }
             } else {
               td::actor::send_closure(actor_id(this), &LiteProxy::check_ext_query, src, dst, std::move(data),
-                                      std::move(promise), 0);
+                                      std::move(promise), refire + 1);
             }
           } else {
             if (!uptodate_private_ls.empty()) {
@@ -1196,6 +1720,10 @@ namespace ton::liteserver {
         }
 
 
+        void query_hedged() {
+          hedged_++;
+        }
+
         void check_ext_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data,
                              td::Promise<td::BufferSlice> promise, int refire = 0) {
           if (refire > allowed_refire) {
@@ -1224,11 +1752,13 @@ namespace ton::liteserver {
                   LOG(INFO)
                   << "Drop to: " << dst.bits256_value().to_hex() << " because of ratelimit, usage: " << usage[dst]
                   << " limit: " << std::get<1>(k);
+                  query_dropped(dst, route_query(data), false);
                   promise.set_value(create_serialize_tl_object<lite_api::liteServer_error>(228, "Ratelimit"));
                   return;
                 }
 
                 if (std::time(nullptr) > std::get<0>(k)) {
+                  query_dropped(dst, route_query(data), false);
                   promise.set_value(create_serialize_tl_object<lite_api::liteServer_error>(228, "Key expired"));
                   LOG(INFO) << "Drop to: " << dst.bits256_value().to_hex() << " because of expired";
                   return;
@@ -1287,15 +1817,17 @@ namespace ton::liteserver {
                                     SelfId = actor_id(this),
                                     src,
                                     dst,
+                                    refire,
                                     promise = std::move(promise)](
                                     td::Result<td::Unit> R) mutable {
                                 if (R.is_error()) {
                                   promise.set_error(R.move_as_error());
                                   return;
                                 }
+                                // a refire keeps its count, its promise already leads the identical queries
                                 td::actor::send_closure(SelfId, &LiteProxy::process_ext_query,
                                                         src, dst, std::move(data),
-                                                        std::move(promise), 0, "waitSeqno");
+                                                        std::move(promise), refire, "waitSeqno");
                             });
                     wait_shard_client_state(e->seqno_, td::Timestamp::in(t), std::move(Q), last_master);
                     return;
@@ -1867,7 +2399,41 @@ namespace ton::liteserver {
         std::vector<adnl::AdnlNodeIdShort> uptodate_private_ls{};
         ton::PublicKeyHash default_dht_node_ = ton::PublicKeyHash::zero();
         std::map<ton::adnl::AdnlNodeIdShort, std::tuple<ValidUntil, RateLimit>> limits;
-        std::map<std::string, std::vector<std::tuple<std::time_t, ton::adnl::AdnlNodeIdShort, td::Promise<td::BufferSlice>>>> cache_similar;
+        std::map<td::Bits256, std::vector<std::tuple<std::time_t, ton::adnl::AdnlNodeIdShort, td::Promise<td::BufferSlice>>>> cache_similar;
+        ResponseCache response_cache_;
+        long long cache_hits_{0};
+        long long coalesced_{0};
+        static constexpr td::uint32 ring_replicas = 128;
+        std::map<td::uint64, adnl::AdnlNodeIdShort> ring_;
+        bool hedge_;
+        static constexpr size_t latency_window = 10000;
+        static constexpr double min_hedge_after = 0.05;
+        std::deque<double> latencies_;
+        long long latencies_added_{0};
+        double hedge_after_{0};  // p99 of the latency window, 0 until it has enough samples
+        long long hedged_{0};
+        struct Backend {
+            double latency{0};  // EWMA of the answer time, 0 until the first answer
+            int in_flight{0};
+            int heavy_in_flight{0};
+            int errors{0};  // network errors in a row
+            double open_until{0};  // the circuit is open until then, 0 if closed
+            bool probing{false};  // the probe of a half-open circuit is in flight
+            td::uint64 generation{0};  // bumped whenever the circuit opens or closes, queries carry it along
+        };
+        static constexpr double latency_ewma_alpha = 0.1;
+        static constexpr double min_backend_latency = 0.01;
+        static constexpr double affinity_slack = 2.0;
+        static constexpr int circuit_errors = 5;
+        static constexpr double circuit_cooldown = 5.0;
+        static constexpr double slow_factor = 4.0;
+        static constexpr double min_slow_latency = 1.0;
+        std::map<adnl::AdnlNodeIdShort, Backend> backends_;
+        int max_in_flight_;
+        int max_heavy_in_flight_;
+        long long rejected_{0};
+        long long shed_[3]{0, 0, 0};
+        long long circuits_opened_{0};
         std::map<ton::adnl::AdnlNodeIdShort, int> usage;
         long long rps;
         std::map<BlockSeqno, WaitList<td::actor::Actor, td::Unit>> shard_client_waiters_;
@@ -1875,6 +2441,14 @@ namespace ton::liteserver {
         td::actor::ActorOwn<ton::PrometheusExporterActor> prometheus_exporter_;
         std::vector<std::tuple<bool, double, std::string>> query_statuses_;
     };
+
+    void HedgedQuery::send(adnl::AdnlNodeIdShort server) {
+      pending_++;
+      auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), server](td::Result<td::BufferSlice> R) mutable {
+          td::actor::send_closure(SelfId, &HedgedQuery::got_answer, server, std::move(R));
+      });
+      td::actor::send_closure(proxy_, &LiteProxy::send_to_backend, server, priority_, data_.clone(), std::move(P));
+    }
 }  // namespace ton::liteserver
 
 int main(int argc, char **argv) {
@@ -1891,6 +2465,11 @@ int main(int argc, char **argv) {
   td::uint32 lite_port = 0;
   td::uint32 adnl_port = 0;
   std::string publisher_endpoint = "";
+  td::uint64 cache_size = 256 << 20;
+  double cache_ttl = 60.0;
+  bool hedge = true;
+  int max_in_flight = 256;
+  int max_heavy_in_flight = 16;
 
 
   p.set_description("lite-proxy");
@@ -1930,6 +2509,42 @@ int main(int argc, char **argv) {
   p.add_option('L', "lite-port", "lite-proxy port", [&](td::Slice arg) { lite_port = td::to_integer<int>(arg); });
   p.add_option('A', "adnl-port", "adnl port", [&](td::Slice arg) { adnl_port = td::to_integer<int>(arg); });
   p.add_option('P', "publisher", "publisher endpoint", [&](td::Slice arg) { publisher_endpoint = arg.str(); });
+  p.add_checked_option('\0', "cache-size",
+                       "memory limit of cached responses to block-pinned queries in bytes (default: 256Mb)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(cache_size, td::to_integer_safe<td::uint64>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('\0', "cache-ttl", "lifetime of a cached response in seconds (default: 60)",
+                       [&](td::Slice arg) -> td::Status {
+                         cache_ttl = td::to_double(arg);
+                         if (cache_ttl <= 0) {
+                           return td::Status::Error("cache-ttl should be positive");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_option('\0', "no-hedge",
+               "do not resend a query to a second server when the first one is slower than the p99 latency",
+               [&]() { hedge = false; });
+  p.add_checked_option('\0', "max-in-flight",
+                       "queries in flight to one server after which the rest are shed, except light ones "
+                       "(sendMessage, getMasterchainInfo, ...) (default: 256)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(max_in_flight, td::to_integer_safe<int>(arg));
+                         if (max_in_flight <= 0) {
+                           return td::Status::Error("max-in-flight should be positive");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('\0', "max-heavy-in-flight",
+                       "runSmcMethod, getState and getConfigAll queries in flight to one server (default: 16)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(max_heavy_in_flight, td::to_integer_safe<int>(arg));
+                         if (max_heavy_in_flight <= 0) {
+                           return td::Status::Error("max-heavy-in-flight should be positive");
+                         }
+                         return td::Status::OK();
+                       });
 
   auto S = p.run(argc, argv);
   if (S.is_error()) {
@@ -1942,7 +2557,9 @@ int main(int argc, char **argv) {
   scheduler.run_in_context([&] {
       td::actor::create_actor<ton::liteserver::LiteProxy>("LiteProxy", std::move(config_path), std::move(db_path),
                                                           std::move(address), lite_port, adnl_port,
-                                                          std::move(global_config), mode, publisher_endpoint)
+                                                          std::move(global_config), mode, publisher_endpoint,
+                                                          cache_size, cache_ttl, hedge, max_in_flight,
+                                                          max_heavy_in_flight)
               .release();
       return td::Status::OK();
   });
@@ -19,6 +19,7 @@
 #include "vm/vm.h"
 #include "td/utils/Slice.h"
 #include "td/utils/common.h"
+#include "td/db/RocksDb.h"
 #include "td/utils/OptionParser.h"
 #include "td/utils/port/user.h"
 #include <utility>
@@ -36,11 +37,17 @@
 namespace ton::liteserver {
 class LiteServerDaemon : public td::actor::Actor {
  public:
-  LiteServerDaemon(std::string db_root, std::string server_config_path, std::string ipaddr, std::string config_path) {
+  LiteServerDaemon(std::string db_root, std::string server_config_path, std::string ipaddr, std::string config_path,
+                   td::uint64 cache_size, td::uint64 cache_disk_size, td::uint32 run_method_cache_size,
+                   bool transaction_index) {
     db_root_ = std::move(db_root);
     server_config_ = std::move(server_config_path);
     tmp_ipaddr_ = std::move(ipaddr);  // only for first run (generate config)
     global_config_ = std::move(config_path);
+    cache_size_ = cache_size;
+    cache_disk_size_ = cache_disk_size;
+    run_method_cache_size_ = run_method_cache_size;
+    transaction_index_ = transaction_index;
   }
 
   void start_up() override {
@@ -84,6 +91,10 @@ class LiteServerDaemon : public td::actor::Actor {
   std::string tmp_ipaddr_;
   std::string global_config_;
   std::string full_node_config_path_;
+  td::uint64 cache_size_;
+  td::uint64 cache_disk_size_;
+  td::uint32 run_method_cache_size_;
+  bool transaction_index_;
   ton::liteserver::Config config_;
 
   ton::adnl::AdnlNodesList adnl_static_nodes_;
@@ -423,6 +434,10 @@ class LiteServerDaemon : public td::actor::Actor {
       h.emplace_back(b);
     }
     opts_.write().set_hardforks(std::move(h));
+    opts_.write().set_liteserver_cache_size(cache_size_);
+    opts_.write().set_liteserver_cache_disk_size(cache_disk_size_);
+    opts_.write().set_liteserver_run_method_cache_size(run_method_cache_size_);
+    opts_.write().set_transaction_index(transaction_index_);
     return td::Status::OK();
   }
 };
@@ -438,6 +453,10 @@ int main(int argc, char **argv) {
   std::string ipaddr;
   std::string full_node_config_path;
   td::uint32 threads = 7;
+  td::uint64 cache_size = 64 << 20;
+  td::uint64 cache_disk_size = 0;
+  td::uint32 run_method_cache_size = 16384;
+  bool transaction_index = false;
   int verbosity = 0;
 
   p.set_description("blockchain indexer");
@@ -475,6 +494,30 @@ int main(int argc, char **argv) {
   p.add_option('I', "ip", "ip address", [&](td::Slice ipaddr_) { ipaddr = ipaddr_.str(); });
   p.add_option('F', "full-node-config", "full node config path",
                [&](td::Slice fname) { full_node_config_path = fname.str(); });
+  p.add_option('R', "secondary-db",
+               "open dbs as secondary instances of a running node, with private files under <dir>, and follow its "
+               "writes",
+               [&](td::Slice dir) { td::RocksDb::set_secondary_root(dir.str()); });
+  p.add_checked_option('\0', "ls-cache-size", "memory limit of the response cache in bytes (default: 64Mb)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(cache_size, td::to_integer_safe<td::uint64>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option(
+      '\0', "ls-cache-disk-size",
+      "size of the on-disk tier of the response cache in bytes, stored in <db>/lscache (default: 0, off)",
+      [&](td::Slice arg) -> td::Status {
+        TRY_RESULT_ASSIGN(cache_disk_size, td::to_integer_safe<td::uint64>(arg));
+        return td::Status::OK();
+      });
+  p.add_checked_option('\0', "ls-run-method-cache-size",
+                       "number of parsed account states kept for runSmcMethod (default: 16384, 0 - off)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(run_method_cache_size, td::to_integer_safe<td::uint32>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_option('\0', "transaction-index", "serve getTransactions from the transaction index kept by the node",
+               [&]() { transaction_index = true; });
 
   auto S = p.run(argc, argv);
   if (S.is_error()) {
@@ -507,7 +550,8 @@ int main(int argc, char **argv) {
   scheduler.run_in_context([&] {
     td::actor::create_actor<ton::liteserver::LiteServerDaemon>("LiteServerDaemon", std::move(db_root),
                                                                std::move(server_config_path), std::move(ipaddr),
-                                                               std::move(config_path))
+                                                               std::move(config_path), cache_size, cache_disk_size,
+                                                               run_method_cache_size, transaction_index)
         .release();
 
     return td::Status::OK();
@@ -26,6 +26,18 @@
 #include "rocksdb/utilities/transaction.h"
 #include "rocksdb/filter_policy.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Random.h"
+
+#include <atomic>
+
+#if TD_PORT_POSIX
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
 
 namespace td {
 namespace {
@@ -41,8 +53,99 @@ static Slice from_rocksdb(rocksdb::Slice slice) {
 static rocksdb::Slice to_rocksdb(Slice slice) {
   return rocksdb::Slice(slice.data(), slice.size());
 }
+
+std::mutex secondary_root_mutex;
+std::string secondary_root;
+// directory of this process under secondary_root, it is owned for as long as process_dir_owner keeps its lock
+std::string process_dir;
+FileFd process_dir_owner;
+
+const char *const owner_file_name = "OWNER";
+
+Result<std::string> default_secondary_path(Slice path) {
+  std::lock_guard<std::mutex> guard(secondary_root_mutex);
+  if (secondary_root.empty()) {
+    return std::string();
+  }
+  if (process_dir.empty()) {
+    // pids repeat in other pid namespaces sharing the root
+    auto dir = PSTRING() << secondary_root << "/" << ::getpid() << "-" << Random::secure_uint32() << "/";
+    TRY_STATUS(mkpath(dir));
+    // the owner file gets its name only when locked, so no other process can find it unlocked while we are alive
+    auto tmp_path = PSTRING() << dir << owner_file_name << ".tmp";
+    TRY_RESULT(owner, FileFd::open(tmp_path, FileFd::Create | FileFd::Read | FileFd::Write));
+    TRY_STATUS(owner.lock(FileFd::LockFlags::Write, "", 1));
+    TRY_STATUS(rename(tmp_path, dir + owner_file_name));
+    process_dir = std::move(dir);
+    process_dir_owner = std::move(owner);
+  }
+  // secondaries of one primary in different processes must not share a directory
+  auto name = path.str();
+  for (auto &c : name) {
+    if (c == '/') {
+      c = '_';
+    }
+  }
+  return PSTRING() << process_dir << name << "/";
+}
+
+// removes the directories under root whose owner file is left by a process which is gone, that is, no longer
+// locked; directories without an owner file are not ours and are never touched
+void remove_stale_secondary_dirs(std::string root) {
+  while (!root.empty() && root.back() == '/') {
+    root.pop_back();
+  }
+  std::vector<std::string> stale;
+  auto S = WalkPath::run(root, [&](CSlice name, WalkPath::Type type) {
+    if (type != WalkPath::Type::EnterDir || name.size() <= root.size()) {
+      return WalkPath::Action::Continue;
+    }
+    auto dir = name.str() + "/";
+    // closing another descriptor of our own owner file would drop our lock
+    if (dir == process_dir) {
+      return WalkPath::Action::SkipDir;
+    }
+    auto r_owner = FileFd::open(dir + owner_file_name, FileFd::Read | FileFd::Write);
+    if (r_owner.is_ok() && r_owner.ok_ref().lock(FileFd::LockFlags::Write, "", 1).is_ok()) {
+      stale.push_back(std::move(dir));
+    }
+    return WalkPath::Action::SkipDir;
+  });
+  if (S.is_error()) {
+    LOG(WARNING) << "Cannot list secondary db root " << root << ": " << S;
+  }
+  for (auto &dir : stale) {
+    LOG(INFO) << "Removing stale secondary db directory " << dir;
+    rmrf(dir).ignore();
+  }
+}
 }  // namespace
 
+struct RocksDb::SecondaryState {
+  SecondaryState(double period, std::string private_path) : period(period), private_path(std::move(private_path)) {
+  }
+
+  // only one catch-up runs at a time, readers coming meanwhile proceed with the current view
+  std::mutex mutex;
+  // guards copying and dropping the RocksDb references to the state, so that the last one is known for sure
+  std::mutex owners_mutex;
+  std::atomic<double> next_catch_up_at{0};
+  std::atomic<td::uint64> sequence_number{0};
+  std::atomic<double> caught_up_at{0};
+  const double period;
+  // directory under the secondary root, removed when the database is closed
+  const std::string private_path;
+
+  Status catch_up(rocksdb::DB &db) {
+    auto now = Time::now();
+    next_catch_up_at.store(now + period, std::memory_order_relaxed);
+    TRY_STATUS(from_rocksdb(db.TryCatchUpWithPrimary()));
+    sequence_number.store(db.GetLatestSequenceNumber(), std::memory_order_relaxed);
+    caught_up_at.store(now, std::memory_order_release);
+    return Status::OK();
+  }
+};
+
 Status RocksDb::destroy(Slice path) {
   return from_rocksdb(rocksdb::DestroyDB(path.str(), {}));
 }
@@ -55,13 +158,36 @@ RocksDb::~RocksDb() {
     return;
   }
   end_snapshot().ensure();
+  if (secondary_ && !secondary_->private_path.empty()) {
+    auto secondary = std::move(secondary_);
+    std::unique_lock<std::mutex> lock(secondary->owners_mutex);
+    if (secondary.use_count() != 1) {
+      secondary.reset();
+      return;
+    }
+    lock.unlock();
+    auto path = secondary->private_path;
+    secondary.reset();
+    db_.reset();
+    rmrf(path).ignore();
+  }
 }
 
 RocksDb RocksDb::clone() const {
   if (transaction_db_) {
     return RocksDb{transaction_db_, options_};
   }
-  return RocksDb{db_, options_};
+  if (secondary_) {
+    std::lock_guard<std::mutex> guard(secondary_->owners_mutex);
+    return RocksDb{db_, options_, read_only_, secondary_};
+  }
+  return RocksDb{db_, options_, read_only_};
+}
+
+void RocksDb::set_secondary_root(std::string root) {
+  std::lock_guard<std::mutex> guard(secondary_root_mutex);
+  remove_stale_secondary_dirs(root);
+  secondary_root = std::move(root);
 }
 
 Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options, bool read_only) {
@@ -113,6 +239,30 @@ Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options, bool rea
     // Place your experimental options here
   }
 
+  if (read_only) {
+    bool private_path = options.secondary_path.empty();
+    std::string secondary_path = options.secondary_path;
+    if (private_path) {
+      TRY_RESULT_ASSIGN(secondary_path, default_secondary_path(path));
+    }
+    if (!secondary_path.empty()) {
+      if (secondary_path.back() != TD_DIR_SLASH) {
+        secondary_path += TD_DIR_SLASH;
+      }
+      TRY_STATUS(mkpath(secondary_path));
+      // secondary instances keep all table files open, so that files deleted by the primary remain readable
+      db_options.max_open_files = -1;
+      db_options.create_if_missing = false;
+      rocksdb::DB *db{nullptr};
+      TRY_STATUS(from_rocksdb(rocksdb::DB::OpenAsSecondary(db_options, std::move(path), secondary_path, &db)));
+      auto secondary =
+          std::make_shared<SecondaryState>(options.secondary_catch_up_period, private_path ? secondary_path : "");
+      RocksDb res(std::shared_ptr<rocksdb::DB>(db), std::move(options), true, secondary);
+      TRY_STATUS(res.catch_up_with_primary());
+      return std::move(res);
+    }
+  }
+
   if (options.no_transactions) {
     rocksdb::DB *db{nullptr};
     TRY_STATUS(from_rocksdb(rocksdb::DB::Open(db_options, std::move(path), &db)));
@@ -127,7 +277,6 @@ Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options, bool rea
     occ_options.validate_policy = rocksdb::OccValidationPolicy::kValidateSerial;
 
     if (read_only) {
-//          const std::string kSecondaryPath = "/tmp/rocksdb_secondary/";
           TRY_STATUS(from_rocksdb(rocksdb::OptimisticTransactionDB::OpenForReadOnly(
                   db_options, std::move(path), column_families, &handles, reinterpret_cast<rocksdb::DB **>(&db))));
       } else {
@@ -159,12 +308,48 @@ std::shared_ptr<rocksdb::Cache> RocksDb::create_cache(size_t capacity) {
 }
 
 std::unique_ptr<KeyValueReader> RocksDb::snapshot() {
-  db_->TryCatchUpWithPrimary();
   auto res = std::make_unique<RocksDb>(clone());
-  res->begin_snapshot().ensure();
+  if (secondary_) {
+    // secondary instances have no rocksdb snapshots, and a frozen view would stop all catch-ups for as long as
+    // anything holds the snapshot (the CellDb loaders do forever); every read of the snapshot is still consistent
+    // in itself, since it pins the version it started with
+    maybe_catch_up_with_primary();
+  } else {
+    res->begin_snapshot().ensure();
+  }
   return std::move(res);
 }
 
+Status RocksDb::catch_up_with_primary() {
+  if (!secondary_) {
+    return Status::Error("not a secondary instance");
+  }
+  std::lock_guard<std::mutex> guard(secondary_->mutex);
+  return secondary_->catch_up(*db_);
+}
+
+void RocksDb::maybe_catch_up_with_primary() {
+  if (!secondary_ || Time::now() < secondary_->next_catch_up_at.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(secondary_->mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return;
+  }
+  auto S = secondary_->catch_up(*db_);
+  if (S.is_error()) {
+    LOG(WARNING) << "Failed to catch up with primary: " << S;
+  }
+}
+
+RocksDb::Freshness RocksDb::freshness() const {
+  if (!secondary_) {
+    return Freshness{db_->GetLatestSequenceNumber(), 0};
+  }
+  return Freshness{secondary_->sequence_number.load(std::memory_order_relaxed),
+                   secondary_->caught_up_at.load(std::memory_order_acquire)};
+}
+
 std::string RocksDb::stats() const {
   std::string out;
   db_->GetProperty("rocksdb.stats", &out);
@@ -173,15 +358,10 @@ std::string RocksDb::stats() const {
 }
 
 Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
-  if (read_only_) {
-    if (!last_catch_timeout_ || last_catch_timeout_.is_in_past()) {
-      db_->TryCatchUpWithPrimary();
-      last_catch_timeout_ = td::Timestamp::at(0.1);
-    }
-  }
   if (options_.no_reads) {
     return td::Status::Error("trying to read from write-only database");
   }
+  maybe_catch_up_with_primary();
   rocksdb::Status status;
   if (snapshot_) {
     rocksdb::ReadOptions options;
@@ -202,6 +382,7 @@ Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
 }
 
 Result<std::vector<RocksDb::GetStatus>> RocksDb::get_multi(td::Span<Slice> keys, std::vector<std::string> *values) {
+  maybe_catch_up_with_primary();
   std::vector<rocksdb::Status> statuses(keys.size());
   std::vector<rocksdb::Slice> keys_rocksdb;
   keys_rocksdb.reserve(keys.size());
@@ -271,6 +452,7 @@ Result<size_t> RocksDb::count(Slice prefix) {
   if (options_.no_reads) {
     return td::Status::Error("trying to read from write-only database");
   }
+  maybe_catch_up_with_primary();
   rocksdb::ReadOptions options;
   options.auto_prefix_mode = true;
   options.snapshot = snapshot_.get();
@@ -298,6 +480,7 @@ Status RocksDb::for_each(std::function<Status(Slice, Slice)> f) {
   if (options_.no_reads) {
     return td::Status::Error("trying to read from write-only database");
   }
+  maybe_catch_up_with_primary();
   rocksdb::ReadOptions options;
   options.auto_prefix_mode = true;
   options.snapshot = snapshot_.get();
@@ -324,6 +507,7 @@ Status RocksDb::for_each_in_range(Slice begin, Slice end, std::function<Status(S
   if (options_.no_reads) {
     return td::Status::Error("trying to read from write-only database");
   }
+  maybe_catch_up_with_primary();
   rocksdb::ReadOptions options;
   options.auto_prefix_mode = true;
   options.snapshot = snapshot_.get();
@@ -417,8 +601,9 @@ RocksDb::RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOp
     : transaction_db_{db}, db_(std::move(db)), options_(std::move(options)), read_only_(read_only) {
 }
 
-RocksDb::RocksDb(std::shared_ptr<rocksdb::DB> db, RocksDbOptions options, bool read_only)
-    : db_(std::move(db)), options_(std::move(options)), read_only_(read_only) {
+RocksDb::RocksDb(std::shared_ptr<rocksdb::DB> db, RocksDbOptions options, bool read_only,
+                 std::shared_ptr<SecondaryState> secondary)
+    : db_(std::move(db)), options_(std::move(options)), read_only_(read_only), secondary_(std::move(secondary)) {
 }
 
 void RocksDbSnapshotStatistics::begin_snapshot(const rocksdb::Snapshot *snapshot) {
@@ -78,6 +78,13 @@ struct RocksDbOptions {
   bool no_block_cache = false;
   bool enable_bloom_filter = false;
   bool two_level_index_and_filter = false;
+
+  // A read_only database is opened as a secondary instance of the running primary, which follows its MANIFEST and WAL,
+  // instead of a frozen read-only view. The directory keeps the secondary's own info logs and must not be shared.
+  // Empty means a private directory under the secondary root (see RocksDb::set_secondary_root), if there is one.
+  std::string secondary_path;
+  // Minimal period between two catch-ups of a secondary instance with the primary, in seconds
+  double secondary_catch_up_period = 0.1;
 };
 
 class RocksDb : public KeyValue {
@@ -86,6 +93,22 @@ class RocksDb : public KeyValue {
   RocksDb clone() const;
   static Result<RocksDb> open(std::string path, RocksDbOptions options = {}, bool read_only = false);
 
+  // Databases opened read_only afterwards become secondary instances with private paths under root. The paths of a
+  // process are kept in its own directory with a locked owner file, directories whose owner is gone are removed here
+  static void set_secondary_root(std::string root);
+
+  struct Freshness {
+    td::uint64 sequence_number{0};  // last sequence number visible to reads
+    double caught_up_at{0};         // td::Time::now() of the last successful catch-up with the primary
+  };
+  bool is_secondary() const {
+    return secondary_ != nullptr;
+  }
+  // Secondary instance only: applies what the primary has written since the last catch-up
+  Status catch_up_with_primary();
+  // Data freshness watermark, for a primary instance caught_up_at is 0
+  Freshness freshness() const;
+
   Result<GetStatus> get(Slice key, std::string &value) override;
   Result<std::vector<RocksDb::GetStatus>> get_multi(td::Span<Slice> keys, std::vector<std::string> *values) override;
   Status set(Slice key, Slice value) override;
@@ -108,6 +131,8 @@ class RocksDb : public KeyValue {
   Status begin_snapshot();
   Status end_snapshot();
 
+  // A snapshot of a secondary instance follows the primary like the instance itself, only each single read
+  // (get, get_multi, for_each) sees one version of the database
   std::unique_ptr<KeyValueReader> snapshot() override;
   std::string stats() const override;
 
@@ -133,7 +158,10 @@ class RocksDb : public KeyValue {
   std::unique_ptr<rocksdb::Transaction> transaction_;
   std::unique_ptr<rocksdb::WriteBatch> write_batch_;
   bool read_only_ = false;
-  td::Timestamp last_catch_timeout_;
+
+  struct SecondaryState;
+  std::shared_ptr<SecondaryState> secondary_;
+  void maybe_catch_up_with_primary();
 
   class UnreachableDeleter {
    public:
@@ -145,6 +173,7 @@ class RocksDb : public KeyValue {
   std::unique_ptr<const rocksdb::Snapshot, UnreachableDeleter> snapshot_;
 
   explicit RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options, bool read_only = false);
-  explicit RocksDb(std::shared_ptr<rocksdb::DB> db, RocksDbOptions options, bool read_only = false);
+  explicit RocksDb(std::shared_ptr<rocksdb::DB> db, RocksDbOptions options, bool read_only = false,
+                   std::shared_ptr<SecondaryState> secondary = nullptr);
 };
 }  // namespace td
@@ -28,6 +28,11 @@
 #include <limits>
 #include <mutex>
 
+#if TD_PORT_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace td {
 
 class BlobViewImpl {
@@ -41,6 +46,12 @@ class BlobViewImpl {
     return td::Status::OK();
   }
   virtual td::uint64 size() = 0;
+  virtual td::Slice as_slice() {
+    return {};
+  }
+  virtual td::Status advise(td::uint64 offset, td::uint64 size, BlobView::Advice advice) {
+    return td::Status::OK();
+  }
 
  private:
   virtual td::Result<td::Slice> view_impl(td::MutableSlice slice, td::uint64 offset) = 0;
@@ -92,6 +103,19 @@ td::uint64 BlobView::size() {
   return impl_->size();
 }
 
+td::Slice BlobView::as_slice() {
+  CHECK(impl_);
+  return impl_->as_slice();
+}
+
+td::Status BlobView::advise(td::uint64 offset, td::uint64 size, Advice advice) {
+  CHECK(impl_);
+  if (offset >= impl_->size()) {
+    return td::Status::OK();
+  }
+  return impl_->advise(offset, td::min(size, impl_->size() - offset), advice);
+}
+
 td::Result<td::Slice> BlobViewImpl::view(td::MutableSlice slice, td::uint64 offset) {
   if (offset > size() || slice.size() > size() - offset) {
     return td::Status::Error(PSLICE() << "BlobView: invalid range requested " << td::tag("slice offset", offset)
@@ -129,6 +153,9 @@ class BufferSliceBlobViewImpl : public BlobViewImpl {
   td::uint64 size() override {
     return slice_.size();
   }
+  td::Slice as_slice() override {
+    return slice_.as_slice();
+  }
 
  private:
   td::BufferSlice slice_;
@@ -289,6 +316,39 @@ class FileMemoryMappingBlobViewImpl : public BlobViewImpl {
   td::uint64 size() override {
     return mapping_.as_slice().size();
   }
+  td::Slice as_slice() override {
+    return mapping_.as_slice();
+  }
+  td::Status advise(td::uint64 offset, td::uint64 size, BlobView::Advice advice) override {
+#if TD_PORT_POSIX
+    if (size == 0) {
+      return td::Status::OK();
+    }
+    int flag = MADV_NORMAL;
+    switch (advice) {
+      case BlobView::Advice::Normal:
+        flag = MADV_NORMAL;
+        break;
+      case BlobView::Advice::Random:
+        flag = MADV_RANDOM;
+        break;
+      case BlobView::Advice::Sequential:
+        flag = MADV_SEQUENTIAL;
+        break;
+      case BlobView::Advice::WillNeed:
+        flag = MADV_WILLNEED;
+        break;
+    }
+    static const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto begin = reinterpret_cast<std::uintptr_t>(mapping_.as_slice().begin()) + offset;
+    auto end = begin + size;
+    begin -= begin % page_size;
+    if (madvise(reinterpret_cast<void *>(begin), static_cast<size_t>(end - begin), flag) != 0) {
+      return OS_ERROR("madvise failed");
+    }
+#endif
+    return td::Status::OK();
+  }
 
  private:
   td::MemoryMapping mapping_;
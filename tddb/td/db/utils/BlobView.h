@@ -36,6 +36,13 @@ class BlobView {
   td::Result<size_t> write(td::Slice data, td::uint64 offset);
   td::uint64 size();
 
+  // The whole blob if it is held in memory (buffer or memory mapping), an empty slice otherwise
+  td::Slice as_slice();
+
+  enum class Advice { Normal, Random, Sequential, WillNeed };
+  // Access pattern hint for the range, a no-op unless the blob is memory mapped
+  td::Status advise(td::uint64 offset, td::uint64 size, Advice advice);
+
   explicit operator bool() const {
     return bool(impl_);
   }
@@ -10,6 +10,9 @@
 #include <queue>
 #include "block/block-auto.h"
 #include "PyCell.h"
+#include "PyTools.h"
+#include <atomic>
+#include <thread>
 
 std::string PyCell::get_hash() const {
   if (my_cell.not_null()) {
@@ -61,14 +64,7 @@ std::string PyCell::dump_as_tlb(std::string tlb_type) const {
     throw std::invalid_argument("Cell is null");
   }
 
-  tlb::TypenameLookup tlb_dict0;
-  tlb_dict0.register_types(block::gen::register_simple_types);
-
-  auto _template = tlb_dict0.lookup(std::move(tlb_type));
-
-  if (!_template) {
-    throw std::invalid_argument("Parse tlb error: not valid tlb type");
-  }
+  auto _template = lookup_tlb_type(tlb_type);
 
   std::ostringstream ss;
   _template->print_ref(9 << 20, ss, my_cell);
@@ -85,6 +81,60 @@ std::string PyCell::to_boc() const {
   return td::base64_encode(std_boc_serialize(my_cell, 31).move_as_ok());
 }
 
+py::bytes PyCell::to_boc_bytes() const {
+  if (my_cell.is_null()) {
+    throw std::invalid_argument("Cell is null");
+  }
+
+  auto boc = std_boc_serialize(my_cell, 31).move_as_ok();
+  return py::bytes(boc.data(), boc.size());
+}
+
+PyCellBuffer PyCell::boc_view() const {
+  if (my_cell.is_null()) {
+    throw std::invalid_argument("Cell is null");
+  }
+
+  PyCellBuffer buffer;
+  buffer.owned = std_boc_serialize(my_cell, 31).move_as_ok();
+  buffer.data = buffer.owned.data();
+  buffer.size = buffer.owned.size();
+  buffer.bits = static_cast<unsigned>(buffer.size * 8);
+  return buffer;
+}
+
+PyCellBuffer PyCell::data_view() const {
+  if (my_cell.is_null()) {
+    throw std::invalid_argument("Cell is null");
+  }
+
+  auto loaded = my_cell->load_cell();
+  if (loaded.is_error()) {
+    throw std::invalid_argument("Can't load cell: " + loaded.move_as_error().to_string());
+  }
+
+  PyCellBuffer buffer;
+  buffer.cell = loaded.move_as_ok().data_cell;
+  buffer.data = reinterpret_cast<const char*>(buffer.cell->get_data());
+  buffer.bits = buffer.cell->get_bits();
+  buffer.size = (buffer.bits + 7) / 8;
+  return buffer;
+}
+
+py::object PyCell::to_tlb_dict(const std::string& tlb_type) const {
+  if (my_cell.is_null()) {
+    throw std::invalid_argument("Cell is null");
+  }
+
+  auto _template = lookup_tlb_type(tlb_type);
+
+  std::ostringstream ss;
+  if (!_template->print_ref(9 << 20, ss, my_cell)) {
+    throw std::invalid_argument("Can't decode cell as " + tlb_type);
+  }
+  return tlb_print_to_py(ss.str());
+}
+
 bool PyCell::is_null() const {
   return my_cell.is_null();
 }
@@ -118,3 +168,70 @@ PyCell parse_string_to_cell(const std::string& base64string) {
 
   return PyCell(boc_decoded.move_as_ok());
 }
+
+PyCell parse_boc(const py::buffer& boc) {
+  auto info = boc.request();
+  td::Slice data(static_cast<const char*>(info.ptr), static_cast<std::size_t>(info.size * info.itemsize));
+
+  td::Result<td::Ref<vm::Cell>> boc_decoded;
+  {
+    py::gil_scoped_release release;
+    boc_decoded = vm::std_boc_deserialize(data);
+  }
+
+  if (boc_decoded.is_error()) {
+    throw std::invalid_argument(boc_decoded.move_as_error().message().str());
+  }
+  return PyCell(boc_decoded.move_as_ok());
+}
+
+std::vector<PyCell> parse_bocs(const py::list& bocs, int threads) {
+  // buffers are requested with the GIL held and stay valid while `bocs` is alive
+  std::vector<py::buffer_info> infos;
+  infos.reserve(bocs.size());
+  for (auto item : bocs) {
+    infos.push_back(item.cast<py::buffer>().request());
+  }
+
+  std::vector<td::Ref<vm::Cell>> cells(infos.size());
+  std::vector<std::string> errors(infos.size());
+  {
+    py::gil_scoped_release release;
+
+    std::size_t workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, infos.size());
+
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+      for (auto i = next.fetch_add(1); i < infos.size(); i = next.fetch_add(1)) {
+        td::Slice data(static_cast<const char*>(infos[i].ptr),
+                       static_cast<std::size_t>(infos[i].size * infos[i].itemsize));
+        auto r_cell = vm::std_boc_deserialize(data);
+        if (r_cell.is_error()) {
+          errors[i] = r_cell.move_as_error().message().str();
+        } else {
+          cells[i] = r_cell.move_as_ok();
+        }
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < workers; i++) {
+      pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  }
+
+  std::vector<PyCell> result;
+  result.reserve(cells.size());
+  for (std::size_t i = 0; i < cells.size(); i++) {
+    if (!errors[i].empty()) {
+      throw std::invalid_argument("BOC #" + std::to_string(i) + ": " + errors[i]);
+    }
+    result.emplace_back(std::move(cells[i]));
+  }
+  return result;
+}
@@ -2,6 +2,7 @@
 
 #include "third-party/pybind11/include/pybind11/pybind11.h"
 #include "vm/vm.h"
+#include "td/utils/buffer.h"
 
 namespace py = pybind11;
 
@@ -9,6 +10,17 @@ namespace py = pybind11;
 #ifndef TON_PYCELL_H
 #define TON_PYCELL_H
 
+// Read-only bytes handed to Python through the buffer protocol without a copy, e.g. memoryview(cell.boc_view()).
+// Owns the serialized BOC or keeps the cell holding the data alive for as long as Python references it.
+class PyCellBuffer {
+ public:
+  td::BufferSlice owned;
+  td::Ref<vm::DataCell> cell;
+  const char* data = nullptr;
+  std::size_t size = 0;
+  unsigned bits = 0;
+};
+
 class PyCell {
  public:
   vm::Ref<vm::Cell> my_cell;
@@ -31,6 +43,10 @@ class PyCell {
   std::string dump_as_tlb(std::string tlb_type) const;
   std::string to_boc() const;
   py::bytes to_slice() const;
+  py::bytes to_boc_bytes() const;
+  PyCellBuffer boc_view() const;
+  PyCellBuffer data_view() const;
+  py::object to_tlb_dict(const std::string& tlb_type) const;
   PyCell copy() const;
   bool is_null() const;
 
@@ -40,5 +56,9 @@ class PyCell {
 };
 
 PyCell parse_string_to_cell(const std::string& base64string);
+// Raw (not base64) BOC from any object supporting the buffer protocol: bytes, bytearray, memoryview, numpy arrays
+PyCell parse_boc(const py::buffer& boc);
+// Deserializes many BOCs on `threads` native threads (0 = all cores) without holding the GIL, keeps the order
+std::vector<PyCell> parse_bocs(const py::list& bocs, int threads = 0);
 
 #endif  //TON_PYCELL_H
@@ -16,6 +16,7 @@
 #include "block/block-auto.h"
 #include "PyCellSlice.h"
 #include "PyCell.h"
+#include "PyTools.h"
 #include <string>
 #include <cassert>
 #include <codecvt>
@@ -331,14 +332,7 @@ bool PyCellSlice::skip_refs(unsigned n, bool last) {
 }
 
 PyCellSlice PyCellSlice::load_tlb(std::string tlb_type) {
-  tlb::TypenameLookup tlb_dict0;
-  tlb_dict0.register_types(block::gen::register_simple_types);
-
-  auto _template = tlb_dict0.lookup(std::move(tlb_type));
-
-  if (!_template) {
-    throw std::invalid_argument("Parse tlb error: not valid tlb type");
-  }
+  auto _template = lookup_tlb_type(tlb_type);
 
   vm::CellBuilder cb;
   auto fetched_tlb = _template->fetch(my_cell_slice);
@@ -356,14 +350,7 @@ int PyCellSlice::bselect_ext(unsigned bits, std::string mask) {
 }
 
 std::string PyCellSlice::dump_as_tlb(std::string tlb_type) const {
-  tlb::TypenameLookup tlb_dict0;
-  tlb_dict0.register_types(block::gen::register_simple_types);
-
-  auto _template = tlb_dict0.lookup(std::move(tlb_type));
-
-  if (!_template) {
-    throw std::invalid_argument("Parse tlb error: not valid tlb type");
-  }
+  auto _template = lookup_tlb_type(tlb_type);
 
   vm::CellBuilder cb;
   cb.append_cellslice(my_cell_slice.clone());
@@ -375,6 +362,19 @@ std::string PyCellSlice::dump_as_tlb(std::string tlb_type) const {
   return output;
 }
 
+py::object PyCellSlice::to_tlb_dict(const std::string& tlb_type) const {
+  auto _template = lookup_tlb_type(tlb_type);
+
+  vm::CellBuilder cb;
+  cb.append_cellslice(my_cell_slice.clone());
+
+  std::ostringstream ss;
+  if (!_template->print_ref(9 << 20, ss, cb.finalize_copy())) {
+    throw std::invalid_argument("Can't decode cell slice as " + tlb_type);
+  }
+  return tlb_print_to_py(ss.str());
+}
+
 std::string PyCellSlice::load_snake_string() {
   return parse_snake_data_string(my_cell_slice);
 }
@@ -54,6 +54,7 @@ class PyCellSlice {
   std::string to_boc() const;
   std::string get_hash() const;
   std::string dump_as_tlb(std::string tlb_type) const;
+  py::object to_tlb_dict(const std::string& tlb_type) const;
   std::string load_string(unsigned int text_size = 0, bool convert_to_utf8 = true);
   PyCellSlice load_tlb(std::string tlb_type);
   PyCellSlice load_subslice(unsigned int bits, unsigned int refs = 0);
@@ -20,49 +20,21 @@
 #include "PyCell.h"
 #include "PyEmulator.h"
 #include "third-party/pybind11/include/pybind11/embed.h"
+#include <atomic>
+#include <thread>
 
+namespace {
 
-bool PyEmulator::set_rand_seed(const std::string &rand_seed_hex) {
-    auto rand_seed_hex_slice = td::Slice(rand_seed_hex);
-    if (rand_seed_hex_slice.size() != 64) {
-        throw std::invalid_argument("Rand seed expected as 64 characters hex string");
-    }
-
-    auto rand_seed_bytes = td::hex_decode(rand_seed_hex_slice);
-    if (rand_seed_bytes.is_error()) {
-        throw std::invalid_argument("Can't decode hex rand seed");
-    }
-
-    td::BitArray<256> rand_seed{};
-    rand_seed.as_slice().copy_from(rand_seed_bytes.move_as_ok());
-
-    emulator->set_rand_seed(rand_seed);
-    return true;
-}
-
-bool PyEmulator::set_ignore_chksig(bool ignore_chksig) {
-    emulator->set_ignore_chksig(ignore_chksig);
-    return true;
-}
-
-bool PyEmulator::set_libs(const PyCell &shardchain_libs_cell) {
-    emulator->set_libs(vm::Dictionary(shardchain_libs_cell.my_cell, 256));
-    return true;
-}
-
-bool PyEmulator::set_debug_enabled(bool debug_enabled) {
-    emulator->set_debug_enabled(debug_enabled);
-    return true;
-}
-
-bool PyEmulator::emulate_transaction(const PyCell &shard_account_cell, const PyCell &message_cell,
-                                     const std::string &unixtime, const std::string &lt_str, int vm_ver,
-                                     bool force_uninit) {
-    auto message_cs = vm::load_cell_slice(message_cell.my_cell);
+// Unpacks the shard account and runs an ordinary transaction on it, throws std::invalid_argument on bad input
+std::unique_ptr<emulator::TransactionEmulator::EmulationResult> emulate_ordinary(
+        emulator::TransactionEmulator &emulator, const td::Ref<vm::Cell> &shard_account_cell,
+        const td::Ref<vm::Cell> &message_cell, const std::string &unixtime, const std::string &lt_str, int vm_ver,
+        bool force_uninit) {
+    auto message_cs = vm::load_cell_slice(message_cell);
     int msg_tag = block::gen::t_CommonMsgInfo.get_tag(message_cs);
 
     block::gen::ShardAccount::Record shard_account;
-    if (!tlb::unpack_cell(shard_account_cell.my_cell, shard_account)) {
+    if (!tlb::unpack_cell(shard_account_cell, shard_account)) {
         throw std::invalid_argument("Can't unpack shard account cell");
     }
 
@@ -108,9 +80,9 @@ bool PyEmulator::emulate_transaction(const PyCell &shard_account_cell, const PyC
     account.now_ = now;
     account.block_lt = lt - lt % block::ConfigInfo::get_lt_align();
 
-    bool is_special = wc == ton::masterchainId && emulator->get_config().is_special_smartcontract(addr);
+    bool is_special = wc == ton::masterchainId && emulator.get_config().is_special_smartcontract(addr);
     if (account_exists) {
-        if (!account.unpack(vm::load_cell_slice_ref(shard_account_cell.my_cell), now, is_special)) {
+        if (!account.unpack(vm::load_cell_slice_ref(shard_account_cell), now, is_special)) {
             throw std::invalid_argument("Can't unpack shard account");
         }
     } else {
@@ -130,14 +102,101 @@ bool PyEmulator::emulate_transaction(const PyCell &shard_account_cell, const PyC
         }
     }
 
-    auto result = emulator->emulate_transaction(std::move(account), message_cell.my_cell, now, lt,
-                                                block::transaction::Transaction::tr_ord, vm_ver);
+    auto result = emulator.emulate_transaction(std::move(account), message_cell, now, lt,
+                                               block::transaction::Transaction::tr_ord, vm_ver);
 
     if (result.is_error()) {
         throw std::invalid_argument("Emulate transaction failed: " + result.move_as_error().to_string());
     }
 
-    auto emulation_result = result.move_as_ok();
+    return result.move_as_ok();
+}
+
+td::Ref<vm::Cell> new_shard_account_cell(const block::Account &account) {
+    return vm::CellBuilder()
+            .store_ref(account.total_state)
+            .store_bits(account.last_trans_hash_.as_bitslice())
+            .store_long(account.last_trans_lt_)
+            .finalize();
+}
+
+}  // namespace
+
+td::unique_ptr<emulator::TransactionEmulator> PyEmulator::create_emulator() const {
+    // todo: pass ConfigParams as root cell
+    const block::StdAddress res =
+            block::StdAddress::parse("-1:5555555555555555555555555555555555555555555555555555555555555555").move_as_ok();
+
+    auto global_config = block::Config(
+            config_params, res.addr,
+            block::Config::needWorkchainInfo | block::Config::needSpecialSmc | block::Config::needCapabilities);
+
+    if (global_config.unpack().is_error()) {
+        throw std::invalid_argument("Can't unpack config params");
+    }
+    auto shared_config = std::make_shared<block::Config>(std::move(global_config));
+    return td::make_unique<emulator::TransactionEmulator>(std::move(shared_config), 0);
+}
+
+void PyEmulator::configure(emulator::TransactionEmulator &worker) {
+    worker.set_rand_seed(rand_seed);
+    worker.set_ignore_chksig(ignore_chksig);
+    worker.set_debug_enabled(debug_enabled);
+    if (libs.not_null()) {
+        worker.set_libs(vm::Dictionary(libs, 256));
+    }
+    if (prev_blocks_info.not_null()) {
+        worker.set_prev_blocks_info(prev_blocks_info);
+    }
+}
+
+bool PyEmulator::set_rand_seed(const std::string &rand_seed_hex) {
+    auto rand_seed_hex_slice = td::Slice(rand_seed_hex);
+    if (rand_seed_hex_slice.size() != 64) {
+        throw std::invalid_argument("Rand seed expected as 64 characters hex string");
+    }
+
+    auto rand_seed_bytes = td::hex_decode(rand_seed_hex_slice);
+    if (rand_seed_bytes.is_error()) {
+        throw std::invalid_argument("Can't decode hex rand seed");
+    }
+
+    td::BitArray<256> seed{};
+    seed.as_slice().copy_from(rand_seed_bytes.move_as_ok());
+
+    std::lock_guard<std::mutex> lock(mtx);
+    rand_seed = seed;
+    emulator->set_rand_seed(seed);
+    return true;
+}
+
+bool PyEmulator::set_ignore_chksig(bool ignore_chksig) {
+    std::lock_guard<std::mutex> lock(mtx);
+    this->ignore_chksig = ignore_chksig;
+    emulator->set_ignore_chksig(ignore_chksig);
+    return true;
+}
+
+bool PyEmulator::set_libs(const PyCell &shardchain_libs_cell) {
+    std::lock_guard<std::mutex> lock(mtx);
+    libs = shardchain_libs_cell.my_cell;
+    emulator->set_libs(vm::Dictionary(shardchain_libs_cell.my_cell, 256));
+    return true;
+}
+
+bool PyEmulator::set_debug_enabled(bool debug_enabled) {
+    std::lock_guard<std::mutex> lock(mtx);
+    this->debug_enabled = debug_enabled;
+    emulator->set_debug_enabled(debug_enabled);
+    return true;
+}
+
+bool PyEmulator::emulate_transaction(const PyCell &shard_account_cell, const PyCell &message_cell,
+                                     const std::string &unixtime, const std::string &lt_str, int vm_ver,
+                                     bool force_uninit) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto emulation_result = emulate_ordinary(*emulator, shard_account_cell.my_cell, message_cell.my_cell, unixtime,
+                                             lt_str, vm_ver, force_uninit);
 
     auto external_not_accepted =
             dynamic_cast<emulator::TransactionEmulator::EmulationExternalNotAccepted *>(emulation_result.get());
@@ -152,14 +211,7 @@ bool PyEmulator::emulate_transaction(const PyCell &shard_account_cell, const PyC
 
     const auto &emulation_success = dynamic_cast<emulator::TransactionEmulator::EmulationSuccess &>(*emulation_result);
     transaction_cell = std::move(emulation_success.transaction);
-
-    auto new_shard_account_cell = vm::CellBuilder()
-            .store_ref(emulation_success.account.total_state)
-            .store_bits(emulation_success.account.last_trans_hash_.as_bitslice())
-            .store_long(emulation_success.account.last_trans_lt_)
-            .finalize();
-
-    account_cell = std::move(new_shard_account_cell);
+    account_cell = new_shard_account_cell(emulation_success.account);
     actions_cell = std::move(emulation_success.actions);
 
     return true;
@@ -167,6 +219,7 @@ bool PyEmulator::emulate_transaction(const PyCell &shard_account_cell, const PyC
 
 bool PyEmulator::emulate_tick_tock_transaction(const PyCell &shard_account_boc, bool is_tock,
                                                const std::string &unixtime, const std::string &lt_str, int vm_ver) {
+    std::lock_guard<std::mutex> lock(mtx);
     auto shard_account_cell = shard_account_boc.my_cell;
 
     if (shard_account_cell.is_null()) {
@@ -226,25 +279,81 @@ bool PyEmulator::emulate_tick_tock_transaction(const PyCell &shard_account_boc,
 
     const auto &emulation_success = dynamic_cast<emulator::TransactionEmulator::EmulationSuccess &>(*emulation_result);
     transaction_cell = std::move(emulation_success.transaction);
-
-    auto new_shard_account_cell = vm::CellBuilder()
-            .store_ref(emulation_success.account.total_state)
-            .store_bits(emulation_success.account.last_trans_hash_.as_bitslice())
-            .store_long(emulation_success.account.last_trans_lt_)
-            .finalize();
-
-    account_cell = std::move(new_shard_account_cell);
+    account_cell = new_shard_account_cell(emulation_success.account);
     actions_cell = std::move(emulation_success.actions);
 
     return true;
 }
 
+std::vector<PyEmulationResult> PyEmulator::emulate_batch(const std::vector<BatchItem> &items, int threads, int vm_ver,
+                                                         bool force_uninit) {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    std::size_t workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, items.size());
+    while (batch_emulators.size() < workers) {
+        batch_emulators.push_back(create_emulator());
+    }
+    for (std::size_t i = 0; i < workers; i++) {
+        configure(*batch_emulators[i]);
+    }
+
+    std::vector<PyEmulationResult> results(items.size());
+    std::atomic<std::size_t> next{0};
+    auto work = [&](emulator::TransactionEmulator &worker) {
+        for (auto i = next.fetch_add(1); i < items.size(); i = next.fetch_add(1)) {
+            auto &result = results[i];
+            try {
+                auto emulation_result = emulate_ordinary(worker, std::get<0>(items[i]).my_cell,
+                                                         std::get<1>(items[i]).my_cell, std::get<2>(items[i]),
+                                                         std::get<3>(items[i]), vm_ver, force_uninit);
+                result.vm_log = std::move(emulation_result->vm_log);
+                result.elapsed_time = emulation_result->elapsed_time;
+
+                auto external_not_accepted =
+                        dynamic_cast<emulator::TransactionEmulator::EmulationExternalNotAccepted *>(
+                                emulation_result.get());
+                if (external_not_accepted) {
+                    result.vm_exit_code = external_not_accepted->vm_exit_code;
+                    continue;
+                }
+
+                auto &emulation_success =
+                        dynamic_cast<emulator::TransactionEmulator::EmulationSuccess &>(*emulation_result);
+                result.success = true;
+                result.transaction_cell = PyCell(std::move(emulation_success.transaction));
+                result.account_cell = PyCell(new_shard_account_cell(emulation_success.account));
+                result.actions_cell = PyCell(std::move(emulation_success.actions));
+            } catch (const std::exception &e) {
+                result.error = e.what();
+            } catch (...) {
+                result.error = "Emulate transaction failed";
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers > 0 ? workers - 1 : 0);
+    for (std::size_t i = 1; i < workers; i++) {
+        pool.emplace_back(work, std::ref(*batch_emulators[i]));
+    }
+    if (workers > 0) {
+        work(*batch_emulators[0]);
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    return results;
+}
+
 std::string PyEmulator::get_vm_log() {
     return vm_log;
 }
 
 void PyEmulator::set_prev_blocks_info(PyStackEntry entry) {
-    emulator->set_prev_blocks_info(entry.entry.as_tuple());
+    std::lock_guard<std::mutex> lock(mtx);
+    prev_blocks_info = entry.entry.as_tuple();
+    emulator->set_prev_blocks_info(prev_blocks_info);
 }
 
 double PyEmulator::get_elapsed_time() {
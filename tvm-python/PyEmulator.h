@@ -24,12 +24,30 @@
 #include "transaction-emulator.h"
 #include "tvm-emulator.hpp"
 #include "crypto/vm/stack.hpp"
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 #ifndef TON_PYEMULATOR_H
 #define TON_PYEMULATOR_H
 
+// Outcome of one emulate_batch item; error is set (and the rest left empty) if the item could not be emulated
+struct PyEmulationResult {
+  bool success = false;
+  PyCell transaction_cell;
+  PyCell account_cell;
+  PyCell actions_cell;
+  std::string vm_log;
+  double elapsed_time = 0;
+  int vm_exit_code = 0;
+  std::string error;
+};
+
 class PyEmulator {
  public:
+  // shard_account, message, unixtime, lt
+  using BatchItem = std::tuple<PyCell, PyCell, std::string, std::string>;
+
   td::unique_ptr<emulator::TransactionEmulator> emulator;
 
   // Result:
@@ -40,20 +58,8 @@ class PyEmulator {
   double elapsed_time;
   int vm_exit_code;
 
-  PyEmulator(const PyCell& config_params_cell) {
-    // todo: pass ConfigParams as root cell
-    const block::StdAddress res =
-        block::StdAddress::parse("-1:5555555555555555555555555555555555555555555555555555555555555555").move_as_ok();
-
-    auto global_config = block::Config(
-        config_params_cell.my_cell, res.addr,
-        block::Config::needWorkchainInfo | block::Config::needSpecialSmc | block::Config::needCapabilities);
-
-    if (global_config.unpack().is_error()) {
-      throw std::invalid_argument("Can't unpack config params");
-    }
-    auto shared_config = std::make_shared<block::Config>(std::move(global_config));
-    emulator = td::make_unique<emulator::TransactionEmulator>(std::move(shared_config), 0);
+  PyEmulator(const PyCell& config_params_cell) : config_params(config_params_cell.my_cell) {
+    emulator = create_emulator();
   };
 
   ~PyEmulator() = default;
@@ -66,6 +72,10 @@ class PyEmulator {
                            const std::string& unixtime = "0", const std::string& lt_str = "0", int vm_ver = 1, bool force_uninit = false);
   bool emulate_tick_tock_transaction(const PyCell& shard_account_boc, bool is_tock, const std::string& unixtime,
                                      const std::string& lt_str, int vm_ver);
+  // Emulates independent ordinary transactions on `threads` native threads (0 = all cores). Every thread keeps its
+  // own emulator with the config parsed once and the current libs / seed / flags; results keep the item order.
+  std::vector<PyEmulationResult> emulate_batch(const std::vector<BatchItem>& items, int threads = 0, int vm_ver = 1,
+                                               bool force_uninit = false);
   std::string get_vm_log();
   double get_elapsed_time();
   PyCell get_transaction_cell();
@@ -76,6 +86,24 @@ class PyEmulator {
   static void dummy_set() {
     throw std::invalid_argument("Not settable");
   }
+
+ private:
+  td::unique_ptr<emulator::TransactionEmulator> create_emulator() const;
+  void configure(emulator::TransactionEmulator& worker);
+
+  // Emulation runs without the GIL: calls on one PyEmulator are serialized, separate instances run in parallel
+  std::mutex mtx;
+
+  // Settings replayed on the batch emulators
+  td::Ref<vm::Cell> config_params;
+  td::Ref<vm::Cell> libs;
+  td::BitArray<256> rand_seed = td::BitArray<256>::zero();
+  bool ignore_chksig = false;
+  bool debug_enabled = false;
+  td::Ref<vm::Tuple> prev_blocks_info;
+
+  // block::Config caches dictionary roots lazily and is not safe to share, so every batch thread has its own
+  std::vector<td::unique_ptr<emulator::TransactionEmulator>> batch_emulators;
 };
 
 #endif  //TON_PYEMULATOR_H
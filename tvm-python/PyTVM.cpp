@@ -34,6 +34,11 @@ void PyTVM::set_c7(PyStackEntry x) {
 }
 
 void PyTVM::log(const std::string &log_string, int level) {
+  if (log_level < level) {
+    return;
+  }
+  // run_vm is called without the GIL
+  py::gil_scoped_acquire acquire;
   if (log_level >= level && level == LOG_INFO) {
     py::print("INFO: " + log_string);
   } else if (log_level >= level && level == LOG_DEBUG) {
@@ -129,6 +134,7 @@ public:
       }
 
       if (!muted) {
+        py::gil_scoped_acquire acquire;
         py::print(slice.str());
       }
     }
@@ -20,7 +20,9 @@
 #include "td/utils/port/path.h"
 #include "PyTools.h"
 #include <string>
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <codecvt>
 #include <iostream>
 #include <locale>
@@ -340,3 +342,126 @@ std::string parse_shard_account(PyCell &shard_account) {
 
   return data.dump(-1);
 };
+
+const tlb::TLB* lookup_tlb_type(const std::string& tlb_type) {
+  static const tlb::TypenameLookup lookup{block::gen::register_simple_types};
+
+  auto type = lookup.lookup(tlb_type);
+  if (!type) {
+    throw std::invalid_argument("Parse tlb error: not valid tlb type");
+  }
+  return type;
+}
+
+namespace {
+
+class TlbPrintParser {
+ public:
+  explicit TlbPrintParser(const std::string& text) : text_(text) {
+  }
+
+  py::object parse() {
+    auto result = value();
+    skip_spaces();
+    if (pos_ != text_.size()) {
+      throw std::invalid_argument("Extra data after TL-B value");
+    }
+    return result;
+  }
+
+ private:
+  const std::string& text_;
+  std::size_t pos_ = 0;
+
+  void skip_spaces() {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+      pos_++;
+    }
+  }
+
+  char peek() {
+    skip_spaces();
+    if (pos_ >= text_.size()) {
+      throw std::invalid_argument("Unexpected end of TL-B value");
+    }
+    return text_[pos_];
+  }
+
+  std::string token() {
+    auto start = pos_;
+    while (pos_ < text_.size() && !std::isspace(static_cast<unsigned char>(text_[pos_])) && text_[pos_] != '(' &&
+           text_[pos_] != ')' && text_[pos_] != ':') {
+      pos_++;
+    }
+    return text_.substr(start, pos_ - start);
+  }
+
+  static py::object scalar(const std::string& token) {
+    auto digits = token.size() > 1 && token[0] == '-' ? token.substr(1) : token;
+    if (!digits.empty() && std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+      return py::reinterpret_steal<py::object>(PyLong_FromString(token.c_str(), nullptr, 10));
+    }
+    // bit strings ("x<hex>") and constructors without fields
+    return py::str(token);
+  }
+
+  py::object value() {
+    if (peek() == '(') {
+      return record();
+    }
+    return scalar(token());
+  }
+
+  py::object record() {
+    pos_++;  // '('
+    py::dict result;
+    auto name = token();
+    result["@type"] = name;
+
+    if (name.rfind("raw@", 0) == 0) {
+      // a value the printer could not decompose: its type, which may itself be parenthesized,
+      // followed by its cell dump; the value ends at the matching ')'
+      auto start = pos_;
+      int depth = 0;
+      for (; pos_ < text_.size(); pos_++) {
+        if (text_[pos_] == '(') {
+          depth++;
+        } else if (text_[pos_] == ')' && depth-- == 0) {
+          break;
+        }
+      }
+      if (pos_ >= text_.size()) {
+        throw std::invalid_argument("Unexpected end of TL-B value");
+      }
+      result["raw"] = text_.substr(start, pos_ - start);
+      pos_++;  // ')'
+      return result;
+    }
+
+    int anonymous = 0;
+    while (peek() != ')') {
+      if (text_[pos_] == '(') {
+        result[py::str("_" + std::to_string(anonymous++))] = record();
+        continue;
+      }
+      auto item = token();
+      if (item.empty()) {
+        throw std::invalid_argument("Unexpected '" + std::string(1, text_[pos_]) + "' in TL-B value");
+      }
+      if (pos_ < text_.size() && text_[pos_] == ':') {
+        pos_++;
+        result[py::str(item)] = value();
+      } else {
+        result[py::str("_" + std::to_string(anonymous++))] = scalar(item);
+      }
+    }
+    pos_++;  // ')'
+    return std::move(result);
+  }
+};
+
+}  // namespace
+
+py::object tlb_print_to_py(const std::string& text) {
+  return TlbPrintParser(text).parse();
+}
@@ -2,6 +2,7 @@
 
 #include "third-party/pybind11/include/pybind11/pybind11.h"
 #include "vm/vm.h"
+#include "tl/tlblib.hpp"
 #include "tvm-python/PyCell.h"
 #include "tvm-python/PyCellSlice.h"
 
@@ -20,4 +21,10 @@ PyCellSlice pack_address(const std::string& address);
 std::string parse_chunked_data(vm::CellSlice& cs);
 std::string parse_shard_account(PyCell &shard_account);
 
+// block::gen type by name, the lookup table is built once; throws if the type is unknown
+const tlb::TLB* lookup_tlb_type(const std::string& tlb_type);
+// Converts TL-B pretty printer output into nested dicts: {"@type": constructor, field: value, ...}.
+// Integers become int, bit strings stay "x<hex>" strings, anonymous fields are keyed "_0", "_1", ...
+py::object tlb_print_to_py(const std::string& text);
+
 #endif  //TON_PYTOOLS_H
@@ -19,6 +19,7 @@
 #include "crypto/tl/tlbc-data.h"
 #include "crypto/func/func.h"
 #include "td/utils/optional.h"
+#include "vm/code-cache.h"
 #include "tl/generate/auto/tl/tonlib_api.h"
 #include "PyGlobal.h"
 
@@ -30,6 +31,15 @@ void globalSetVerbosity(int vb) {
   SET_VERBOSITY_LEVEL(v);
 }
 
+void set_decoded_code_cache_size(std::size_t cells) {
+  vm::DecodedCodeCache::set_capacity(cells);
+}
+
+py::dict get_decoded_code_cache_stats() {
+  auto stats = vm::DecodedCodeCache::get_stats();
+  return py::dict("hits"_a = stats.hits, "misses"_a = stats.misses, "decoded"_a = stats.decoded);
+}
+
 unsigned method_name_to_id(const std::string& method_name) {
   unsigned crc = td::crc16(method_name);
   const unsigned method_id = (crc & 0xffff) | 0x10000;
@@ -183,18 +193,31 @@ PYBIND11_MODULE(python_ton, m) {
       .def("skip_refs", &PyCellSlice::skip_refs, py::arg("n"), py::arg("last"))
       .def("load_string", &PyCellSlice::load_string, py::arg("text_size") = 0, py::arg("convert_to_utf8") = true)
       .def("dump_as_tlb", &PyCellSlice::dump_as_tlb, py::arg("tlb_type"))
+      .def("to_tlb_dict", &PyCellSlice::to_tlb_dict, py::arg("tlb_type"))
       .def("load_var_integer_str", &PyCellSlice::load_var_integer_str, py::arg("bit_len"), py::arg("sgnd"))
       .def("__repr__", &PyCellSlice::toString)
       .def_property("bits", &PyCellSlice::bits, &PyCellSlice::dummy_set)
       .def_property("refs", &PyCellSlice::refs, &PyCellSlice::dummy_set);
 
+  py::class_<PyCellBuffer>(m, "PyCellBuffer", py::buffer_protocol(), py::module_local())
+      .def_buffer([](PyCellBuffer& buffer) {
+        return py::buffer_info(const_cast<char*>(buffer.data), 1, py::format_descriptor<unsigned char>::format(),
+                               static_cast<py::ssize_t>(buffer.size), true);
+      })
+      .def("__len__", [](const PyCellBuffer& buffer) { return buffer.size; })
+      .def_readonly("bits", &PyCellBuffer::bits);
+
   py::class_<PyCell>(m, "PyCell", py::module_local())
       .def(py::init<>())
       .def("get_hash", &PyCell::get_hash)
       .def("get_depth", &PyCell::get_depth)
       .def("dump", &PyCell::dump)
       .def("dump_as_tlb", &PyCell::dump_as_tlb, py::arg("tlb_type"))
+      .def("to_tlb_dict", &PyCell::to_tlb_dict, py::arg("tlb_type"))
       .def("to_boc", &PyCell::to_boc)
+      .def("to_boc_bytes", &PyCell::to_boc_bytes)
+      .def("boc_view", &PyCell::boc_view)
+      .def("data_view", &PyCell::data_view)
       .def("__repr__", &PyCell::toString)
       .def("copy", &PyCell::copy)
       .def("is_null", &PyCell::is_null);
@@ -276,7 +299,11 @@ PYBIND11_MODULE(python_ton, m) {
       .def("__repr__", &PyDict::toString);
 
   m.def("parse_string_to_cell", parse_string_to_cell, py::arg("cell_boc"));
+  m.def("parse_boc", parse_boc, py::arg("boc"));
+  m.def("parse_bocs", parse_bocs, py::arg("bocs"), py::arg("threads") = 0);
   m.def("globalSetVerbosity", globalSetVerbosity, py::arg("verbosity"));
+  m.def("set_decoded_code_cache_size", set_decoded_code_cache_size, py::arg("cells"));
+  m.def("get_decoded_code_cache_stats", get_decoded_code_cache_stats);
   m.def("load_as_cell_slice", load_as_cell_slice, py::arg("cell"), py::arg("allow_special"));
   m.def("codegen_python_tlb", codeget_python_tlb, py::arg("tlb_text"));
   m.def("parse_token_data", parse_token_data, py::arg("cell"));
@@ -315,7 +342,7 @@ PYBIND11_MODULE(python_ton, m) {
       .def("set_state_init", &PyTVM::set_state_init)
       .def("clear_stack", &PyTVM::clear_stack)
       .def("set_gasLimit", &PyTVM::set_gasLimit, py::arg("gas_limit") = "0", py::arg("gas_max") = "-1")
-      .def("run_vm", &PyTVM::run_vm)
+      .def("run_vm", &PyTVM::run_vm, py::call_guard<py::gil_scoped_release>())
       .def("arun_vm", [](PyTVM &self) {
           return async_wrapper([&self]() { return self.run_vm(); });
       })
@@ -368,6 +395,16 @@ PYBIND11_MODULE(python_ton, m) {
       .def("serialize", &PyStackEntry::serialize, py::arg("mode"))
       .def("type", &PyStackEntry::type);
 
+  py::class_<PyEmulationResult>(m, "PyEmulationResult", py::module_local())
+      .def_readonly("success", &PyEmulationResult::success)
+      .def_readonly("transaction_cell", &PyEmulationResult::transaction_cell)
+      .def_readonly("account_cell", &PyEmulationResult::account_cell)
+      .def_readonly("actions_cell", &PyEmulationResult::actions_cell)
+      .def_readonly("vm_log", &PyEmulationResult::vm_log)
+      .def_readonly("elapsed_time", &PyEmulationResult::elapsed_time)
+      .def_readonly("vm_exit_code", &PyEmulationResult::vm_exit_code)
+      .def_readonly("error", &PyEmulationResult::error);
+
   py::class_<PyEmulator>(m, "PyEmulator", py::module_local())
       .def(py::init<PyCell>(), py::arg("global_config_boc"))
       .def("set_rand_seed", &PyEmulator::set_rand_seed, py::arg("rand_seed_hex"))
@@ -377,7 +414,9 @@ PYBIND11_MODULE(python_ton, m) {
       .def("set_debug_enabled", &PyEmulator::set_debug_enabled, py::arg("debug_enabled"))
       .def("emulate_transaction", &PyEmulator::emulate_transaction, py::arg("shard_account_cell"),
            py::arg("message_cell"), py::arg("unixtime") = "0", py::arg("lt") = "0", py::arg("vm_ver") = 1,
-           py::arg("force_uninit") = false)
+           py::arg("force_uninit") = false, py::call_guard<py::gil_scoped_release>())
+      .def("emulate_batch", &PyEmulator::emulate_batch, py::arg("items"), py::arg("threads") = 0,
+           py::arg("vm_ver") = 1, py::arg("force_uninit") = false, py::call_guard<py::gil_scoped_release>())
       .def("aemulate_transaction",
            [](PyEmulator &self,
               const PyCell& shard_account_cell,
@@ -398,7 +437,8 @@ PYBIND11_MODULE(python_ton, m) {
            py::arg("vm_ver") = 1,
            py::arg("force_uninit") = false)
       .def("emulate_tick_tock_transaction", &PyEmulator::emulate_tick_tock_transaction, py::arg("shard_account_boc"),
-           py::arg("is_tock"), py::arg("unixtime") = "0", py::arg("lt") = "0", py::arg("vm_ver") = 1)
+           py::arg("is_tock"), py::arg("unixtime") = "0", py::arg("lt") = "0", py::arg("vm_ver") = 1,
+           py::call_guard<py::gil_scoped_release>())
       .def("aemulate_tick_tock_transaction",
            [](PyEmulator &self,
               const PyCell& shard_account_boc,
@@ -34,6 +34,7 @@
 #include <chrono>
 #include <thread>
 #include "BlockParserAsync.hpp"
+#include "BlockPublishFormat.hpp"
 #include "td/utils/port/sleep.h"
 #include "td/utils/Time.h"
 #include "td/utils/date.h"
@@ -95,7 +96,7 @@ namespace ton::validator {
         LOG(DEBUG) << "Parse accounts states " << block_id_string << " " << timer;
 
         block::gen::ShardStateUnsplit::Record shard_state;
-        CHECK(tlb::unpack_cell(std::move(root_cell), shard_state));
+        CHECK(tlb::unpack_cell(root_cell, shard_state));
 
         std::vector<std::tuple<int, std::string>> dummy;
 
@@ -233,165 +234,73 @@ namespace ton::validator {
         accounts = td::make_unique<vm::AugmentedDictionary>(vm::load_cell_slice_ref(shard_state.accounts), 256,
                                                             block::tlb::aug_ShardAccounts);
 
-        if (with_prev_state) {
-          block::gen::ShardStateUnsplit::Record prev_shard_state;
-          CHECK(tlb::unpack_cell(std::move(prev_root_cell.value()), prev_shard_state));
-
-          prev_accounts = td::make_unique<vm::AugmentedDictionary>(
-                  vm::load_cell_slice_ref(prev_shard_state.accounts),
-                  256, block::tlb::aug_ShardAccounts);
-        }
-        if (accounts_keys.empty()) {
-          td::actor::send_closure(actor_id(this), &AsyncStateIndexer::finalize);
-        } else {
-          LOG(DEBUG) << "Parse accounts states one by one " << block_id_string << " " << timer;
-
-          for (const auto &account: accounts_keys) {
-            td::actor::send_closure(actor_id(this), &AsyncStateIndexer::processAccount, account.first,
-                                    account.second);
-          }
+        if (!accounts_keys.empty()) {
+          process_accounts();
         }
       } catch (std::exception &e) {
         LOG(ERROR) << e.what() << " state error: " << block_id_string;
       } catch (...) {
         LOG(ERROR) << " state error: " << block_id_string;
       }
+      finalize();
     }
 
-    void AsyncStateIndexer::processAccount(td::Bits256 account, int tx_count) {
-      // todo: move to separate actor
-      try {
-        std::vector<std::tuple<int, std::string>> dummy;
-
-        auto value = accounts->lookup(account);
-        LOG(DEBUG)
-        << "Parse accounts states got account data " << account.to_hex() << " " << block_id_string << " "
-        << timer;
-
-        if (value.not_null()) {
-          block::gen::ShardAccount::Record sa;
-          block::gen::CurrencyCollection::Record dbi_cc;
-          CHECK(tlb::unpack(value.write(), sa));
-          LOG(DEBUG)
-          << "Parse accounts states account data parsed " << account.to_hex() << " " << block_id_string << " "
-          << timer;
-
-          json data;
-
-          if (with_prev_state && tx_count > 1) {
-            auto prev_acc = prev_accounts->lookup(account.cbits(), 256);
-
-            if (prev_acc.not_null() && (prev_acc->have_refs() || !prev_acc->empty())) {
-              vm::CellBuilder b;
-              b.append_cellslice(prev_acc);
-              const auto prev_state_acc = td::base64_encode(
-                      std_boc_serialize(b.finalize(), 31).move_as_ok());
-              data["prev_state"] = prev_state_acc;
-
-              LOG(DEBUG) << "In account " << account.to_hex()
-                         << " several transactions in one block save prev state for emulation";
-            }
-          }
-
-          data["account_address"] = {{"workchain", block_id.id.workchain},
-                                     {"address",   account.to_hex()}};
-          data["account"] = {{"last_trans_hash", sa.last_trans_hash.to_hex()},
-                             {"last_trans_lt",   sa.last_trans_lt}};
-
-          auto account_cell = load_cell_slice(sa.account);
-          auto acc_tag = block::gen::t_Account.get_tag(account_cell);
-
-          if (acc_tag == block::gen::t_Account.account) {
-            block::gen::Account::Record_account acc;
-            block::gen::StorageInfo::Record si;
-            block::gen::AccountStorage::Record as;
-            block::gen::StorageUsed::Record su;
-            block::gen::CurrencyCollection::Record balance;
-
-            CHECK(tlb::unpack(account_cell, acc));
-
-            CHECK(tlb::unpack(acc.storage.write(), as));
-            CHECK(tlb::unpack(acc.storage_stat.write(), si));
-            CHECK(tlb::unpack(si.used.write(), su));
-            CHECK(tlb::unpack(as.balance.write(), balance));
-            LOG(DEBUG) << "Parse accounts states account main info parsed " << account.to_hex() << " "
-                       << block_id_string
-                       << " " << timer;
-
-            data["account"]["addr"] = parse_address(acc.addr.write());
-            std::string due_payment;
-
-            if (si.due_payment->prefetch_ulong(1) > 0) {
-              auto due = si.due_payment.write();
-              due.fetch_bits(1);  // maybe
-              due_payment = block::tlb::t_Grams.as_integer(due)->to_dec_string();
-            }
-
-            data["account"]["storage_stat"] = {{"last_paid",   si.last_paid},
-                                               {"due_payment", due_payment}};
-
-            data["account"]["storage_stat"]["used"] = {
-                    {"cells",        block::tlb::t_VarUInteger_7.as_uint(su.cells.write())},
-                    {"bits",         block::tlb::t_VarUInteger_7.as_uint(su.bits.write())},
-            };
-
-            data["account"]["storage"] = {{"last_trans_lt", as.last_trans_lt}};
-
-            data["account"]["storage"]["balance"] = {
-                    {"grams", block::tlb::t_Grams.as_integer(balance.grams)->to_dec_string()},
-                    {"extra", balance.other->have_refs() ? parse_extra_currency(
-                            balance.other->prefetch_ref()) : dummy}};
-
-            LOG(DEBUG)
-            << "Parse accounts states account storage parsed" << account.to_hex() << " " << block_id_string
-            << " " << timer;
-
-            auto tag = block::gen::t_AccountState.get_tag(as.state.write());
-
-            if (tag == block::gen::t_AccountState.account_uninit) {
-              data["account"]["state"] = {{"type", "uninit"}};
-            } else if (tag == block::gen::t_AccountState.account_active) {
-              block::gen::AccountState::Record_account_active active_account;
-              CHECK(tlb::unpack(as.state.write(), active_account));
-
-              data["account"]["state"] = {{"type",       "active"},
-                                          {"state_init", parse_state_init(active_account.x.write())}};
+    void AsyncStateIndexer::process_accounts() {
+      std::map<td::Bits256, int> tx_counts;
+      for (const auto &account: accounts_keys) {
+        tx_counts.emplace(account.first, account.second);
+      }
 
-            } else if (tag == block::gen::t_AccountState.account_frozen) {
-              block::gen::AccountState::Record_account_frozen f{};
-              CHECK(tlb::unpack(as.state.write(), f))
-              data["account"]["state"] = {{"type",       "frozen"},
-                                          {"state_hash", f.state_hash.to_hex()}};
-            }
+      auto &engine = StateDiffEngine::shared();
+      std::vector<AccountStateChange> changes;
+      bool diffed = false;
 
-            {
-              std::lock_guard<std::mutex> lock(accounts_mtx_);
-              json_accounts.emplace_back(data);
-            }
-          }
+      if (!prev_root_cells.empty()) {
+        LOG(DEBUG) << "Diff accounts states " << block_id_string << " " << timer;
+        auto R = engine.diff(root_cell, prev_root_cells);
+        if (R.is_ok()) {
+          changes = R.move_as_ok();
+          diffed = true;
+        } else {
+          LOG(ERROR) << R.move_as_error() << " state error: " << block_id_string << ", parse accounts one by one";
         }
-
-        LOG(DEBUG)
-        << "Parse accounts states account finally parsed " << account.to_hex() << " " << block_id_string << " "
-        << timer;
-      } catch (std::exception &e) {
-        LOG(ERROR) << e.what() << "account error " << account.to_hex();
-      } catch (...) {
-        LOG(ERROR) << "account error " << account.to_hex();
       }
-
-      bool is_end;
-
-      {
-        std::lock_guard<std::mutex> lock(accounts_count_mtx_);
-        total_accounts -= 1;
-        LOG(DEBUG) << "Parse accounts for " << block_id_string << " left " << total_accounts;
-        is_end = total_accounts == 0;
+      if (!diffed) {
+        // nothing to diff against or the diff failed, look the touched accounts up one by one
+        LOG(DEBUG) << "Parse accounts states one by one " << block_id_string << " " << timer;
+        changes.reserve(accounts_keys.size());
+        for (const auto &account: accounts_keys) {
+          changes.push_back(AccountStateChange{account.first, {}, accounts->lookup(account.first)});
+        }
       }
 
-      if (is_end) {
-        td::actor::send_closure(actor_id(this), &AsyncStateIndexer::finalize);
+      std::vector<json> parsed(changes.size());
+      engine.parallel_for(changes.size(), [&](std::size_t i) {
+          const auto &change = changes[i];
+          if (change.cur.is_null()) {
+            return;
+          }
+          // the state before the block is kept for emulation when the account has several transactions in it
+          auto tx_count = tx_counts.find(change.account);
+          bool with_prev = tx_count != tx_counts.end() && tx_count->second > 1;
+          try {
+            parsed[i] = parse_shard_account(change.cur, with_prev ? change.prev : Ref<vm::CellSlice>{},
+                                            change.account, block_id.id.workchain);
+          } catch (std::exception &e) {
+            LOG(ERROR) << e.what() << "account error " << change.account.to_hex();
+          } catch (...) {
+            LOG(ERROR) << "account error " << change.account.to_hex();
+          }
+      });
+
+      json_accounts.reserve(parsed.size());
+      for (auto &data: parsed) {
+        if (!data.is_null()) {
+          json_accounts.emplace_back(std::move(data));
+        }
       }
+      LOG(DEBUG) << "Parse accounts states parsed " << json_accounts.size() << " accounts " << block_id_string << " "
+                 << timer;
     }
 
     bool AsyncStateIndexer::finalize() {
@@ -924,10 +833,10 @@ namespace ton::validator {
               std::to_string(id.id.workchain) + ":" + std::to_string(id.id.shard) + ":" + std::to_string(id.id.seqno);
 
       //  AsyncStateIndexer(std::string block_id_string_, vm::Ref<vm::Cell> root_cell_,
-      //                    td::optional<td::Ref<vm::Cell>> prev_root_cell_, std::vector<td::Bits256> accounts_keys_,
+      //                    std::vector<td::Ref<vm::Cell>> prev_root_cells_, std::vector<td::Bits256> accounts_keys_,
       //                    BlockIdExt block_id_, td::Promise<std::string> final_promise_) {
 
-      td::actor::create_actor<AsyncStateIndexer>("AsyncStateIndexer", block_id_string, state, prev_state,
+      td::actor::create_actor<AsyncStateIndexer>("AsyncStateIndexer", block_id_string, state, prev_states,
                                                  accounts_keys, id,
                                                  [SelfId = actor_id(this)](td::Result<std::string> potential_state) {
                                                      if (potential_state.is_error()) {
@@ -957,6 +866,62 @@ namespace ton::validator {
       stop();
     }
 
+    void BlockBocSerializer::start_up() {
+      // Topics published as BOC skip the JSON parser; it still runs when some topic is JSON or traces are enabled
+      std::string block_boc;
+      std::string state_boc;
+      if (publish_format_from_env("KAFKA_BLOCK_TOPIC") == PublishFormat::boc) {
+        auto R = serialize_block_boc(id_, true, data_);
+        if (R.is_ok()) {
+          block_boc = R.move_as_ok();
+        } else {
+          LOG(ERROR) << "Fallback to json block for " << id_.to_str() << ": " << R.move_as_error();
+        }
+      }
+      if (publish_format_from_env("KAFKA_STATE_TOPIC") == PublishFormat::boc) {
+        auto R = [&]() -> td::Result<std::string> {
+            TRY_RESULT(accounts, block_accounts(data_));
+            return serialize_state_boc(id_, state_, accounts);
+        }();
+        if (R.is_ok()) {
+          state_boc = R.move_as_ok();
+        } else {
+          LOG(ERROR) << "Fallback to json state for " << id_.to_str() << ": " << R.move_as_error();
+        }
+      }
+
+      if (!block_boc.empty() && !state_boc.empty() && !parse_traces_) {
+        P_.set_value(std::make_tuple(id_.root_hash, std::move(block_boc), std::move(state_boc)));
+        stop();
+        return;
+      }
+
+      if (!block_boc.empty() || !state_boc.empty()) {
+        P_ = td::PromiseCreator::lambda(
+                [P = std::move(P_), block_boc = std::move(block_boc), state_boc = std::move(state_boc)](
+                        td::Result<std::tuple<td::Bits256, td::string, td::string>> R) mutable {
+                    if (R.is_error()) {
+                      P.set_error(R.move_as_error());
+                      return;
+                    }
+                    auto parsed = R.move_as_ok();
+                    if (!block_boc.empty()) {
+                      std::get<1>(parsed) = std::move(block_boc);
+                    }
+                    if (!state_boc.empty()) {
+                      std::get<2>(parsed) = std::move(state_boc);
+                    }
+                    P.set_value(std::move(parsed));
+                });
+      }
+
+      td::actor::create_actor<BlockParserAsync>("BlockParserAsync", id_, std::move(handle_), std::move(data_),
+                                                std::move(state_), std::move(prev_states_), std::move(P_),
+                                                std::move(out_messages_promise_))
+              .release();
+      stop();
+    }
+
     void StartupBlockParser::end_with_error(td::Status err) {
       P_final.set_error(std::move(err));
       stop();
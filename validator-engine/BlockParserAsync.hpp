@@ -37,6 +37,7 @@
 #include "validator/interfaces/validator-manager.h"
 #include "blockchain-indexer/json.hpp"
 #include "blockchain-indexer/json-utils.hpp"
+#include "blockchain-indexer/state-diff.hpp"
 
 namespace ton::validator {
 
@@ -46,41 +47,31 @@ namespace ton::validator {
         std::string block_id_string;
         td::Timer timer;
         BlockIdExt block_id;
-        std::mutex accounts_mtx_;
-        std::mutex accounts_count_mtx_;
-        unsigned long total_accounts;
         json answer;
         td::Promise<std::string> final_promise;
         vm::Ref<vm::Cell> root_cell;
-        td::optional<td::Ref<vm::Cell>> prev_root_cell;
+        std::vector<td::Ref<vm::Cell>> prev_root_cells;  // two after a merge, none if unknown
         std::vector<std::pair<td::Bits256, int>> accounts_keys;
-        bool with_prev_state;
-        td::unique_ptr<vm::AugmentedDictionary> prev_accounts;
 
     public:
         AsyncStateIndexer(std::string block_id_string_, vm::Ref<vm::Cell> root_cell_,
-                          td::optional<td::Ref<vm::Cell>> prev_root_cell_,
+                          std::vector<td::Ref<vm::Cell>> prev_root_cells_,
                           std::vector<std::pair<td::Bits256, int>> accounts_keys_, BlockIdExt block_id_,
                           td::Promise<std::string> final_promise_) {
             block_id = block_id_;
             block_id_string = std::move(block_id_string_);
-            total_accounts = accounts_keys_.size();
             root_cell = std::move(root_cell_);
-            with_prev_state = true;
-            if (!prev_root_cell_) {
-                with_prev_state = false;
-            }
 
-            LOG(INFO) << "Parse state: " << block_id.id.to_str() << " with prev state: " << with_prev_state;
+            LOG(INFO) << "Parse state: " << block_id.id.to_str() << " with prev states: " << prev_root_cells_.size();
 
-            prev_root_cell = std::move(prev_root_cell_);
+            prev_root_cells = std::move(prev_root_cells_);
             accounts_keys = std::move(accounts_keys_);
             final_promise = std::move(final_promise_);
         }
 
         void start_up() override;
 
-        void processAccount(td::Bits256 account, int tx_count);
+        void process_accounts();
 
         bool finalize();
     };
@@ -88,14 +79,14 @@ namespace ton::validator {
     class BlockParserAsync : public td::actor::Actor {
     public:
         BlockParserAsync(BlockIdExt id_, ConstBlockHandle handle_, td::Ref<BlockData> data_, td::Ref<vm::Cell> state_,
-                         td::optional<td::Ref<vm::Cell>> prev_state_,
+                         std::vector<td::Ref<vm::Cell>> prev_states_,
                          td::Promise<std::tuple<td::Bits256, td::string, td::string>> P_,
                          td::Promise<std::tuple<td::vector<json>, td::Bits256, unsigned long long, int>> out_messages_promise_) {
             id = id_;
             handle = std::move(handle_);
             data = std::move(data_);
             state = std::move(state_);
-            prev_state = std::move(prev_state_);
+            prev_states = std::move(prev_states_);
             P = std::move(P_);
             out_messages_promise = std::move(out_messages_promise_);
         }
@@ -115,7 +106,7 @@ namespace ton::validator {
         ConstBlockHandle handle;
         td::Ref<BlockData> data;
         td::Ref<vm::Cell> state;
-        td::optional<td::Ref<vm::Cell>> prev_state;
+        std::vector<td::Ref<vm::Cell>> prev_states;
         td::Promise<std::tuple<td::Bits256, td::string, td::string>> P;
         td::Promise<std::tuple<td::vector<json>, td::Bits256, unsigned long long, int>> out_messages_promise;
         std::string parsed_data;
@@ -123,6 +114,32 @@ namespace ton::validator {
         td::Bits256 root_hash_;
     };
 
+    // Serializes the topics published as BOC, then runs BlockParserAsync for the topics published as JSON and for
+    // traces. Keeps the serialization off the threads that call BlockParser.
+    class BlockBocSerializer : public td::actor::Actor {
+    public:
+        BlockBocSerializer(BlockIdExt id, ConstBlockHandle handle, td::Ref<BlockData> data, td::Ref<vm::Cell> state,
+                           std::vector<td::Ref<vm::Cell>> prev_states, bool parse_traces,
+                           td::Promise<std::tuple<td::Bits256, td::string, td::string>> P,
+                           td::Promise<std::tuple<td::vector<json>, td::Bits256, unsigned long long, int>> out_messages_promise)
+                : id_(id), handle_(std::move(handle)), data_(std::move(data)), state_(std::move(state)),
+                  prev_states_(std::move(prev_states)), parse_traces_(parse_traces), P_(std::move(P)),
+                  out_messages_promise_(std::move(out_messages_promise)) {
+        }
+
+        void start_up() override;
+
+    private:
+        BlockIdExt id_;
+        ConstBlockHandle handle_;
+        td::Ref<BlockData> data_;
+        td::Ref<vm::Cell> state_;
+        std::vector<td::Ref<vm::Cell>> prev_states_;
+        bool parse_traces_;
+        td::Promise<std::tuple<td::Bits256, td::string, td::string>> P_;
+        td::Promise<std::tuple<td::vector<json>, td::Bits256, unsigned long long, int>> out_messages_promise_;
+    };
+
     class StartupBlockParser : public td::actor::Actor {
     public:
         StartupBlockParser(td::actor::ActorId<ValidatorManagerInterface> validator_id,
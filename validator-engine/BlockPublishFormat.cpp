@@ -0,0 +1,181 @@
+#include "BlockPublishFormat.hpp"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "vm/boc.h"
+#include "vm/dict.h"
+
+namespace ton::validator {
+
+    namespace {
+
+        struct TransactionIndexEntry {
+            td::Bits256 account;
+            td::uint64 lt;
+            td::Bits256 hash;
+
+            template<class StorerT>
+            void store(StorerT &storer) const {
+              storer.store_slice(account.as_slice());
+              td::store(lt, storer);
+              storer.store_slice(hash.as_slice());
+            }
+        };
+
+        struct AccountEntry {
+            td::Bits256 account;
+            td::uint64 last_trans_lt;
+            td::Bits256 last_trans_hash;
+            std::string boc;
+
+            template<class StorerT>
+            void store(StorerT &storer) const {
+              storer.store_slice(account.as_slice());
+              td::store(last_trans_lt, storer);
+              storer.store_slice(last_trans_hash.as_slice());
+              td::store(boc, storer);
+            }
+        };
+
+        template<class StorerT>
+        void store_block_id(td::int32 magic, const BlockIdExt &id, StorerT &storer) {
+          td::store(magic, storer);
+          td::store(publish_format_version, storer);
+          td::store(id.id.workchain, storer);
+          td::store(static_cast<td::int64>(id.id.shard), storer);
+          td::store(static_cast<td::int32>(id.id.seqno), storer);
+          storer.store_slice(id.root_hash.as_slice());
+          storer.store_slice(id.file_hash.as_slice());
+        }
+
+        struct BlockRecord {
+            BlockIdExt id;
+            bool is_applied;
+            td::uint32 gen_utime;
+            td::uint64 start_lt;
+            td::uint64 end_lt;
+            std::vector<TransactionIndexEntry> transactions;
+            td::BufferSlice boc;
+
+            template<class StorerT>
+            void store(StorerT &storer) const {
+              store_block_id(block_boc_magic, id, storer);
+              td::store(is_applied, storer);
+              td::store(gen_utime, storer);
+              td::store(start_lt, storer);
+              td::store(end_lt, storer);
+              td::store(transactions, storer);
+              td::store(boc.as_slice(), storer);
+            }
+        };
+
+        struct StateRecord {
+            BlockIdExt id;
+            td::Bits256 state_hash;
+            std::vector<AccountEntry> accounts;
+
+            template<class StorerT>
+            void store(StorerT &storer) const {
+              store_block_id(state_boc_magic, id, storer);
+              storer.store_slice(state_hash.as_slice());
+              td::store(accounts, storer);
+            }
+        };
+
+    }  // namespace
+
+    PublishFormat publish_format_from_env(const char *topic_env) {
+      const std::string env_var_name = std::string(topic_env) + "_FORMAT";
+      const char *value = std::getenv(env_var_name.c_str());
+      if (value != nullptr && std::string(value) == "boc") {
+        return PublishFormat::boc;
+      }
+      return PublishFormat::json;
+    }
+
+    td::Result<std::vector<td::Bits256>> block_accounts(const td::Ref<BlockData> &data) {
+      block::gen::Block::Record blk;
+      block::gen::BlockExtra::Record extra;
+      if (!(tlb::unpack_cell(data->root_cell(), blk) && tlb::unpack_cell(blk.extra, extra))) {
+        return td::Status::Error("cannot unpack block " + data->block_id().to_str());
+      }
+
+      std::vector<td::Bits256> accounts;
+      vm::AugmentedDictionary account_blocks{vm::load_cell_slice_ref(extra.account_blocks), 256,
+                                             block::tlb::aug_ShardAccountBlocks};
+      account_blocks.check_for_each_extra(
+              [&](Ref<vm::CellSlice>, Ref<vm::CellSlice>, td::ConstBitPtr key, int) {
+                  accounts.emplace_back(key);
+                  return true;
+              });
+      return accounts;
+    }
+
+    td::Result<std::string> serialize_block_boc(const BlockIdExt &id, bool is_applied,
+                                                const td::Ref<BlockData> &data) {
+      block::gen::Block::Record blk;
+      block::gen::BlockInfo::Record info;
+      block::gen::BlockExtra::Record extra;
+      if (!(tlb::unpack_cell(data->root_cell(), blk) && tlb::unpack_cell(blk.extra, extra) &&
+            tlb::unpack_cell(blk.info, info))) {
+        return td::Status::Error("cannot unpack block " + id.to_str());
+      }
+
+      BlockRecord record{id, is_applied, info.gen_utime, info.start_lt, info.end_lt, {}, data->data()};
+
+      vm::AugmentedDictionary account_blocks{vm::load_cell_slice_ref(extra.account_blocks), 256,
+                                             block::tlb::aug_ShardAccountBlocks};
+      bool ok = account_blocks.check_for_each_extra(
+              [&](Ref<vm::CellSlice> value, Ref<vm::CellSlice>, td::ConstBitPtr key, int) {
+                  td::Bits256 account{key};
+                  block::gen::AccountBlock::Record acc_blk;
+                  if (!tlb::csr_unpack(std::move(value), acc_blk)) {
+                    return false;
+                  }
+                  vm::AugmentedDictionary trans_dict{vm::DictNonEmpty(), std::move(acc_blk.transactions), 64,
+                                                     block::tlb::aug_AccountTransactions};
+                  return trans_dict.check_for_each_extra(
+                          [&](Ref<vm::CellSlice> tvalue, Ref<vm::CellSlice>, td::ConstBitPtr tkey, int) {
+                              if (!tvalue->have_refs()) {
+                                return false;
+                              }
+                              record.transactions.push_back(TransactionIndexEntry{
+                                      account, tkey.get_uint(64), tvalue->prefetch_ref()->get_hash().bits()});
+                              return true;
+                          });
+              });
+      if (!ok) {
+        return td::Status::Error("cannot iterate transactions of block " + id.to_str());
+      }
+
+      return td::serialize(record);
+    }
+
+    td::Result<std::string> serialize_state_boc(const BlockIdExt &id, td::Ref<vm::Cell> state,
+                                                const std::vector<td::Bits256> &accounts) {
+      StateRecord record{id, state->get_hash().bits(), {}};
+
+      block::gen::ShardStateUnsplit::Record shard_state;
+      if (!tlb::unpack_cell(std::move(state), shard_state)) {
+        return td::Status::Error("cannot unpack state of " + id.to_str());
+      }
+      vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(shard_state.accounts), 256,
+                                            block::tlb::aug_ShardAccounts};
+
+      record.accounts.reserve(accounts.size());
+      for (const auto &account: accounts) {
+        auto value = accounts_dict.lookup(account);
+        if (value.is_null()) {
+          continue;
+        }
+        block::gen::ShardAccount::Record sa;
+        if (!tlb::csr_unpack(std::move(value), sa)) {
+          return td::Status::Error("cannot unpack account " + account.to_hex() + " of " + id.to_str());
+        }
+        TRY_RESULT(boc, vm::std_boc_serialize(std::move(sa.account)));
+        record.accounts.push_back(AccountEntry{account, sa.last_trans_lt, sa.last_trans_hash, boc.as_slice().str()});
+      }
+
+      return td::serialize(record);
+    }
+
+}  // namespace ton::validator
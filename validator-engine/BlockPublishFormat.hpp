@@ -0,0 +1,43 @@
+#pragma once
+
+#include "td/utils/Status.h"
+#include "td/utils/tl_helpers.h"
+#include "ton/ton-types.h"
+#include "validator/interfaces/block.h"
+
+namespace ton::validator {
+
+    // Encoding of payloads published to one topic. Selected per topic with <TOPIC_ENV>_FORMAT=json|boc,
+    // e.g. KAFKA_BLOCK_TOPIC_FORMAT=boc. Consumers tell the encodings apart by the first bytes: JSON payloads
+    // start with '{', binary ones with one of the magics below.
+    enum class PublishFormat { json = 0, boc = 1 };
+
+    PublishFormat publish_format_from_env(const char *topic_env);
+
+    /*
+     * Binary payloads are TL-serialized (little-endian, 4-byte aligned, bytes are length-prefixed):
+     *
+     * block_boc magic:int32 version:int32 workchain:int32 shard:int64 seqno:int32 root_hash:int256 file_hash:int256
+     *           is_applied:Bool gen_utime:int32 start_lt:int64 end_lt:int64
+     *           transactions:(vector [account:int256 lt:int64 hash:int256]) block:bytes
+     *
+     * state_boc magic:int32 version:int32 workchain:int32 shard:int64 seqno:int32 root_hash:int256 file_hash:int256
+     *           state_hash:int256 accounts:(vector [account:int256 last_trans_lt:int64 last_trans_hash:int256
+     *           account:bytes])
+     *
+     * `block` is the block BOC exactly as stored in the db, `account` is a BOC of the Account cell. The index in front
+     * lets consumers filter by account / lt without deserializing the BOC.
+     */
+    constexpr td::int32 block_boc_magic = 0x424e4f54;  // "TONB"
+    constexpr td::int32 state_boc_magic = 0x534e4f54;  // "TONS"
+    constexpr td::int32 publish_format_version = 1;
+
+    td::Result<std::string> serialize_block_boc(const BlockIdExt &id, bool is_applied, const td::Ref<BlockData> &data);
+
+    td::Result<std::string> serialize_state_boc(const BlockIdExt &id, td::Ref<vm::Cell> state,
+                                                const std::vector<td::Bits256> &accounts);
+
+    // Touched accounts of a block, in dictionary order
+    td::Result<std::vector<td::Bits256>> block_accounts(const td::Ref<BlockData> &data);
+
+}  // namespace ton::validator
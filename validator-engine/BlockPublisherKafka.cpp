@@ -1,153 +1,172 @@
 #include "BlockPublisherKafka.hpp"
 #include "blockchain-indexer/json-utils.hpp"
 #include "tdutils/td/utils/Random.h"
+#include "td/utils/Time.h"
 
 namespace ton::validator {
 
-    BlockPublisherKafka::BlockPublisherKafka(const std::string &endpoint)
-            : producer(cppkafka::Configuration{{"metadata.broker.list", endpoint},
-                                               {"message.max.bytes",    "1000000000"},  // max
-                                               {"compression.type",    "lz4"},
-                                               {"retry.backoff.ms",     5},
-                                               {"retries",              2147483647},
-                                               {"acks",                 "1"},
-                                               {"debug",                "broker,topic,msg"}}) {
-    }
+    BlockPublisherKafka::BlockPublisherKafka(const std::string &endpoint, std::size_t max_in_flight_per_topic)
+            : max_in_flight(max_in_flight_per_topic) {
+      cppkafka::Configuration config{{"metadata.broker.list", endpoint},
+                                     {"message.max.bytes",    "1000000000"},  // max
+                                     {"compression.type",    "lz4"},
+                                     {"retry.backoff.ms",     5},
+                                     {"retries",              2147483647},
+                                     // keeps per-partition order with several requests in flight and retries
+                                     {"enable.idempotence",   true},
+                                     {"acks",                 "all"},
+                                     {"linger.ms",            5},
+                                     {"debug",                "broker,topic,msg"}};
+      config.set_delivery_report_callback(
+              [this](cppkafka::Producer &, const cppkafka::Message &msg) { on_delivery(msg); });
+      producer = std::make_unique<cppkafka::Producer>(std::move(config));
+
+      error_callback = [this](const std::string &topic, int partition, const std::string &error,
+                              const std::string &payload) {
+          std::string id;
+          try {
+            id = to_string(json::parse(payload)["id"]);
+          } catch (std::exception &e) {
+            id = "unknown";
+          }
+          LOG(ERROR) << "Error while sending (" << id << ") to kafka " << topic << ":" << partition << ": " << error;
+          publishBlockError(id, error);
+      };
 
-    void BlockPublisherKafka::publishBlockApplied(int wc, unsigned long long shard, std::string json) {
-      std::lock_guard<std::mutex> guard(net_mtx);
-      LOG(DEBUG) << "[block-applied] Sending " << json.size() << " bytes to Kafka";
-      try {
-        const char *value = getenv("KAFKA_APPLY_TOPIC");
-
-        //    if (shard_to_partition.find(shard) == shard_to_partition.end()) {
-        //      max_partition++;
-        //      shard_to_partition[shard] = max_partition;
-        //    }
-
-        int p;
-        if (wc == -1) {
-          p = 0;
-        } else {
-          if (shard_to_partition.find(shard) == shard_to_partition.end()) {
-            max_partition++;
-            if (max_partition > 16) {
-              max_partition = 1;
-            }
-            p = max_partition;
-            shard_to_partition[shard] = max_partition;
-          } else {
-            p = shard_to_partition[shard];
+      poll_thread = std::thread([this] {
+          while (!stop.load(std::memory_order_relaxed)) {
+            producer->poll(std::chrono::milliseconds(100));
           }
-        }
+      });
+    }
 
-        producer.produce(cppkafka::MessageBuilder(value ? value : "block-applied-mainnet").partition(p).payload(json));
-        deliver();
-      } catch (std::exception &e) {
-        const auto id = to_string(json::parse(json)["id"]);
-        LOG(ERROR) << "Error while sending block applied (" << id << ") to kafka: " << e.what();
-        publishBlockError(id, e.what());
+    BlockPublisherKafka::~BlockPublisherKafka() {
+      auto S = deliver();
+      if (S.is_error()) {
+        LOG(ERROR) << "Kafka messages are lost on shutdown: " << S;
       }
+      stop = true;
+      poll_thread.join();
     }
 
-    void BlockPublisherKafka::deliver() {
-      try {
-        producer.flush(std::chrono::milliseconds(1000000));
-      } catch (std::exception &e) {
-        LOG(ERROR) << "Error while deliver to kafka: " << e.what();
-        std::exit(7);
-      }
+    void BlockPublisherKafka::publishBlockApplied(int wc, unsigned long long shard, std::string json) {
+      publish("KAFKA_APPLY_TOPIC", "block-applied-mainnet", "block-applied", wc, shard, std::move(json));
     }
 
     void BlockPublisherKafka::publishBlockData(int wc, unsigned long long shard, std::string json) {
-      std::lock_guard<std::mutex> guard(net_mtx);
-      LOG(DEBUG) << "[block-data] Sending " << json.size() << " bytes to Kafka";
-      try {
-        const char *value = getenv("KAFKA_BLOCK_TOPIC");
-
-        int p;
-        if (wc == -1) {
-          p = 0;
-        } else {
-          if (shard_to_partition.find(shard) == shard_to_partition.end()) {
-            max_partition++;
-            if (max_partition > 16) {
-              max_partition = 1;
-            }
-            p = max_partition;
-            shard_to_partition[shard] = max_partition;
-          } else {
-            p = shard_to_partition[shard];
-          }
-        }
+      publish("KAFKA_BLOCK_TOPIC", "block-data-mainnet", "block-data", wc, shard, std::move(json));
+    }
 
-        producer.produce(cppkafka::MessageBuilder(value ? value : "block-data-mainnet").partition(p).payload(json));
-        deliver();
-      } catch (std::exception &e) {
-        const auto id = to_string(json::parse(json)["id"]);
-        LOG(ERROR) << "Error while sending block data (" << id << ") to kafka: " << e.what();
-        publishBlockError(id, e.what());
+    void BlockPublisherKafka::publishOutMsgs(int wc, unsigned long long shard, std::string data) {
+      publish("KAFKA_OUTMSG_TOPIC", "testnet-traces", "block-out-msg", wc, shard, std::move(data));
+    }
+
+    void BlockPublisherKafka::publishBlockState(int wc, unsigned long long shard, std::string json) {
+      publish("KAFKA_STATE_TOPIC", "block-state-mainnet", "block-state", wc, shard, std::move(json));
+    }
+
+    td::Status BlockPublisherKafka::deliver() {
+      // Waits for everything produced so far, errors are reported to error_callback by the delivery reports
+      auto deadline = td::Timestamp::in(deliver_timeout);
+      while (true) {
+        try {
+          producer->flush(std::chrono::milliseconds(1000));
+        } catch (std::exception &e) {
+          LOG(WARNING) << "Kafka flush is not finished yet: " << e.what();
+        }
+        auto left = producer->get_out_queue_length();
+        if (left == 0) {
+          return td::Status::OK();
+        }
+        if (deadline.is_in_past()) {
+          return td::Status::Error(PSLICE() << left << " messages are not delivered to kafka in " << deliver_timeout
+                                            << "s");
+        }
       }
     }
 
-    void BlockPublisherKafka::publishOutMsgs(int wc, unsigned long long shard, std::string data) {
-      std::lock_guard<std::mutex> guard(net_mtx);
-      const char *value = getenv("KAFKA_OUTMSG_TOPIC");
-      LOG(DEBUG) << "[block-out-msg] Sending " << data.size() << " bytes to Kafka";
+    void BlockPublisherKafka::publish(const char *topic_env, const char *default_topic, const char *kind, int wc,
+                                      unsigned long long shard, std::string payload) {
+      const char *value = getenv(topic_env);
+      const std::string topic = value ? value : default_topic;
+      const int p = get_partition(wc, shard);
+      LOG(DEBUG) << "[" << kind << "] Sending " << payload.size() << " bytes to Kafka";
+
+      // Only the window of this topic is waited for: a slow topic does not stall the others
+      auto &window = get_window(topic);
+      {
+        std::unique_lock<std::mutex> lock(window.mtx);
+        window.cv.wait(lock, [&] { return window.count < max_in_flight; });
+        window.count++;
+      }
 
-      int p;
-      if (wc == -1) {
-        p = 0;
-      } else {
-        if (shard_to_partition.find(shard) == shard_to_partition.end()) {
-          max_partition++;
-          if (max_partition > 16) {
-            max_partition = 1;
+      while (true) {
+        try {
+          producer->produce(cppkafka::MessageBuilder(topic).partition(p).payload(payload).user_data(&window));
+          return;
+        } catch (cppkafka::HandleException &e) {
+          if (e.get_error().get_error() == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+          }
+          {
+            std::lock_guard<std::mutex> lock(window.mtx);
+            window.count--;
           }
-          p = max_partition;
-          shard_to_partition[shard] = max_partition;
-        } else {
-          p = shard_to_partition[shard];
+          window.cv.notify_one();
+          error_callback(topic, p, e.what(), payload);
+          return;
         }
       }
+    }
+
+    int BlockPublisherKafka::get_partition(int wc, unsigned long long shard) {
+      if (wc == -1) {
+        return 0;
+      }
 
-      producer.produce(cppkafka::MessageBuilder(value ? value : "testnet-traces").partition(p).payload(data));
-      deliver();
+      std::lock_guard<std::mutex> guard(partition_mtx);
+      auto it = shard_to_partition.find(shard);
+      if (it != shard_to_partition.end()) {
+        return it->second;
+      }
+
+      max_partition++;
+      if (max_partition > 16) {
+        max_partition = 1;
+      }
+      shard_to_partition[shard] = max_partition;
+      return max_partition;
     }
 
-    void BlockPublisherKafka::publishBlockState(int wc, unsigned long long shard, std::string json) {
-      std::lock_guard<std::mutex> guard(net_mtx);
-      LOG(DEBUG) << "[block-state] Sending " << json.size() << " bytes to Kafka";
-      try {
-        const char *value = getenv("KAFKA_STATE_TOPIC");
-
-        //    if (shard_to_partition.find(shard) == shard_to_partition.end()) {
-        //      max_partition++;
-        //      shard_to_partition[shard] = max_partition;
-        //    }
-
-        int p;
-        if (wc == -1) {
-          p = 0;
-        } else {
-          if (shard_to_partition.find(shard) == shard_to_partition.end()) {
-            max_partition++;
-            if (max_partition > 16) {
-              max_partition = 1;
-            }
-            p = max_partition;
-            shard_to_partition[shard] = max_partition;
-          } else {
-            p = shard_to_partition[shard];
-          }
+    BlockPublisherKafka::InFlightWindow &BlockPublisherKafka::get_window(const std::string &topic) {
+      std::lock_guard<std::mutex> guard(windows_mtx);
+      auto &window = windows[topic];
+      if (!window) {
+        window = std::make_unique<InFlightWindow>();
+      }
+      return *window;
+    }
+
+    void BlockPublisherKafka::on_delivery(const cppkafka::Message &msg) {
+      // error reports are produced outside of the windows and carry no user data
+      auto window = static_cast<InFlightWindow *>(msg.get_user_data());
+      if (window) {
+        {
+          std::lock_guard<std::mutex> lock(window->mtx);
+          window->count--;
         }
+        window->cv.notify_one();
+      }
 
-        producer.produce(cppkafka::MessageBuilder(value ? value : "block-state-mainnet").partition(p).payload(json));
-        deliver();
-      } catch (std::exception &e) {
-        const auto id = to_string(json::parse(json)["id"]);
-        LOG(ERROR) << "Error while sending block state (" << id << ") to kafka: " << e.what();
-        publishBlockError(id, e.what());
+      if (msg.get_error()) {
+        // a failed error report is not reported again, that would loop while the broker is down
+        if (msg.get_topic() == error_topic()) {
+          LOG(ERROR) << "Error while sending block error to kafka: " << msg.get_error().to_string();
+          return;
+        }
+        error_callback(msg.get_topic(), msg.get_partition(), msg.get_error().to_string(),
+                       std::string(msg.get_payload()));
       }
     }
 
@@ -157,13 +176,16 @@ namespace ton::validator {
       const std::string dump = json.dump();
 
       try {
-        const char *value = getenv("KAFKA_ERROR_TOPIC");
         LOG(WARNING) << "[block-error] Sending " << json.size() << " bytes to Kafka";
-        producer.produce(cppkafka::MessageBuilder(value ? value : "block-error-mainnet").partition(0).payload(dump));
-        producer.flush(std::chrono::milliseconds(1000000));
+        producer->produce(cppkafka::MessageBuilder(error_topic()).partition(0).payload(dump));
       } catch (std::exception &e) {
         LOG(ERROR) << "Error while sending block (" << id << ") error (" << error << ") to kafka: " << e.what();
       }
     }
 
+    std::string BlockPublisherKafka::error_topic() {
+      const char *value = getenv("KAFKA_ERROR_TOPIC");
+      return value ? value : "block-error-mainnet";
+    }
+
 }  // namespace ton::validator
@@ -3,31 +3,62 @@
 
 #include "IBlockParser.hpp"
 #include <cppkafka/cppkafka.h>
+#include <atomic>
 
 namespace ton::validator {
 
 class BlockPublisherKafka : public IBLockPublisher {
  public:
-  explicit BlockPublisherKafka(const std::string& endpoint);
+  // topic, partition, error, payload of the failed message
+  using ErrorCallback =
+      std::function<void(const std::string& topic, int partition, const std::string& error, const std::string& payload)>;
+
+  explicit BlockPublisherKafka(const std::string& endpoint, std::size_t max_in_flight_per_topic = 256);
+  ~BlockPublisherKafka() override;
 
   void publishBlockApplied(int wc, unsigned long long shard, std::string json) override;
   void publishBlockData(int wc, unsigned long long shard, std::string json) override;
   void publishBlockState(int wc, unsigned long long shard, std::string json) override;
   void publishOutMsgs(int wc, unsigned long long shard, std::string data) override;
-  void deliver() override;
-  void merge_new_shards(std::map<unsigned long long, int> new_shards) {
+  td::Status deliver() override;
+  void merge_new_shards(std::map<unsigned long long, int> new_shards) override {
+    std::lock_guard<std::mutex> guard(partition_mtx);
     for (const auto& pair : new_shards) {
       LOG(WARNING) << "Shard: " << pair.first << " mapped to: " << pair.second;
       shard_to_partition[pair.first] = pair.second;
     }
   }
+  void set_error_callback(ErrorCallback callback) {
+    error_callback = std::move(callback);
+  }
 
  private:
+  // Messages of one topic that were produced but not acknowledged yet
+  struct InFlightWindow {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::size_t count = 0;
+  };
+
+  void publish(const char* topic_env, const char* default_topic, const char* kind, int wc, unsigned long long shard,
+               std::string payload);
+  int get_partition(int wc, unsigned long long shard);
+  InFlightWindow& get_window(const std::string& topic);
+  void on_delivery(const cppkafka::Message& msg);
   void publishBlockError(const std::string& id, const std::string& error);
+  static std::string error_topic();
 
  private:
-  std::mutex net_mtx;
-  cppkafka::Producer producer;
+  std::mutex partition_mtx;
+  std::mutex windows_mtx;
+  std::map<std::string, std::unique_ptr<InFlightWindow>> windows;
+  const std::size_t max_in_flight;
+  static constexpr double deliver_timeout = 60.0;
+  ErrorCallback error_callback;
+
+  std::unique_ptr<cppkafka::Producer> producer;
+  std::thread poll_thread;
+  std::atomic<bool> stop{false};
   std::map<unsigned long long, int> shard_to_partition{};
   int max_partition = 0;
 };
@@ -20,7 +20,7 @@ namespace ton::validator {
     }
 
     void BlockParser::storeBlockApplied(BlockIdExt id, td::Promise<std::tuple<td::string, td::string>> P) {
-      std::lock_guard<std::mutex> lock(maps_mtx_);
+      std::unique_lock<std::mutex> lock(maps_mtx_);
       if (!check_allowed_shard_parse(id.id.workchain, id.id.shard)) {
         LOG(WARNING) << "Skip applied: " << id.id.to_str();
         P.set_value(std::make_tuple("", ""));
@@ -31,7 +31,7 @@ namespace ton::validator {
       const std::string key =
               std::to_string(id.id.workchain) + ":" + std::to_string(id.id.shard) + ":" + std::to_string(id.id.seqno);
       stored_applied_.insert({key, id});
-      handleBlockProgress(id, std::move(P));
+      handleBlockProgress(id, std::move(P), lock);
     }
 
     void BlockParser::storeBlockData(ConstBlockHandle handle, td::Ref<BlockData> block,
@@ -42,7 +42,7 @@ namespace ton::validator {
         return;
       }
 
-      std::lock_guard<std::mutex> lock(maps_mtx_);
+      std::unique_lock<std::mutex> lock(maps_mtx_);
       LOG(DEBUG) << "Store block: " << block->block_id().to_str();
       const std::string key = std::to_string(handle->id().id.workchain) + ":" + std::to_string(handle->id().id.shard) +
                               ":" + std::to_string(handle->id().id.seqno);
@@ -55,7 +55,7 @@ namespace ton::validator {
         blocks_vec->second.emplace_back(std::pair{handle, block});
       }
 
-      handleBlockProgress(handle->id(), std::move(P));
+      handleBlockProgress(handle->id(), std::move(P), lock);
       LOG(DEBUG) << "Stored block: " << block->block_id().to_str();
     }
 
@@ -67,7 +67,7 @@ namespace ton::validator {
         return;
       }
 
-      std::lock_guard<std::mutex> lock(maps_mtx_);
+      std::unique_lock<std::mutex> lock(maps_mtx_);
       LOG(DEBUG) << "Store state: " << handle->id().to_str();
       const std::string key = std::to_string(handle->id().id.workchain) + ":" + std::to_string(handle->id().id.shard) +
                               ":" + std::to_string(handle->id().id.seqno);
@@ -80,11 +80,12 @@ namespace ton::validator {
         states_vec->second.emplace_back(std::pair{handle, std::move(state)});
       }
 
-      handleBlockProgress(handle->id(), std::move(P));
+      handleBlockProgress(handle->id(), std::move(P), lock);
       LOG(DEBUG) << "Stored state: " << handle->id().to_str();
     }
 
-    void BlockParser::storeBlockStateWithPrev(const ConstBlockHandle &handle, td::Ref<vm::Cell> prev_state,
+    void BlockParser::storeBlockStateWithPrev(const ConstBlockHandle &handle,
+                                              std::vector<td::Ref<vm::Cell>> prev_states,
                                               td::Ref<vm::Cell> state,
                                               td::Promise<std::tuple<td::string, td::string>> P) {
       if (!check_allowed_shard_parse(handle->id().id.workchain, handle->id().id.shard)) {
@@ -93,7 +94,7 @@ namespace ton::validator {
         return;
       }
 
-      std::lock_guard<std::mutex> lock(maps_mtx_);
+      std::unique_lock<std::mutex> lock(maps_mtx_);
       LOG(DEBUG) << "Store prev state: " << handle->id().to_str();
       const std::string key = std::to_string(handle->id().id.workchain) + ":" + std::to_string(handle->id().id.shard) +
                               ":" + std::to_string(handle->id().id.seqno);
@@ -108,18 +109,19 @@ namespace ton::validator {
 
       auto prev_states_vec = stored_prev_states_.find(key);
       if (prev_states_vec == stored_prev_states_.end()) {
-        std::vector<std::pair<ConstBlockHandle, td::Ref<vm::Cell>>> prev_state_vec;
-        prev_state_vec.emplace_back(std::pair{handle, std::move(prev_state)});
-        stored_prev_states_.insert({key, prev_state_vec});
+        std::vector<std::pair<ConstBlockHandle, std::vector<td::Ref<vm::Cell>>>> prev_state_vec;
+        prev_state_vec.emplace_back(std::pair{handle, std::move(prev_states)});
+        stored_prev_states_.insert({key, std::move(prev_state_vec)});
       } else {
-        prev_states_vec->second.emplace_back(std::pair{handle, prev_state});
+        prev_states_vec->second.emplace_back(std::pair{handle, std::move(prev_states)});
       }
 
-      handleBlockProgress(handle->id(), std::move(P));
+      handleBlockProgress(handle->id(), std::move(P), lock);
       LOG(DEBUG) << "Stored prev state: " << handle->id().to_str();
     }
 
-    void BlockParser::handleBlockProgress(BlockIdExt id, td::Promise<std::tuple<td::string, td::string>> P) {
+    void BlockParser::handleBlockProgress(BlockIdExt id, td::Promise<std::tuple<td::string, td::string>> P,
+                                          std::unique_lock<std::mutex> &lock) {
       const std::string key =
               std::to_string(id.id.workchain) + ":" + std::to_string(id.id.shard) + ":" + std::to_string(id.id.seqno);
 
@@ -157,7 +159,7 @@ namespace ton::validator {
       }
 
       bool with_prev_state = false;
-      td::Ref<vm::Cell> prev_state;
+      std::vector<td::Ref<vm::Cell>> prev_states;
 
       auto prev_states_vec_found = stored_prev_states_.find(key);
       if (!(prev_states_vec_found == stored_prev_states_.end())) {
@@ -167,23 +169,26 @@ namespace ton::validator {
                                                   [&id](const auto &s) { return s.first->id() == id; });
         if (!(prev_state_found_iter == prev_states_vec.end())) {
           with_prev_state = true;
-          prev_state = prev_state_found_iter->second;
+          prev_states = prev_state_found_iter->second;
         }
       }
 
-      td::optional<td::Ref<vm::Cell>> prev_state_opt;
+      ConstBlockHandle handle = block_found_iter->first;
+      td::Ref<BlockData> data = block_found_iter->second;
+      td::Ref<vm::Cell> state = state_found_iter->second;
 
+      stored_applied_.erase(applied_found);
+      stored_blocks_.erase(blocks_vec_found);
+      stored_states_.erase(states_vec_found);
       if (with_prev_state) {
-        prev_state_opt = prev_state;
+        stored_prev_states_.erase(prev_states_vec_found);
       }
+      // the rest does not touch the maps, other store callbacks must not wait for it
+      lock.unlock();
 
       const auto applied_parsed = parseBlockApplied(id);
       enqueuePublishBlockApplied(id.id.workchain, id.id.shard, applied_parsed);
 
-      ConstBlockHandle handle = block_found_iter->first;
-      td::Ref<BlockData> data = block_found_iter->second;
-      td::Ref<vm::Cell> state = state_found_iter->second;
-
       const char *value = getenv("KAFKA_OUTMSG_TOPIC");
       bool allow_send_messages = bool(value);
 
@@ -196,7 +201,7 @@ namespace ton::validator {
                   }
               });
 
-      auto promise_try_sync = td::PromiseCreator::lambda(
+      td::Promise<std::tuple<td::Bits256, td::string, td::string>> promise_try_sync = td::PromiseCreator::lambda(
               [P = std::move(P), cluster_sync = cluster_sync_](
                       td::Result<std::tuple<td::Bits256, td::string, td::string>> R) mutable {
                   if (R.is_ok()) {
@@ -210,17 +215,9 @@ namespace ton::validator {
                   }
               });
 
-      td::actor::create_actor<BlockParserAsync>("BlockParserAsync", id, handle, data, state, prev_state_opt,
-                                                std::move(promise_try_sync), std::move(Po))
+      td::actor::create_actor<BlockBocSerializer>("BlockBocSerializer", id, handle, data, state, std::move(prev_states),
+                                                  allow_send_messages, std::move(promise_try_sync), std::move(Po))
               .release();
-
-      stored_applied_.erase(stored_applied_.find(key));
-      stored_blocks_.erase(stored_blocks_.find(key));
-      stored_states_.erase(stored_states_.find(key));
-
-      if (with_prev_state) {
-        stored_prev_states_.erase(stored_prev_states_.find(key));
-      }
     }
 
     std::string BlockParser::parseBlockApplied(BlockIdExt id) {
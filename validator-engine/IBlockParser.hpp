@@ -32,7 +32,8 @@ namespace ton {
 
             virtual void publishOutMsgs(int wc, unsigned long long shard, std::string out_msg_data) = 0;
 
-            virtual void deliver() = 0;
+            // Waits for everything published so far, fails if it is not acknowledged in time
+            virtual td::Status deliver() = 0;
 
             virtual void merge_new_shards(std::map<unsigned long long, int> new_shards) = 0;
         };
@@ -107,7 +108,8 @@ namespace ton {
             void storeBlockState(const ConstBlockHandle &handle, td::Ref<vm::Cell> state,
                                  td::Promise<std::tuple<td::string, td::string>> P);
 
-            void storeBlockStateWithPrev(const ConstBlockHandle &handle, td::Ref<vm::Cell> prev_state,
+            // prev_states are the states of the previous blocks, two after a merge
+            void storeBlockStateWithPrev(const ConstBlockHandle &handle, std::vector<td::Ref<vm::Cell>> prev_states,
                                          td::Ref<vm::Cell> state,
                                          td::Promise<std::tuple<td::string, td::string>> P);
 
@@ -118,7 +120,9 @@ namespace ton {
             void enqueuePublishBlockState(td::int32 wc, unsigned long long shard, const std::string &json);
 
         private:
-            void handleBlockProgress(BlockIdExt id, td::Promise<std::tuple<td::string, td::string>> P);
+            // Called with maps_mtx_ locked, releases it once the block is taken out of the maps
+            void handleBlockProgress(BlockIdExt id, td::Promise<std::tuple<td::string, td::string>> P,
+                                     std::unique_lock<std::mutex> &lock);
 
             std::string parseBlockApplied(BlockIdExt id);
 
@@ -139,7 +143,7 @@ namespace ton {
             std::map<std::string, BlockIdExt> stored_applied_;
             std::map<std::string, std::vector<std::pair<ConstBlockHandle, td::Ref<BlockData>>>> stored_blocks_;      // multimap?
             std::map<std::string, std::vector<std::pair<ConstBlockHandle, td::Ref<vm::Cell>>>> stored_states_;       // multimap?
-            std::map<std::string, std::vector<std::pair<ConstBlockHandle, td::Ref<vm::Cell>>>> stored_prev_states_;  // multimap?
+            std::map<std::string, std::vector<std::pair<ConstBlockHandle, std::vector<td::Ref<vm::Cell>>>>> stored_prev_states_;  // multimap?
 
             // mb rewrite with https://github.com/andreiavrammsd/cpp-channel
 
@@ -1663,6 +1663,7 @@ td::Status ValidatorEngine::load_global_config() {
   validator_options_.write().set_celldb_in_memory(celldb_in_memory_);
   validator_options_.write().set_celldb_v2(celldb_v2_);
   validator_options_.write().set_celldb_disable_bloom_filter(celldb_disable_bloom_filter_);
+  validator_options_.write().set_celldb_prefetch_depth(celldb_prefetch_depth_);
   validator_options_.write().set_max_open_archive_files(max_open_archive_files_);
   validator_options_.write().set_archive_preload_period(archive_preload_period_);
   validator_options_.write().set_disable_rocksdb_stats(disable_rocksdb_stats_);
@@ -1703,6 +1704,13 @@ td::Status ValidatorEngine::load_global_config() {
   }
   validator_options_.write().set_hardforks(std::move(h));
   validator_options_.write().set_fast_state_serializer_enabled(fast_state_serializer_enabled_);
+  validator_options_.write().set_validation_threads(validation_threads_);
+  validator_options_.write().set_liteserver_cache_size(liteserver_cache_size_);
+  validator_options_.write().set_liteserver_cache_disk_size(liteserver_cache_disk_size_);
+  validator_options_.write().set_liteserver_run_method_cache_size(liteserver_run_method_cache_size_);
+  validator_options_.write().set_transaction_index(transaction_index_);
+  validator_options_.write().set_transaction_index_build_range(transaction_index_build_range_.first,
+                                                               transaction_index_build_range_.second);
   validator_options_.write().set_catchain_broadcast_speed_multiplier(broadcast_speed_multiplier_catchain_);
 
   for (auto& id : config_.collator_node_whitelist) {
@@ -5604,6 +5612,18 @@ int main(int argc, char *argv[]) {
       [&]() {
         acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_disable_bloom_filter, true); });
       });
+  p.add_checked_option(
+      '\0', "celldb-prefetch-depth",
+      "load up to this many levels of children of a cell read from CellDb (V1 only) in one batch per level, "
+      "speeds up cold dictionary lookups at the cost of extra reads (default: 0, disabled)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+        if (v > 8) {
+          return td::Status::Error("celldb-prefetch-depth should be at most 8");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_prefetch_depth, v); });
+        return td::Status::OK();
+      });
   p.add_checked_option(
           '\0', "catchain-max-block-delay", "delay before creating a new catchain block, in seconds (default: 0.4)",
           [&](td::Slice s) -> td::Status {
@@ -5647,6 +5667,65 @@ int main(int argc, char *argv[]) {
                           td::actor::send_closure(x, &ValidatorEngine::set_fast_state_serializer_enabled, true);
                       });
           });
+  p.add_checked_option(
+      '\0', "validation-threads",
+      "check transactions of different accounts of a block candidate on N threads (default: 1)",
+      [&](td::Slice arg) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(arg));
+        if (v == 0) {
+          return td::Status::Error(ton::ErrorCode::error, "bad value for --validation-threads: should be > 0");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_validation_threads, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option('\0', "ls-cache-size",
+                       "memory limit of the lite-server response cache in bytes (default: 64Mb)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT(v, td::to_integer_safe<td::uint64>(arg));
+                         acts.push_back(
+                             [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_liteserver_cache_size, v); });
+                         return td::Status::OK();
+                       });
+  p.add_checked_option(
+      '\0', "ls-cache-disk-size",
+      "size of the on-disk tier of the lite-server response cache in bytes, stored in <db>/lscache (default: 0, off)",
+      [&](td::Slice arg) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint64>(arg));
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_liteserver_cache_disk_size, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "ls-run-method-cache-size",
+      "number of parsed account states kept by the lite-server for runSmcMethod (default: 16384, 0 - off)",
+      [&](td::Slice arg) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(arg));
+        acts.push_back(
+            [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_liteserver_run_method_cache_size, v); });
+        return td::Status::OK();
+      });
+  p.add_option('\0', "transaction-index",
+               "keep an index of transactions by account in <db>/txindex, used by getTransactions queries", [&]() {
+                 acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_transaction_index); });
+               });
+  p.add_checked_option(
+      '\0', "transaction-index-build",
+      "<from>:<to> add transactions of masterchain blocks from..to and their shard blocks from the archive to the "
+      "transaction index, implies --transaction-index",
+      [&](td::Slice arg) -> td::Status {
+        auto pos = arg.find(':');
+        if (pos == td::Slice::npos) {
+          return td::Status::Error(ton::ErrorCode::error, "bad value for --transaction-index-build: expected from:to");
+        }
+        TRY_RESULT(from, td::to_integer_safe<ton::BlockSeqno>(arg.substr(0, pos)));
+        TRY_RESULT(to, td::to_integer_safe<ton::BlockSeqno>(arg.substr(pos + 1)));
+        if (from == 0 || from > to) {
+          return td::Status::Error(ton::ErrorCode::error, "bad value for --transaction-index-build: empty range");
+        }
+        acts.push_back([&x, from, to]() {
+          td::actor::send_closure(x, &ValidatorEngine::set_transaction_index_build_range, from, to);
+        });
+        return td::Status::OK();
+      });
   p.add_option(
       '\0', "collect-validator-telemetry",
       "store validator telemetry from fast sync overlay to a given file (json format)",
@@ -251,6 +251,7 @@ class ValidatorEngine : public td::actor::Actor {
   bool celldb_in_memory_ = false;
   bool celldb_v2_ = false;
   bool celldb_disable_bloom_filter_ = false;
+  td::uint32 celldb_prefetch_depth_ = 0;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
   bool read_config_ = false;
   bool started_keyring_ = false;
@@ -258,6 +259,12 @@ class ValidatorEngine : public td::actor::Actor {
   ton::BlockSeqno truncate_seqno_{0};
   std::string session_logs_file_;
   bool fast_state_serializer_enabled_ = false;
+  td::uint32 validation_threads_ = 1;
+  td::uint64 liteserver_cache_size_ = 64 << 20;
+  td::uint64 liteserver_cache_disk_size_ = 0;
+  td::uint32 liteserver_run_method_cache_size_ = 16384;
+  bool transaction_index_ = false;
+  std::pair<ton::BlockSeqno, ton::BlockSeqno> transaction_index_build_range_{0, 0};
   std::string validator_telemetry_filename_;
   bool not_all_shards_ = false;
   std::vector<ton::ShardIdFull> add_shard_cmds_;
@@ -355,6 +362,9 @@ class ValidatorEngine : public td::actor::Actor {
   void set_celldb_disable_bloom_filter(bool value) {
     celldb_disable_bloom_filter_ = value;
   }
+  void set_celldb_prefetch_depth(td::uint32 value) {
+    celldb_prefetch_depth_ = value;
+  }
   void set_catchain_max_block_delay(double value) {
     catchain_max_block_delay_ = value;
   }
@@ -368,6 +378,25 @@ class ValidatorEngine : public td::actor::Actor {
   void set_fast_state_serializer_enabled(bool value) {
     fast_state_serializer_enabled_ = value;
   }
+  void set_validation_threads(td::uint32 value) {
+    validation_threads_ = value;
+  }
+  void set_liteserver_cache_size(td::uint64 value) {
+    liteserver_cache_size_ = value;
+  }
+  void set_liteserver_cache_disk_size(td::uint64 value) {
+    liteserver_cache_disk_size_ = value;
+  }
+  void set_liteserver_run_method_cache_size(td::uint32 value) {
+    liteserver_run_method_cache_size_ = value;
+  }
+  void set_transaction_index() {
+    transaction_index_ = true;
+  }
+  void set_transaction_index_build_range(ton::BlockSeqno from, ton::BlockSeqno to) {
+    transaction_index_ = true;
+    transaction_index_build_range_ = {from, to};
+  }
   void set_validator_telemetry_filename(std::string value) {
     validator_telemetry_filename_ = std::move(value);
   }
@@ -62,6 +62,8 @@ class PackageStatistics {
 
     ss << "ton.pack.read.bytes COUNT : " << read_bytes.exchange(0, std::memory_order_relaxed) << "\n";
     ss << "ton.pack.write.bytes COUNT : " << write_bytes.exchange(0, std::memory_order_relaxed) << "\n";
+    ss << "ton.pack.mmap.read.bytes COUNT : " << Package::mapped_read_bytes_and_reset() << "\n";
+    ss << "ton.pack.mmap.mapped.bytes COUNT : " << Package::mapped_bytes() << "\n";
 
     PercentileStats temp_read_time;
     {
@@ -183,6 +185,35 @@ class PackageReader : public td::actor::Actor {
   std::shared_ptr<PackageStatistics> statistics_;
 };
 
+class PackageSliceReader : public td::actor::Actor {
+ public:
+  PackageSliceReader(std::shared_ptr<Package> package, td::uint64 offset, td::uint64 limit,
+                     td::Promise<td::BufferSlice> promise, std::shared_ptr<PackageStatistics> statistics)
+      : package_(std::move(package))
+      , offset_(offset)
+      , limit_(limit)
+      , promise_(std::move(promise))
+      , statistics_(std::move(statistics)) {
+  }
+  void start_up() override {
+    auto start = td::Timestamp::now();
+    auto result = package_->read_raw(offset_, limit_);
+    if (statistics_ && result.is_ok()) {
+      statistics_->record_read((td::Timestamp::now().at() - start.at()) * 1e6, result.ok_ref().size());
+    }
+    package_ = {};
+    promise_.set_result(std::move(result));
+    stop();
+  }
+
+ private:
+  std::shared_ptr<Package> package_;
+  td::uint64 offset_;
+  td::uint64 limit_;
+  td::Promise<td::BufferSlice> promise_;
+  std::shared_ptr<PackageStatistics> statistics_;
+};
+
 static std::string get_package_file_name(PackageId p_id, ShardIdFull shard_prefix) {
   td::StringBuilder sb;
   sb << p_id.name();
@@ -646,6 +677,12 @@ void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint3
     TRY_RESULT_PROMISE_ASSIGN(promise, p, choose_package(value, ShardIdFull{masterchainId}, false));
   }
   promise = begin_async_query(std::move(promise));
+  if (p->package) {
+    td::actor::create_actor<PackageSliceReader>("slicereader", p->package, offset, limit, std::move(promise),
+                                                statistics_.pack_statistics)
+        .release();
+    return;
+  }
   td::actor::create_actor<db::ReadFile>("readfile", p->path, offset, limit, 0, std::move(promise)).release();
 }
 
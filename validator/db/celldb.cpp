@@ -230,7 +230,10 @@ void CellDbIn::start_up() {
     };
     LOG(WARNING) << "Using InMemory DynamicBagOfCells with options " << *boc_v2_options;
   } else {
-    boc_v1_options = vm::DynamicBagOfCellsDb::CreateV1Options{};
+    // dictionary lookups on a cold cache descend through forks, children of a loaded fork can be fetched in one
+    // MultiGet per level
+    boc_v1_options = vm::DynamicBagOfCellsDb::CreateV1Options{.prefetch_depth = opts_->get_celldb_prefetch_depth(),
+                                                              .prefetch_fanout = 16};
     LOG(WARNING) << "Using V1 DynamicBagOfCells with options " << *boc_v1_options;
   }
 
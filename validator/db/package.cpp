@@ -19,6 +19,14 @@
 #include "package.hpp"
 #include "common/errorcode.h"
 
+#include <atomic>
+#include <cstring>
+
+#if TD_PORT_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace ton {
 
 namespace {
@@ -42,12 +50,111 @@ constexpr td::uint16 entry_header_magic() {
 constexpr td::uint32 package_header_magic() {
   return 0xae8fdd01;
 }
+
+std::atomic<td::uint64> mapped_bytes_total{0};
+std::atomic<td::uint64> mapped_read_bytes{0};
 }  // namespace
 
+class Package::Mapping {
+ public:
+  Mapping(const char *data, size_t size) : data_(data), size_(size) {
+    mapped_bytes_total.fetch_add(size_, std::memory_order_relaxed);
+  }
+  Mapping(const Mapping &) = delete;
+  Mapping &operator=(const Mapping &) = delete;
+  ~Mapping() {
+#if TD_PORT_POSIX
+    munmap(const_cast<char *>(data_), size_);
+#endif
+    mapped_bytes_total.fetch_sub(size_, std::memory_order_relaxed);
+  }
+
+  td::uint64 size() const {
+    return size_;
+  }
+  td::Slice slice(td::uint64 offset, td::uint64 size) const {
+    mapped_read_bytes.fetch_add(size, std::memory_order_relaxed);
+    return td::Slice(data_ + offset, td::narrow_cast<size_t>(size));
+  }
+
+  // archives are streamed front to back: let the kernel read ahead aggressively and drop the pages behind
+  void advise_sequential() const {
+#if TD_PORT_POSIX
+    madvise(const_cast<char *>(data_), size_, MADV_SEQUENTIAL);
+#endif
+  }
+
+ private:
+  const char *data_;
+  size_t size_;
+};
+
 Package::Package(td::FileFd fd) : fd_(std::move(fd)) {
 }
 
+td::uint64 Package::mapped_bytes() {
+  return mapped_bytes_total.load(std::memory_order_relaxed);
+}
+
+td::uint64 Package::mapped_read_bytes_and_reset() {
+  return mapped_read_bytes.exchange(0, std::memory_order_relaxed);
+}
+
+std::shared_lock<std::shared_mutex> Package::lock_reads() const {
+  if (!mapping_state_) {
+    return {};
+  }
+  return std::shared_lock<std::shared_mutex>(mapping_state_->truncate_mutex);
+}
+
+std::shared_ptr<const Package::Mapping> Package::get_mapping(td::uint64 end) const {
+#if TD_PORT_POSIX
+  if (!mapping_state_) {
+    return nullptr;
+  }
+  auto &state = *mapping_state_;
+  std::lock_guard<std::mutex> guard(state.mutex);
+  if (state.mapping && state.mapping->size() >= end) {
+    return state.mapping;
+  }
+  if (state.disabled) {
+    return nullptr;
+  }
+  auto r_size = fd_.get_size();
+  if (r_size.is_error() || static_cast<td::uint64>(r_size.ok()) < end || r_size.ok() == 0) {
+    // the caller reports the short read
+    return nullptr;
+  }
+  auto size = td::narrow_cast<size_t>(r_size.ok());
+  auto data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_.get_native_fd().fd(), 0);
+  if (data == MAP_FAILED) {
+    auto error = OS_ERROR("mmap call failed");
+    LOG(WARNING) << "Can't map package, falling back to pread: " << error;
+    state.disabled = true;
+    return nullptr;
+  }
+  state.mapping = std::make_shared<const Mapping>(static_cast<const char *>(data), size);
+  return state.mapping;
+#else
+  return nullptr;
+#endif
+}
+
+void Package::reset_mapping() {
+  if (!mapping_state_) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mapping_state_->mutex);
+  mapping_state_->mapping = nullptr;
+}
+
 td::Status Package::truncate(td::uint64 size) {
+  // waits for the reads in progress, the ones coming later map the file anew
+  std::unique_lock<std::shared_mutex> guard;
+  if (mapping_state_) {
+    guard = std::unique_lock<std::shared_mutex>(mapping_state_->truncate_mutex);
+  }
+  reset_mapping();
   TRY_STATUS(fd_.seek(size + header_size()));
   return fd_.truncate_to_current_position(size + header_size());
 }
@@ -93,6 +200,28 @@ td::uint64 Package::size() const {
 td::Result<std::pair<std::string, td::BufferSlice>> Package::read(td::uint64 offset) const {
   offset += header_size();
 
+  auto guard = lock_reads();
+  if (auto mapping = get_mapping(offset + 8)) {
+    td::uint32 header[2];
+    std::memcpy(header, mapping->slice(offset, 8).data(), 8);
+    if ((header[0] & 0xffff) != entry_header_magic()) {
+      return td::Status::Error(ErrorCode::notready,
+                               PSTRING() << "bad entry magic " << (header[0] & 0xffff) << " offset=" << offset);
+    }
+    offset += 8;
+    auto fname_size = header[0] >> 16;
+    auto data_size = header[1];
+    if (offset + fname_size + data_size > mapping->size()) {
+      mapping = get_mapping(offset + fname_size + data_size);
+      if (!mapping) {
+        return td::Status::Error(ErrorCode::notready, "too short read (data)");
+      }
+    }
+    auto fname = mapping->slice(offset, fname_size).str();
+    return std::pair<std::string, td::BufferSlice>{std::move(fname),
+                                                   td::BufferSlice{mapping->slice(offset + fname_size, data_size)}};
+  }
+
   td::uint32 header[2];
   TRY_RESULT(s1, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), 8), offset));
   if (s1 != 8) {
@@ -121,6 +250,44 @@ td::Result<std::pair<std::string, td::BufferSlice>> Package::read(td::uint64 off
   return std::pair<std::string, td::BufferSlice>{std::move(fname), std::move(data)};
 }
 
+td::Result<td::BufferSlice> Package::read_raw(td::uint64 offset, td::uint64 limit) const {
+  auto guard = lock_reads();
+  TRY_RESULT(file_size, fd_.get_size());
+  if (offset > static_cast<td::uint64>(file_size)) {
+    return td::Status::Error(ErrorCode::notready, "invalid offset");
+  }
+  auto size = std::min<td::uint64>(limit, file_size - offset);
+  if (size == 0) {
+    return td::BufferSlice{};
+  }
+
+#if TD_PORT_POSIX
+  // the range gets a mapping of its own: sequential access advice must not apply to the shared mapping, which serves
+  // random reads of single entries
+  static const auto page_size = static_cast<td::uint64>(sysconf(_SC_PAGESIZE));
+  auto begin = offset / page_size * page_size;
+  auto length = td::narrow_cast<size_t>(offset + size - begin);
+  auto range = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd_.get_native_fd().fd(), static_cast<off_t>(begin));
+  if (range != MAP_FAILED) {
+    Mapping mapping(static_cast<const char *>(range), length);
+    mapping.advise_sequential();
+    return td::BufferSlice{mapping.slice(offset - begin, size)};
+  }
+#endif
+
+  td::BufferSlice data{td::narrow_cast<size_t>(size)};
+  auto slice = data.as_slice();
+  while (!slice.empty()) {
+    TRY_RESULT(got_size, fd_.pread(slice, offset));
+    if (got_size == 0) {
+      return td::Status::Error(ErrorCode::notready, "too short read");
+    }
+    offset += got_size;
+    slice.remove_prefix(got_size);
+  }
+  return std::move(data);
+}
+
 td::Result<td::uint64> Package::advance(td::uint64 offset) {
   offset += header_size();
 
@@ -22,6 +22,10 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/buffer.h"
 
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
 namespace ton {
 
 class Package {
@@ -39,6 +43,9 @@ class Package {
   td::Status try_sync();
   td::uint64 size() const;
   td::Result<std::pair<std::string, td::BufferSlice>> read(td::uint64 offset) const;
+  // Reads up to limit bytes of the package file itself (offset counts from the beginning of the file), for streaming
+  // whole archives
+  td::Result<td::BufferSlice> read_raw(td::uint64 offset, td::uint64 limit) const;
 
   td::Result<td::uint64> advance(td::uint64 offset);
   void iterate(std::function<bool(std::string, td::BufferSlice, td::uint64)> func);
@@ -47,8 +54,31 @@ class Package {
     return fd_;
   }
 
+  // Size of package files mapped at the moment
+  static td::uint64 mapped_bytes();
+  // Bytes read through mappings since the previous call
+  static td::uint64 mapped_read_bytes_and_reset();
+
  private:
   td::FileFd fd_;
+
+  // Reads are served from a read-only mapping of the whole file, which is replaced by a larger one once the package
+  // has grown past it. Readers keep the mapping they got alive, so a replacement never invalidates their data.
+  // Readers copy out of a mapping under a shared lock of truncate_mutex, and truncate() takes it exclusively, so that
+  // no read touches pages past the end of a truncated file. Without a mapping (e.g. mmap failed) reads fall back
+  // to pread.
+  class Mapping;
+  struct MappingState {
+    std::mutex mutex;
+    std::shared_ptr<const Mapping> mapping;
+    bool disabled{false};
+    std::shared_mutex truncate_mutex;
+  };
+  std::unique_ptr<MappingState> mapping_state_ = std::make_unique<MappingState>();
+
+  std::shared_lock<std::shared_mutex> lock_reads() const;
+  std::shared_ptr<const Mapping> get_mapping(td::uint64 end) const;
+  void reset_mapping();
 };
 
 }  // namespace ton
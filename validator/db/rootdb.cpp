@@ -289,10 +289,14 @@ void RootDb::store_block_state(BlockHandle handle, td::Ref<ShardState> state,
                                td::Promise<td::Ref<ShardState>> promise) {
   if (publisher_) {
     LOG(DEBUG) << "Start finding prev state for: " << handle->id();
-    const auto prev_id = handle->one_prev(true);
+    // both previous states are needed to diff the accounts of a block after a merge
+    std::vector<BlockIdExt> prev{handle->one_prev(true)};
+    if (handle->merge_before()) {
+      prev.push_back(handle->one_prev(false));
+    }
 
-    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), next_handle = handle, next_state = state,
-                                         publisher = publisher_, prev_id](td::Result<BlockHandle> R) mutable {
+    auto P = td::PromiseCreator::lambda([next_handle = handle, next_state = state, publisher = publisher_](
+                                            td::Result<std::vector<td::Ref<vm::Cell>>> R) mutable {
       const auto handle_id = next_handle->id();
       const auto shard = next_handle->id().id.shard;
       const auto wc = next_handle->id().id.workchain;
@@ -313,33 +317,17 @@ void RootDb::store_block_state(BlockHandle handle, td::Ref<ShardState> state,
             }
           });
 
+      ConstBlockHandle h(next_handle);
       if (R.is_error()) {
-        LOG(ERROR) << "Can't find handle for prev block state " << prev_id.to_str();
-        ConstBlockHandle h(next_handle);
+        LOG(ERROR) << "Can't find prev block state for " << handle_id.to_str() << ": " << R.move_as_error();
         publisher->storeBlockState(h, next_state->root_cell(), std::move(final_publish));
       } else {
-        auto P2 = td::PromiseCreator::lambda([final_publish = std::move(final_publish), next_handle = next_handle,
-                                              next_state = next_state, publisher = publisher,
-                                              prev_id](td::Result<td::Ref<vm::DataCell>> R) mutable {
-          if (R.is_error()) {
-            LOG(ERROR) << "Can't find prev block state for" << prev_id.to_str();
-            ConstBlockHandle h(next_handle);
-            publisher->storeBlockState(h, next_state->root_cell(), std::move(final_publish));
-          } else {
-            LOG(DEBUG) << "Found prev state for: " << next_handle->id();
-            auto root_cell = R.move_as_ok();
-            ConstBlockHandle h(next_handle);
-            publisher->storeBlockStateWithPrev(h, std::move(root_cell), next_state->root_cell(),
-                                               std::move(final_publish));
-          }
-        });
-
-        const auto new_handle = R.move_as_ok();
-        td::actor::send_closure(SelfId, &RootDb::get_block_state_root_cell, new_handle, std::move(P2));
+        LOG(DEBUG) << "Found prev state for: " << handle_id;
+        publisher->storeBlockStateWithPrev(h, R.move_as_ok(), next_state->root_cell(), std::move(final_publish));
       }
     });
 
-    td::actor::send_closure(actor_id(this), &RootDb::get_block_handle, prev_id, std::move(P));
+    get_prev_state_roots(std::move(prev), {}, std::move(P));
   }
 
   if (handle->moved_to_archive()) {
@@ -505,6 +493,28 @@ void RootDb::store_block_handle(BlockHandle handle, td::Promise<td::Unit> promis
   td::actor::send_closure(archive_db_, &ArchiveManager::update_handle, std::move(handle), std::move(promise));
 }
 
+void RootDb::get_prev_state_roots(std::vector<BlockIdExt> prev, std::vector<td::Ref<vm::Cell>> roots,
+                                  td::Promise<std::vector<td::Ref<vm::Cell>>> promise) {
+  if (roots.size() == prev.size()) {
+    promise.set_value(std::move(roots));
+    return;
+  }
+  auto id = prev[roots.size()];
+  get_block_handle(id, [SelfId = actor_id(this), prev = std::move(prev), roots = std::move(roots),
+                        promise = std::move(promise)](td::Result<BlockHandle> R) mutable {
+    TRY_RESULT_PROMISE_PREFIX(promise, handle, std::move(R), "no handle of prev block: ");
+    td::actor::send_closure(
+        SelfId, &RootDb::get_block_state_root_cell, std::move(handle),
+        [SelfId, prev = std::move(prev), roots = std::move(roots),
+         promise = std::move(promise)](td::Result<td::Ref<vm::DataCell>> R) mutable {
+          TRY_RESULT_PROMISE_PREFIX(promise, root, std::move(R), "no state of prev block: ");
+          roots.push_back(std::move(root));
+          td::actor::send_closure(SelfId, &RootDb::get_prev_state_roots, std::move(prev), std::move(roots),
+                                  std::move(promise));
+        });
+  });
+}
+
 void RootDb::get_block_handle(BlockIdExt id, td::Promise<BlockHandle> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::get_handle, id, std::move(promise));
 }
@@ -514,6 +524,15 @@ void RootDb::try_get_static_file(FileHash file_hash, td::Promise<td::BufferSlice
 }
 
 void RootDb::apply_block(BlockHandle handle, td::Promise<td::Unit> promise) {
+  if (!tx_index_db_.empty()) {
+    // indexing is not a part of applying the block, it is started once the block is archived
+    promise = [SelfId = actor_id(this), handle, promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+      if (R.is_ok()) {
+        td::actor::send_closure(SelfId, &RootDb::index_transactions, handle);
+      }
+      promise.set_result(std::move(R));
+    };
+  }
   td::actor::create_actor<BlockArchiver>("archiver", std::move(handle), archive_db_.get(), actor_id(this),
                                          std::move(promise))
       .release();
@@ -523,6 +542,32 @@ void RootDb::get_block_by_lt(AccountIdPrefixFull account, LogicalTime lt, td::Pr
   td::actor::send_closure(archive_db_, &ArchiveManager::get_block_by_lt, account, lt, std::move(promise));
 }
 
+void RootDb::index_transactions(ConstBlockHandle handle) {
+  get_block_data(handle, [tx_index_db = tx_index_db_.get(), block_id = handle->id()](td::Result<td::Ref<BlockData>> R) {
+    if (R.is_error()) {
+      LOG(WARNING) << "cannot index transactions of " << block_id.to_str() << ": " << R.move_as_error();
+      return;
+    }
+    td::actor::send_closure(tx_index_db, &TransactionIndexDb::add_block, R.move_as_ok(),
+                            [block_id](td::Result<td::Unit> R) {
+                              if (R.is_error()) {
+                                LOG(WARNING) << "cannot index transactions of " << block_id.to_str() << ": "
+                                             << R.move_as_error();
+                              }
+                            });
+  });
+}
+
+void RootDb::get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                      td::Promise<std::vector<AccountTransactionRef>> promise) {
+  if (tx_index_db_.empty()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+    return;
+  }
+  td::actor::send_closure(tx_index_db_, &TransactionIndexDb::get_account_transactions, workchain, addr, lt, count,
+                          std::move(promise));
+}
+
 void RootDb::get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts, td::Promise<ConstBlockHandle> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::get_block_by_unix_time, account, ts, std::move(promise));
 }
@@ -590,6 +635,15 @@ void RootDb::start_up() {
   static_files_db_ =
       td::actor::create_actor<StaticFilesDb>("staticfilesdb", actor_id(this), root_path_ + "/static/", read_only_);
   archive_db_ = td::actor::create_actor<ArchiveManager>("archive", actor_id(this), root_path_, opts_, read_only_);
+  if (opts_->get_transaction_index()) {
+    tx_index_db_ = td::actor::create_actor<TransactionIndexDb>("txindexdb", root_path_ + "/txindex/", read_only_);
+    auto range = opts_->get_transaction_index_build_range();
+    if (!read_only_ && range.first > 0 && range.first <= range.second) {
+      td::actor::create_actor<TransactionIndexBuilder>("txindexbuilder", actor_id(this), tx_index_db_.get(),
+                                                       range.first, range.second)
+          .release();
+    }
+  }
 }
 
 void RootDb::archive(BlockHandle handle, td::Promise<td::Unit> promise) {
@@ -28,6 +28,7 @@
 #include "archive-manager.hpp"
 #include "validator/fabric.h"
 #include "archiver.hpp"
+#include "txindexdb.hpp"
 
 #include "td/db/RocksDb.h"
 #include "ton/ton-tl.hpp"
@@ -156,6 +157,8 @@ class RootDb : public Db {
   void get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts, td::Promise<ConstBlockHandle> promise) override;
   void get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno,
                           td::Promise<ConstBlockHandle> promise) override;
+  void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                td::Promise<std::vector<AccountTransactionRef>> promise) override;
 
   void update_init_masterchain_block(BlockIdExt block, td::Promise<td::Unit> promise) override;
   void get_init_masterchain_block(td::Promise<BlockIdExt> promise) override;
@@ -213,9 +216,14 @@ class RootDb : public Db {
   td::actor::ActorOwn<StateDb> state_db_;
   td::actor::ActorOwn<StaticFilesDb> static_files_db_;
   td::actor::ActorOwn<ArchiveManager> archive_db_;
+  td::actor::ActorOwn<TransactionIndexDb> tx_index_db_;
   td::actor::ActorOwn<ClusterPublishSync> cluster_sync_;
 
   BlockParser* publisher_ = nullptr;
+  void index_transactions(ConstBlockHandle handle);
+  // State roots of the blocks `prev`, loaded one after another
+  void get_prev_state_roots(std::vector<BlockIdExt> prev, std::vector<td::Ref<vm::Cell>> roots,
+                            td::Promise<std::vector<td::Ref<vm::Cell>>> promise);
   void get_block_state_root_cell(ConstBlockHandle handle, td::Promise<td::Ref<vm::DataCell>> promise) override;
 };
 
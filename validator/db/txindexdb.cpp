@@ -0,0 +1,323 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "txindexdb.hpp"
+#include "block/block.h"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "block/mc-config.h"
+#include "vm/dict.h"
+
+namespace ton {
+
+namespace validator {
+
+namespace {
+
+void store_be(char *ptr, td::uint64 x, int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    ptr[i] = static_cast<char>(x & 0xff);
+    x >>= 8;
+  }
+}
+
+td::uint64 fetch_be(const char *ptr, int bytes) {
+  td::uint64 x = 0;
+  for (int i = 0; i < bytes; i++) {
+    x = (x << 8) | static_cast<unsigned char>(ptr[i]);
+  }
+  return x;
+}
+
+}  // namespace
+
+void TransactionIndexDb::start_up() {
+  auto R = td::RocksDb::open(db_path_, {}, read_only_);
+  if (R.is_error()) {
+    LOG(ERROR) << "Cannot open transaction index at " << db_path_ << ", the index is disabled: " << R.move_as_error();
+    return;
+  }
+  kv_ = std::make_unique<td::RocksDb>(R.move_as_ok());
+}
+
+std::string TransactionIndexDb::account_prefix(WorkchainId workchain, const StdSmcAddress &addr) {
+  std::string key(4 + 32, '\0');
+  store_be(key.data(), static_cast<td::uint32>(workchain), 4);
+  std::memcpy(key.data() + 4, addr.data(), 32);
+  return key;
+}
+
+std::string TransactionIndexDb::transaction_key(WorkchainId workchain, const StdSmcAddress &addr, LogicalTime lt) {
+  auto key = account_prefix(workchain, addr);
+  key.resize(KEY_SIZE);
+  store_be(key.data() + 36, ~lt, 8);
+  return key;
+}
+
+std::string TransactionIndexDb::transaction_value(const BlockIdExt &block_id, const td::Bits256 &hash) {
+  std::string value(VALUE_SIZE, '\0');
+  auto ptr = value.data();
+  store_be(ptr, static_cast<td::uint32>(block_id.id.workchain), 4);
+  store_be(ptr + 4, block_id.id.shard, 8);
+  store_be(ptr + 12, block_id.id.seqno, 4);
+  std::memcpy(ptr + 16, block_id.root_hash.data(), 32);
+  std::memcpy(ptr + 48, block_id.file_hash.data(), 32);
+  std::memcpy(ptr + 80, hash.data(), 32);
+  return value;
+}
+
+td::Result<AccountTransactionRef> TransactionIndexDb::parse_entry(td::Slice key, td::Slice value) {
+  if (key.size() != KEY_SIZE || value.size() != VALUE_SIZE) {
+    return td::Status::Error("invalid transaction index entry");
+  }
+  AccountTransactionRef ref;
+  ref.lt = ~fetch_be(key.data() + 36, 8);
+  auto ptr = value.data();
+  ref.block_id.id.workchain = static_cast<WorkchainId>(fetch_be(ptr, 4));
+  ref.block_id.id.shard = fetch_be(ptr + 4, 8);
+  ref.block_id.id.seqno = static_cast<BlockSeqno>(fetch_be(ptr + 12, 4));
+  std::memcpy(ref.block_id.root_hash.data(), ptr + 16, 32);
+  std::memcpy(ref.block_id.file_hash.data(), ptr + 48, 32);
+  std::memcpy(ref.hash.data(), ptr + 80, 32);
+  return ref;
+}
+
+void TransactionIndexDb::add_block(td::Ref<BlockData> block, td::Promise<td::Unit> promise) {
+  if (!kv_ || read_only_) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is not writable"));
+    return;
+  }
+  auto block_id = block->block_id();
+  auto workchain = block_id.id.workchain;
+  block::gen::Block::Record blk;
+  block::gen::BlockExtra::Record extra;
+  if (!(tlb::unpack_cell(block->root_cell(), blk) && tlb::unpack_cell(blk.extra, extra))) {
+    promise.set_error(td::Status::Error(ErrorCode::protoviolation, "cannot unpack block " + block_id.to_str()));
+    return;
+  }
+  kv_->begin_write_batch().ensure();
+  size_t count = 0;
+  bool ok;
+  try {
+    vm::AugmentedDictionary acc_dict{vm::load_cell_slice_ref(extra.account_blocks), 256,
+                                     block::tlb::aug_ShardAccountBlocks};
+    ok = acc_dict.check_for_each_extra([&](Ref<vm::CellSlice> value, Ref<vm::CellSlice>, td::ConstBitPtr key,
+                                           int key_len) {
+      CHECK(key_len == 256);
+      StdSmcAddress addr = key;
+      block::gen::AccountBlock::Record acc_blk;
+      if (!tlb::csr_unpack(std::move(value), acc_blk)) {
+        return false;
+      }
+      vm::AugmentedDictionary trans_dict{vm::DictNonEmpty(), std::move(acc_blk.transactions), 64,
+                                         block::tlb::aug_AccountTransactions};
+      return trans_dict.check_for_each_extra([&](Ref<vm::CellSlice> tvalue, Ref<vm::CellSlice>, td::ConstBitPtr tkey,
+                                                 int tkey_len) {
+        CHECK(tkey_len == 64);
+        auto root = tvalue->prefetch_ref();
+        if (root.is_null()) {
+          return false;
+        }
+        kv_->set(transaction_key(workchain, addr, tkey.get_uint(64)),
+                 transaction_value(block_id, root->get_hash().bits()))
+            .ensure();
+        ++count;
+        return true;
+      });
+    });
+  } catch (vm::VmError &err) {
+    kv_->abort_write_batch().ensure();
+    promise.set_error(td::Status::Error(
+        ErrorCode::protoviolation, PSTRING() << "cannot index block " << block_id.to_str() << ": " << err.get_msg()));
+    return;
+  }
+  if (!ok) {
+    kv_->abort_write_batch().ensure();
+    promise.set_error(
+        td::Status::Error(ErrorCode::protoviolation, "invalid account blocks in block " + block_id.to_str()));
+    return;
+  }
+  kv_->commit_write_batch().ensure();
+  VLOG(VALIDATOR_DEBUG) << "indexed " << count << " transactions of block " << block_id.to_str();
+  promise.set_value(td::Unit());
+}
+
+void TransactionIndexDb::get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                                  td::uint32 count,
+                                                  td::Promise<std::vector<AccountTransactionRef>> promise) {
+  if (!kv_) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is not available"));
+    return;
+  }
+  std::vector<AccountTransactionRef> result;
+  // every key of the account is shorter than `end`, which extends the largest one
+  auto begin = transaction_key(workchain, addr, lt);
+  auto end = account_prefix(workchain, addr) + std::string(9, '\xff');
+  auto S = kv_->for_each_in_range(begin, end, [&](td::Slice key, td::Slice value) -> td::Status {
+    if (result.size() >= count) {
+      // stops the scan, not reported
+      return td::Status::Error(ErrorCode::cancelled, "enough");
+    }
+    TRY_RESULT(ref, parse_entry(key, value));
+    result.push_back(ref);
+    return td::Status::OK();
+  });
+  if (S.is_error() && S.code() != ErrorCode::cancelled) {
+    promise.set_error(S.move_as_error_prefix("cannot read transaction index: "));
+    return;
+  }
+  promise.set_value(std::move(result));
+}
+
+void TransactionIndexBuilder::start_up() {
+  LOG(WARNING) << "Building transaction index for masterchain blocks " << from_ << ".." << to_;
+  seeding_ = from_ > 1;
+  seqno_ = seeding_ ? from_ - 1 : from_;
+  load_masterchain_block();
+}
+
+void TransactionIndexBuilder::load_masterchain_block() {
+  if (seqno_ > to_) {
+    LOG(WARNING) << "Transaction index is built for masterchain blocks " << from_ << ".." << to_ << ", " << blocks_
+                 << " blocks indexed";
+    stop();
+    return;
+  }
+  td::actor::send_closure(
+      db_, &Db::get_block_by_seqno, AccountIdPrefixFull{masterchainId, shardIdAll}, seqno_,
+      [SelfId = actor_id(this), db = db_](td::Result<ConstBlockHandle> R) {
+        if (R.is_error()) {
+          td::actor::send_closure(SelfId, &TransactionIndexBuilder::abort_query, R.move_as_error());
+          return;
+        }
+        td::actor::send_closure(db, &Db::get_block_data, R.move_as_ok(),
+                                [SelfId](td::Result<td::Ref<BlockData>> R) {
+                                  if (R.is_error()) {
+                                    td::actor::send_closure(SelfId, &TransactionIndexBuilder::abort_query,
+                                                            R.move_as_error());
+                                  } else {
+                                    td::actor::send_closure(SelfId, &TransactionIndexBuilder::got_masterchain_block,
+                                                            R.move_as_ok());
+                                  }
+                                });
+      });
+}
+
+void TransactionIndexBuilder::got_masterchain_block(td::Ref<BlockData> block) {
+  block::gen::Block::Record rec;
+  block::gen::BlockExtra::Record extra;
+  block::gen::McBlockExtra::Record mc_extra;
+  if (!(block::gen::unpack_cell(block->root_cell(), rec) && block::gen::unpack_cell(rec.extra, extra) &&
+        block::gen::unpack_cell(extra.custom->prefetch_ref(), mc_extra))) {
+    abort_query(td::Status::Error(ErrorCode::protoviolation, "cannot unpack " + block->block_id().to_str()));
+    return;
+  }
+  block::ShardConfig shard_config{mc_extra.shard_hashes->prefetch_ref()};
+  tops_.clear();
+  shard_config.process_shard_hashes([&](block::McShardHash &shard) {
+    tops_.insert(shard.top_block_id());
+    return 0;
+  });
+  if (seeding_) {
+    seeding_ = false;
+    next_masterchain_block();
+    return;
+  }
+
+  visited_.clear();
+  for (auto &id : tops_) {
+    if (!prev_tops_.count(id)) {
+      visited_.insert(id);
+      queue_.push_back(id);
+    }
+  }
+  ++blocks_;
+  td::actor::send_closure(index_, &TransactionIndexDb::add_block, std::move(block),
+                          [SelfId = actor_id(this)](td::Result<td::Unit> R) {
+                            if (R.is_error()) {
+                              td::actor::send_closure(SelfId, &TransactionIndexBuilder::abort_query, R.move_as_error());
+                            } else {
+                              td::actor::send_closure(SelfId, &TransactionIndexBuilder::load_next_shard_block);
+                            }
+                          });
+}
+
+void TransactionIndexBuilder::load_next_shard_block() {
+  if (queue_.empty()) {
+    next_masterchain_block();
+    return;
+  }
+  auto block_id = queue_.back();
+  queue_.pop_back();
+  td::actor::send_closure(
+      db_, &Db::get_block_handle, block_id, [SelfId = actor_id(this), db = db_](td::Result<BlockHandle> R) {
+        if (R.is_error()) {
+          td::actor::send_closure(SelfId, &TransactionIndexBuilder::abort_query, R.move_as_error());
+          return;
+        }
+        td::actor::send_closure(db, &Db::get_block_data, R.move_as_ok(), [SelfId](td::Result<td::Ref<BlockData>> R) {
+          if (R.is_error()) {
+            td::actor::send_closure(SelfId, &TransactionIndexBuilder::abort_query, R.move_as_error());
+          } else {
+            td::actor::send_closure(SelfId, &TransactionIndexBuilder::got_shard_block, R.move_as_ok());
+          }
+        });
+      });
+}
+
+void TransactionIndexBuilder::got_shard_block(td::Ref<BlockData> block) {
+  std::vector<BlockIdExt> prev;
+  BlockIdExt mc_blkid;
+  bool after_split;
+  auto S = block::unpack_block_prev_blk_try(block->root_cell(), block->block_id(), prev, mc_blkid, after_split);
+  if (S.is_error()) {
+    abort_query(std::move(S));
+    return;
+  }
+  for (auto &id : prev) {
+    if (id.seqno() != 0 && !prev_tops_.count(id) && visited_.insert(id).second) {
+      queue_.push_back(id);
+    }
+  }
+  ++blocks_;
+  td::actor::send_closure(index_, &TransactionIndexDb::add_block, std::move(block),
+                          [SelfId = actor_id(this)](td::Result<td::Unit> R) {
+                            if (R.is_error()) {
+                              td::actor::send_closure(SelfId, &TransactionIndexBuilder::abort_query, R.move_as_error());
+                            } else {
+                              td::actor::send_closure(SelfId, &TransactionIndexBuilder::load_next_shard_block);
+                            }
+                          });
+}
+
+void TransactionIndexBuilder::next_masterchain_block() {
+  prev_tops_ = std::move(tops_);
+  tops_.clear();
+  if (seqno_ % 1000 == 0) {
+    LOG(WARNING) << "Transaction index: masterchain block " << seqno_ << ", " << blocks_ << " blocks indexed";
+  }
+  ++seqno_;
+  load_masterchain_block();
+}
+
+void TransactionIndexBuilder::abort_query(td::Status reason) {
+  LOG(ERROR) << "Failed to build transaction index at masterchain block " << seqno_ << ": " << reason;
+  stop();
+}
+
+}  // namespace validator
+
+}  // namespace ton
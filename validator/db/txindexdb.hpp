@@ -0,0 +1,92 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/actor/actor.h"
+#include "td/db/RocksDb.h"
+#include "validator/interfaces/db.h"
+
+#include <set>
+
+namespace ton {
+
+namespace validator {
+
+// Transactions of applied blocks by account: (workchain, address, lt) -> (block id, transaction hash).
+// The key stores ~lt, so a forward range scan returns the transactions of an account from the newest to the oldest.
+// The index may have gaps (it is filled from the moment it is enabled plus whatever was built offline), so readers
+// must verify every entry against the block and fall back to walking blocks when an entry is missing.
+class TransactionIndexDb : public td::actor::Actor {
+ public:
+  TransactionIndexDb(std::string db_path, bool read_only = false)
+      : db_path_(std::move(db_path)), read_only_(read_only) {
+  }
+
+  void start_up() override;
+
+  void add_block(td::Ref<BlockData> block, td::Promise<td::Unit> promise);
+  // At most count transactions of the account with lt <= `lt`, newest first
+  void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                td::Promise<std::vector<AccountTransactionRef>> promise);
+
+ private:
+  static constexpr size_t KEY_SIZE = 4 + 32 + 8;
+  static constexpr size_t VALUE_SIZE = 4 + 8 + 4 + 32 + 32 + 32;
+
+  static std::string account_prefix(WorkchainId workchain, const StdSmcAddress &addr);
+  static std::string transaction_key(WorkchainId workchain, const StdSmcAddress &addr, LogicalTime lt);
+  static std::string transaction_value(const BlockIdExt &block_id, const td::Bits256 &hash);
+  static td::Result<AccountTransactionRef> parse_entry(td::Slice key, td::Slice value);
+
+  std::string db_path_;
+  bool read_only_;
+  std::unique_ptr<td::RocksDb> kv_;
+};
+
+// Fills the index offline from the archive: every masterchain block in [from, to] together with the shard blocks
+// committed in it, found by walking each shard back from its top to the tops of the previous masterchain block.
+class TransactionIndexBuilder : public td::actor::Actor {
+ public:
+  TransactionIndexBuilder(td::actor::ActorId<Db> db, td::actor::ActorId<TransactionIndexDb> index, BlockSeqno from,
+                          BlockSeqno to)
+      : db_(db), index_(index), from_(std::max<BlockSeqno>(from, 1)), to_(to) {
+  }
+
+  void start_up() override;
+
+ private:
+  void load_masterchain_block();
+  void got_masterchain_block(td::Ref<BlockData> block);
+  void load_next_shard_block();
+  void got_shard_block(td::Ref<BlockData> block);
+  void next_masterchain_block();
+  void abort_query(td::Status reason);
+
+  td::actor::ActorId<Db> db_;
+  td::actor::ActorId<TransactionIndexDb> index_;
+  BlockSeqno from_, to_;
+  BlockSeqno seqno_ = 0;
+  // only the shard tops of masterchain block from - 1 are needed, its own blocks are not indexed
+  bool seeding_ = false;
+  std::set<BlockIdExt> prev_tops_, tops_, visited_;
+  std::vector<BlockIdExt> queue_;
+  td::uint64 blocks_ = 0;
+};
+
+}  // namespace validator
+
+}  // namespace ton
@@ -24,6 +24,7 @@
 #include "vm/cells/MerkleProof.h"
 #include "crypto/block/block-auto.h"
 #include "crypto/block/block-parse.h"
+#include "td/utils/port/thread.h"
 
 namespace ton {
 
@@ -359,6 +360,25 @@ void DownloadShardState::downloaded_split_state_header(td::BufferSlice data) {
 
 namespace {
 
+// Deserializes a state part in a separate actor, so that DownloadShardState stays responsive meanwhile.
+// State parts hold millions of cells, their hashes are computed with the help of the shared BOC threads
+class StatePartDeserializer : public td::actor::Actor {
+ public:
+  StatePartDeserializer(td::BufferSlice data, td::Promise<td::Ref<vm::Cell>> promise)
+      : data_(std::move(data)), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    promise_.set_result(
+        vm::std_boc_deserialize(data_, false, false, std::max(td::thread::hardware_concurrency() / 2, 1u) - 1));
+    stop();
+  }
+
+ private:
+  td::BufferSlice data_;
+  td::Promise<td::Ref<vm::Cell>> promise_;
+};
+
 void retry_part_download(td::actor::ActorId<DownloadShardState> SelfId, td::Status error) {
   LOG(WARNING) << "failed to download state part : " << error;
   delay_action([=]() { td::actor::send_closure(SelfId, &DownloadShardState::download_next_part_or_finish); },
@@ -406,13 +426,20 @@ void DownloadShardState::downloaded_state_part(td::BufferSlice data) {
   status_.set_status(PSTRING() << block_id_.id.to_str() << " : processing state part (part " << idx + 1 << " out of "
                                << parts_.size() << ")");
 
-  auto maybe_part = vm::std_boc_deserialize(data);
-  if (maybe_part.is_error()) {
-    retry_part_download(actor_id(this), maybe_part.move_as_error());
-    return;
-  }
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), data = data.clone()](td::Result<td::Ref<vm::Cell>> R) mutable {
+        if (R.is_error()) {
+          retry_part_download(SelfId, R.move_as_error());
+        } else {
+          td::actor::send_closure(SelfId, &DownloadShardState::deserialized_state_part, std::move(data),
+                                  R.move_as_ok());
+        }
+      });
+  td::actor::create_actor<StatePartDeserializer>("deserializestatepart", std::move(data), std::move(P)).release();
+}
 
-  auto root = maybe_part.move_as_ok();
+void DownloadShardState::deserialized_state_part(td::BufferSlice data, td::Ref<vm::Cell> root) {
+  size_t idx = stored_parts_.size();
   if (root->get_hash() != parts_[idx].root_hash) {
     auto error_message =
         "Hash mismatch for part " +
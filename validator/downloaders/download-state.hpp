@@ -57,6 +57,7 @@ class DownloadShardState : public td::actor::Actor {
   void downloaded_split_state_header(td::BufferSlice data);
   void download_next_part_or_finish();
   void downloaded_state_part(td::BufferSlice data);
+  void deserialized_state_part(td::BufferSlice data, td::Ref<vm::Cell> root);
   void written_state_part_file();
   void saved_state_part_into_celldb(td::Ref<vm::DataCell> cell);
 
@@ -31,8 +31,12 @@ enum CollateMode { skip_store_candidate = 1, from_collator_node = 2 };
 
 td::actor::ActorOwn<Db> create_db_actor(td::actor::ActorId<ValidatorManager> manager, std::string db_root_,
                                         td::Ref<ValidatorManagerOptions> opts, bool read_only = false);
+std::shared_ptr<LiteServerResponseCache> create_liteserver_response_cache(std::string db_root,
+                                                                          td::Ref<ValidatorManagerOptions> opts);
+std::shared_ptr<LiteServerRunMethodCache> create_liteserver_run_method_cache(td::Ref<ValidatorManagerOptions> opts);
 td::actor::ActorOwn<LiteServerCache> create_liteserver_cache_actor(td::actor::ActorId<ValidatorManager> manager,
-                                                                   std::string db_root);
+                                                                   std::string db_root,
+                                                                   std::shared_ptr<LiteServerResponseCache> responses);
 
 td::Result<td::Ref<BlockData>> create_block(BlockIdExt block_id, td::BufferSlice data);
 td::Result<td::Ref<BlockData>> create_block(ReceivedBlock data);
@@ -83,7 +87,7 @@ void run_check_proof_link_query(BlockIdExt id, td::Ref<ProofLink> proof, td::act
 void run_validate_query(ShardIdFull shard, BlockIdExt min_masterchain_block_id, std::vector<BlockIdExt> prev,
                         BlockCandidate candidate, td::Ref<ValidatorSet> validator_set, PublicKeyHash local_validator_id,
                         td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                        td::Promise<ValidateCandidateResult> promise, unsigned mode = 0);
+                        td::Promise<ValidateCandidateResult> promise, unsigned mode = 0, td::uint32 threads = 1);
 void run_collate_query(ShardIdFull shard, const BlockIdExt& min_masterchain_block_id, std::vector<BlockIdExt> prev,
                        Ed25519_PublicKey creator, td::Ref<ValidatorSet> validator_set,
                        td::Ref<CollatorOptions> collator_opts, td::actor::ActorId<ValidatorManager> manager,
@@ -94,11 +98,14 @@ void run_collate_hardfork(ShardIdFull shard, const BlockIdExt& min_masterchain_b
                           td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
                           td::Promise<BlockCandidate> promise);
 void run_liteserver_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                          td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
+                          td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+                          std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                          td::Promise<td::BufferSlice> promise);
 
 void run_liteserver_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                          td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise,
-                          adnl::AdnlNodeIdShort dst);
+                          td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+                          std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                          td::Promise<td::BufferSlice> promise, adnl::AdnlNodeIdShort dst);
 void run_fetch_account_state(
     WorkchainId wc, StdSmcAddress addr, td::actor::ActorId<ValidatorManager> manager,
     td::Promise<std::tuple<td::Ref<vm::CellSlice>, UnixTime, LogicalTime, std::unique_ptr<block::ConfigInfo>>> promise);
@@ -45,9 +45,25 @@ td::actor::ActorOwn<Db> create_db_actor(td::actor::ActorId<ValidatorManager> man
   return td::actor::create_actor<RootDb>("db", manager, db_root_, opts, read_only);
 }
 
+std::shared_ptr<LiteServerResponseCache> create_liteserver_response_cache(std::string db_root,
+                                                                          td::Ref<ValidatorManagerOptions> opts) {
+  LiteServerResponseCacheImpl::Options options;
+  options.max_size = opts->get_liteserver_cache_size();
+  options.max_disk_size = opts->get_liteserver_cache_disk_size();
+  if (options.max_disk_size > 0) {
+    options.disk_path = db_root + "/lscache/";
+  }
+  return std::make_shared<LiteServerResponseCacheImpl>(std::move(options));
+}
+
+std::shared_ptr<LiteServerRunMethodCache> create_liteserver_run_method_cache(td::Ref<ValidatorManagerOptions> opts) {
+  return std::make_shared<LiteServerRunMethodCacheImpl>(opts->get_liteserver_run_method_cache_size());
+}
+
 td::actor::ActorOwn<LiteServerCache> create_liteserver_cache_actor(td::actor::ActorId<ValidatorManager> manager,
-                                                                   std::string db_root) {
-  return td::actor::create_actor<LiteServerCacheImpl>("cache");
+                                                                   std::string db_root,
+                                                                   std::shared_ptr<LiteServerResponseCache> responses) {
+  return td::actor::create_actor<LiteServerCacheImpl>("cache", std::move(responses));
 }
 
 td::Result<td::Ref<BlockData>> create_block(BlockIdExt block_id, td::BufferSlice data) {
@@ -194,7 +210,7 @@ void run_check_proof_link_query(BlockIdExt id, td::Ref<ProofLink> proof, td::act
 void run_validate_query(ShardIdFull shard, BlockIdExt min_masterchain_block_id, std::vector<BlockIdExt> prev,
                         BlockCandidate candidate, td::Ref<ValidatorSet> validator_set, PublicKeyHash local_validator_id,
                         td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                        td::Promise<ValidateCandidateResult> promise, unsigned mode) {
+                        td::Promise<ValidateCandidateResult> promise, unsigned mode, td::uint32 threads) {
   BlockSeqno seqno = 0;
   for (auto& p : prev) {
     if (p.seqno() > seqno) {
@@ -207,7 +223,7 @@ void run_validate_query(ShardIdFull shard, BlockIdExt min_masterchain_block_id,
                                                    << ":" << (seqno + 1) << "#" << idx.fetch_add(1),
                                          shard, min_masterchain_block_id, std::move(prev), std::move(candidate),
                                          std::move(validator_set), local_validator_id, std::move(manager), timeout,
-                                         std::move(promise), mode)
+                                         std::move(promise), mode, threads)
       .release();
 }
 
@@ -248,14 +264,19 @@ void run_collate_hardfork(ShardIdFull shard, const BlockIdExt& min_masterchain_b
 }
 
 void run_liteserver_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                          td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise) {
-  LiteQuery::run_query(std::move(data), std::move(manager), std::move(cache), std::move(promise));
+                          td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+                          std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                          td::Promise<td::BufferSlice> promise) {
+  LiteQuery::run_query(std::move(data), std::move(manager), std::move(cache), std::move(responses),
+                       std::move(run_method_cache), std::move(promise));
 }
 
 void run_liteserver_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                          td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise,
-                          adnl::AdnlNodeIdShort dst) {
-  LiteQuery::run_query(std::move(data), std::move(manager), std::move(cache), std::move(promise), dst);
+                          td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+                          std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                          td::Promise<td::BufferSlice> promise, adnl::AdnlNodeIdShort dst) {
+  LiteQuery::run_query(std::move(data), std::move(manager), std::move(cache), std::move(responses),
+                       std::move(run_method_cache), std::move(promise), dst);
 }
 
 void run_fetch_account_state(
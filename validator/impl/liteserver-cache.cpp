@@ -0,0 +1,369 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "liteserver-cache.hpp"
+#include "tl-utils/lite-utils.hpp"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "block/mc-config.h"
+#include "vm/dict.h"
+
+namespace ton::validator {
+
+LiteServerResponseCacheImpl::LiteServerResponseCacheImpl(Options options)
+    : options_(std::move(options)), max_shard_size_(options_.max_size / SHARDS) {
+  if (options_.max_disk_size == 0 || options_.disk_path.empty()) {
+    return;
+  }
+  // nothing on disk is known to the queue, so the previous contents are dropped
+  td::RocksDb::destroy(options_.disk_path).ignore();
+  auto R = td::RocksDb::open(options_.disk_path);
+  if (R.is_error()) {
+    LOG(ERROR) << "Cannot open lite-server cache db at " << options_.disk_path << ", disk tier is disabled: "
+               << R.move_as_error();
+    return;
+  }
+  disk_ = std::make_unique<td::RocksDb>(R.move_as_ok());
+}
+
+td::Result<td::BufferSlice> LiteServerResponseCacheImpl::lookup(td::int32 query_id, const td::Bits256 &key) {
+  auto &shard = get_shard(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto &stats = shard.stats[query_id];
+    ++stats.queries;
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+      ++stats.hits;
+      auto entry = it->second.get();
+      entry->remove();
+      shard.lru.put(entry);
+      return entry->value_.clone();
+    }
+  }
+  if (!disk_) {
+    return td::Status::Error("not found");
+  }
+  TRY_RESULT(value, disk_lookup(key));
+  std::vector<std::unique_ptr<CacheEntry>> evicted;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto &stats = shard.stats[query_id];
+    ++stats.hits;
+    ++stats.disk_hits;
+    evicted = insert(shard, key, value.clone());
+  }
+  spill(std::move(evicted));
+  return std::move(value);
+}
+
+void LiteServerResponseCacheImpl::update(td::int32 query_id, const td::Bits256 &key, td::BufferSlice value) {
+  // a single response must not flush a whole shard
+  if (value.size() + 64 > max_shard_size_ / 4) {
+    return;
+  }
+  auto &shard = get_shard(key);
+  std::vector<std::unique_ptr<CacheEntry>> evicted;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    evicted = insert(shard, key, std::move(value));
+  }
+  spill(std::move(evicted));
+}
+
+std::vector<std::unique_ptr<LiteServerResponseCacheImpl::CacheEntry>> LiteServerResponseCacheImpl::insert(
+    Shard &shard, td::Bits256 key, td::BufferSlice value) {
+  std::unique_ptr<CacheEntry> &entry = shard.entries[key];
+  if (entry == nullptr) {
+    entry = std::make_unique<CacheEntry>(key, std::move(value));
+  } else {
+    shard.size -= entry->size();
+    entry->value_ = std::move(value);
+    entry->remove();
+  }
+  shard.lru.put(entry.get());
+  shard.size += entry->size();
+
+  std::vector<std::unique_ptr<CacheEntry>> evicted;
+  while (shard.size > max_shard_size_) {
+    auto to_remove = (CacheEntry *)shard.lru.get();
+    CHECK(to_remove);
+    shard.size -= to_remove->size();
+    auto it = shard.entries.find(to_remove->key_);
+    evicted.push_back(std::move(it->second));
+    shard.entries.erase(it);
+  }
+  return evicted;
+}
+
+td::Result<td::BufferSlice> LiteServerResponseCacheImpl::disk_lookup(const td::Bits256 &key) {
+  std::string value;
+  TRY_RESULT(status, disk_->get(key.as_slice(), value));
+  if (status != td::KeyValue::GetStatus::Ok) {
+    return td::Status::Error("not found");
+  }
+  return td::BufferSlice{value};
+}
+
+void LiteServerResponseCacheImpl::spill(std::vector<std::unique_ptr<CacheEntry>> entries) {
+  if (!disk_ || entries.empty()) {
+    return;
+  }
+  // rocksdb itself is thread-safe, the mutex guards only the queue of entries on disk
+  std::lock_guard<std::mutex> lock(disk_mutex_);
+  for (auto &entry : entries) {
+    if (!disk_keys_.insert(entry->key_).second) {
+      continue;
+    }
+    auto S = disk_->set(entry->key_.as_slice(), entry->value_.as_slice());
+    if (S.is_error()) {
+      LOG(WARNING) << "Cannot write to lite-server cache db: " << S;
+      disk_keys_.erase(entry->key_);
+      continue;
+    }
+    disk_queue_.emplace_back(entry->key_, entry->size());
+    disk_size_ += entry->size();
+  }
+  while (disk_size_ > options_.max_disk_size && !disk_queue_.empty()) {
+    auto [key, size] = disk_queue_.front();
+    disk_queue_.pop_front();
+    disk_->erase(key.as_slice()).ignore();
+    disk_keys_.erase(key);
+    disk_size_ -= size;
+  }
+}
+
+std::vector<std::pair<td::int32, LiteServerResponseCache::QueryStats>> LiteServerResponseCacheImpl::get_stats()
+    const {
+  std::map<td::int32, QueryStats> total;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto &[query_id, stats] : shard.stats) {
+      auto &x = total[query_id];
+      x.queries += stats.queries;
+      x.hits += stats.hits;
+      x.disk_hits += stats.disk_hits;
+    }
+  }
+  return {total.begin(), total.end()};
+}
+
+LiteServerResponseCache::Usage LiteServerResponseCacheImpl::get_usage() const {
+  Usage usage;
+  usage.max_size = options_.max_size;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    usage.entries += shard.entries.size();
+    usage.size += shard.size;
+  }
+  if (disk_) {
+    std::lock_guard<std::mutex> lock(disk_mutex_);
+    usage.disk_size = disk_size_;
+    usage.max_disk_size = options_.max_disk_size;
+  }
+  return usage;
+}
+
+td::Ref<vm::Tuple> LiteServerRunMethodCache::Config::get_unpacked_config_tuple(UnixTime now) const {
+  std::vector<vm::StackEntry> tuple;
+  vm::StackEntry storage_prices_entry;
+  if (storage_prices.not_null()) {
+    vm::Dictionary dict{storage_prices, 32};
+    dict.check_for_each([&](td::Ref<vm::CellSlice> cs_ref, td::ConstBitPtr key, int n) -> bool {
+      if (now >= key.get_uint(n)) {
+        storage_prices_entry = std::move(cs_ref);
+        return true;
+      }
+      return false;
+    });
+  }
+  tuple.push_back(std::move(storage_prices_entry));
+  for (const auto &param : unpacked_params) {
+    tuple.push_back(param.is_null() ? vm::StackEntry() : vm::StackEntry(vm::load_cell_slice_ref(param)));
+  }
+  return td::make_cnt_ref<std::vector<vm::StackEntry>>(std::move(tuple));
+}
+
+td::optional<td::uint64> LiteServerRunMethodCache::Config::get_precompiled_gas_usage(
+    const td::Bits256 &code_hash) const {
+  if (precompiled_contracts.is_null()) {
+    return {};
+  }
+  block::PrecompiledContractsConfig config;
+  config.list = vm::Dictionary{precompiled_contracts, 256};
+  auto contract = config.get_contract(code_hash);
+  if (!contract) {
+    return {};
+  }
+  return contract.value().gas_usage;
+}
+
+td::Result<std::shared_ptr<const LiteServerRunMethodCache::Config>> LiteServerRunMethodCache::parse_config(
+    td::Ref<MasterchainState> state) {
+  TRY_RESULT(info, block::ConfigInfo::extract_config(state->root_cell(), block::ConfigInfo::needLibraries |
+                                                                              block::ConfigInfo::needCapabilities |
+                                                                              block::ConfigInfo::needPrevBlocks));
+  auto config = std::make_shared<Config>();
+  config->block_id = state->get_block_id();
+  config->global_version = info->get_global_version();
+  config->root = info->get_root_cell();
+  config->libraries = info->get_libraries_root();
+  config->storage_prices = info->get_config_param(18);
+  for (int idx : {19, 20, 21, 24, 25, 43}) {
+    config->unpacked_params.push_back(info->get_config_param(idx));
+  }
+  block::gen::PrecompiledContractsConfig::Record precompiled;
+  auto param = info->get_config_param(45);
+  if (param.not_null() && tlb::unpack_cell(param, precompiled)) {
+    config->precompiled_contracts = precompiled.list->prefetch_ref();
+  }
+  auto prev_blocks_info = info->get_prev_blocks_info();
+  if (prev_blocks_info.is_ok()) {
+    config->prev_blocks_info = prev_blocks_info.move_as_ok();
+  }
+  return config;
+}
+
+td::Result<LiteServerRunMethodCache::Account> LiteServerRunMethodCache::parse_account(td::Ref<vm::Cell> root) {
+  block::gen::Account::Record_account acc;
+  block::gen::StorageInfo::Record storage_info;
+  block::gen::AccountStorage::Record store;
+  block::gen::StateInit::Record state_init;
+  Account account;
+  if (!(tlb::unpack_cell(std::move(root), acc) && tlb::csr_unpack(std::move(acc.storage), store) &&
+        account.balance.validate_unpack(store.balance) && store.state->prefetch_ulong(1) == 1 &&
+        store.state.write().advance(1) && tlb::csr_unpack(std::move(store.state), state_init) &&
+        tlb::csr_unpack(std::move(acc.storage_stat), storage_info))) {
+    return td::Status::Error("error unpacking account state, or account is frozen or uninitialized");
+  }
+  account.code = state_init.code->prefetch_ref();
+  account.data = state_init.data->prefetch_ref();
+  account.libraries = state_init.library->prefetch_ref();
+  vm::CellBuilder cb;
+  if (!(cb.append_cellslice_bool(acc.addr) && cb.finalize_to(account.addr))) {
+    return td::Status::Error("cannot store account address");
+  }
+  if (storage_info.due_payment.write().fetch_long(1)) {
+    account.due_payment = block::tlb::t_Grams.as_integer(storage_info.due_payment);
+  } else {
+    account.due_payment = td::zero_refint();
+  }
+  return std::move(account);
+}
+
+td::Result<std::shared_ptr<const LiteServerRunMethodCache::Config>> LiteServerRunMethodCacheImpl::get_config(
+    td::Ref<MasterchainState> state) {
+  auto block_id = state->get_block_id();
+  {
+    std::lock_guard<std::mutex> lock(configs_mutex_);
+    for (const auto &config : configs_) {
+      if (config->block_id == block_id) {
+        return config;
+      }
+    }
+  }
+  // parsed outside of the lock, two queries may parse the same config at once, the second one is dropped
+  TRY_RESULT(config, parse_config(std::move(state)));
+  std::lock_guard<std::mutex> lock(configs_mutex_);
+  for (const auto &other : configs_) {
+    if (other->block_id == block_id) {
+      return other;
+    }
+  }
+  configs_.push_back(config);
+  if (configs_.size() > MAX_CONFIGS) {
+    configs_.pop_front();
+  }
+  return config;
+}
+
+std::shared_ptr<const LiteServerRunMethodCache::Account> LiteServerRunMethodCacheImpl::get_account(
+    td::Ref<vm::Cell> root) {
+  td::Bits256 key = root->get_hash().bits();
+  {
+    std::lock_guard<std::mutex> lock(accounts_mutex_);
+    ++queries_;
+    auto it = accounts_.find(key);
+    if (it != accounts_.end()) {
+      ++hits_;
+      auto entry = it->second.get();
+      entry->remove();
+      lru_.put(entry);
+      return entry->account_;
+    }
+  }
+  auto R = parse_account(std::move(root));
+  if (R.is_error()) {
+    return nullptr;
+  }
+  auto account = std::make_shared<const Account>(R.move_as_ok());
+  if (max_accounts_ == 0) {
+    return account;
+  }
+  std::lock_guard<std::mutex> lock(accounts_mutex_);
+  auto &entry = accounts_[key];
+  if (entry == nullptr) {
+    entry = std::make_unique<AccountEntry>(key, account);
+    lru_.put(entry.get());
+  }
+  while (accounts_.size() > max_accounts_) {
+    auto to_remove = (AccountEntry *)lru_.get();
+    CHECK(to_remove);
+    accounts_.erase(to_remove->key_);
+  }
+  return account;
+}
+
+LiteServerRunMethodCache::Stats LiteServerRunMethodCacheImpl::get_stats() const {
+  std::lock_guard<std::mutex> lock(accounts_mutex_);
+  Stats stats;
+  stats.queries = queries_;
+  stats.hits = hits_;
+  stats.accounts = accounts_.size();
+  return stats;
+}
+
+void LiteServerCacheImpl::alarm() {
+  alarm_timestamp() = td::Timestamp::in(60.0);
+  td::StringBuilder sb;
+  td::uint64 queries = 0, hits = 0;
+  auto stats = responses_->get_stats();
+  for (auto &[query_id, cur] : stats) {
+    auto &prev = last_stats_[query_id];
+    auto cur_queries = cur.queries - prev.queries, cur_hits = cur.hits - prev.hits;
+    if (cur_queries > 0) {
+      sb << " " << lite_query_name_by_id(query_id) << ":" << cur_hits << "/" << cur_queries;
+      if (cur.disk_hits > prev.disk_hits) {
+        sb << "(disk " << cur.disk_hits - prev.disk_hits << ")";
+      }
+    }
+    queries += cur_queries;
+    hits += cur_hits;
+    prev = cur;
+  }
+  if (queries > 0 || !send_message_cache_.empty()) {
+    auto usage = responses_->get_usage();
+    LOG(WARNING) << "LS Cache stats: " << queries << " queries, " << hits << " hits; " << usage.entries
+                 << " entries, size=" << usage.size << "/" << usage.max_size << ", disk=" << usage.disk_size << "/"
+                 << usage.max_disk_size << "; hits by query:" << sb.as_cslice() << ";   "
+                 << send_message_cache_.size() << " different sendMessage queries, " << send_message_error_cnt_
+                 << " duplicates";
+    send_message_cache_.clear();
+    send_message_error_cnt_ = 0;
+  }
+}
+
+}  // namespace ton::validator
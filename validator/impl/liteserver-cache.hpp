@@ -17,65 +17,120 @@
 #pragma once
 
 #include "interfaces/liteserver.h"
+#include "td/db/RocksDb.h"
+#include "td/utils/List.h"
+#include <array>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <set>
 
 namespace ton::validator {
 
-class LiteServerCacheImpl : public LiteServerCache {
+// LRU of responses split into independently locked shards by the first byte of the key, so that LiteQuery actors
+// running on different threads rarely wait for each other. Every shard holds at most max_size / SHARDS bytes.
+// With max_disk_size > 0 entries evicted from memory are spilled to a RocksDb, which is emptied on start and
+// trimmed in FIFO order; an entry found on disk is moved back to memory.
+class LiteServerResponseCacheImpl : public LiteServerResponseCache {
  public:
-  void start_up() override {
-    alarm();
-  }
+  struct Options {
+    td::uint64 max_size = 64 << 20;
+    td::uint64 max_disk_size = 0;
+    std::string disk_path;
+  };
 
-  void alarm() override {
-    alarm_timestamp() = td::Timestamp::in(60.0);
-    if (queries_cnt_ > 0 || !send_message_cache_.empty()) {
-      LOG(WARNING) << "LS Cache stats: " << queries_cnt_ << " queries, " << queries_hit_cnt_ << " hits; "
-                   << cache_.size() << " entries, size=" << total_size_ << "/" << MAX_CACHE_SIZE << ";   "
-                   << send_message_cache_.size() << " different sendMessage queries, " << send_message_error_cnt_
-                   << " duplicates";
-      queries_cnt_ = 0;
-      queries_hit_cnt_ = 0;
-      send_message_cache_.clear();
-      send_message_error_cnt_ = 0;
+  explicit LiteServerResponseCacheImpl(Options options);
+
+  td::Result<td::BufferSlice> lookup(td::int32 query_id, const td::Bits256 &key) override;
+  void update(td::int32 query_id, const td::Bits256 &key, td::BufferSlice value) override;
+
+  std::vector<std::pair<td::int32, QueryStats>> get_stats() const override;
+  Usage get_usage() const override;
+
+ private:
+  static constexpr size_t SHARDS = 16;
+
+  struct CacheEntry : public td::ListNode {
+    CacheEntry(td::Bits256 key, td::BufferSlice value) : key_(key), value_(std::move(value)) {
     }
-  }
+    td::Bits256 key_;
+    td::BufferSlice value_;
 
-  void lookup(td::Bits256 key, td::Promise<td::BufferSlice> promise) override {
-    ++queries_cnt_;
-    auto it = cache_.find(key);
-    if (it == cache_.end()) {
-      promise.set_error(td::Status::Error("not found"));
-      return;
+    size_t size() const {
+      return value_.size() + 32 * 2;
     }
-    ++queries_hit_cnt_;
-    auto entry = it->second.get();
-    entry->remove();
-    lru_.put(entry);
-    promise.set_value(entry->value_.clone());
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::map<td::Bits256, std::unique_ptr<CacheEntry>> entries;
+    td::ListNode lru;
+    size_t size = 0;
+    std::map<td::int32, QueryStats> stats;
+  };
+
+  Shard &get_shard(const td::Bits256 &key) {
+    return shards_[key.as_slice().ubegin()[0] % SHARDS];
   }
+  std::vector<std::unique_ptr<CacheEntry>> insert(Shard &shard, td::Bits256 key, td::BufferSlice value);
+  td::Result<td::BufferSlice> disk_lookup(const td::Bits256 &key);
+  void spill(std::vector<std::unique_ptr<CacheEntry>> entries);
+
+  Options options_;
+  size_t max_shard_size_;
+  std::array<Shard, SHARDS> shards_;
+
+  std::unique_ptr<td::RocksDb> disk_;
+  mutable std::mutex disk_mutex_;
+  std::deque<std::pair<td::Bits256, size_t>> disk_queue_;
+  std::set<td::Bits256> disk_keys_;
+  td::uint64 disk_size_ = 0;
+};
 
-  void update(td::Bits256 key, td::BufferSlice value) override {
-    std::unique_ptr<CacheEntry> &entry = cache_[key];
-    if (entry == nullptr) {
-      entry = std::make_unique<CacheEntry>(key, std::move(value));
-    } else {
-      total_size_ -= entry->size();
-      entry->value_ = std::move(value);
-      entry->remove();
-    }
-    lru_.put(entry.get());
-    total_size_ += entry->size();
-
-    while (total_size_ > MAX_CACHE_SIZE) {
-      auto to_remove = (CacheEntry *)lru_.get();
-      CHECK(to_remove);
-      total_size_ -= to_remove->size();
-      to_remove->remove();
-      cache_.erase(to_remove->key_);
+// Accounts are kept in an LRU of at most max_accounts entries. A new state of an account is a new key, so entries of
+// old states are never returned again and leave by LRU. Configs are kept for the last MAX_CONFIGS masterchain blocks.
+class LiteServerRunMethodCacheImpl : public LiteServerRunMethodCache {
+ public:
+  explicit LiteServerRunMethodCacheImpl(size_t max_accounts) : max_accounts_(max_accounts) {
+  }
+
+  td::Result<std::shared_ptr<const Config>> get_config(td::Ref<MasterchainState> state) override;
+  std::shared_ptr<const Account> get_account(td::Ref<vm::Cell> root) override;
+
+  Stats get_stats() const override;
+
+ private:
+  static constexpr size_t MAX_CONFIGS = 16;
+
+  struct AccountEntry : public td::ListNode {
+    AccountEntry(td::Bits256 key, std::shared_ptr<const Account> account) : key_(key), account_(std::move(account)) {
     }
+    td::Bits256 key_;
+    std::shared_ptr<const Account> account_;
+  };
+
+  size_t max_accounts_;
+
+  mutable std::mutex configs_mutex_;
+  std::deque<std::shared_ptr<const Config>> configs_;
+
+  mutable std::mutex accounts_mutex_;
+  std::map<td::Bits256, std::unique_ptr<AccountEntry>> accounts_;
+  td::ListNode lru_;
+  td::uint64 queries_ = 0, hits_ = 0;
+};
+
+class LiteServerCacheImpl : public LiteServerCache {
+ public:
+  explicit LiteServerCacheImpl(std::shared_ptr<LiteServerResponseCache> responses) : responses_(std::move(responses)) {
+  }
+
+  void start_up() override {
+    alarm_timestamp() = td::Timestamp::in(60.0);
   }
 
+  void alarm() override;
+
   void process_send_message(td::Bits256 key, td::Promise<td::Unit> promise) override {
     //    if (send_message_cache_.insert(key).second) {
     promise.set_result(td::Unit());
@@ -90,27 +145,11 @@ class LiteServerCacheImpl : public LiteServerCache {
   }
 
  private:
-  struct CacheEntry : public td::ListNode {
-    explicit CacheEntry(td::Bits256 key, td::BufferSlice value) : key_(key), value_(std::move(value)) {
-    }
-    td::Bits256 key_;
-    td::BufferSlice value_;
-
-    size_t size() const {
-      return value_.size() + 32 * 2;
-    }
-  };
-
-  std::map<td::Bits256, std::unique_ptr<CacheEntry>> cache_;
-  td::ListNode lru_;
-  size_t total_size_ = 0;
-
-  size_t queries_cnt_ = 0, queries_hit_cnt_ = 0;
+  std::shared_ptr<LiteServerResponseCache> responses_;
+  std::map<td::int32, LiteServerResponseCache::QueryStats> last_stats_;
 
   std::set<td::Bits256> send_message_cache_;
   size_t send_message_error_cnt_ = 0;
-
-  const size_t MAX_CACHE_SIZE = 64 << 20;
 };
 
 }  // namespace ton::validator
@@ -92,6 +92,10 @@ namespace ton {
           if (!after_merge) {
             left_prev_state_ = std::move(state_);
           }
+          std::vector<td::Ref<vm::Cell>> prev_states{left_prev_state_->root_cell()};
+          if (after_merge) {
+            prev_states.push_back(state_->root_cell());
+          }
 
           auto P0 = td::PromiseCreator::lambda(
                   [](td::Result<std::tuple<td::vector<json>, td::Bits256, unsigned long long, int>> R) {});
@@ -118,7 +122,7 @@ namespace ton {
                                                     parse_handle_,
                                                     block_,
                                                     current_state_->root_cell(),
-                                                    left_prev_state_->root_cell(),
+                                                    std::move(prev_states),
                                                     std::move(P),
                                                     std::move(P0))
                   .release();
@@ -41,6 +41,7 @@
 #include "validator-set.hpp"
 #include "signature-set.hpp"
 #include "fabric.h"
+#include <algorithm>
 #include <ctime>
 #include "td/actor/MultiPromise.h"
 #include "collator-impl.h"
@@ -67,17 +68,22 @@ namespace ton {
         }
 
         void LiteQuery::run_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                                  td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise) {
+                                  td::actor::ActorId<LiteServerCache> cache,
+                                  std::shared_ptr<LiteServerResponseCache> responses,
+                                  std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                                  td::Promise<td::BufferSlice> promise) {
           td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(cache),
-                                             std::move(promise))
+                                             std::move(responses), std::move(run_method_cache), std::move(promise))
                   .release();
         }
 
         void LiteQuery::run_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                                  td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise,
-                                  adnl::AdnlNodeIdShort dst) {
+                                  td::actor::ActorId<LiteServerCache> cache,
+                                  std::shared_ptr<LiteServerResponseCache> responses,
+                                  std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                                  td::Promise<td::BufferSlice> promise, adnl::AdnlNodeIdShort dst) {
           td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(cache),
-                                             std::move(promise), dst)
+                                             std::move(responses), std::move(run_method_cache), std::move(promise), dst)
                   .release();
         }
 
@@ -90,16 +96,23 @@ namespace ton {
         }
 
         LiteQuery::LiteQuery(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                             td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise)
+                             td::actor::ActorId<LiteServerCache> cache,
+                             std::shared_ptr<LiteServerResponseCache> responses,
+                             std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                             td::Promise<td::BufferSlice> promise)
                 : query_(std::move(data)), manager_(std::move(manager)), cache_(std::move(cache)),
+                  responses_(std::move(responses)), run_method_cache_(std::move(run_method_cache)),
                   promise_(std::move(promise)) {
           timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
         }
 
         LiteQuery::LiteQuery(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                             td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise,
-                             adnl::AdnlNodeIdShort dst)
+                             td::actor::ActorId<LiteServerCache> cache,
+                             std::shared_ptr<LiteServerResponseCache> responses,
+                             std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                             td::Promise<td::BufferSlice> promise, adnl::AdnlNodeIdShort dst)
                 : query_(std::move(data)), manager_(std::move(manager)), cache_(std::move(cache)),
+                  responses_(std::move(responses)), run_method_cache_(std::move(run_method_cache)),
                   promise_(std::move(promise)), dst_(dst) {
           compiled_query_string = "UNKNOWN to " + dst.bits256_value().to_hex();
           timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
@@ -188,7 +201,7 @@ namespace ton {
           }
 
           if (use_cache_ && !skip_cache_update) {
-            td::actor::send_closure(cache_, &LiteServerCache::update, cache_key_, result.clone());
+            responses_->update(query_obj_->get_id(), cache_key_, result.clone());
           }
           if (promise_) {
             promise_.set_result(std::move(result));
@@ -233,31 +246,53 @@ namespace ton {
           use_cache_ = use_cache();
           if (use_cache_) {
             cache_key_ = td::sha256_bits256(query_);
-            td::actor::send_closure(cache_, &LiteServerCache::lookup, cache_key_,
-                                    [SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
-                                        if (R.is_error()) {
-                                          td::actor::send_closure(SelfId, &LiteQuery::perform);
-                                        } else {
-                                          td::actor::send_closure(SelfId, &LiteQuery::finish_query, R.move_as_ok(),
-                                                                  true);
-                                        }
-                                    });
-          } else {
-            perform();
+            auto R = responses_->lookup(query_obj_->get_id(), cache_key_);
+            if (R.is_ok()) {
+              finish_query(R.move_as_ok(), true);
+              return;
+            }
           }
+          perform();
         }
 
         bool LiteQuery::use_cache() {
-          if (cache_.empty()) {
+          if (!responses_) {
             return false;
           }
+          // wc=-1, seqno=-1 means "use latest mc block", the answer changes with every new block
+          auto pinned = [](const tl_object_ptr<lite_api::tonNode_blockIdExt> &id) {
+              return id->workchain_ != masterchainId || id->seqno_ != -1;
+          };
           bool use = false;
           lite_api::downcast_call(
                   *query_obj_,
                   td::overloaded(
-                          [&](lite_api::liteServer_runSmcMethod &q) {
-                              // wc=-1, seqno=-1 means "use latest mc block"
-                              use = q.id_->workchain_ != masterchainId || q.id_->seqno_ != -1;
+                          [&](lite_api::liteServer_getBlock &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getBlockHeader &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getAccountState &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getAccountStatePrunned &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_runSmcMethod &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getShardInfo &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getAllShardsInfo &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getOneTransaction &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_listBlockTransactions &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_listBlockTransactionsExt &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getConfigAll &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getConfigParams &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getValidatorStats &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getLibrariesWithProof &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getShardBlockProof &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getBlockOutMsgQueueSize &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getDispatchQueueInfo &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getDispatchQueueMessages &q) { use = pinned(q.id_); },
+                          [&](lite_api::liteServer_getBlockProof &q) {
+                              // without a target block the proof goes to the last known masterchain block
+                              use = (q.mode_ & 1) && pinned(q.known_block_);
+                          },
+                          // lookup by lt or utime may resolve differently until the next block is known
+                          [&](lite_api::liteServer_lookupBlock &q) { use = (q.mode_ & 7) == 1; },
+                          [&](lite_api::liteServer_lookupBlockWithProof &q) {
+                              use = (q.mode_ & 7) == 1 && pinned(q.mc_block_id_);
                           },
                           [&](auto &obj) { use = false; }));
           return use;
@@ -1713,7 +1748,7 @@ void LiteQuery::perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, St
 // same as in lite-client/lite-client-common.cpp
         static td::Ref<vm::Tuple> prepare_vm_c7(ton::UnixTime now, ton::LogicalTime lt, td::Ref<vm::CellSlice> my_addr,
                                                 const block::CurrencyCollection &balance,
-                                                const block::ConfigInfo *config = nullptr,
+                                                const LiteServerRunMethodCache::Config *config = nullptr,
                                                 td::Ref<vm::Cell> my_code = {},
                                                 td::RefInt256 due_payment = td::zero_refint()) {
           td::BitArray<256> rand_seed;
@@ -1732,10 +1767,10 @@ void LiteQuery::perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, St
                   std::move(rand_seed_int),                            //   rand_seed:Integer
                   balance.as_vm_tuple(),                               //   balance_remaining:[Integer (Maybe Cell)]
                   my_addr,                                             //   myself:MsgAddressInt
-                  config ? config->get_root_cell()
+                  config ? config->root
                          : vm::StackEntry()  //   global_config:(Maybe Cell) ] = SmartContractInfo;
           };
-          if (config && config->get_global_version() >= 4) {
+          if (config && config->global_version >= 4) {
             tuple.push_back(vm::StackEntry::maybe(my_code));                   // code:Cell
             tuple.push_back(block::CurrencyCollection::zero().as_vm_tuple());  // in_msg_value:[Integer (Maybe Cell)]
             tuple.push_back(td::zero_refint());                                // storage_fees:Integer
@@ -1743,20 +1778,19 @@ void LiteQuery::perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, St
     // [ wc:Integer shard:Integer seqno:Integer root_hash:Integer file_hash:Integer] = BlockId;
     // [ last_mc_blocks:[BlockId...]
     //   prev_key_block:BlockId ] : PrevBlocksInfo
-    auto info = config->get_prev_blocks_info();
-    tuple.push_back(info.is_ok() ? info.move_as_ok() : vm::StackEntry());
+    tuple.push_back(config->prev_blocks_info);
   }
-  if (config && config->get_global_version() >= 6) {
+  if (config && config->global_version >= 6) {
     tuple.push_back(vm::StackEntry::maybe(config->get_unpacked_config_tuple(now)));  // unpacked_config_tuple:[...]
     tuple.push_back(due_payment);                                                    // due_payment:Integer
     // precompiled_gas_usage:(Maybe Integer)
-    td::optional<block::PrecompiledContractsConfig::Contract> precompiled;
+    td::optional<td::uint64> precompiled;
     if (my_code.not_null()) {
-      precompiled = config->get_precompiled_contracts_config().get_contract(my_code->get_hash().bits());
+      precompiled = config->get_precompiled_gas_usage(my_code->get_hash().bits());
     }
-    tuple.push_back(precompiled ? td::make_refint(precompiled.value().gas_usage) : vm::StackEntry());
+    tuple.push_back(precompiled ? td::make_refint(precompiled.value()) : vm::StackEntry());
   }
-  if (config && config->get_global_version() >= 11) {
+  if (config && config->global_version >= 11) {
     tuple.push_back(block::transaction::Transaction::prepare_in_msg_params_tuple(nullptr, {}, {}));
   }
   auto tuple_ref = td::make_cnt_ref<std::vector<vm::StackEntry>>(std::move(tuple));
@@ -1778,16 +1812,22 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
     finish_query(std::move(b));
     return;
   }
-  vm::MerkleProofBuilder pb{std::move(acc_root)};
-  block::gen::Account::Record_account acc;
-  block::gen::StorageInfo::Record storage_info;
-  block::gen::AccountStorage::Record store;
-  block::CurrencyCollection balance;
-  block::gen::StateInit::Record state_init;
-  if (!(tlb::unpack_cell(pb.root(), acc) && tlb::csr_unpack(std::move(acc.storage), store) &&
-        balance.validate_unpack(store.balance) && store.state->prefetch_ulong(1) == 1 &&
-        store.state.write().advance(1) && tlb::csr_unpack(std::move(store.state), state_init) &&
-        tlb::csr_unpack(std::move(acc.storage_stat), storage_info))) {
+  // With a proof requested the VM must run on the usage tree, so that the proof covers every cell it loads;
+  // otherwise the account is taken from the cache of parsed accounts
+  vm::MerkleProofBuilder pb;
+  std::shared_ptr<const LiteServerRunMethodCache::Account> account;
+  if ((mode & 2) || !run_method_cache_) {
+    if (mode & 2) {
+      acc_root = pb.init(std::move(acc_root));
+    }
+    auto R = LiteServerRunMethodCache::parse_account(std::move(acc_root));
+    if (R.is_ok()) {
+      account = std::make_shared<const LiteServerRunMethodCache::Account>(R.move_as_ok());
+    }
+  } else {
+    account = run_method_cache_->get_account(std::move(acc_root));
+  }
+  if (!account) {
     LOG(INFO) << "error unpacking account state, or account is frozen or uninitialized";
     td::Result<td::BufferSlice> proof_boc;
     if (mode & 2) {
@@ -1806,44 +1846,34 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
     finish_query(std::move(b));
     return;
   }
-  auto code = state_init.code->prefetch_ref();
-  auto data = state_init.data->prefetch_ref();
-  auto acc_libs = state_init.library->prefetch_ref();
   long long gas_limit = client_method_gas_limit;
-  td::RefInt256 due_payment;
-  if (storage_info.due_payment.write().fetch_long(1)) {
-    due_payment = block::tlb::t_Grams.as_integer(storage_info.due_payment);
-  } else {
-    due_payment = td::zero_refint();
-  }
   LOG(DEBUG) << "creating VM with gas limit " << gas_limit;
   // **** INIT VM ****
-  auto r_config = block::ConfigInfo::extract_config(
-      mc_state_->root_cell(),
-      block::ConfigInfo::needLibraries | block::ConfigInfo::needCapabilities | block::ConfigInfo::needPrevBlocks);
+  auto r_config = run_method_cache_ ? run_method_cache_->get_config(mc_state_)
+                                    : LiteServerRunMethodCache::parse_config(mc_state_);
   if (r_config.is_error()) {
     fatal_error(r_config.move_as_error());
     return;
   }
   auto config = r_config.move_as_ok();
   std::vector<td::Ref<vm::Cell>> libraries;
-  if (config->get_libraries_root().not_null()) {
-    libraries.push_back(config->get_libraries_root());
+  if (config->libraries.not_null()) {
+    libraries.push_back(config->libraries);
   }
-  if (acc_libs.not_null()) {
-    libraries.push_back(acc_libs);
+  if (account->libraries.not_null()) {
+    libraries.push_back(account->libraries);
   }
   vm::GasLimits gas{gas_limit, gas_limit};
-  vm::VmState vm{code,
-                 config->get_global_version(),
+  vm::VmState vm{account->code,
+                 config->global_version,
                  std::move(stack_),
                  gas,
                  1,
-                 std::move(data),
+                 account->data,
                  vm::VmLog::Null(),
                  std::move(libraries)};
-  auto c7 = prepare_vm_c7(gen_utime, gen_lt, td::make_ref<vm::CellSlice>(acc.addr->clone()), balance, config.get(),
-                          std::move(code), due_payment);
+  auto c7 = prepare_vm_c7(gen_utime, gen_lt, vm::load_cell_slice_ref(account->addr), account->balance, config.get(),
+                          account->code, account->due_payment);
   vm.set_c7(c7);  // tuple with SmartContractInfo
   // vm.incr_stack_trace(1);    // enable stack dump after each step
   LOG(INFO) << "starting VM to run GET-method of smart contract " << acc_workchain_ << ":" << acc_addr_.to_hex();
@@ -1860,7 +1890,7 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
   if (mode & 8) {
     // serialize c7
     if (!(mode & 32)) {
-      c7 = prepare_vm_c7(gen_utime, gen_lt, td::make_ref<vm::CellSlice>(acc.addr->clone()), balance);
+      c7 = prepare_vm_c7(gen_utime, gen_lt, vm::load_cell_slice_ref(account->addr), account->balance);
     }
     vm::CellBuilder cb;
     if (!(vm::StackEntry{std::move(c7)}.serialize(cb) && cb.finalize_to(cell))) {
@@ -1957,7 +1987,55 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
           acc_addr_ = addr;
           trans_lt_ = lt;
           trans_hash_ = hash;
-          continue_getTransactions(count, false);
+          ++pending_;
+          td::actor::send_closure_later(
+                  manager_, &ValidatorManager::get_account_transactions_for_litequery, workchain, addr, lt, count,
+                  [Self = actor_id(this), count](td::Result<std::vector<AccountTransactionRef>> res) {
+                      if (res.is_error()) {
+                        // no index, walk the blocks
+                        LOG(DEBUG) << "transaction index: " << res.move_as_error();
+                        td::actor::send_closure(Self, &LiteQuery::got_transaction_index,
+                                                std::vector<AccountTransactionRef>{}, count);
+                      } else {
+                        td::actor::send_closure(Self, &LiteQuery::got_transaction_index, res.move_as_ok(), count);
+                      }
+                  });
+        }
+
+        void LiteQuery::got_transaction_index(std::vector<AccountTransactionRef> refs, unsigned remaining) {
+          --pending_;
+          indexed_transactions_ = std::move(refs);
+          std::set<BlockIdExt> blocks;
+          for (const auto &ref : indexed_transactions_) {
+            blocks.insert(ref.block_id);
+          }
+          LOG(DEBUG) << "getTransactions() : " << indexed_transactions_.size() << " transactions in "
+                     << blocks.size() << " blocks found in the index";
+          if (blocks.empty()) {
+            continue_getTransactions(remaining, false);
+            return;
+          }
+          // all blocks are requested at once, the transactions are still checked one by one against them
+          for (const auto &blkid : blocks) {
+            ++pending_;
+            td::actor::send_closure_later(manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+                                          [Self = actor_id(this), blkid, remaining](td::Result<Ref<BlockData>> res) {
+                                              td::actor::send_closure(Self, &LiteQuery::got_indexed_block, blkid,
+                                                                      std::move(res), remaining);
+                                          });
+          }
+        }
+
+        void LiteQuery::got_indexed_block(BlockIdExt blkid, td::Result<Ref<BlockData>> res, unsigned remaining) {
+          --pending_;
+          if (res.is_ok()) {
+            indexed_blocks_[blkid] = Ref<BlockQ>(res.move_as_ok());
+          } else {
+            LOG(DEBUG) << "getTransactions() : cannot load indexed block " << blkid.to_str() << ": " << res.error();
+          }
+          if (!pending_) {
+            continue_getTransactions(remaining, false);
+          }
         }
 
         void LiteQuery::continue_getTransactions(unsigned remaining, bool exact) {
@@ -1965,6 +2043,11 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
           bool redo = true;
           while (remaining && redo && trans_lt_ && block_.not_null()) {
             redo = false;
+            if (block_from_index_ && !ton::shard_contains(block_->block_id().shard_full(),
+                                                          ton::extract_addr_prefix(acc_workchain_, acc_addr_))) {
+              drop_indexed_transaction(trans_lt_);
+              break;
+            }
             if (!ton::shard_contains(block_->block_id().shard_full(),
                                      ton::extract_addr_prefix(acc_workchain_, acc_addr_))) {
               fatal_error("obtained a block that cannot contain specified account");
@@ -2007,6 +2090,10 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
               exact = false;
               --remaining;
               continue;
+            } else if (exact && block_from_index_) {
+              // the index named a wrong block, look the transaction up by its logical time instead
+              drop_indexed_transaction(trans_lt_);
+              break;
             } else if (exact) {
               LOG(DEBUG)
               << "could not find transaction " << trans_lt_ << " of " << acc_workchain_ << ':' << acc_addr_.to_hex()
@@ -2023,6 +2110,22 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
             finish_getTransactions();
             return;
           }
+          for (const auto &ref : indexed_transactions_) {
+            if (ref.lt != trans_lt_) {
+              continue;
+            }
+            auto it = indexed_blocks_.find(ref.block_id);
+            if (it != indexed_blocks_.end() && it->second.get() != block_.get()) {
+              LOG(DEBUG) << "getTransactions() : transaction " << trans_lt_ << " is in indexed block "
+                         << ref.block_id.to_str();
+              block_ = it->second;
+              blk_id_ = ref.block_id;
+              block_from_index_ = true;
+              continue_getTransactions(remaining, true);
+              return;
+            }
+            break;
+          }
           ++pending_;
           LOG(DEBUG)
           << "sending get_block_by_lt_from_db() query to manager for " << acc_workchain_ << ":" << acc_addr_.to_hex()
@@ -2055,6 +2158,14 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
                   });
         }
 
+        void LiteQuery::drop_indexed_transaction(LogicalTime lt) {
+          LOG(WARNING) << "getTransactions() : transaction index entry " << acc_workchain_ << ":" << acc_addr_.to_hex()
+                       << " lt=" << lt << " does not match block " << block_->block_id().to_str();
+          indexed_transactions_.erase(std::remove_if(indexed_transactions_.begin(), indexed_transactions_.end(),
+                                                     [&](const AccountTransactionRef &ref) { return ref.lt == lt; }),
+                                      indexed_transactions_.end());
+        }
+
         void LiteQuery::continue_getTransactions_2(BlockIdExt blkid, Ref<BlockData> block, unsigned remaining) {
           LOG(INFO) << "getTransactions() : loaded block " << blkid.to_str();
           --pending_;
@@ -2062,6 +2173,7 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
           CHECK(block.not_null());
           block_ = Ref<BlockQ>(std::move(block));
           blk_id_ = blkid;
+          block_from_index_ = false;
           continue_getTransactions(remaining, true);
         }
 
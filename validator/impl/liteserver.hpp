@@ -39,6 +39,8 @@ class LiteQuery : public td::actor::Actor {
   std::string compiled_query_string = "UNKNOWN";
   td::actor::ActorId<ton::validator::ValidatorManager> manager_;
   td::actor::ActorId<LiteServerCache> cache_;
+  std::shared_ptr<LiteServerResponseCache> responses_;
+  std::shared_ptr<LiteServerRunMethodCache> run_method_cache_;
   td::Timestamp timeout_;
   long started_at_;
   td::Promise<td::BufferSlice> promise_;
@@ -77,6 +79,11 @@ class LiteQuery : public td::actor::Actor {
   std::unique_ptr<block::BlockProofChain> chain_;
   Ref<vm::Stack> stack_;
 
+  // getTransactions: entries of the transaction index and the blocks they point to
+  std::vector<AccountTransactionRef> indexed_transactions_;
+  std::map<BlockIdExt, Ref<BlockQ>> indexed_blocks_;
+  bool block_from_index_{false};  // block_ was named by the transaction index, which may be wrong
+
   td::BufferSlice lookup_header_proof_;
   td::BufferSlice lookup_prev_header_proof_;
 
@@ -91,17 +98,23 @@ class LiteQuery : public td::actor::Actor {
     ls_capabilities = 7
   };  // version 1.1; +1 = build block proof chains, +2 = masterchainInfoExt, +4 = runSmcMethod
   LiteQuery(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-            td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
+            td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+            std::shared_ptr<LiteServerRunMethodCache> run_method_cache, td::Promise<td::BufferSlice> promise);
   LiteQuery(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-            td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise, adnl::AdnlNodeIdShort dst);
+            td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+            std::shared_ptr<LiteServerRunMethodCache> run_method_cache, td::Promise<td::BufferSlice> promise,
+            adnl::AdnlNodeIdShort dst);
   LiteQuery(WorkchainId wc, StdSmcAddress acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
             td::Promise<std::tuple<td::Ref<vm::CellSlice>, UnixTime, LogicalTime, std::unique_ptr<block::ConfigInfo>>>
                 promise);
   static void run_query(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                        td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
+                        td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+                        std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                        td::Promise<td::BufferSlice> promise);
   static void run_query(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                        td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise,
-                        adnl::AdnlNodeIdShort dst);
+                        td::actor::ActorId<LiteServerCache> cache, std::shared_ptr<LiteServerResponseCache> responses,
+                        std::shared_ptr<LiteServerRunMethodCache> run_method_cache,
+                        td::Promise<td::BufferSlice> promise, adnl::AdnlNodeIdShort dst);
 
   static void fetch_account_state(
       WorkchainId wc, StdSmcAddress acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
@@ -150,6 +163,9 @@ class LiteQuery : public td::actor::Actor {
   void continue_getOneTransaction();
   void perform_getTransactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash, unsigned count);
   void continue_getTransactions(unsigned remaining, bool exact);
+  void got_transaction_index(std::vector<AccountTransactionRef> refs, unsigned remaining);
+  void got_indexed_block(BlockIdExt blkid, td::Result<Ref<BlockData>> res, unsigned remaining);
+  void drop_indexed_transaction(LogicalTime lt);
   void continue_getTransactions_2(BlockIdExt blkid, Ref<BlockData> block, unsigned remaining);
   void abort_getTransactions(td::Status error, ton::BlockIdExt blkid);
   void finish_getTransactions();
@@ -33,8 +33,16 @@
 #include "common/errorlog.h"
 #include "fabric.h"
 #include "storage-stat-cache.hpp"
+#include "td/utils/port/thread.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 namespace ton {
 
@@ -68,11 +76,13 @@ std::string ErrorCtx::as_string() const {
  * @param timeout The timeout for the validation.
  * @param promise The Promise to return the ValidateCandidateResult to.
  * @param mode +1 - fake mode
+ * @param threads The number of threads checking transactions of different accounts.
  */
 ValidateQuery::ValidateQuery(ShardIdFull shard, BlockIdExt min_masterchain_block_id, std::vector<BlockIdExt> prev,
                              BlockCandidate candidate, Ref<ValidatorSet> validator_set,
                              PublicKeyHash local_validator_id, td::actor::ActorId<ValidatorManager> manager,
-                             td::Timestamp timeout, td::Promise<ValidateCandidateResult> promise, unsigned mode)
+                             td::Timestamp timeout, td::Promise<ValidateCandidateResult> promise, unsigned mode,
+                             td::uint32 threads)
     : shard_(shard)
     , id_(candidate.id)
     , min_mc_block_id(min_masterchain_block_id)
@@ -84,6 +94,7 @@ ValidateQuery::ValidateQuery(ShardIdFull shard, BlockIdExt min_masterchain_block
     , timeout(timeout)
     , main_promise(std::move(promise))
     , is_fake_(mode & ValidateMode::fake)
+    , threads_(std::max<td::uint32>(threads, 1))
     , shard_pfx_(shard_.shard)
     , shard_pfx_len_(ton::shard_prefix_length(shard_))
     , perf_timer_("validateblock", 0.1, [manager](double duration) {
@@ -91,6 +102,8 @@ ValidateQuery::ValidateQuery(ShardIdFull shard, BlockIdExt min_masterchain_block
     }) {
 }
 
+thread_local ValidateQuery::AccountCheck* ValidateQuery::worker_check_ = nullptr;
+
 /**
  * Raises an error when timeout is reached.
  */
@@ -116,6 +129,15 @@ void ValidateQuery::abort_query(td::Status error) {
  * @returns False indicating that the validation failed.
  */
 bool ValidateQuery::reject_query(std::string error, td::BufferSlice reason) {
+  if (worker_check_) {
+    // reported by check_transactions() once the worker threads are joined; the first error wins as in stop()
+    if (worker_check_->error.is_ok()) {
+      worker_check_->error = td::Status::Error(error);
+      worker_check_->rejected = true;
+      worker_check_->reject_reason = std::move(reason);
+    }
+    return false;
+  }
   error = error_ctx() + error;
   LOG(ERROR) << "REJECT: aborting validation of block candidate for " << shard_.to_str() << " : " << error;
   if (main_promise) {
@@ -178,6 +200,12 @@ bool ValidateQuery::soft_reject_query(std::string error, td::BufferSlice reason)
  */
 bool ValidateQuery::fatal_error(td::Status error) {
   error.ensure_error();
+  if (worker_check_) {
+    if (worker_check_->error.is_ok()) {
+      worker_check_->error = std::move(error);
+    }
+    return false;
+  }
   LOG(ERROR) << "aborting validation of block candidate for " << shard_.to_str() << " : " << error.to_string();
   if (main_promise) {
     record_stats(false, error.message().str());
@@ -5327,13 +5355,14 @@ std::unique_ptr<block::Account> ValidateQuery::make_account_from(td::ConstBitPtr
  * Accounts are cached in the ValidatorQuery's map.
  * Similar to Collator::make_account()
  *
- * @param addr The 256-bit address of the account.
+ * @param check The check of the account, holds its address.
  *
  * @returns Pointer to the account if found or created successfully.
  *          Returns nullptr if an error occured.
  */
-std::unique_ptr<block::Account> ValidateQuery::unpack_account(td::ConstBitPtr addr) {
-  auto dict_entry = ps_.account_dict_->lookup_extra(addr, 256);
+std::unique_ptr<block::Account> ValidateQuery::unpack_account(AccountCheck& check) {
+  td::ConstBitPtr addr = check.addr.cbits();
+  auto dict_entry = check.dicts->account_dict->lookup_extra(addr, 256);
   auto new_acc = make_account_from(addr, std::move(dict_entry.first));
   if (!new_acc) {
     reject_query("cannot load state of account "s + addr.to_hex(256) + " from previous shardchain state");
@@ -5357,8 +5386,8 @@ std::unique_ptr<block::Account> ValidateQuery::unpack_account(td::ConstBitPtr ad
           return {};
         }
       }
-    } else if (storage_stat_cache_ && new_acc->storage_dict_hash) {
-      auto dict_root = storage_stat_cache_(new_acc->storage_dict_hash.value());
+    } else if (check.dicts->storage_stat_cache && new_acc->storage_dict_hash) {
+      auto dict_root = check.dicts->storage_stat_cache(new_acc->storage_dict_hash.value());
       if (dict_root.not_null()) {
         auto S = new_acc->init_account_storage_stat(dict_root);
         if (S.is_error()) {
@@ -5368,7 +5397,7 @@ std::unique_ptr<block::Account> ValidateQuery::unpack_account(td::ConstBitPtr ad
         }
         LOG(DEBUG) << "Inited storage stat from cache for account " << addr.to_hex(256) << " ("
                    << new_acc->storage_used.cells << " cells)";
-        storage_stat_cache_update_.emplace_back(dict_root, new_acc->storage_used.cells);
+        check.storage_stat_cache_update.emplace_back(dict_root, new_acc->storage_used.cells);
       }
     }
   }
@@ -5379,6 +5408,7 @@ std::unique_ptr<block::Account> ValidateQuery::unpack_account(td::ConstBitPtr ad
  * Checks the validity of a single transaction for a given account.
  * Performs transaction execution.
  *
+ * @param check The check of the account collecting the results of its transactions.
  * @param account The account of the transaction.
  * @param lt The logical time of the transaction.
  * @param trans_root The root of the transaction.
@@ -5387,8 +5417,8 @@ std::unique_ptr<block::Account> ValidateQuery::unpack_account(td::ConstBitPtr ad
  *
  * @returns True if the transaction is valid, false otherwise.
  */
-bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalTime lt, Ref<vm::Cell> trans_root,
-                                          bool is_first, bool is_last) {
+bool ValidateQuery::check_one_transaction(AccountCheck& check, block::Account& account, ton::LogicalTime lt,
+                                          Ref<vm::Cell> trans_root, bool is_first, bool is_last) {
   if (!check_timeout()) {
     return false;
   }
@@ -5408,7 +5438,7 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
   CHECK(tag >= 0);  // we have already validated the serialization of all Transactions
   td::optional<block::MsgMetadata> in_msg_metadata;
   if (in_msg_root.not_null()) {
-    auto in_descr_cs = in_msg_dict_->lookup(in_msg_root->get_hash().as_bitslice());
+    auto in_descr_cs = check.dicts->in_msg_dict->lookup(in_msg_root->get_hash().as_bitslice());
     if (in_descr_cs.is_null()) {
       return reject_query(PSTRING() << "inbound message with hash " << in_msg_root->get_hash().to_hex()
                                     << " of transaction " << lt << " of account " << addr.to_hex()
@@ -5456,7 +5486,7 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
         }
       }
       if (info.created_lt != start_lt_ || !is_special_tx) {
-        msg_proc_lt_.emplace_back(addr, lt, emitted_lt);
+        check.msg_proc_lt.emplace_back(addr, lt, emitted_lt);
       }
       dest = std::move(info.dest);
       CHECK(money_imported.validate_unpack(info.value));
@@ -5495,7 +5525,7 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
   for (int i = 0; i < trans.outmsg_cnt; i++) {
     auto out_msg_root = out_dict.lookup_ref(td::BitArray<15>{i});
     CHECK(out_msg_root.not_null());  // we have pre-checked this
-    auto out_descr_cs = out_msg_dict_->lookup(out_msg_root->get_hash().as_bitslice());
+    auto out_descr_cs = check.dicts->out_msg_dict->lookup(out_msg_root->get_hash().as_bitslice());
     if (out_descr_cs.is_null()) {
       return reject_query(PSTRING() << "outbound message #" << i + 1 << " with hash "
                                     << out_msg_root->get_hash().to_hex() << " of transaction " << lt << " of account "
@@ -5560,7 +5590,9 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
     }
     if (tag != block::gen::OutMsg::msg_export_ext) {
       bool is_deferred = tag == block::gen::OutMsg::msg_export_new_defer;
-      if (account_expected_defer_all_messages_.count(ss_addr) && !is_deferred) {
+      // ss_addr == addr here, so only this account can have added itself since the dispatch queue was checked
+      bool defer_all = check.defer_all_messages || account_expected_defer_all_messages_.count(ss_addr);
+      if (defer_all && !is_deferred) {
         return reject_query(
             PSTRING() << "outbound message #" << i + 1 << " on account " << workchain() << ":" << ss_addr.to_hex()
                       << " must be deferred because this account has earlier messages in DispatchQueue");
@@ -5568,16 +5600,16 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
       if (is_deferred) {
         LOG(INFO) << "message from account " << workchain() << ":" << ss_addr.to_hex() << " with lt " << message_lt
                   << " was deferred";
-        if (!deferring_messages_enabled_ && !account_expected_defer_all_messages_.count(ss_addr)) {
+        if (!deferring_messages_enabled_ && !defer_all) {
           return reject_query(PSTRING() << "outbound message #" << i + 1 << " on account " << workchain() << ":"
                                         << ss_addr.to_hex() << " is deferred, but deferring messages is disabled");
         }
-        if (i == 0 && !account_expected_defer_all_messages_.count(ss_addr)) {
+        if (i == 0 && !defer_all) {
           return reject_query(PSTRING() << "outbound message #1 on account " << workchain() << ":" << ss_addr.to_hex()
                                         << " must not be deferred (the first message cannot be deferred unless some "
                                            "prevoius messages are deferred)");
         }
-        account_expected_defer_all_messages_.insert(ss_addr);
+        check.defer_all_messages = true;
       }
     }
   }
@@ -5835,29 +5867,18 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
     return reject_query(PSTRING() << "cannot re-create the serialization of  transaction " << lt
                                   << " for smart contract " << addr.to_hex());
   }
-  if (!trs->update_limits(*block_limit_status_, /* with_gas = */ false, /* with_size = */ false)) {
-    return fatal_error(PSTRING() << "cannot update block limit status to include transaction " << lt << " of account "
-                                 << addr.to_hex());
-  }
+  // the same as trs->update_limits(*block_limit_status_, /* with_gas = */ false, /* with_size = */ false)
+  check.end_lt = std::max(check.end_lt, trs->end_lt);
 
   // Collator should stop if total gas usage exceeds limits, including transactions on special accounts, but without
   // ticktocks and mint/recover.
   // Here Validator checks a weaker condition
   if (!is_special_tx && !trs->gas_limit_overridden && trans_type == block::transaction::Transaction::tr_ord) {
-    (account.is_special ? total_special_gas_used_ : total_gas_used_) += trs->gas_used();
-  }
-  if (total_gas_used_ > block_limits_->gas.hard() + compute_phase_cfg_.gas_limit) {
-    return reject_query(PSTRING() << "gas block limits are exceeded: total_gas_used > gas_limit_hard + trx_gas_limit ("
-                                  << "total_gas_used=" << total_gas_used_
-                                  << ", gas_limit_hard=" << block_limits_->gas.hard()
-                                  << ", trx_gas_limit=" << compute_phase_cfg_.gas_limit << ")");
+    (account.is_special ? check.special_gas_used : check.gas_used) += trs->gas_used();
   }
-  if (total_special_gas_used_ > block_limits_->gas.hard() + compute_phase_cfg_.special_gas_limit) {
-    return reject_query(
-        PSTRING() << "gas block limits are exceeded: total_special_gas_used > gas_limit_hard + special_gas_limit ("
-                  << "total_special_gas_used=" << total_special_gas_used_
-                  << ", gas_limit_hard=" << block_limits_->gas.hard()
-                  << ", special_gas_limit=" << compute_phase_cfg_.special_gas_limit << ")");
+  // total_gas_used_ includes only the accounts merged so far, check_transactions() repeats the check after the merge
+  if (!check_gas_limits(total_gas_used_ + check.gas_used, total_special_gas_used_ + check.special_gas_used)) {
+    return false;
   }
 
   auto trans_root2 = trs->commit(account);
@@ -5907,7 +5928,7 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
         << "transaction " << lt << " of " << addr.to_hex()
         << " is invalid: it has produced a set of outbound messages different from that listed in the transaction");
   }
-  total_burned_ += trs->blackhole_burned;
+  check.burned += trs->blackhole_burned;
   // check new balance and value flow
   auto new_balance = account.get_balance();
   block::CurrencyCollection total_fees;
@@ -5929,17 +5950,17 @@ bool ValidateQuery::check_one_transaction(block::Account& account, ton::LogicalT
 
 /**
  * Checks the validity of transactions for a given account block.
- * NB: may be run in parallel for different accounts
+ * NB: may be run in parallel for different accounts, see check_transactions()
  *
- * @param acc_addr The address of the account.
- * @param acc_blk_root The root of the AccountBlock.
+ * @param check The check of the account: its address, its AccountBlock and the results of its transactions.
  *
  * @returns True if the account transactions are valid, false otherwise.
  */
-bool ValidateQuery::check_account_transactions(const StdSmcAddress& acc_addr, Ref<vm::CellSlice> acc_blk_root) {
+bool ValidateQuery::check_account_transactions(AccountCheck& check) {
+  const StdSmcAddress& acc_addr = check.addr;
   block::gen::AccountBlock::Record acc_blk;
-  CHECK(tlb::csr_unpack(std::move(acc_blk_root), acc_blk) && acc_blk.account_addr == acc_addr);
-  auto account_p = unpack_account(acc_addr.cbits());
+  CHECK(tlb::csr_unpack(check.acc_blk, acc_blk) && acc_blk.account_addr == acc_addr);
+  auto account_p = unpack_account(check);
   if (!account_p) {
     return reject_query("cannot unpack old state of account "s + acc_addr.to_hex());
   }
@@ -5950,41 +5971,306 @@ bool ValidateQuery::check_account_transactions(const StdSmcAddress& acc_addr, Re
   td::BitArray<64> min_trans, max_trans;
   CHECK(trans_dict.get_minmax_key(min_trans).not_null() && trans_dict.get_minmax_key(max_trans, true).not_null());
   ton::LogicalTime min_trans_lt = min_trans.to_ulong(), max_trans_lt = max_trans.to_ulong();
-  if (!trans_dict.check_for_each_extra([this, &account, min_trans_lt, max_trans_lt](Ref<vm::CellSlice> value,
-                                                                                    Ref<vm::CellSlice> extra,
-                                                                                    td::ConstBitPtr key, int key_len) {
+  if (!trans_dict.check_for_each_extra([this, &check, &account, min_trans_lt, max_trans_lt](
+                                           Ref<vm::CellSlice> value, Ref<vm::CellSlice> extra, td::ConstBitPtr key,
+                                           int key_len) {
         CHECK(key_len == 64);
         ton::LogicalTime lt = key.get_uint(64);
         extra.clear();
-        return check_one_transaction(account, lt, value->prefetch_ref(), lt == min_trans_lt, lt == max_trans_lt);
+        return check_one_transaction(check, account, lt, value->prefetch_ref(), lt == min_trans_lt,
+                                     lt == max_trans_lt);
       })) {
     return reject_query("at least one Transaction of account "s + acc_addr.to_hex() + " is invalid");
   }
   if ((!full_collated_data_ || is_masterchain()) && account.storage_dict_hash && account.account_storage_stat &&
       account.account_storage_stat.value().is_dict_ready() &&
       account.storage_used.cells >= StorageStatCache::MIN_ACCOUNT_CELLS) {
-    storage_stat_cache_update_.emplace_back(account.account_storage_stat.value().get_dict_root().move_as_ok(),
-                                            account.storage_used.cells);
+    check.storage_stat_cache_update.emplace_back(account.account_storage_stat.value().get_dict_root().move_as_ok(),
+                                                 account.storage_used.cells);
   }
   if (is_masterchain() && account.libraries_changed()) {
-    return scan_account_libraries(account.orig_library, account.library, acc_addr);
+    return scan_account_libraries(check, account.orig_library, account.library);
   } else {
     return true;
   }
 }
 
+/**
+ * Creates copies of the dictionaries looked up by check_account_transactions().
+ *
+ * @returns Dictionaries to be used by one thread.
+ */
+ValidateQuery::AccountCheckDicts ValidateQuery::make_account_check_dicts() const {
+  AccountCheckDicts dicts;
+  dicts.in_msg_dict =
+      std::make_unique<vm::AugmentedDictionary>(in_msg_dict_->get_root(), 256, block::tlb::aug_InMsgDescr);
+  dicts.out_msg_dict =
+      std::make_unique<vm::AugmentedDictionary>(out_msg_dict_->get_root(), 256, block::tlb::aug_OutMsgDescr);
+  dicts.account_dict =
+      std::make_unique<vm::AugmentedDictionary>(ps_.account_dict_->get_root(), 256, block::tlb::aug_ShardAccounts);
+  dicts.storage_stat_cache = storage_stat_cache_;
+  return dicts;
+}
+
+/**
+ * Checks that the gas used by transactions does not exceed block limits.
+ *
+ * @param gas_used Gas used by ordinary transactions on ordinary accounts.
+ * @param special_gas_used Gas used by ordinary transactions on special accounts.
+ *
+ * @returns True if the limits are not exceeded, false otherwise.
+ */
+bool ValidateQuery::check_gas_limits(td::uint64 gas_used, td::uint64 special_gas_used) {
+  if (gas_used > block_limits_->gas.hard() + compute_phase_cfg_.gas_limit) {
+    return reject_query(PSTRING() << "gas block limits are exceeded: total_gas_used > gas_limit_hard + trx_gas_limit ("
+                                  << "total_gas_used=" << gas_used << ", gas_limit_hard=" << block_limits_->gas.hard()
+                                  << ", trx_gas_limit=" << compute_phase_cfg_.gas_limit << ")");
+  }
+  if (special_gas_used > block_limits_->gas.hard() + compute_phase_cfg_.special_gas_limit) {
+    return reject_query(
+        PSTRING() << "gas block limits are exceeded: total_special_gas_used > gas_limit_hard + special_gas_limit ("
+                  << "total_special_gas_used=" << special_gas_used << ", gas_limit_hard=" << block_limits_->gas.hard()
+                  << ", special_gas_limit=" << compute_phase_cfg_.special_gas_limit << ")");
+  }
+  return true;
+}
+
+/**
+ * Merges the results of check_account_transactions() into the query.
+ * Must be called in the order of accounts.
+ *
+ * @param check The check of the account.
+ *
+ * @returns True if the account transactions are valid and fit into block gas limits, false otherwise.
+ */
+bool ValidateQuery::merge_account_check(AccountCheck& check) {
+  // gas of the transactions checked before the error counts, as if the accounts were checked one after another
+  total_gas_used_ += check.gas_used;
+  total_special_gas_used_ += check.special_gas_used;
+  if (!check_gas_limits(total_gas_used_, total_special_gas_used_)) {
+    return false;
+  }
+  if (check.error.is_error()) {
+    if (check.rejected) {
+      return reject_query(check.error.message().str(), std::move(check.reject_reason));
+    }
+    return fatal_error(std::move(check.error));
+  }
+  block_limit_status_->update_lt(check.end_lt);
+  total_burned_ += check.burned;
+  if (check.defer_all_messages) {
+    account_expected_defer_all_messages_.insert(check.addr);
+  }
+  std::move(check.msg_proc_lt.begin(), check.msg_proc_lt.end(), std::back_inserter(msg_proc_lt_));
+  std::move(check.lib_publishers.begin(), check.lib_publishers.end(), std::back_inserter(lib_publishers_));
+  std::move(check.storage_stat_cache_update.begin(), check.storage_stat_cache_update.end(),
+            std::back_inserter(storage_stat_cache_update_));
+  return true;
+}
+
+namespace {
+
+/**
+ * Helper threads shared by all validations in the process.
+ * They are started once, and concurrent validations split them instead of each starting its own threads.
+ */
+class ValidationThreadPool {
+ public:
+  static ValidationThreadPool& get() {
+    static ValidationThreadPool pool(std::max(td::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+  }
+
+  explicit ValidationThreadPool(std::size_t workers_n) {
+    for (std::size_t i = 0; i < workers_n; i++) {
+      workers_.emplace_back([this] { loop(); });
+    }
+  }
+
+  ~ValidationThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Runs tasks 0..n-1 on the calling thread and on at most extra_threads_n pool threads.
+   */
+  void run(std::size_t n, const std::function<void(std::size_t)>& run_task, std::size_t extra_threads_n) {
+    Job job{n, &run_task};
+    auto helpers = std::min({extra_threads_n, workers_.size(), n > 0 ? n - 1 : 0});
+    if (helpers > 0) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job.helpers = helpers;
+        jobs_.push_back(&job);
+      }
+      job_cv_.notify_all();
+    }
+
+    job.work();
+
+    if (helpers > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // every task is taken, threads that have not joined yet must not see the job anymore
+      auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+      if (it != jobs_.end()) {
+        jobs_.erase(it);
+      }
+      done_cv_.wait(lock, [&] { return job.active == 0; });
+    }
+  }
+
+ private:
+  struct Job {
+    std::size_t n;
+    const std::function<void(std::size_t)>* run_task;
+    std::atomic<std::size_t> next_task_id{0};
+    std::size_t helpers = 0;  // threads that may still join, guarded by mutex_
+    std::size_t active = 0;   // threads running the job, guarded by mutex_
+
+    void work() {
+      for (auto task_id = next_task_id++; task_id < n; task_id = next_task_id++) {
+        (*run_task)(task_id);
+      }
+    }
+  };
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      job_cv_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        return;
+      }
+      auto job = jobs_.front();
+      job->active++;
+      if (--job->helpers == 0) {
+        jobs_.pop_front();
+      }
+      lock.unlock();
+      job->work();
+      lock.lock();
+      if (--job->active == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Job*> jobs_;
+  bool stop_ = false;
+  std::vector<td::thread> workers_;
+};
+
+}  // namespace
+
+/**
+ * Checks transactions of the accounts on up to threads_ threads: the actor thread and threads_ - 1 threads
+ * of the shared validation pool.
+ * Every thread takes the next unchecked account, accounts after the first failed one are not checked.
+ * The results are merged afterwards in the order of accounts, so the outcome does not depend on scheduling.
+ * CPU time spent on pool threads is added to worker_cpu_time_.
+ *
+ * @param checks Checks of all accounts of the block in the order of their addresses.
+ *
+ * @returns True if all transactions pass the check, False otherwise.
+ */
+bool ValidateQuery::check_transactions_parallel(std::vector<AccountCheck>& checks) {
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> first_failed{checks.size()};
+  std::vector<AccountCheckDicts> dicts;
+  auto workers = std::min<std::size_t>(threads_, checks.size());
+  for (std::size_t i = 0; i < workers; i++) {
+    dicts.push_back(make_account_check_dicts());
+  }
+
+  auto work = [&](AccountCheckDicts& thread_dicts) {
+    for (auto i = next.fetch_add(1); i < checks.size() && i < first_failed.load(); i = next.fetch_add(1)) {
+      auto& check = checks[i];
+      check.dicts = &thread_dicts;
+      worker_check_ = &check;
+      bool ok = false;
+      try {
+        ok = check_account_transactions(check);
+      } catch (vm::VmError& err) {
+        ok = fatal_error(-666, err.get_msg());
+      } catch (vm::VmVirtError& err) {
+        ok = reject_query(err.get_msg());
+      }
+      worker_check_ = nullptr;
+      if (!ok) {
+        auto cur = first_failed.load();
+        while (i < cur && !first_failed.compare_exchange_weak(cur, i)) {
+        }
+      }
+    }
+  };
+
+  // a task is one worker with its own dictionaries, the actor thread may run several of them if the pool is busy
+  auto actor_thread = std::this_thread::get_id();
+  std::vector<double> worker_cpu_time(workers, 0.0);
+  ValidationThreadPool::get().run(
+      workers,
+      [&](std::size_t i) {
+        td::ThreadCpuTimer timer;
+        work(dicts[i]);
+        if (std::this_thread::get_id() != actor_thread) {
+          // cpu_work_timer_ only sees the actor thread
+          worker_cpu_time[i] = timer.elapsed();
+        }
+      },
+      workers - 1);
+  for (auto time : worker_cpu_time) {
+    worker_cpu_time_ += time;
+  }
+
+  for (std::size_t i = 0; i < checks.size() && i <= first_failed.load(); i++) {
+    if (!merge_account_check(checks[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  * Checks all transactions in the account blocks.
+ * With threads_ > 1 the accounts are checked in parallel.
  *
  * @returns True if all transactions pass the check, False otherwise.
  */
 bool ValidateQuery::check_transactions() {
   LOG(INFO) << "checking all transactions";
-  return account_blocks_dict_->check_for_each_extra(
-      [this](Ref<vm::CellSlice> value, Ref<vm::CellSlice> extra, td::ConstBitPtr key, int key_len) {
-        CHECK(key_len == 256);
-        return check_account_transactions(key, std::move(value));
-      });
+  std::vector<AccountCheck> checks;
+  if (!account_blocks_dict_->check_for_each_extra(
+          [&](Ref<vm::CellSlice> value, Ref<vm::CellSlice> extra, td::ConstBitPtr key, int key_len) {
+            CHECK(key_len == 256);
+            checks.emplace_back();
+            checks.back().addr = key;
+            checks.back().acc_blk = std::move(value);
+            return true;
+          })) {
+    return reject_query("cannot enumerate AccountBlocks");
+  }
+  if (threads_ > 1 && checks.size() > 1) {
+    LOG(INFO) << "checking transactions of " << checks.size() << " accounts on " << threads_ << " threads";
+    return check_transactions_parallel(checks);
+  }
+  auto dicts = make_account_check_dicts();
+  for (auto& check : checks) {
+    check.dicts = &dicts;
+    if (!check_account_transactions(check) || !merge_account_check(check)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 /**
@@ -5992,22 +6278,23 @@ bool ValidateQuery::check_transactions() {
  * Used in masterchain validation.
  * Similar to Collator::update_account_public_libraries()
  *
+ * @param check The check of the account.
  * @param orig_libs The original libraries of the account.
  * @param final_libs The final libraries of the account.
- * @param addr The address of the account.
  *
  * @returns True if the update was successful, false otherwise.
  */
-bool ValidateQuery::scan_account_libraries(Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs, const td::Bits256& addr) {
+bool ValidateQuery::scan_account_libraries(AccountCheck& check, Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs) {
+  const td::Bits256& addr = check.addr;
   vm::Dictionary dict1{std::move(orig_libs), 256}, dict2{std::move(final_libs), 256};
   return dict1.scan_diff(
              dict2,
-             [this, &addr](td::ConstBitPtr key, int n, Ref<vm::CellSlice> val1, Ref<vm::CellSlice> val2) -> bool {
+             [&check, &addr](td::ConstBitPtr key, int n, Ref<vm::CellSlice> val1, Ref<vm::CellSlice> val2) -> bool {
                CHECK(n == 256);
                bool f = block::is_public_library(key, std::move(val1));
                bool g = block::is_public_library(key, val2);
                if (f != g) {
-                 lib_publishers_.emplace_back(key, addr, g);
+                 check.lib_publishers.emplace_back(key, addr, g);
                }
                return true;
              },
@@ -7196,7 +7483,7 @@ void ValidateQuery::record_stats(bool valid, std::string error_message) {
   stats.actual_collated_data_bytes = block_candidate.collated_data.size();
   stats.total_time = perf_timer_.elapsed();
   stats.work_time = work_timer_.elapsed();
-  stats.cpu_work_time = cpu_work_timer_.elapsed();
+  stats.cpu_work_time = cpu_work_timer_.elapsed() + worker_cpu_time_;
   LOG(WARNING) << "validation took " << perf_timer_.elapsed() << "s";
   LOG(WARNING) << "Validate query work time = " << stats.work_time << "s, cpu time = " << stats.cpu_work_time << "s";
   td::actor::send_closure(manager, &ValidatorManager::log_validate_query_stats, std::move(stats));
@@ -120,7 +120,7 @@ class ValidateQuery : public td::actor::Actor {
   ValidateQuery(ShardIdFull shard, BlockIdExt min_masterchain_block_id, std::vector<BlockIdExt> prev,
                 BlockCandidate candidate, td::Ref<ValidatorSet> validator_set, PublicKeyHash local_validator_id,
                 td::actor::ActorId<ValidatorManager> manager, td::Timestamp timeout,
-                td::Promise<ValidateCandidateResult> promise, unsigned mode = 0);
+                td::Promise<ValidateCandidateResult> promise, unsigned mode = 0, td::uint32 threads = 1);
 
  private:
   int verbosity{3 * 1};
@@ -144,6 +144,7 @@ class ValidateQuery : public td::actor::Actor {
   bool is_key_block_{false};
   bool update_shard_cc_{false};
   bool is_fake_{false};
+  td::uint32 threads_{1};
   bool full_collated_data_{false};
   bool prev_key_block_exists_{false};
   bool debug_checks_{false};
@@ -252,6 +253,30 @@ class ValidateQuery : public td::actor::Actor {
   td::uint64 processed_account_dispatch_queues_ = 0;
   bool have_unprocessed_account_dispatch_queue_ = false;
 
+  // Dictionaries are not thread-safe: every thread checking transactions works with its own copies
+  struct AccountCheckDicts {
+    std::unique_ptr<vm::AugmentedDictionary> in_msg_dict, out_msg_dict, account_dict;
+    std::function<td::Ref<vm::Cell>(const td::Bits256&)> storage_stat_cache;
+  };
+  // Everything check_account_transactions() contributes to the query, merged in the order of accounts.
+  // On a worker thread reject_query() and fatal_error() only record the error here.
+  struct AccountCheck {
+    StdSmcAddress addr;
+    Ref<vm::CellSlice> acc_blk;
+    AccountCheckDicts* dicts{nullptr};
+    td::uint64 gas_used{0}, special_gas_used{0};
+    LogicalTime end_lt{0};
+    block::CurrencyCollection burned{0};
+    bool defer_all_messages{false};
+    std::vector<std::tuple<Bits256, LogicalTime, LogicalTime>> msg_proc_lt;
+    std::vector<std::tuple<Bits256, Bits256, bool>> lib_publishers;
+    std::vector<std::pair<td::Ref<vm::Cell>, td::uint32>> storage_stat_cache_update;
+    td::Status error;
+    bool rejected{false};
+    td::BufferSlice reject_reason;
+  };
+  static thread_local AccountCheck* worker_check_;
+
   td::PerfWarningTimer perf_timer_;
 
   static constexpr td::uint32 priority() {
@@ -376,12 +401,16 @@ class ValidateQuery : public td::actor::Actor {
   bool check_in_queue();
   bool check_delivered_dequeued();
   std::unique_ptr<block::Account> make_account_from(td::ConstBitPtr addr, Ref<vm::CellSlice> account);
-  std::unique_ptr<block::Account> unpack_account(td::ConstBitPtr addr);
-  bool check_one_transaction(block::Account& account, LogicalTime lt, Ref<vm::Cell> trans_root, bool is_first,
-                             bool is_last);
-  bool check_account_transactions(const StdSmcAddress& acc_addr, Ref<vm::CellSlice> acc_tr);
+  std::unique_ptr<block::Account> unpack_account(AccountCheck& check);
+  bool check_one_transaction(AccountCheck& check, block::Account& account, LogicalTime lt, Ref<vm::Cell> trans_root,
+                             bool is_first, bool is_last);
+  bool check_account_transactions(AccountCheck& check);
+  AccountCheckDicts make_account_check_dicts() const;
+  bool check_gas_limits(td::uint64 gas_used, td::uint64 special_gas_used);
+  bool merge_account_check(AccountCheck& check);
+  bool check_transactions_parallel(std::vector<AccountCheck>& checks);
   bool check_transactions();
-  bool scan_account_libraries(Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs, const td::Bits256& addr);
+  bool scan_account_libraries(AccountCheck& check, Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs);
   bool check_all_ticktock_processed();
   bool check_message_processing_order();
   bool check_special_message(Ref<vm::Cell> in_msg_root, const block::CurrencyCollection& amount,
@@ -415,6 +444,7 @@ class ValidateQuery : public td::actor::Actor {
 
   td::Timer work_timer_{true};
   td::ThreadCpuTimer cpu_work_timer_{true};
+  double worker_cpu_time_ = 0.0;  // spent on the validation pool threads, see check_transactions_parallel
   void record_stats(bool valid, std::string error_message = "");
 };
 
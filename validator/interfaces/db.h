@@ -101,6 +101,8 @@ class Db : public td::actor::Actor {
                                       td::Promise<ConstBlockHandle> promise) = 0;
   virtual void get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno,
                                   td::Promise<ConstBlockHandle> promise) = 0;
+  virtual void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                        td::Promise<std::vector<AccountTransactionRef>> promise) = 0;
 
   virtual void update_init_masterchain_block(BlockIdExt block, td::Promise<td::Unit> promise) = 0;
   virtual void get_init_masterchain_block(td::Promise<BlockIdExt> promise) = 0;
@@ -20,19 +20,92 @@
 
 #include "td/actor/actor.h"
 #include "td/utils/buffer.h"
+#include "td/utils/optional.h"
 #include "common/bitstring.h"
+#include "block/block.h"
+#include "vm/stack.hpp"
+#include "shard.h"
+
+#include <vector>
 
 namespace ton::validator {
 
+// Responses to lite-server queries pinned to an explicit block, keyed by the hash of the query.
+// Shared by all LiteQuery actors and safe to use from any thread.
+class LiteServerResponseCache {
+ public:
+  struct QueryStats {
+    td::uint64 queries = 0;
+    td::uint64 hits = 0;
+    td::uint64 disk_hits = 0;
+  };
+  struct Usage {
+    size_t entries = 0;
+    td::uint64 size = 0, max_size = 0;
+    td::uint64 disk_size = 0, max_disk_size = 0;
+  };
+
+  virtual ~LiteServerResponseCache() = default;
+
+  // query_id is the TL id of the query, it is used only for statistics
+  virtual td::Result<td::BufferSlice> lookup(td::int32 query_id, const td::Bits256 &key) = 0;
+  virtual void update(td::int32 query_id, const td::Bits256 &key, td::BufferSlice value) = 0;
+
+  // Cumulative statistics per query TL id
+  virtual std::vector<std::pair<td::int32, QueryStats>> get_stats() const = 0;
+  virtual Usage get_usage() const = 0;
+};
+
+// What runSmcMethod needs to start a VM, parsed once per masterchain block and once per account state, so that
+// get-methods of hot accounts skip unpacking the account and the config on every query.
+// Only cells, integers and tuples of integers are kept: a CellSlice or a vm::Dictionary caches its read position
+// and must not be shared between threads. Safe to use from any thread.
+class LiteServerRunMethodCache {
+ public:
+  struct Config {
+    BlockIdExt block_id;
+    int global_version = 0;
+    td::Ref<vm::Cell> root, libraries;
+    td::Ref<vm::Cell> storage_prices;                // ConfigParam 18
+    std::vector<td::Ref<vm::Cell>> unpacked_params;  // ConfigParams 19, 20, 21, 24, 25, 43
+    td::Ref<vm::Cell> precompiled_contracts;         // list of ConfigParam 45
+    vm::StackEntry prev_blocks_info;
+
+    // same as block::Config::get_unpacked_config_tuple
+    td::Ref<vm::Tuple> get_unpacked_config_tuple(UnixTime now) const;
+    td::optional<td::uint64> get_precompiled_gas_usage(const td::Bits256 &code_hash) const;
+  };
+  struct Account {
+    td::Ref<vm::Cell> code, data, libraries;
+    td::Ref<vm::Cell> addr;  // MsgAddressInt
+    block::CurrencyCollection balance;
+    td::RefInt256 due_payment;
+  };
+  struct Stats {
+    td::uint64 queries = 0;
+    td::uint64 hits = 0;
+    size_t accounts = 0;
+  };
+
+  virtual ~LiteServerRunMethodCache() = default;
+
+  static td::Result<std::shared_ptr<const Config>> parse_config(td::Ref<MasterchainState> state);
+  // Fails if the account is not active
+  static td::Result<Account> parse_account(td::Ref<vm::Cell> root);
+
+  virtual td::Result<std::shared_ptr<const Config>> get_config(td::Ref<MasterchainState> state) = 0;
+  // Keyed by the hash of the account state, returns nullptr if the account is not active
+  virtual std::shared_ptr<const Account> get_account(td::Ref<vm::Cell> root) = 0;
+
+  virtual Stats get_stats() const = 0;
+};
+
 class LiteServerCache : public td::actor::Actor {
  public:
   ~LiteServerCache() override = default;
 
-  virtual void lookup(td::Bits256 key, td::Promise<td::BufferSlice> promise) = 0;
-  virtual void update(td::Bits256 key, td::BufferSlice value) = 0;
-
   virtual void process_send_message(td::Bits256 key, td::Promise<td::Unit> promise) = 0;
   virtual void drop_send_message_from_cache(td::Bits256 key) = 0;
 };
 
-} // namespace ton::validator
\ No newline at end of file
+} // namespace ton::validator
@@ -56,6 +56,13 @@ struct AsyncSerializerState {
   UnixTime last_written_block_ts;
 };
 
+// Entry of the per-account transaction index: transaction `hash` with logical time `lt` is in block `block_id`
+struct AccountTransactionRef {
+  LogicalTime lt = 0;
+  BlockIdExt block_id;
+  td::Bits256 hash = td::Bits256::zero();
+};
+
 struct CollationStats {
   BlockIdExt block_id{workchainInvalid, 0, 0, RootHash::zero(), FileHash::zero()};
   td::Status status = td::Status::OK();
@@ -308,6 +315,11 @@ class ValidatorManager : public ValidatorManagerInterface {
                                                     td::Promise<ConstBlockHandle> promise) = 0;
   virtual void get_block_by_seqno_for_litequery(AccountIdPrefixFull account, BlockSeqno seqno,
                                                 td::Promise<ConstBlockHandle> promise) = 0;
+  virtual void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                                      td::uint32 count,
+                                                      td::Promise<std::vector<AccountTransactionRef>> promise) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+  }
   virtual void get_block_candidate_for_litequery(PublicKey source, BlockIdExt block_id, FileHash collated_data_hash,
                                                  td::Promise<BlockCandidate> promise) = 0;
   virtual void get_validator_groups_info_for_litequery(
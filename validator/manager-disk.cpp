@@ -1155,7 +1155,9 @@ void ValidatorManagerImpl::start_up() {
     td::actor::send_closure(adnl_, &adnl::Adnl::create_ext_server, std::vector<adnl::AdnlNodeIdShort>{},
                             std::vector<td::uint16>{}, std::move(Q));
 
-    lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_);
+    lite_server_response_cache_ = create_liteserver_response_cache(db_root_, opts_);
+    lite_server_run_method_cache_ = create_liteserver_run_method_cache(opts_);
+    lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_, lite_server_response_cache_);
   }
 
   validator_manager_init(opts_, actor_id(this), db_.get(), std::move(P), read_only_);
@@ -1240,21 +1242,26 @@ void ValidatorManagerImpl::run_ext_query_extended(td::BufferSlice data, adnl::Ad
 
     auto E = fetch_tl_prefix<lite_api::liteServer_waitMasterchainSeqno>(data, true);
     if (E.is_error()) {
-      run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), std::move(P), dst);
+      run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), lite_server_response_cache_,
+                           lite_server_run_method_cache_, std::move(P), dst);
     } else {
       auto e = E.move_as_ok();
       if (static_cast<BlockSeqno>(e->seqno_) <= last_masterchain_seqno_) {
-        run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), std::move(P), dst);
+        run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), lite_server_response_cache_,
+                             lite_server_run_method_cache_, std::move(P), dst);
       } else {
         auto t = e->timeout_ms_ < 10000 ? e->timeout_ms_ * 0.001 : 10.0;
         auto Q = td::PromiseCreator::lambda([data = std::move(data), SelfId = actor_id(this),
                                              cache = lite_server_cache_.get(),
+                                             responses = lite_server_response_cache_,
+                                             run_method_cache = lite_server_run_method_cache_,
                                              promise = std::move(P)](td::Result<td::Unit> R) mutable {
           if (R.is_error()) {
             promise.set_error(R.move_as_error());
             return;
           }
-          run_liteserver_query(std::move(data), SelfId, cache, std::move(promise));
+          run_liteserver_query(std::move(data), SelfId, cache, std::move(responses), std::move(run_method_cache),
+                               std::move(promise));
         });
         wait_shard_client_state(e->seqno_, td::Timestamp::in(t), std::move(Q));
       }
@@ -466,6 +466,11 @@ class ValidatorManagerImpl : public ValidatorManager {
                                                 td::Promise<ConstBlockHandle> promise) override {
     get_block_by_seqno_from_db(account, seqno, std::move(promise));
   }
+  void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                              td::uint32 count,
+                                              td::Promise<std::vector<AccountTransactionRef>> promise) override {
+    td::actor::send_closure(db_, &Db::get_account_transactions, workchain, addr, lt, count, std::move(promise));
+  }
   void get_block_candidate_for_litequery(PublicKey source, BlockIdExt block_id, FileHash collated_data_hash,
                                          td::Promise<BlockCandidate> promise) override {
     promise.set_result(td::Status::Error("not implemented"));
@@ -591,6 +596,8 @@ class ValidatorManagerImpl : public ValidatorManager {
 
   td::actor::ActorOwn<adnl::AdnlExtServer> lite_server_;
   td::actor::ActorOwn<LiteServerCache> lite_server_cache_;
+  std::shared_ptr<LiteServerResponseCache> lite_server_response_cache_;
+  std::shared_ptr<LiteServerRunMethodCache> lite_server_run_method_cache_;
   std::vector<td::uint16> pending_ext_ports_;
   std::vector<adnl::AdnlNodeIdShort> pending_ext_ids_;
 
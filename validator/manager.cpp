@@ -774,21 +774,26 @@ void ValidatorManagerImpl::run_ext_query(td::BufferSlice data, td::Promise<td::B
 
   auto E = fetch_tl_prefix<lite_api::liteServer_waitMasterchainSeqno>(data, true);
   if (E.is_error()) {
-    run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), std::move(P));
+    run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), lite_server_response_cache_,
+                         lite_server_run_method_cache_, std::move(P));
   } else {
     auto e = E.move_as_ok();
     if (static_cast<BlockSeqno>(e->seqno_) <= min_confirmed_masterchain_seqno_) {
-      run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), std::move(P));
+      run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), lite_server_response_cache_,
+                           lite_server_run_method_cache_, std::move(P));
     } else {
       auto t = e->timeout_ms_ < 10000 ? e->timeout_ms_ * 0.001 : 10.0;
       auto Q =
           td::PromiseCreator::lambda([data = std::move(data), SelfId = actor_id(this), cache = lite_server_cache_.get(),
+                                      responses = lite_server_response_cache_,
+                                      run_method_cache = lite_server_run_method_cache_,
                                       promise = std::move(P)](td::Result<td::Unit> R) mutable {
             if (R.is_error()) {
               promise.set_error(R.move_as_error());
               return;
             }
-            run_liteserver_query(std::move(data), SelfId, cache, std::move(promise));
+            run_liteserver_query(std::move(data), SelfId, cache, std::move(responses), std::move(run_method_cache),
+                                 std::move(promise));
           });
       wait_shard_client_state(e->seqno_, td::Timestamp::in(t), std::move(Q));
     }
@@ -1931,7 +1936,9 @@ void ValidatorManagerImpl::get_block_proof_link_from_import(BlockIdExt block_id,
 void ValidatorManagerImpl::start_up() {
   db_ = create_db_actor(actor_id(this), db_root_, opts_);
   actor_stats_ = td::actor::create_actor<td::actor::ActorStats>("actor_stats");
-  lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_);
+  lite_server_response_cache_ = create_liteserver_response_cache(db_root_, opts_);
+  lite_server_run_method_cache_ = create_liteserver_run_method_cache(opts_);
+  lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_, lite_server_response_cache_);
   token_manager_ = td::actor::create_actor<TokenManager>("tokenmanager");
   storage_stat_cache_ = td::actor::create_actor<StorageStatCache>("storagestatcache");
   td::mkdir(db_root_ + "/tmp/").ensure();
@@ -2306,7 +2313,7 @@ void ValidatorManagerImpl::completed_prestart_sync() {
                     }
                   });
 
-              publisher->get()->storeBlockStateWithPrev(last_handle, last_prev_state, last_state, std::move(P2));
+              publisher->get()->storeBlockStateWithPrev(last_handle, {last_prev_state}, last_state, std::move(P2));
 
               // TODO: store promises in BlockParserAsync
               auto P3 = td::PromiseCreator::lambda(
@@ -3048,6 +3055,27 @@ void ValidatorManagerImpl::alarm() {
         if (ls_stats_check_ext_messages_ > 0) {
           sb << "liteserver_stats_check_ext_message " << ls_stats_check_ext_messages_ << "\n";
         }
+        if (lite_server_response_cache_) {
+          sb << "# HELP liteserver_cache_queries Cacheable liteserver queries, hits and hits from disk (total)\n";
+          sb << "# TYPE liteserver_cache_queries counter\n";
+          for (const auto &[query_id, stats] : lite_server_response_cache_->get_stats()) {
+            auto name = lite_query_name_by_id(query_id);
+            sb << "liteserver_cache_queries{name=\"" << name << "\"} " << stats.queries << "\n";
+            sb << "liteserver_cache_hits{name=\"" << name << "\"} " << stats.hits << "\n";
+            sb << "liteserver_cache_disk_hits{name=\"" << name << "\"} " << stats.disk_hits << "\n";
+          }
+          auto usage = lite_server_response_cache_->get_usage();
+          sb << "liteserver_cache_size " << usage.size << "\n";
+          sb << "liteserver_cache_disk_size " << usage.disk_size << "\n";
+        }
+        if (lite_server_run_method_cache_) {
+          auto stats = lite_server_run_method_cache_->get_stats();
+          sb << "# HELP liteserver_run_method_cache_queries Accounts looked up by runSmcMethod and hits (total)\n";
+          sb << "# TYPE liteserver_run_method_cache_queries counter\n";
+          sb << "liteserver_run_method_cache_queries " << stats.queries << "\n";
+          sb << "liteserver_run_method_cache_hits " << stats.hits << "\n";
+          sb << "liteserver_run_method_cache_accounts " << stats.accounts << "\n";
+        }
         sb << "\n";
 
         td::actor::send_closure(prometheus_exporter_, &ton::PrometheusExporterActor::set_liteserver_stats, sb.as_cslice().str());
@@ -3246,6 +3274,15 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
     vec.emplace_back("ton_node_status_cell_stat_" + key, PSTRING() << value);
   });
 
+  if (lite_server_response_cache_) {
+    for (const auto &[query_id, stats] : lite_server_response_cache_->get_stats()) {
+      auto name = lite_query_name_by_id(query_id);
+      vec.emplace_back(PSTRING() << "ton_node_status_ls_cache_queries_" << name, td::to_string(stats.queries));
+      vec.emplace_back(PSTRING() << "ton_node_status_ls_cache_hits_" << name, td::to_string(stats.hits));
+      vec.emplace_back(PSTRING() << "ton_node_status_ls_cache_disk_hits_" << name, td::to_string(stats.disk_hits));
+    }
+  }
+
   if (!shard_client_.empty()) {
     auto P = td::PromiseCreator::lambda([promise = merger.make_promise("")](td::Result<BlockSeqno> R) mutable {
       if (R.is_error()) {
@@ -3482,6 +3519,12 @@ void ValidatorManagerImpl::get_block_by_seqno_for_litequery(AccountIdPrefixFull
       });
 }
 
+void ValidatorManagerImpl::get_account_transactions_for_litequery(
+    WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+    td::Promise<std::vector<AccountTransactionRef>> promise) {
+  td::actor::send_closure(db_, &Db::get_account_transactions, workchain, addr, lt, count, std::move(promise));
+}
+
 void ValidatorManagerImpl::process_block_handle_for_litequery_error(BlockIdExt block_id,
                                                                     td::Result<BlockHandle> r_handle,
                                                                     td::Promise<ConstBlockHandle> promise) {
@@ -673,6 +673,9 @@ class ValidatorManagerImpl : public ValidatorManager {
                                                     td::Promise<ConstBlockHandle> promise) override;
   void get_block_by_seqno_for_litequery(AccountIdPrefixFull account, BlockSeqno seqno,
                                                 td::Promise<ConstBlockHandle> promise) override;
+  void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                              td::uint32 count,
+                                              td::Promise<std::vector<AccountTransactionRef>> promise) override;
   void process_block_handle_for_litequery_error(BlockIdExt block_id, td::Result<BlockHandle> r_handle,
                                                 td::Promise<ConstBlockHandle> promise);
   void process_lookup_block_for_litequery_error(AccountIdPrefixFull account, int type, td::uint64 value,
@@ -735,6 +738,8 @@ class ValidatorManagerImpl : public ValidatorManager {
  private:
   td::actor::ActorOwn<adnl::AdnlExtServer> lite_server_;
   td::actor::ActorOwn<LiteServerCache> lite_server_cache_;
+  std::shared_ptr<LiteServerResponseCache> lite_server_response_cache_;
+  std::shared_ptr<LiteServerRunMethodCache> lite_server_run_method_cache_;
   td::actor::ActorId<PrometheusExporterActor> prometheus_exporter_;
   bool prometheus_exporter_available_ = false;
   std::vector<td::uint16> pending_ext_ports_;
@@ -495,7 +495,8 @@ void AsyncStateSerializer::got_shard_handle(BlockHandle handle) {
 namespace {
 
 // Expects `ShardStateUnsplit` as `shard_state_cell`.
-std::vector<SerializablePart> split_shard_state(ShardId shard_id, td::Ref<vm::Cell> shard_state_cell, int split_depth) {
+std::vector<SerializablePart> split_shard_state(ShardId shard_id, td::Ref<vm::Cell> shard_state_cell, int split_depth,
+                                                vm::CellDbReader* cell_db_reader) {
   CHECK(split_depth <= 63);
   int shard_prefix_length = shard_pfx_len(shard_id);
   if (shard_prefix_length >= static_cast<int>(split_depth)) {
@@ -509,6 +510,15 @@ std::vector<SerializablePart> split_shard_state(ShardId shard_id, td::Ref<vm::Ce
   std::vector<SerializablePart> result;
 
   auto unwrapped_accounts_root = unsplit_shard_state.accounts;
+  if (cell_db_reader) {
+    // every part is cut out by descending from the root, load the levels above the parts one bulk request per level
+    // instead of one cell at a time; the unwrapped root keeps the prefetch out of the usage tree and the proof
+    vm::AugmentedDictionary unwrapped_accounts{vm::load_cell_slice_ref(unwrapped_accounts_root), 256,
+                                               block::tlb::aug_ShardAccounts, false};
+    unwrapped_accounts.prefetch_levels(
+        [&](td::Span<td::Ref<vm::Cell>> cells) { cell_db_reader->prefetch(cells); },
+        split_depth - shard_prefix_length + 1);
+  }
   auto accounts_cut = std::make_shared<vm::CellUsageTree>();
   auto accounts_root = vm::UsageCell::create(unwrapped_accounts_root, accounts_cut->root_ptr());
 
@@ -564,7 +574,8 @@ void AsyncStateSerializer::got_shard_state(BlockHandle handle, td::Ref<ShardStat
   }
   LOG(ERROR) << "serializing shard state " << handle->id().id.to_str();
 
-  auto parts = split_shard_state(state->get_shard().shard, state->root_cell(), archive_split_depth);
+  auto parts =
+      split_shard_state(state->get_shard().shard, state->root_cell(), archive_split_depth, cell_db_reader.get());
   CHECK(!parts.empty());
 
   write_shard_state(handle, state->get_shard(), cell_db_reader,
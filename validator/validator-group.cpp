@@ -164,7 +164,7 @@ void ValidatorGroup::validate_block_candidate(validatorsession::BlockSourceInfo
   }
   VLOG(VALIDATOR_DEBUG) << "validating block candidate " << next_block_id;
   run_validate_query(shard_, min_masterchain_block_id_, prev_block_ids_, std::move(block), validator_set_, local_id_,
-                     manager_, td::Timestamp::in(15.0), std::move(P));
+                     manager_, td::Timestamp::in(15.0), std::move(P), 0, opts_->get_validation_threads());
 }
 
 void ValidatorGroup::update_approve_cache(CacheKey key, UnixTime value) {
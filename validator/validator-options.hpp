@@ -146,6 +146,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_celldb_disable_bloom_filter() const override {
     return celldb_disable_bloom_filter_;
   }
+  td::uint32 get_celldb_prefetch_depth() const override {
+    return celldb_prefetch_depth_;
+  }
   td::optional<double> get_catchain_max_block_delay() const override {
     return catchain_max_block_delay_;
   }
@@ -176,6 +179,24 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   td::Ref<ShardBlockVerifierConfig> get_shard_block_verifier_config() const override {
     return shard_block_verifier_config_;
   }
+  td::uint32 get_validation_threads() const override {
+    return validation_threads_;
+  }
+  td::uint64 get_liteserver_cache_size() const override {
+    return liteserver_cache_size_;
+  }
+  td::uint64 get_liteserver_cache_disk_size() const override {
+    return liteserver_cache_disk_size_;
+  }
+  td::uint32 get_liteserver_run_method_cache_size() const override {
+    return liteserver_run_method_cache_size_;
+  }
+  bool get_transaction_index() const override {
+    return transaction_index_;
+  }
+  std::pair<BlockSeqno, BlockSeqno> get_transaction_index_build_range() const override {
+    return transaction_index_build_range_;
+  }
 
   void set_zero_block_id(BlockIdExt block_id) override {
     zero_block_id_ = block_id;
@@ -262,6 +283,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_celldb_disable_bloom_filter(bool value) override {
     celldb_disable_bloom_filter_ = value;
   }
+  void set_celldb_prefetch_depth(td::uint32 value) override {
+    celldb_prefetch_depth_ = value;
+  }
   void set_catchain_max_block_delay(double value) override {
     catchain_max_block_delay_ = value;
   }
@@ -299,6 +323,24 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_shard_block_verifier_config(td::Ref<ShardBlockVerifierConfig> config) override {
     shard_block_verifier_config_ = std::move(config);
   }
+  void set_validation_threads(td::uint32 value) override {
+    validation_threads_ = value;
+  }
+  void set_liteserver_cache_size(td::uint64 value) override {
+    liteserver_cache_size_ = value;
+  }
+  void set_liteserver_cache_disk_size(td::uint64 value) override {
+    liteserver_cache_disk_size_ = value;
+  }
+  void set_liteserver_run_method_cache_size(td::uint32 value) override {
+    liteserver_run_method_cache_size_ = value;
+  }
+  void set_transaction_index(bool value) override {
+    transaction_index_ = value;
+  }
+  void set_transaction_index_build_range(BlockSeqno from, BlockSeqno to) override {
+    transaction_index_build_range_ = {from, to};
+  }
 
   ValidatorManagerOptionsImpl *make_copy() const override {
     return new ValidatorManagerOptionsImpl(*this);
@@ -348,6 +390,7 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool celldb_in_memory_ = false;
   bool celldb_v2_ = false;
   bool celldb_disable_bloom_filter_ = false;
+  td::uint32 celldb_prefetch_depth_ = 0;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
   bool state_serializer_enabled_ = true;
   td::Ref<CollatorOptions> collator_options_{true};
@@ -358,6 +401,12 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   std::set<adnl::AdnlNodeIdShort> collator_node_whitelist_;
   bool collator_node_whitelist_enabled_ = false;
   td::Ref<ShardBlockVerifierConfig> shard_block_verifier_config_{true};
+  td::uint32 validation_threads_ = 1;
+  td::uint64 liteserver_cache_size_ = 64 << 20;
+  td::uint64 liteserver_cache_disk_size_ = 0;
+  td::uint32 liteserver_run_method_cache_size_ = 16384;
+  bool transaction_index_ = false;
+  std::pair<BlockSeqno, BlockSeqno> transaction_index_build_range_{0, 0};
 };
 
 }  // namespace validator
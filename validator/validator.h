@@ -147,6 +147,7 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual bool get_celldb_direct_io() const = 0;
   virtual bool get_celldb_preload_all() const = 0;
   virtual bool get_celldb_disable_bloom_filter() const = 0;
+  virtual td::uint32 get_celldb_prefetch_depth() const = 0;
   virtual td::optional<double> get_catchain_max_block_delay() const = 0;
   virtual td::optional<double> get_catchain_max_block_delay_slow() const = 0;
   virtual bool get_state_serializer_enabled() const = 0;
@@ -157,6 +158,12 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual td::Ref<CollatorsList> get_collators_list() const = 0;
   virtual bool check_collator_node_whitelist(adnl::AdnlNodeIdShort id) const = 0;
   virtual td::Ref<ShardBlockVerifierConfig> get_shard_block_verifier_config() const = 0;
+  virtual td::uint32 get_validation_threads() const = 0;
+  virtual td::uint64 get_liteserver_cache_size() const = 0;
+  virtual td::uint64 get_liteserver_cache_disk_size() const = 0;
+  virtual td::uint32 get_liteserver_run_method_cache_size() const = 0;
+  virtual bool get_transaction_index() const = 0;
+  virtual std::pair<BlockSeqno, BlockSeqno> get_transaction_index_build_range() const = 0;
 
   virtual void set_zero_block_id(BlockIdExt block_id) = 0;
   virtual void set_init_block_id(BlockIdExt block_id) = 0;
@@ -186,6 +193,7 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void set_celldb_in_memory(bool value) = 0;
   virtual void set_celldb_v2(bool value) = 0;
   virtual void set_celldb_disable_bloom_filter(bool value) = 0;
+  virtual void set_celldb_prefetch_depth(td::uint32 value) = 0;
   virtual void set_catchain_max_block_delay(double value) = 0;
   virtual void set_catchain_max_block_delay_slow(double value) = 0;
   virtual void set_state_serializer_enabled(bool value) = 0;
@@ -197,6 +205,12 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void set_collator_node_whitelisted_validator(adnl::AdnlNodeIdShort id, bool add) = 0;
   virtual void set_collator_node_whitelist_enabled(bool enabled) = 0;
   virtual void set_shard_block_verifier_config(td::Ref<ShardBlockVerifierConfig> config) = 0;
+  virtual void set_validation_threads(td::uint32 value) = 0;
+  virtual void set_liteserver_cache_size(td::uint64 value) = 0;
+  virtual void set_liteserver_cache_disk_size(td::uint64 value) = 0;
+  virtual void set_liteserver_run_method_cache_size(td::uint32 value) = 0;
+  virtual void set_transaction_index(bool value) = 0;
+  virtual void set_transaction_index_build_range(BlockSeqno from, BlockSeqno to) = 0;
 
   static td::Ref<ValidatorManagerOptions> create(
       BlockIdExt zero_block_id, BlockIdExt init_block_id,